@@ -1,5 +1,6 @@
 import { createServer } from 'http';
 import { WebSocketServer } from 'ws';
+import { encode, decode } from '@msgpack/msgpack';
 
 const PORT = process.env.PORT || 3000;
 
@@ -24,13 +25,71 @@ const wss = new WebSocketServer({ server: httpServer });
 // Registry: device_id → WebSocket connection
 const devices = new Map();
 
+// device_id → PWA sockets that get its events, and the weather they add up to
+const subscribers = new Map();
+const weatherStates = new Map();
+
+// Requests a device parses in one batch (RELAY_BATCH_MAX in the firmware)
+const DEVICE_BATCH_MAX = 8;
+// How long a PWA waits for an answer. Longer than a device holds back a
+// "fresh" /weather (RELAY_PENDING_MS, 22 s).
+const REQUEST_TIMEOUT_MS = 30000;
+
+// Remembers which PWA asked for request `id`, until the device answers it or
+// the request times out
+function addPending(deviceWs, id, pwaWs) {
+  deviceWs.pendingRequests = deviceWs.pendingRequests || new Map();
+  clearTimeout(deviceWs.pendingRequests.get(id)?.timer);
+  const timer = setTimeout(() => {
+    console.log(`[Relay] ⏱️  Request ${id} timed out on device ${deviceWs.deviceId}`);
+    failRequest(takePending(deviceWs, id), id, 'Device did not answer');
+  }, REQUEST_TIMEOUT_MS);
+  deviceWs.pendingRequests.set(id, { pwaWs, timer });
+}
+
+// The PWA waiting for `id`, which is no longer pending
+function takePending(deviceWs, id) {
+  const pending = deviceWs.pendingRequests?.get(id);
+  if (!pending) {
+    return undefined;
+  }
+  clearTimeout(pending.timer);
+  deviceWs.pendingRequests.delete(id);
+  return pending.pwaWs;
+}
+
+function failRequest(pwaWs, id, error) {
+  if (pwaWs.readyState === 1) {
+    pwaWs.send(JSON.stringify({ id, type: 'error', error }));
+  }
+}
+
+// Tells a device how many PWAs take its events: with none, it stops pushing
+// them and refreshing its forecast on their behalf
+function sendSubscriberCount(deviceId) {
+  const deviceWs = devices.get(deviceId);
+  if (!deviceWs || deviceWs.readyState !== 1) {
+    return;
+  }
+  const msg = { type: 'subscribers', count: subscribers.get(deviceId)?.size || 0 };
+  deviceWs.send(deviceWs.msgpack ? encode(msg) : JSON.stringify(msg));
+}
+
+// A complete weather event for a PWA that has just subscribed
+function weatherSnapshot(state) {
+  return JSON.stringify({ type: 'event', event: 'weather', version: state.version, complete: true, data: state.data });
+}
+
 wss.on('connection', (ws) => {
   console.log('[Relay] New connection established');
 
-  ws.on('message', (data) => {
+  ws.on('message', (data, isBinary) => {
     try {
-      const msg = JSON.parse(data.toString());
-      console.log(`[Relay] Received message type: ${msg.type}`);
+      // Binary frames are MessagePack from a device that negotiated it.
+      // PWAs only ever see JSON.
+      const msg = isBinary ? decode(data) : JSON.parse(data.toString());
+      const text = () => (isBinary ? JSON.stringify(msg) : data.toString());
+      console.log(`[Relay] Received message type: ${msg.type}${isBinary ? ' (MessagePack)' : ''}`);
 
       if (msg.type === 'register') {
         // ESP32 device registration
@@ -39,41 +98,118 @@ wss.on('connection', (ws) => {
         ws.deviceId = deviceId;
         console.log(`[Relay] ✅ Device registered: ${deviceId}`);
         console.log(`[Relay] Total devices online: ${devices.size}`);
+        // Devices that offer MessagePack get it both ways from here on
+        ws.msgpack = Array.isArray(msg.encodings) && msg.encodings.includes('msgpack');
+        ws.send(JSON.stringify({ type: 'registered', encoding: ws.msgpack ? 'msgpack' : 'json' }));
+        sendSubscriberCount(deviceId);
+
+      } else if (msg.type === 'subscribe') {
+        // PWA wants the device's events instead of polling /weather
+        const deviceId = msg.device_id;
+        if (!subscribers.has(deviceId)) {
+          subscribers.set(deviceId, new Set());
+        }
+        subscribers.get(deviceId).add(ws);
+        ws.subscriptions = ws.subscriptions || new Set();
+        ws.subscriptions.add(deviceId);
+        console.log(`[Relay] 🔔 PWA subscribed to ${deviceId}`);
+        const state = weatherStates.get(deviceId);
+        if (state) {
+          ws.send(weatherSnapshot(state));
+        }
+        sendSubscriberCount(deviceId);
 
-      } else if (msg.type === 'request') {
-        // PWA request to device
+      } else if (msg.type === 'event' && ws.deviceId) {
+        // ESP32 event: only what changed. Kept merged for late subscribers,
+        // passed on as it came to the ones already there.
+        if (msg.event === 'weather') {
+          const previous = weatherStates.get(ws.deviceId);
+          const merged = msg.complete || !previous ? msg.data : { ...previous.data, ...msg.data };
+          weatherStates.set(ws.deviceId, { version: msg.version, data: merged });
+        }
+        const pwas = subscribers.get(ws.deviceId);
+        let sent = 0;
+        for (const pwaWs of pwas || []) {
+          if (pwaWs.readyState === 1) {
+            pwaWs.send(text());
+            sent++;
+          }
+        }
+        console.log(`[Relay] 🔔 ${msg.event} event ${msg.version} from ${ws.deviceId} to ${sent} PWA(s)`);
+
+      } else if (msg.type === 'request' || (msg.type === 'batch' && Array.isArray(msg.requests))) {
+        // PWA request(s) to device; a batch is answered in one frame, bar
+        // requests the device finishes later in frames of their own
         const deviceId = msg.device_id;
         const deviceWs = devices.get(deviceId);
+        const requestIds = msg.type === 'batch' ? msg.requests.map((r) => r.id) : [msg.id];
 
         if (!deviceWs || deviceWs.readyState !== 1) {
           console.log(`[Relay] ❌ Device ${deviceId} offline or not found`);
-          ws.send(JSON.stringify({
-            id: msg.id,
-            type: 'error',
-            error: 'Device offline or not found'
-          }));
+          for (const id of requestIds) {
+            failRequest(ws, id, 'Device offline or not found');
+          }
           return;
         }
 
-        console.log(`[Relay] 📨 Forwarding request ${msg.id} (${msg.method} ${msg.path}) to device ${deviceId}`);
-        deviceWs.send(data.toString());
+        if (msg.type === 'batch') {
+          console.log(`[Relay] 📨 Forwarding batch of ${requestIds.length} (${requestIds.join(', ')}) to device ${deviceId}`);
+        } else {
+          console.log(`[Relay] 📨 Forwarding request ${msg.id} (${msg.method} ${msg.path}) to device ${deviceId}`);
+        }
 
-        // Store PWA socket for response routing
-        deviceWs.pendingRequests = deviceWs.pendingRequests || new Map();
-        deviceWs.pendingRequests.set(msg.id, ws);
+        // Store PWA socket for response routing, by request id: responses
+        // may come back in any order
+        for (const id of requestIds) {
+          addPending(deviceWs, id, ws);
+        }
+        // The device parses at most DEVICE_BATCH_MAX requests at a time
+        const messages = [];
+        if (msg.type === 'batch' && msg.requests.length > DEVICE_BATCH_MAX) {
+          for (let i = 0; i < msg.requests.length; i += DEVICE_BATCH_MAX) {
+            messages.push({ ...msg, requests: msg.requests.slice(i, i + DEVICE_BATCH_MAX) });
+          }
+        } else {
+          messages.push(msg);
+        }
+        for (const message of messages) {
+          if (deviceWs.msgpack) {
+            deviceWs.send(encode(message));
+          } else {
+            deviceWs.send(message === msg ? data.toString() : JSON.stringify(message));
+          }
+        }
 
       } else if (msg.type === 'response') {
         // ESP32 response to PWA
         const requestId = msg.id;
-        const pwaWs = ws.pendingRequests?.get(requestId);
+        const pwaWs = takePending(ws, requestId);
 
         if (pwaWs && pwaWs.readyState === 1) {
           console.log(`[Relay] 📨 Forwarding response ${requestId} (status ${msg.status}) to PWA`);
-          pwaWs.send(data.toString());
-          ws.pendingRequests.delete(requestId);
+          pwaWs.send(text());
         } else {
           console.log(`[Relay] ⚠️  No PWA client found for response ${requestId}`);
         }
+
+      } else if (msg.type === 'batch' && Array.isArray(msg.responses)) {
+        // ESP32 batch of responses: one frame on to each PWA that asked
+        const byPwa = new Map();
+        for (const response of msg.responses) {
+          const pwaWs = takePending(ws, response.id);
+          if (!pwaWs || pwaWs.readyState !== 1) {
+            console.log(`[Relay] ⚠️  No PWA client found for response ${response.id}`);
+            continue;
+          }
+          if (!byPwa.has(pwaWs)) {
+            byPwa.set(pwaWs, []);
+          }
+          byPwa.get(pwaWs).push(response);
+        }
+        for (const [pwaWs, responses] of byPwa) {
+          console.log(`[Relay] 📨 Forwarding ${responses.length} batched responses to PWA`);
+          pwaWs.send(JSON.stringify({ type: 'batch', responses }));
+        }
       }
 
     } catch (err) {
@@ -85,8 +221,16 @@ wss.on('connection', (ws) => {
     if (ws.deviceId) {
       console.log(`[Relay] Device disconnected: ${ws.deviceId}`);
       devices.delete(ws.deviceId);
+      // Its requests will not be answered now
+      for (const id of [...(ws.pendingRequests?.keys() || [])]) {
+        failRequest(takePending(ws, id), id, 'Device disconnected');
+      }
       console.log(`[Relay] Total devices online: ${devices.size}`);
     } else {
+      for (const deviceId of ws.subscriptions || []) {
+        subscribers.get(deviceId)?.delete(ws);
+        sendSubscriberCount(deviceId);
+      }
       console.log('[Relay] PWA client disconnected');
     }
   });
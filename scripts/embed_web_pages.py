@@ -0,0 +1,135 @@
+"""Gzip the pages in web/ into src/web_pages.h so the firmware serves them
+straight from flash.
+
+Runs before each build (extra_scripts in platformio.ini) and can be run by
+hand:
+
+    python3 scripts/embed_web_pages.py
+
+Each page becomes a StaticPage (src/static_page.h) holding the gzipped bytes
+and a strong ETag derived from them. A *.tmpl.* page has %NAME% fields filled
+in per request instead: it becomes a PageTemplate (src/page_template.h), its
+text pre-split into literal segments and fields. The header is only rewritten when its
+content changes, so an untouched web/ does not trigger a rebuild.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 -- provided when PlatformIO runs the script
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+WEB_DIR = os.path.join(PROJECT_DIR, "web")
+OUTPUT = os.path.join(PROJECT_DIR, "src", "web_pages.h")
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+}
+
+
+# %NAME% in a *.tmpl.* page; CSS like "100%;" does not match
+FIELD = re.compile(r"%([A-Z][A-Z0-9_]*)%")
+
+
+def identifier(name):
+    """setup.html -> SETUP_HTML, index.tmpl.html -> INDEX_HTML"""
+    return re.sub(r"[^0-9A-Za-z]", "_", name.replace(".tmpl", "")).upper()
+
+
+def c_bytes(data, indent="  ", per_line=16):
+    lines = []
+    for i in range(0, len(data), per_line):
+        lines.append(indent + ", ".join("0x%02x" % b for b in data[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def c_string(text, indent="    "):
+    """A C string literal, one source line per line of text"""
+    escaped = text.replace("\\", "\\\\").replace('"', '\\"')
+    lines = escaped.split("\n")
+    parts = ['"%s\\n"' % line for line in lines[:-1]]
+    if lines[-1] or not parts:
+        parts.append('"%s"' % lines[-1])
+    return ("\n" + indent).join(parts)
+
+
+def static_page(name, ident, content_type, source):
+    # mtime=0 keeps the output (and so the ETag) stable across builds
+    packed = gzip.compress(source, compresslevel=9, mtime=0)
+    etag = hashlib.sha256(packed).hexdigest()[:16]
+    return [
+        "",
+        "// web/%s: %d bytes, %d gzipped" % (name, len(source), len(packed)),
+        "const uint8_t %s_GZ[] PROGMEM = {" % ident,
+        c_bytes(packed),
+        "};",
+        'const StaticPage %s = { "%s", %s_GZ, sizeof(%s_GZ), "\\"%s\\"" };'
+        % (ident, content_type, ident, ident, etag),
+    ]
+
+
+def page_template(name, ident, content_type, source):
+    pieces = FIELD.split(source.decode("utf-8"))  # text, field, text, ..., text
+    out = [
+        "",
+        "// web/%s: %d bytes, %d fields" % (name, len(source), len(pieces) // 2),
+        "const TemplateSegment %s_SEGMENTS[] = {" % ident,
+    ]
+    for i in range(0, len(pieces), 2):
+        text = pieces[i]
+        field = '"%s"' % pieces[i + 1] if i + 1 < len(pieces) else "nullptr"
+        out.append("  { %s,\n    %d, %s }," % (c_string(text), len(text.encode("utf-8")), field))
+    out += [
+        "};",
+        'const PageTemplate %s = { "%s", %s_SEGMENTS, %d };'
+        % (ident, content_type, ident, (len(pieces) + 1) // 2),
+    ]
+    return out
+
+
+def render():
+    out = [
+        "// Generated by scripts/embed_web_pages.py from web/ -- do not edit.",
+        "#ifndef WEB_PAGES_H",
+        "#define WEB_PAGES_H",
+        "",
+        '#include "page_template.h"',
+        '#include "static_page.h"',
+    ]
+    for name in sorted(os.listdir(WEB_DIR)):
+        ext = os.path.splitext(name)[1]
+        if ext not in CONTENT_TYPES:
+            continue
+        with open(os.path.join(WEB_DIR, name), "rb") as f:
+            source = f.read()
+        if ".tmpl." in name:
+            out += page_template(name, identifier(name), CONTENT_TYPES[ext], source)
+        else:
+            out += static_page(name, identifier(name), CONTENT_TYPES[ext], source)
+    out += ["", "#endif // WEB_PAGES_H", ""]
+    return "\n".join(out)
+
+
+def main():
+    text = render()
+    try:
+        with open(OUTPUT, encoding="utf-8") as f:
+            if f.read() == text:
+                return
+    except FileNotFoundError:
+        pass
+    with open(OUTPUT, "w", encoding="utf-8") as f:
+        f.write(text)
+    print("embed_web_pages: wrote %s" % os.path.relpath(OUTPUT, PROJECT_DIR))
+
+
+main()
@@ -0,0 +1,397 @@
+#ifndef API_CONNECTION_H
+#define API_CONNECTION_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>  // HTTPC_ERROR_* codes
+#include "log.h"
+
+// An idle connection younger than this is reused for the next request. Older
+// ones are closed first: the server will have dropped them by then.
+#ifndef API_KEEPALIVE_MS
+#define API_KEEPALIVE_MS 60000UL
+#endif
+
+// How long a resolved address is trusted before looking the host up again
+#ifndef API_DNS_CACHE_MS
+#define API_DNS_CACHE_MS (60UL * 60UL * 1000UL)
+#endif
+
+// Request head (request line plus headers) and longest response header line
+// kept; longer header lines are truncated, which only matters for headers we
+// don't look at.
+#define API_REQUEST_MAX 512
+#define API_HEADER_LINE_MAX 128
+
+struct ApiConnectionStats {
+  uint32_t requests;
+  uint32_t reused;           // Requests sent on an already open connection
+  uint32_t handshakes;       // Full TCP + TLS handshakes
+  uint32_t dnsLookups;
+  bool lastReused;
+  uint32_t lastHandshakeMs;  // 0 when the last request reused the connection
+  uint32_t lastBytesOut;     // HTTP bytes written / read by the last request
+  uint32_t lastBytesIn;
+};
+
+// WiFiClientSecure that counts the HTTP bytes going through it (TLS record
+// overhead is not included)
+class CountingClientSecure : public WiFiClientSecure {
+ public:
+  uint32_t bytesIn = 0;
+  uint32_t bytesOut = 0;
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buf, size_t size) override {
+    size_t n = WiFiClientSecure::write(buf, size);
+    bytesOut += n;
+    return n;
+  }
+  int read() override {
+    int c = WiFiClientSecure::read();
+    if (c >= 0) bytesIn++;
+    return c;
+  }
+  int read(uint8_t *buf, size_t size) override {
+    int n = WiFiClientSecure::read(buf, size);
+    if (n > 0) bytesIn += n;
+    return n;
+  }
+};
+
+// Next byte from `client`, waiting up to `timeoutMs` for it: on the 2.0.x core
+// WiFiClientSecure reads return at once when no decrypted data is buffered yet,
+// even with more on the way. -1 once the deadline passes, or when the peer
+// closed and nothing is left to read.
+inline int readWithin(WiFiClient &client, uint32_t timeoutMs) {
+  unsigned long start = millis();
+  for (;;) {
+    int c = client.read();
+    if (c >= 0) return c;
+    if (!client.connected()) return client.read();  // Bytes that came with the close
+    if (millis() - start >= timeoutMs) return -1;
+    delay(1);
+  }
+}
+
+// Body of an HTTP/1.1 response. Strips chunked transfer framing and stops at
+// the end of the body, so parsers see the plain payload and the socket is
+// left at the start of the next response.
+class HttpBodyStream : public Stream {
+ public:
+  void begin(Stream &source, bool chunked, int contentLength) {
+    src = &source;
+    socket = nullptr;
+    isChunked = chunked;
+    remaining = chunked ? 0 : contentLength;  // -1: until the peer closes
+    done = !chunked && contentLength == 0;
+    clean = done;
+    peeked = -1;
+    // Waits for data happen in sourceRead(). Once the body has ended, find()
+    // and the like give up at once instead of retrying read() for Stream's
+    // default second.
+    setTimeout(0);
+  }
+
+  // Body read off a socket: bytes still in flight are waited for, up to
+  // `readTimeoutMs` each, rather than taken for the end of the body
+  void begin(WiFiClient &source, bool chunked, int contentLength, uint32_t readTimeoutMs) {
+    begin((Stream &)source, chunked, contentLength);
+    socket = &source;
+    waitMs = readTimeoutMs;
+  }
+
+  int available() override {
+    if (peeked >= 0) return 1;
+    return (done || !src) ? 0 : (src->available() > 0 ? 1 : 0);
+  }
+
+  int read() override {
+    if (peeked >= 0) {
+      int c = peeked;
+      peeked = -1;
+      return c;
+    }
+    if (done || !src) return -1;
+    if (isChunked && remaining == 0 && !nextChunk()) return -1;
+
+    int c = sourceRead();
+    if (c < 0) {
+      done = true;
+      clean = remaining < 0 && !isChunked;  // Close-delimited body ends at EOF
+      return -1;
+    }
+    if (remaining > 0 && --remaining == 0) {
+      if (isChunked) {
+        sourceRead();  // CRLF closing the chunk
+        sourceRead();
+      } else {
+        done = clean = true;
+      }
+    }
+    return c;
+  }
+
+  int peek() override {
+    if (peeked < 0) peeked = read();
+    return peeked;
+  }
+
+  size_t write(uint8_t c) override { (void)c; return 0; }
+
+  // Read whatever the parser left; true when the body ended cleanly
+  bool drain() {
+    while (read() >= 0) {
+    }
+    return clean;
+  }
+
+ private:
+  int sourceRead() {
+    if (socket) return readWithin(*socket, waitMs);
+    char c;
+    return src->readBytes(&c, 1) == 1 ? (uint8_t)c : -1;
+  }
+
+  // Parse "<hex size>[;ext]\r\n"; a zero size ends the body (trailers skipped)
+  bool nextChunk() {
+    long size = 0;
+    bool digits = false, inExtension = false;
+    int c;
+    while ((c = sourceRead()) >= 0 && c != '\n') {
+      if (inExtension || c == '\r') continue;
+      if (c == ';') { inExtension = true; continue; }
+      int v = isdigit(c) ? c - '0' : (isxdigit(c) ? (tolower(c) - 'a' + 10) : -1);
+      if (v < 0) break;
+      size = size * 16 + v;
+      digits = true;
+    }
+    if (c != '\n' || !digits) {
+      done = true;
+      return false;
+    }
+    if (size == 0) {
+      // Trailers end at an empty line
+      size_t lineLength = 0;
+      while ((c = sourceRead()) >= 0) {
+        if (c == '\n') {
+          if (lineLength == 0) break;
+          lineLength = 0;
+        } else if (c != '\r') {
+          lineLength++;
+        }
+      }
+      done = true;
+      clean = c == '\n';
+      return false;
+    }
+    remaining = size;
+    return true;
+  }
+
+  Stream *src = nullptr;
+  WiFiClient *socket = nullptr;  // Set when src is a socket
+  uint32_t waitMs = 0;
+  bool isChunked = false;
+  long remaining = 0;
+  bool done = true;
+  bool clean = false;
+  int peeked = -1;
+};
+
+// Keeps one HTTPS connection to an API host across requests: the address is
+// resolved once per API_DNS_CACHE_MS and an open connection is reused while
+// it has been idle less than API_KEEPALIVE_MS, so close-together requests skip
+// DNS, TCP and the TLS handshake. Not thread-safe; owned by one task.
+//
+// Speaks HTTP/1.1 itself rather than through HTTPClient: the request head is
+// written from one fixed buffer and the response headers are read line by
+// line into another, so a request does not allocate.
+//
+// The Arduino core's WiFiClientSecure (2.0.x) has no hook to save and restore
+// a TLS session, so requests further apart than the keep-alive pay a full
+// handshake.
+class ApiConnection {
+ public:
+  // caCert == nullptr skips certificate checks, like HTTPClient::begin(url)
+  ApiConnection(const char *host, const char *caCert = nullptr) : host(host), caCert(caCert) {}
+
+  // Send a GET for `path` on hostName(). The body is then read from
+  // responseBody() and the request finished with end(). Returns the HTTP status
+  // or a negative HTTPC_ERROR_* code.
+  int get(const char *path, const char *authorization, uint32_t connectTimeoutMs, uint16_t readTimeoutMs) {
+    stats.requests++;
+    stats.lastReused = false;
+    stats.lastHandshakeMs = 0;
+    client.bytesIn = 0;
+    client.bytesOut = 0;
+
+    int length = snprintf(request, sizeof(request),
+                          "GET %s HTTP/1.1\r\n"
+                          "Host: %s\r\n"
+                          "Authorization: %s\r\n"
+                          "User-Agent: WeatherPotato\r\n"
+                          "Connection: keep-alive\r\n"
+                          "\r\n",
+                          path, host, authorization);
+    if (length < 0 || (size_t)length >= sizeof(request)) {
+      return HTTPC_ERROR_TOO_LESS_RAM;
+    }
+
+    bool reusing = client.connected() && millis() - lastUsed < API_KEEPALIVE_MS;
+    int code = reusing ? send(length, readTimeoutMs) : HTTPC_ERROR_CONNECTION_LOST;
+    if (reusing && code > 0) {
+      stats.reused++;
+      stats.lastReused = true;
+    } else {
+      // Nothing open, idle too long, or the server dropped it under us
+      close();
+      if (!open(connectTimeoutMs)) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+      }
+      code = send(length, readTimeoutMs);
+    }
+
+    lastUsed = millis();
+    return code;
+  }
+
+  Stream &responseBody() { return body; }
+
+  // Finish the response. A fully read body leaves the connection open for the
+  // next request; pass keepOpen = false to drop it instead (e.g. when a parse
+  // was abandoned halfway through a large body).
+  void end(bool keepOpen = true) {
+    if (!keepOpen || !serverKeepsOpen || !body.drain()) {
+      close();
+    }
+    stats.lastBytesOut = client.bytesOut;
+    stats.lastBytesIn = client.bytesIn;
+    lastUsed = millis();
+  }
+
+  void close() { client.stop(); }
+
+  const ApiConnectionStats &statistics() const { return stats; }
+  const char *hostName() const { return host; }
+
+ private:
+  // Write the request head built by get() and read the response head
+  int send(int length, uint16_t readTimeoutMs) {
+    client.setTimeout((readTimeoutMs + 999) / 1000);  // Seconds on WiFiClient
+    readTimeout = readTimeoutMs;
+    if (client.write((const uint8_t *)request, length) != (size_t)length) {
+      return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+
+    // "HTTP/1.1 200 OK"
+    char line[API_HEADER_LINE_MAX];
+    if (readLine(line, sizeof(line)) < 0) {
+      return client.connected() ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+    }
+    if (strncmp(line, "HTTP/1.", 7) != 0 || line[8] != ' ') {
+      return HTTPC_ERROR_NO_HTTP_SERVER;
+    }
+    int code = atoi(line + 9);
+    serverKeepsOpen = line[7] != '0';
+
+    bool chunked = false;
+    long contentLength = -1;
+    int n;
+    while ((n = readLine(line, sizeof(line))) > 0) {
+      const char *value;
+      if ((value = headerValue(line, "Content-Length"))) {
+        contentLength = atol(value);
+      } else if ((value = headerValue(line, "Transfer-Encoding"))) {
+        chunked = strcasecmp(value, "chunked") == 0;
+      } else if ((value = headerValue(line, "Connection"))) {
+        serverKeepsOpen = strcasecmp(value, "close") != 0;
+      }
+    }
+    if (n < 0) {
+      return HTTPC_ERROR_CONNECTION_LOST;
+    }
+    if (code <= 0) {
+      return HTTPC_ERROR_NO_HTTP_SERVER;
+    }
+
+    body.begin(client, chunked, contentLength, readTimeout);
+    return code;
+  }
+
+  // One header line without its CRLF; excess characters are dropped. Returns
+  // the length kept, or -1 when the connection closed or a byte took longer
+  // than the read timeout.
+  int readLine(char *line, size_t size) {
+    size_t length = 0;
+    for (;;) {
+      int c = readWithin(client, readTimeout);
+      if (c < 0) return -1;
+      if (c == '\n') break;
+      if (length + 1 < size) line[length++] = c;
+    }
+    if (length > 0 && line[length - 1] == '\r') length--;
+    line[length] = '\0';
+    return (int)length;
+  }
+
+  // Value of "<name>: <value>", or nullptr when the line is another header
+  static const char *headerValue(const char *line, const char *name) {
+    size_t length = strlen(name);
+    if (strncasecmp(line, name, length) != 0 || line[length] != ':') return nullptr;
+    const char *value = line + length + 1;
+    while (*value == ' ') value++;
+    return value;
+  }
+
+  bool resolve(IPAddress &ip) {
+    if (resolvedAt != 0 && millis() - resolvedAt < API_DNS_CACHE_MS) {
+      ip = address;
+      return true;
+    }
+    stats.dnsLookups++;
+    if (!WiFi.hostByName(host, address)) {
+      resolvedAt = 0;
+      return false;
+    }
+    resolvedAt = millis();
+    if (resolvedAt == 0) resolvedAt = 1;
+    ip = address;
+    return true;
+  }
+
+  bool open(uint32_t connectTimeoutMs) {
+    IPAddress ip;
+    if (!resolve(ip)) {
+      WP_LOGW("DNS lookup for %s failed", host);
+      return false;
+    }
+
+    if (!caCert) client.setInsecure();
+    client.setHandshakeTimeout((connectTimeoutMs + 999) / 1000);
+    unsigned long start = millis();
+    // Connect by address, with the host name for SNI and certificate checks
+    if (!client.connect(ip, 443, host, caCert, nullptr, nullptr)) {
+      resolvedAt = 0;  // The host may have moved; look it up again next time
+      return false;
+    }
+    stats.handshakes++;
+    stats.lastHandshakeMs = millis() - start;
+    return true;
+  }
+
+  const char *host;
+  const char *caCert;
+  CountingClientSecure client;
+  HttpBodyStream body;
+  char request[API_REQUEST_MAX];
+  bool serverKeepsOpen = false;
+  uint16_t readTimeout = 0;  // Longest wait for any one response byte
+  IPAddress address;
+  unsigned long resolvedAt = 0;
+  unsigned long lastUsed = 0;
+  ApiConnectionStats stats = {};
+};
+
+#endif // API_CONNECTION_H
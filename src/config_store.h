@@ -0,0 +1,92 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+// Bump when ConfigRecord changes; a record of another version is ignored and
+// the device goes back to onboarding
+#define CONFIG_RECORD_VERSION 1
+#define CONFIG_SSID_MAX 32      // 802.11 limit
+#define CONFIG_PASSWORD_MAX 64  // WPA2 passphrase limit
+
+// NVS namespace and key of the record
+#define CONFIG_NAMESPACE "potato"
+#define CONFIG_KEY "config"
+
+// Everything the device needs to come back online after a reboot, stored as
+// one binary blob. Always start from ConfigRecord() so padding is zero and
+// the CRC and the unchanged-record check see the same bytes every time.
+struct ConfigRecord {
+  uint16_t version;
+  uint16_t size;  // sizeof(ConfigRecord) when written
+  char ssid[CONFIG_SSID_MAX + 1];
+  char password[CONFIG_PASSWORD_MAX + 1];
+  float latitude;
+  float longitude;
+  uint32_t crc;  // CRC-32 of every byte before it
+
+  ConfigRecord() { memset(this, 0, sizeof(*this)); }
+};
+
+// CRC-32 (IEEE 802.3, as zlib). Bitwise: the record is ~110 bytes and is
+// checked once per boot, so a table is not worth its 1 KB.
+inline uint32_t crc32(const void *data, size_t length) {
+  const uint8_t *p = (const uint8_t *)data;
+  uint32_t crc = 0xFFFFFFFFu;
+  while (length--) {
+    crc ^= *p++;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+// Reads and writes the ConfigRecord in NVS
+class ConfigStore {
+ public:
+  // False, leaving `record` untouched, when there is no record or it is from
+  // another version, the wrong size or fails its CRC
+  bool load(ConfigRecord &record) {
+    ConfigRecord stored;
+    Preferences prefs;
+    if (!prefs.begin(CONFIG_NAMESPACE, true)) {
+      return false;
+    }
+    size_t length = prefs.getBytesLength(CONFIG_KEY);
+    bool ok = length == sizeof(stored) && prefs.getBytes(CONFIG_KEY, &stored, sizeof(stored)) == sizeof(stored);
+    prefs.end();
+
+    if (!ok || stored.version != CONFIG_RECORD_VERSION || stored.size != sizeof(stored) ||
+        stored.crc != crc32(&stored, offsetof(ConfigRecord, crc))) {
+      return false;
+    }
+    stored.ssid[CONFIG_SSID_MAX] = '\0';
+    stored.password[CONFIG_PASSWORD_MAX] = '\0';
+    record = stored;
+    return true;
+  }
+
+  // Seals `record` (version, size, CRC) and writes it, unless NVS already
+  // holds the same bytes: flash sectors wear, and handlers save on every call
+  bool save(ConfigRecord &record) {
+    record.version = CONFIG_RECORD_VERSION;
+    record.size = sizeof(record);
+    record.crc = crc32(&record, offsetof(ConfigRecord, crc));
+
+    Preferences prefs;
+    if (!prefs.begin(CONFIG_NAMESPACE, false)) {
+      return false;
+    }
+    ConfigRecord current;
+    bool unchanged = prefs.getBytesLength(CONFIG_KEY) == sizeof(current) &&
+                     prefs.getBytes(CONFIG_KEY, &current, sizeof(current)) == sizeof(current) &&
+                     memcmp(&current, &record, sizeof(record)) == 0;
+    bool ok = unchanged || prefs.putBytes(CONFIG_KEY, &record, sizeof(record)) == sizeof(record);
+    prefs.end();
+    return ok;
+  }
+};
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,40 @@
+#ifndef FIRMWARE_CONFIG_H
+#define FIRMWARE_CONFIG_H
+
+// Pins, timings and buffer sizes of src/main.cpp that the native test
+// harness also works with. Kept here rather than in main.cpp so the benches
+// build against the firmware's own values.
+
+// Hardware pins
+#define LED_PIN 12
+// Pixels on the ring; -DNUM_LEDS=... in build_flags for a bigger one
+#ifndef NUM_LEDS
+#define NUM_LEDS 12
+#endif
+#define CAP_SENSOR_PIN 15
+
+// WiFi joins
+#define WIFI_SAVED_TIMEOUT_MS 15000  // Saved network at boot, before falling back to onboarding
+#define WIFI_ONBOARDING_TIMEOUT_MS 30000  // Credentials from BLE or the setup page
+
+// Periods of loop()'s tasks (see scheduler.h)
+// WebServer and WebSockets have no events to wait on: a request waits up to
+// this period, plus whatever task runs ahead of it, before it is read
+#define NETWORK_POLL_MS 10
+#define WIFI_MONITOR_MS 1000
+#define WIFI_JOIN_POLL_MS 100     // While joining: begin()'s timeouts and retries
+#define WEATHER_CHECK_MS 1000     // Results and cache refreshes also notify
+#define TIME_CHECK_MS 3600000UL   // Hourly once the clock is set
+#define TIME_RETRY_MS 10000       // Until then
+#define TIME_SYNC_POLL_MS 500     // After configTime(), until the first answer
+#define TIME_SYNC_POLLS 20        // Up to 10 s, then the relay starts anyway
+#define TIME_VALID_AFTER 1700000000  // A clock before 2023 was never set
+#define SLEEP_CHECK_MS 1000
+
+// Local API JSON replies (see JsonResponse)
+#define JSON_RESPONSE_BUFFER 512
+
+// Relay frames, in or out (see handleWebSocketMessage())
+#define RELAY_FRAME_MAX 2048
+
+#endif // FIRMWARE_CONFIG_H
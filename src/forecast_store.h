@@ -0,0 +1,103 @@
+#ifndef FORECAST_STORE_H
+#define FORECAST_STORE_H
+
+#include <Arduino.h>
+
+// Hours fetched per Meteomatics request (one PT1H time series per parameter)
+#ifndef FORECAST_HOURS
+#define FORECAST_HOURS 48
+#endif
+
+// Fixed-point scales: values are stored as int16 hundredths
+#define FORECAST_TEMP_SCALE 100    // 0.01 °C, range ±327 °C
+#define FORECAST_PRECIP_SCALE 100  // 0.01 mm, range 0..327 mm/h
+
+enum ForecastParam {
+  FORECAST_TEMPERATURE,
+  FORECAST_SYMBOL,
+  FORECAST_PRECIPITATION,
+  FORECAST_UNKNOWN
+};
+
+// Meteomatics parameter names, in the order requested in the URL
+#define FORECAST_PARAMETERS "t_2m:C,weather_symbol_1h:idx,precip_1h:mm"
+
+inline ForecastParam forecastParamFromName(const char *name) {
+  if (strcmp(name, "t_2m:C") == 0) return FORECAST_TEMPERATURE;
+  if (strcmp(name, "weather_symbol_1h:idx") == 0) return FORECAST_SYMBOL;
+  if (strcmp(name, "precip_1h:mm") == 0) return FORECAST_PRECIPITATION;
+  return FORECAST_UNKNOWN;
+}
+
+struct WeatherSample {
+  int symbol;
+  int temperature;       // Whole °C, as shown on the LEDs and in the API
+  int16_t tempCenti;     // 0.01 °C
+  int16_t precipCenti;   // 0.01 mm over the hour
+};
+
+// Hourly forecast for one location, one array per parameter (struct of
+// arrays) so a whole series is contiguous and each hour costs 5 bytes.
+class ForecastStore {
+ public:
+  ForecastStore() { clear(0); }
+
+  void clear(uint32_t startHour) {
+    firstHour = startHour;
+    count = 0;
+    memset(temperature, 0, sizeof(temperature));
+    memset(precipitation, 0, sizeof(precipitation));
+    memset(symbol, 0, sizeof(symbol));
+  }
+
+  void set(ForecastParam param, uint16_t index, float value) {
+    if (index >= FORECAST_HOURS) return;
+
+    switch (param) {
+      case FORECAST_TEMPERATURE: temperature[index] = toFixed(value, FORECAST_TEMP_SCALE); break;
+      case FORECAST_PRECIPITATION: precipitation[index] = toFixed(value, FORECAST_PRECIP_SCALE); break;
+      case FORECAST_SYMBOL: symbol[index] = (value < 0 || value > 255) ? 0 : (uint8_t)value; break;
+      default: return;
+    }
+    if (index >= count) count = index + 1;
+  }
+
+  bool covers(uint32_t hour) const { return count > 0 && hour >= firstHour && hour < firstHour + count; }
+
+  // Hours of forecast left from `hour` on (0 once the series has run out)
+  uint16_t hoursRemaining(uint32_t hour) const { return covers(hour) ? firstHour + count - hour : 0; }
+
+  bool sample(uint32_t hour, WeatherSample &out) const {
+    if (!covers(hour)) return false;
+
+    uint16_t i = hour - firstHour;
+    out.symbol = symbol[i];
+    out.tempCenti = temperature[i];
+    out.precipCenti = precipitation[i];
+    out.temperature = roundDiv(temperature[i], FORECAST_TEMP_SCALE);
+    return true;
+  }
+
+  uint32_t startHour() const { return firstHour; }
+  uint16_t size() const { return count; }
+
+ private:
+  static int16_t toFixed(float value, int scale) {
+    float scaled = value * scale;
+    if (scaled > INT16_MAX) return INT16_MAX;
+    if (scaled < INT16_MIN) return INT16_MIN;
+    return (int16_t)lroundf(scaled);
+  }
+
+  static int roundDiv(int value, int scale) {
+    return value >= 0 ? (value + scale / 2) / scale : -((-value + scale / 2) / scale);
+  }
+
+  uint32_t firstHour;  // UTC hours since epoch of slot 0
+  uint16_t count;
+  int16_t temperature[FORECAST_HOURS];
+  int16_t precipitation[FORECAST_HOURS];
+  uint8_t symbol[FORECAST_HOURS];
+};
+
+#endif // FORECAST_STORE_H
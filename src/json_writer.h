@@ -0,0 +1,409 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+#include <math.h>
+
+// Nesting depth JsonWriter tracks commas (MessagePack: member counts) for
+#define JSON_WRITER_MAX_DEPTH 16
+
+// Writes JSON text straight into a caller-provided buffer, so a response is
+// built without a String or a JsonDocument. Commas and colons are placed
+// automatically and strings are escaped per RFC 8259.
+//
+//   StaticJsonWriter<256> json;
+//   json.beginObject();
+//   json.key("status").value("ready");
+//   json.key("temperature").value(21);
+//   json.endObject();
+//
+// When the buffer fills, the flush callback (if any) is handed its contents
+// and writing carries on from an empty buffer. Without one, output that does
+// not fit is dropped and ok() turns false.
+//
+// useMsgPack() switches the same calls to MessagePack. Maps and arrays are
+// opened with a 16-bit count that is filled in when they close, and shrunk
+// to the one-byte form when they hold fewer than 16 members; that needs the
+// whole container in the buffer, so MessagePack output is never flushed.
+class JsonWriter {
+ public:
+  typedef void (*Flush)(void *context, const char *data, size_t length);
+
+  JsonWriter(char *buffer, size_t size) : buf(buffer), capacity(size) { buf[0] = '\0'; }
+
+  void onFlush(Flush fn, void *fnContext) {
+    flush = fn;
+    context = fnContext;
+  }
+
+  // Before anything is written
+  void useMsgPack() { msgpack = true; }
+  bool isMsgPack() const { return msgpack; }
+
+  JsonWriter &beginObject() { return open('{'); }
+  JsonWriter &endObject() { return close('}'); }
+  JsonWriter &beginArray() { return open('['); }
+  JsonWriter &endArray() { return close(']'); }
+
+  JsonWriter &key(const char *name) {
+    separate();
+    if (msgpack) {
+      writeMsgPackString(name, strlen(name));
+    } else {
+      writeString(name);
+      write(":", 1);
+    }
+    afterKey = true;
+    return *this;
+  }
+
+  // nullptr is written as null
+  JsonWriter &value(const char *s) {
+    separate();
+    if (msgpack) {
+      if (s) {
+        writeMsgPackString(s, strlen(s));
+      } else {
+        writeByte(MSGPACK_NIL);
+      }
+    } else if (s) {
+      writeString(s);
+    } else {
+      write("null", 4);
+    }
+    return *this;
+  }
+  JsonWriter &value(const String &s) { return value(s.c_str()); }
+
+  JsonWriter &value(bool b) {
+    separate();
+    if (msgpack) {
+      writeByte(b ? 0xc3 : 0xc2);
+    } else if (b) {
+      write("true", 4);
+    } else {
+      write("false", 5);
+    }
+    return *this;
+  }
+
+  JsonWriter &value(long n) {
+    separate();
+    if (msgpack) {
+      writeMsgPackInt(n);
+    } else if (n < 0) {
+      write("-", 1);
+      writeUnsigned(0UL - (unsigned long)n, 1);
+    } else {
+      writeUnsigned((unsigned long)n, 1);
+    }
+    return *this;
+  }
+  JsonWriter &value(int n) { return value((long)n); }
+  JsonWriter &value(unsigned long n) {
+    separate();
+    if (msgpack) {
+      writeMsgPackUnsigned(n);
+    } else {
+      writeUnsigned(n, 1);
+    }
+    return *this;
+  }
+  JsonWriter &value(unsigned int n) { return value((unsigned long)n); }
+
+  // Fixed number of decimals (at most 6), rounded like String(value, decimals)
+  // but without printf's float path. NaN and infinities become null.
+  // MessagePack: a float64 of the rounded value, so that a decoder gets the
+  // number the JSON shows and not a float32's neighbour of it.
+  JsonWriter &value(float f, uint8_t decimals) {
+    separate();
+    if (!isfinite(f)) {
+      writeNull();
+      return *this;
+    }
+    if (decimals > 6) decimals = 6;
+    unsigned long scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+
+    double scaled = fabs((double)f) * scale + 0.5;
+    if (scaled >= 4294967295.0) {  // Out of integer range; not worth a slow path
+      writeNull();
+      return *this;
+    }
+    unsigned long fixed = (unsigned long)scaled;
+    if (msgpack) {
+      double rounded = (double)fixed / scale;
+      uint64_t bits;
+      memcpy(&bits, &rounded, sizeof(bits));
+      if (f < 0 && fixed != 0) bits |= 1ULL << 63;
+      writeByte(0xcb);
+      writeBigEndian((uint32_t)(bits >> 32), 4);
+      writeBigEndian((uint32_t)bits, 4);
+      return *this;
+    }
+    if (f < 0 && fixed != 0) write("-", 1);
+    writeUnsigned(fixed / scale, 1);
+    if (decimals > 0) {
+      write(".", 1);
+      writeUnsigned(fixed % scale, decimals);
+    }
+    return *this;
+  }
+
+  JsonWriter &value(const IPAddress &ip) {
+    separate();
+    if (msgpack) {
+      char text[16];
+      int n = snprintf(text, sizeof(text), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+      writeMsgPackString(text, n);
+      return *this;
+    }
+    write("\"", 1);
+    for (int i = 0; i < 4; i++) {
+      if (i > 0) write(".", 1);
+      writeUnsigned(ip[i], 1);
+    }
+    write("\"", 1);
+    return *this;
+  }
+
+  // Output still in the buffer (all of it unless a flush happened). Text is
+  // NUL-terminated; MessagePack may hold NULs of its own.
+  const char *c_str() const { return buf; }
+  size_t bufferedLength() const { return used; }
+  // Everything written so far, flushed or not
+  size_t length() const { return flushed + used; }
+  bool hasFlushed() const { return flushed > 0; }
+  // False once output was dropped or the nesting was too deep
+  bool ok() const { return !overflowed; }
+
+ private:
+  void write(const char *data, size_t length) {
+    while (length > 0) {
+      size_t room = capacity - 1 - used;
+      if (room == 0) {
+        if (!flush || msgpack) {
+          overflowed = true;
+          return;
+        }
+        flush(context, buf, used);
+        flushed += used;
+        used = 0;
+        room = capacity - 1;
+      }
+      size_t n = length < room ? length : room;
+      memcpy(buf + used, data, n);
+      used += n;
+      buf[used] = '\0';
+      data += n;
+      length -= n;
+    }
+  }
+
+  JsonWriter &open(char bracket) {
+    separate();
+    size_t start = used;
+    if (msgpack) {
+      const char head[3] = { (char)(bracket == '{' ? MSGPACK_MAP16 : MSGPACK_ARRAY16), 0, 0 };
+      write(head, sizeof(head));
+    } else {
+      write(&bracket, 1);
+    }
+    if (excessDepth > 0 || depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+      overflowed = true;
+      excessDepth++;
+    } else {
+      depth++;
+      needComma &= ~(1UL << depth);
+      starts[depth] = (uint16_t)start;
+      members[depth] = 0;
+    }
+    return *this;
+  }
+
+  JsonWriter &close(char bracket) {
+    if (excessDepth > 0) {  // Untracked: the levels below it are left as they are
+      excessDepth--;
+      if (!msgpack) write(&bracket, 1);
+      return *this;
+    }
+    if (msgpack) {
+      if (depth > 0 && !overflowed) sizeContainer(starts[depth], members[depth]);
+    } else {
+      write(&bracket, 1);
+    }
+    if (depth > 0) depth--;
+    return *this;
+  }
+
+  // Comma before every member but the first, nothing between key and value.
+  // MessagePack has no separators: the member is counted instead.
+  void separate() {
+    if (afterKey) {
+      afterKey = false;
+      return;
+    }
+    if (excessDepth > 0) return;  // Nothing is tracked that deep
+    if (msgpack) {
+      members[depth]++;
+      return;
+    }
+    if (needComma & (1UL << depth)) write(",", 1);
+    needComma |= 1UL << depth;
+  }
+
+  void writeNull() {
+    if (msgpack) {
+      writeByte(MSGPACK_NIL);
+    } else {
+      write("null", 4);
+    }
+  }
+
+  // ---- MessagePack
+
+  enum : uint8_t { MSGPACK_NIL = 0xc0, MSGPACK_MAP16 = 0xde, MSGPACK_ARRAY16 = 0xdc };
+
+  void writeByte(uint8_t b) { write((const char *)&b, 1); }
+
+  void writeBigEndian(uint32_t v, uint8_t bytes) {
+    char out[4];
+    for (uint8_t i = 0; i < bytes; i++) out[i] = (char)(v >> (8 * (bytes - 1 - i)));
+    write(out, bytes);
+  }
+
+  void writeMsgPackUnsigned(unsigned long n) {
+    if (n < 0x80) {
+      writeByte((uint8_t)n);
+    } else if (n <= 0xff) {
+      writeByte(0xcc);
+      writeBigEndian(n, 1);
+    } else if (n <= 0xffff) {
+      writeByte(0xcd);
+      writeBigEndian(n, 2);
+    } else {
+      writeByte(0xce);
+      writeBigEndian((uint32_t)n, 4);
+    }
+  }
+
+  void writeMsgPackInt(long n) {
+    if (n >= 0) {
+      writeMsgPackUnsigned((unsigned long)n);
+    } else if (n >= -32) {
+      writeByte((uint8_t)(int8_t)n);  // Negative fixint
+    } else if (n >= -128) {
+      writeByte(0xd0);
+      writeBigEndian((uint8_t)n, 1);
+    } else if (n >= -32768) {
+      writeByte(0xd1);
+      writeBigEndian((uint16_t)n, 2);
+    } else {
+      writeByte(0xd2);
+      writeBigEndian((uint32_t)n, 4);
+    }
+  }
+
+  void writeMsgPackString(const char *s, size_t length) {
+    if (length < 32) {
+      writeByte(0xa0 | length);
+    } else if (length <= 0xff) {
+      writeByte(0xd9);
+      writeBigEndian(length, 1);
+    } else if (length <= 0xffff) {
+      writeByte(0xda);
+      writeBigEndian(length, 2);
+    } else {
+      writeByte(0xdb);
+      writeBigEndian((uint32_t)length, 4);
+    }
+    write(s, length);
+  }
+
+  // Fills in the count of the map or array opened at `start`: in place, or
+  // as a fixmap/fixarray with the contents moved down over the spare bytes
+  void sizeContainer(size_t start, uint16_t count) {
+    uint8_t *head = (uint8_t *)buf + start;
+    if (count < 16) {
+      *head = (*head == MSGPACK_MAP16 ? 0x80 : 0x90) | count;
+      memmove(head + 1, head + 3, used - start - 3);
+      used -= 2;
+      buf[used] = '\0';
+    } else {
+      head[1] = (uint8_t)(count >> 8);
+      head[2] = (uint8_t)count;
+    }
+  }
+
+  void writeString(const char *s) {
+    write("\"", 1);
+    const char *run = s;
+    for (; *s; s++) {
+      uint8_t c = (uint8_t)*s;
+      if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+      write(run, s - run);
+      run = s + 1;
+      char escaped[7] = { '\\', 0 };
+      size_t n = 2;
+      switch (c) {
+        case '"': escaped[1] = '"'; break;
+        case '\\': escaped[1] = '\\'; break;
+        case '\b': escaped[1] = 'b'; break;
+        case '\f': escaped[1] = 'f'; break;
+        case '\n': escaped[1] = 'n'; break;
+        case '\r': escaped[1] = 'r'; break;
+        case '\t': escaped[1] = 't'; break;
+        default: {
+          static const char hex[] = "0123456789abcdef";
+          memcpy(escaped + 1, "u00", 3);
+          escaped[4] = hex[c >> 4];
+          escaped[5] = hex[c & 0x0f];
+          n = 6;
+        }
+      }
+      write(escaped, n);
+    }
+    write(run, s - run);
+    write("\"", 1);
+  }
+
+  void writeUnsigned(unsigned long n, uint8_t minDigits) {
+    char digits[20];
+    uint8_t count = 0;
+    do {
+      digits[sizeof(digits) - 1 - count++] = '0' + n % 10;
+      n /= 10;
+    } while (n > 0 || count < minDigits);
+    write(digits + sizeof(digits) - count, count);
+  }
+
+  char *buf;
+  size_t capacity;
+  size_t used = 0;
+  size_t flushed = 0;
+  Flush flush = nullptr;
+  void *context = nullptr;
+  uint32_t needComma = 0;  // Bit per depth: a member was already written there
+  uint8_t depth = 0;
+  uint16_t excessDepth = 0;  // Containers open beyond JSON_WRITER_MAX_DEPTH
+  bool afterKey = false;
+  bool overflowed = false;
+  bool msgpack = false;
+  // MessagePack, per open container: where its head is, and its members so
+  // far. Depth 0 is the top level, counted like the rest but never sized.
+  uint16_t starts[JSON_WRITER_MAX_DEPTH] = {};
+  uint16_t members[JSON_WRITER_MAX_DEPTH] = {};
+};
+
+// JsonWriter with its own buffer of N bytes (one is kept for the terminator)
+template <size_t N>
+class StaticJsonWriter : public JsonWriter {
+ public:
+  StaticJsonWriter() : JsonWriter(storage, N) {}
+
+ private:
+  char storage[N];
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,265 @@
+#ifndef LED_ANIMATION_H
+#define LED_ANIMATION_H
+
+#include <Arduino.h>
+
+#define LED_FRAME_MS 100        // 10 frames a second
+#define LED_ANIMATION_MS 10000  // Then the strip goes dark
+
+// Range of the temperature colour table; colder or hotter is clamped
+#define LED_TEMP_MIN -20
+#define LED_TEMP_MAX 40
+
+struct Rgb {
+  uint8_t r, g, b;
+};
+
+// Compile-time tables. Written as single-expression recursions and index
+// packs so they stay constexpr under the ESP32 toolchain's C++11.
+namespace led_tables {
+
+template <int... I>
+struct Indices {};
+template <int N, int... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template <int... I>
+struct MakeIndices<0, I...> {
+  typedef Indices<I...> type;
+};
+
+// Newton's method from 1.0; 24 steps settle any x in [0, 1]
+constexpr double squareRoot(double x, double guess = 1.0, int steps = 24) {
+  return steps == 0 || x <= 0.0 ? (x <= 0.0 ? 0.0 : guess) : squareRoot(x, 0.5 * (guess + x / guess), steps - 1);
+}
+
+// Gamma 2.5 (x^2 * sqrt(x)): WS2812 duty is linear, the eye is not, so
+// equal steps of the 0-255 an effect works in look like equal steps
+constexpr uint8_t gammaAt(int i) {
+  return (uint8_t)(255.0 * (i / 255.0) * (i / 255.0) * squareRoot(i / 255.0) + 0.5);
+}
+
+struct Gamma8 {
+  uint8_t v[256];
+};
+
+template <int... I>
+constexpr Gamma8 makeGamma(Indices<I...>) {
+  return Gamma8{{gammaAt(I)...}};
+}
+
+// Arduino's map(), integer and truncating, so the table holds exactly what
+// the float-era renderer computed per frame
+constexpr int mapInt(int x, int inMin, int inMax, int outMin, int outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+constexpr uint8_t clamp8(int v) { return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v)); }
+
+// Base colour the effects shade. Freezing: blue, brighter toward 0°C. Mild:
+// cyan turning warm white. Hot: the flame picks its own colours.
+constexpr Rgb temperatureColourAt(int t) {
+  return t <= 0 ? Rgb{0, 0, clamp8(mapInt(t, -10, 0, 128, 255))}
+                : (t <= 25 ? Rgb{clamp8(mapInt(t, 0, 25, 0, 128)), clamp8(mapInt(t, 0, 25, 255, 128)),
+                                 clamp8(mapInt(t, 0, 25, 255, 64))}
+                           : Rgb{255, 96, 0});
+}
+
+struct TemperatureColours {
+  Rgb v[LED_TEMP_MAX - LED_TEMP_MIN + 1];
+};
+
+template <int... I>
+constexpr TemperatureColours makeTemperatureColours(Indices<I...>) {
+  return TemperatureColours{{temperatureColourAt(I + LED_TEMP_MIN)...}};
+}
+
+}  // namespace led_tables
+
+constexpr led_tables::Gamma8 LED_GAMMA = led_tables::makeGamma(led_tables::MakeIndices<256>::type());
+constexpr led_tables::TemperatureColours LED_TEMPERATURE_COLOURS =
+    led_tables::makeTemperatureColours(led_tables::MakeIndices<LED_TEMP_MAX - LED_TEMP_MIN + 1>::type());
+
+inline Rgb temperatureColour(int temperature) {
+  int t = temperature < LED_TEMP_MIN ? LED_TEMP_MIN : (temperature > LED_TEMP_MAX ? LED_TEMP_MAX : temperature);
+  return LED_TEMPERATURE_COLOURS.v[t - LED_TEMP_MIN];
+}
+
+// x * s / 255 without the division; exact at s = 0 and s = 255
+inline uint8_t scale8(uint8_t x, uint8_t s) { return (uint8_t)(((uint16_t)x * (s + 1)) >> 8); }
+
+// Marsaglia xorshift32: three shifts a draw, plenty random for flicker.
+// `state` must not be 0.
+struct XorShift32 {
+  uint32_t state;
+
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+};
+
+// One look of the strip. Each effect keeps its own state between frames, so
+// any number of animations can run side by side.
+class LedEffect {
+ public:
+  virtual ~LedEffect() {}
+  virtual void begin() = 0;
+  // The next frame, before gamma, into pixels[0..count)
+  virtual void render(Rgb base, Rgb *pixels, uint16_t count) = 0;
+};
+
+// Freezing: a blue gradient turning around the ring, a step per frame
+class ColdSpin : public LedEffect {
+ public:
+  void begin() override { step_ = 0; }
+
+  void render(Rgb base, Rgb *pixels, uint16_t count) override {
+    if (count != count_) {
+      count_ = count;
+      fadeStep_ = (uint16_t)(255 * 256 / count);  // 8.8 fixed point: 255/count per pixel
+    }
+    uint16_t p = step_;
+    uint16_t fade = 255 << 8;
+    for (uint16_t i = 0; i < count; i++) {
+      pixels[p] = Rgb{0, 0, scale8(base.b, (uint8_t)(fade >> 8))};
+      fade -= fadeStep_;
+      p = p + 1 < count ? p + 1 : 0;
+    }
+    step_ = step_ + 1 < count ? step_ + 1 : 0;
+  }
+
+ private:
+  uint16_t step_ = 0;
+  uint16_t count_ = 0;
+  uint16_t fadeStep_ = 0;
+};
+
+// Mild: the whole ring breathing in the temperature's colour
+class MildPulse : public LedEffect {
+ public:
+  void begin() override {
+    level_ = 0;
+    rising_ = true;
+  }
+
+  void render(Rgb base, Rgb *pixels, uint16_t count) override {
+    if (rising_) {
+      level_ += PULSE_STEP;
+      if (level_ >= 255) rising_ = false;
+    } else {
+      level_ -= PULSE_STEP;
+      if (level_ <= 0) rising_ = true;
+    }
+    uint8_t s = (uint8_t)level_;
+    Rgb shade = {scale8(base.r, s), scale8(base.g, s), scale8(base.b, s)};
+    for (uint16_t i = 0; i < count; i++) {
+      pixels[i] = shade;
+    }
+  }
+
+ private:
+  static const int PULSE_STEP = 15;  // 17 frames up, 17 down
+  int level_ = 0;
+  bool rising_ = true;
+};
+
+// Hot: flickering embers, one random draw per pixel per frame
+class Flame : public LedEffect {
+ public:
+  explicit Flame(uint32_t seed = 0x9E3779B9u) { rng_.state = seed ? seed : 1; }
+
+  void begin() override {}
+
+  void render(Rgb base, Rgb *pixels, uint16_t count) override {
+    (void)base;
+    for (uint16_t i = 0; i < count; i++) {
+      uint32_t r = rng_.next();
+      bool flare = (r & 0xFF) < 51;  // 1 in 5
+      uint8_t flicker = (uint8_t)(r >> 8);
+      pixels[i] = flare ? Rgb{255, (uint8_t)(64 + (flicker & 63)), 0} : Rgb{128, (uint8_t)(32 + (flicker & 31)), 0};
+    }
+  }
+
+ private:
+  XorShift32 rng_;
+};
+
+// The weather animation on one strip: the effect the temperature calls for,
+// a frame every LED_FRAME_MS, dark again after LED_ANIMATION_MS. `Strip` is
+// an LedStrip<N>; the frame buffer is sized from its pixel count.
+template <typename Strip>
+class LedAnimation {
+ public:
+  explicit LedAnimation(Strip &strip) : strip_(strip) {}
+
+  void start(unsigned long nowMs) {
+    startMs_ = nowMs;
+    lastFrameMs_ = nowMs - LED_FRAME_MS;  // First frame right away
+    effect_ = nullptr;
+    running_ = true;
+  }
+
+  bool running() const { return running_; }
+
+  // Shows the next frame once it is due. False, with the strip cleared, once
+  // the animation is over. The temperature may change between frames.
+  bool update(int temperature, unsigned long nowMs) {
+    if (!running_) {
+      return false;
+    }
+    if (nowMs - startMs_ >= LED_ANIMATION_MS) {
+      stop();
+      return false;
+    }
+    if (nowMs - lastFrameMs_ < LED_FRAME_MS) {
+      return true;
+    }
+    lastFrameMs_ = nowMs;
+    render(temperature);
+    show();
+    return true;
+  }
+
+  void stop() {
+    running_ = false;
+    strip_.clear();
+    strip_.show();
+  }
+
+  // Next frame into pixels() without showing it
+  void render(int temperature) {
+    LedEffect *effect = temperature <= 0 ? (LedEffect *)&cold_ : temperature <= 25 ? (LedEffect *)&mild_ : &flame_;
+    if (effect != effect_) {
+      effect_ = effect;
+      effect_->begin();
+    }
+    effect_->render(temperatureColour(temperature), pixels_, COUNT);
+  }
+
+  const Rgb *pixels() const { return pixels_; }
+
+ private:
+  void show() {
+    for (uint16_t i = 0; i < COUNT; i++) {
+      const Rgb &p = pixels_[i];
+      strip_.setPixelColor(i, LED_GAMMA.v[p.r], LED_GAMMA.v[p.g], LED_GAMMA.v[p.b]);
+    }
+    strip_.show();
+  }
+
+  static const uint16_t COUNT = Strip::numPixels();
+
+  Strip &strip_;
+  ColdSpin cold_;
+  MildPulse mild_;
+  Flame flame_;
+  LedEffect *effect_ = nullptr;
+  Rgb pixels_[COUNT] = {};
+  unsigned long startMs_ = 0;
+  unsigned long lastFrameMs_ = 0;
+  bool running_ = false;
+};
+
+#endif // LED_ANIMATION_H
@@ -0,0 +1,157 @@
+#ifndef LED_STRIP_H
+#define LED_STRIP_H
+
+#include <Arduino.h>
+#include <string.h>
+#include "driver/rmt.h"
+#include "log.h"
+
+// RMT clock: APB 80 MHz / 2, 25 ns a tick
+#define LED_RMT_CLK_DIV 2
+
+// WS2812 bit timings in RMT ticks
+#define LED_T0H_TICKS 16     // 0.40 us
+#define LED_T0L_TICKS 34     // 0.85 us
+#define LED_T1H_TICKS 32     // 0.80 us
+#define LED_T1L_TICKS 18     // 0.45 us
+#define LED_RESET_TICKS 12000  // 300 us low latches the frame (newer WS2812B want 280)
+
+// RMT memory blocks (64 bits each) for the LED channel. Two halve the refill
+// interrupts and ride out more WiFi interrupt latency, but take the memory of
+// the next channel, which must stay unused.
+#define LED_RMT_MEM_BLOCKS 2
+
+// RMT translator: GRB bytes to one pulse pair per bit, MSB first. Runs in the
+// RMT interrupt, a refill at a time. The last bit of the frame holds the line
+// low for the latch, so a frame is only done once the strip has taken it.
+static void IRAM_ATTR ledRmtTranslate(const void *src, rmt_item32_t *dest, size_t srcSize, size_t wantedNum,
+                                      size_t *translatedSize, size_t *itemNum) {
+  const uint8_t *in = (const uint8_t *)src;
+  size_t size = 0;
+  size_t num = 0;
+  while (size < srcSize && num + 8 <= wantedNum) {
+    uint8_t byte = in[size];
+    for (int bit = 7; bit >= 0; bit--) {
+      rmt_item32_t &item = dest[num++];
+      bool one = byte & (1 << bit);
+      item.level0 = 1;
+      item.duration0 = one ? LED_T1H_TICKS : LED_T0H_TICKS;
+      item.level1 = 0;
+      item.duration1 = one ? LED_T1L_TICKS : LED_T0L_TICKS;
+    }
+    size++;
+  }
+  if (size == srcSize && num > 0) {
+    dest[num - 1].duration1 = LED_RESET_TICKS;
+  }
+  *translatedSize = size;
+  *itemNum = num;
+}
+
+// A WS2812 strip of `Count` pixels on an RMT channel, with the parts of the
+// Adafruit_NeoPixel interface the firmware uses.
+//
+// show() hands the frame to the RMT driver and returns. The RMT interrupt
+// turns it into pulses 32 bits at a time while the CPU goes on, so neither
+// the frame length nor the WiFi and BLE stacks are held up by a bit-banged
+// show() running with interrupts off (30 us a pixel: 9 ms for 300). The
+// frame on the wire is one of two buffers; setPixelColor() draws into the
+// other, so the next frame can be drawn while this one goes out.
+template <uint16_t Count>
+class LedStrip {
+ public:
+  explicit LedStrip(uint8_t pin, rmt_channel_t channel = RMT_CHANNEL_0) : pin_(pin), channel_(channel) {}
+
+  bool begin() {
+    if (ready_) {
+      return true;  // The driver is installed once per boot
+    }
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)pin_, channel_);
+    config.clk_div = LED_RMT_CLK_DIV;
+    config.mem_block_num = LED_RMT_MEM_BLOCKS;
+    esp_err_t err = rmt_config(&config);
+    if (err == ESP_OK) err = rmt_driver_install(channel_, 0, 0);
+    if (err == ESP_OK) err = rmt_translator_init(channel_, ledRmtTranslate);
+    ready_ = err == ESP_OK;
+    if (!ready_) {
+      WP_LOGE("LED strip: RMT setup failed (%d)", err);
+    }
+    return ready_;
+  }
+
+  static constexpr uint16_t numPixels() { return Count; }
+
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+
+  // Applies to pixels set from now on, as Adafruit_NeoPixel does
+  void setBrightness(uint8_t brightness) { scale_ = (uint16_t)brightness + 1; }
+
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+    if (n >= Count) {
+      return;
+    }
+    uint8_t *p = back_ + n * 3;
+    p[0] = (uint8_t)((g * scale_) >> 8);
+    p[1] = (uint8_t)((r * scale_) >> 8);
+    p[2] = (uint8_t)((b * scale_) >> 8);
+  }
+
+  void setPixelColor(uint16_t n, uint32_t c) { setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c); }
+
+  // After brightness
+  uint32_t getPixelColor(uint16_t n) const {
+    if (n >= Count) {
+      return 0;
+    }
+    const uint8_t *p = back_ + n * 3;
+    return Color(p[1], p[0], p[2]);
+  }
+
+  void clear() { memset(back_, 0, FRAME_BYTES); }
+
+  // Starts sending the frame drawn so far and returns. Only waits when the
+  // previous frame is still going out, i.e. frames come faster than the
+  // strip takes them (300 pixels: 9.3 ms a frame, over 100 a second).
+  void show() {
+    if (!ready_) {
+      return;
+    }
+    if (rmt_wait_tx_done(channel_, 0) != ESP_OK) {
+      stalls_++;
+      rmt_wait_tx_done(channel_, portMAX_DELAY);
+    }
+    uint8_t *frame = back_;
+    back_ = front_;
+    front_ = frame;
+    rmt_write_sample(channel_, front_, FRAME_BYTES, false);
+    // Pixels not set again keep their colour, as with a single buffer
+    memcpy(back_, front_, FRAME_BYTES);
+  }
+
+  // Blocks until the frame on the wire is out, e.g. before deep sleep stops
+  // the RMT clock mid-frame
+  void flush() {
+    if (ready_) {
+      rmt_wait_tx_done(channel_, portMAX_DELAY);
+    }
+  }
+
+  // show() calls that had to wait for the previous frame
+  uint32_t stalls() const { return stalls_; }
+
+ private:
+  static const size_t FRAME_BYTES = (size_t)Count * 3;  // GRB
+
+  uint8_t pin_;
+  rmt_channel_t channel_;
+  bool ready_ = false;
+  uint16_t scale_ = 256;  // brightness + 1
+  uint8_t buffers_[2][FRAME_BYTES] = {};
+  uint8_t *back_ = buffers_[0];   // Drawn into
+  uint8_t *front_ = buffers_[1];  // On the wire
+  uint32_t stalls_ = 0;
+};
+
+#endif // LED_STRIP_H
@@ -0,0 +1,177 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Levelled logging that never waits for the UART. WP_LOGx() formats the line
+// into a slot of a lock-free ring and returns; a low-priority task drains the
+// ring to Serial. When the ring is full the line is dropped and counted, and
+// the drain task reports how many were lost.
+//
+//   WP_LOGI("Location updated: %.4f, %.4f", latitude, longitude);
+//
+// Levels above WP_LOG_LEVEL are compiled out, arguments included.
+#define WP_LOG_NONE 0
+#define WP_LOG_ERROR 1
+#define WP_LOG_WARN 2
+#define WP_LOG_INFO 3
+#define WP_LOG_DEBUG 4
+
+// Most verbose level built in; -DWP_LOG_LEVEL=WP_LOG_DEBUG for debug builds
+#ifndef WP_LOG_LEVEL
+#define WP_LOG_LEVEL WP_LOG_INFO
+#endif
+
+// Lines the ring holds (a power of two) and the longest line kept; longer
+// ones are cut
+#ifndef LOG_QUEUE_LINES
+#define LOG_QUEUE_LINES 32
+#endif
+#ifndef LOG_LINE_MAX
+#define LOG_LINE_MAX 120
+#endif
+
+// Below loop() and the weather task (both 1): logs go out when nothing else
+// wants the CPU
+#define LOG_TASK_STACK 3072
+#define LOG_TASK_PRIORITY 0
+#define LOG_DRAIN_IDLE_MS 20
+
+// Multi-producer, single-consumer ring of fixed-size lines (bounded queue
+// after Dmitry Vyukov): each slot carries a sequence number that says whose
+// turn it is, so producers on either core only contend on one atomic
+// counter and never block.
+class Logger {
+ public:
+  Logger() {
+    for (uint32_t i = 0; i < LOG_QUEUE_LINES; i++) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Queue one line ("I (12345) text"); false when the ring was full
+  bool print(uint8_t level, const char *format, ...) __attribute__((format(printf, 3, 4))) {
+    va_list args;
+    va_start(args, format);
+    bool ok = vprint(level, format, args);
+    va_end(args);
+    return ok;
+  }
+
+  bool vprint(uint8_t level, const char *format, va_list args) {
+    Slot *slot = claim();
+    if (!slot) {
+      droppedLines.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    static const char levelLetters[] = "-EWID";
+    int n = snprintf(slot->text, sizeof(slot->text), "%c (%lu) ", levelLetters[level <= WP_LOG_DEBUG ? level : 0],
+                     (unsigned long)millis());
+    if (n > 0 && n < (int)sizeof(slot->text)) {
+      int m = vsnprintf(slot->text + n, sizeof(slot->text) - n, format, args);
+      n = m < 0 ? n : n + m;
+    }
+    slot->length = n < (int)sizeof(slot->text) ? n : sizeof(slot->text) - 1;
+    publish(slot);
+    return true;
+  }
+
+  // Write out every finished line, oldest first. One task only.
+  size_t drain(Print &out) {
+    size_t lines = 0;
+    uint32_t lost = droppedLines.load(std::memory_order_relaxed);
+    if (lost != reportedDrops) {
+      out.printf("W (%lu) log: %lu lines dropped\r\n", (unsigned long)millis(), (unsigned long)(lost - reportedDrops));
+      reportedDrops = lost;
+    }
+
+    for (;;) {
+      Slot &slot = slots[dequeuePos & (LOG_QUEUE_LINES - 1)];
+      if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+        break;  // Empty, or the next line is still being written
+      }
+      out.write((const uint8_t *)slot.text, slot.length);
+      out.write((const uint8_t *)"\r\n", 2);
+      slot.sequence.store(dequeuePos + LOG_QUEUE_LINES, std::memory_order_release);
+      dequeuePos++;
+      lines++;
+    }
+    return lines;
+  }
+
+  uint32_t dropped() const { return droppedLines.load(std::memory_order_relaxed); }
+
+ private:
+  struct Slot {
+    std::atomic<uint32_t> sequence;
+    uint8_t length;
+    char text[LOG_LINE_MAX];
+  };
+
+  static_assert((LOG_QUEUE_LINES & (LOG_QUEUE_LINES - 1)) == 0, "LOG_QUEUE_LINES must be a power of two");
+  static_assert(LOG_LINE_MAX <= 255, "Slot::length is a uint8_t");
+
+  Slot *claim() {
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot &slot = slots[pos & (LOG_QUEUE_LINES - 1)];
+      int32_t diff = (int32_t)(slot.sequence.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          return &slot;
+        }
+      } else if (diff < 0) {
+        return nullptr;  // Full: the drain task is a whole ring behind
+      } else {
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // A claimed slot still holds its ticket as the sequence number
+  void publish(Slot *slot) {
+    uint32_t pos = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+  }
+
+  Slot slots[LOG_QUEUE_LINES];
+  std::atomic<uint32_t> enqueuePos{0};
+  uint32_t dequeuePos = 0;
+  std::atomic<uint32_t> droppedLines{0};
+  uint32_t reportedDrops = 0;
+};
+
+extern Logger logger;
+
+// A stripped level: sizeof keeps the call unevaluated, so no code and no
+// argument side effects, but the format is still checked against its
+// arguments and variables only logged stay "used".
+#define WP_LOG_STRIPPED(...) ((void)sizeof(logger.print(WP_LOG_NONE, __VA_ARGS__)))
+
+#if WP_LOG_LEVEL >= WP_LOG_ERROR
+#define WP_LOGE(...) logger.print(WP_LOG_ERROR, __VA_ARGS__)
+#else
+#define WP_LOGE(...) WP_LOG_STRIPPED(__VA_ARGS__)
+#endif
+#if WP_LOG_LEVEL >= WP_LOG_WARN
+#define WP_LOGW(...) logger.print(WP_LOG_WARN, __VA_ARGS__)
+#else
+#define WP_LOGW(...) WP_LOG_STRIPPED(__VA_ARGS__)
+#endif
+#if WP_LOG_LEVEL >= WP_LOG_INFO
+#define WP_LOGI(...) logger.print(WP_LOG_INFO, __VA_ARGS__)
+#else
+#define WP_LOGI(...) WP_LOG_STRIPPED(__VA_ARGS__)
+#endif
+#if WP_LOG_LEVEL >= WP_LOG_DEBUG
+#define WP_LOGD(...) logger.print(WP_LOG_DEBUG, __VA_ARGS__)
+#else
+#define WP_LOGD(...) WP_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#endif // LOG_H
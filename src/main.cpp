@@ -2,9 +2,9 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
-#include <Adafruit_NeoPixel.h>
 #include "driver/ledc.h"
 #include "esp_err.h"
+#include "esp_sleep.h"
 #include <Wire.h>
 #include <ArduinoJson.h>
 #include <time.h>
@@ -13,6 +13,28 @@
 #include <Update.h>
 #include <ESPmDNS.h>
 #include <WebSocketsClient.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "weather_cache.h"
+#include "weather_fetch.h"
+#include "api_connection.h"
+#include "weather_request.h"
+#include "json_writer.h"
+#include "route_table.h"
+#include "log.h"
+#include "web_pages.h"
+#include "config_store.h"
+#include "wifi_link.h"
+#include "sleep_snapshot.h"
+#include "touch_input.h"
+#include "scheduler.h"
+#include "led_strip.h"
+#include "led_animation.h"
+#include "melody_player.h"
+#include "weather_condition.h"
+#include "weather_event.h"
+#include "firmware_config.h"
 
 // ISRG Root X1 Certificate (Let's Encrypt, used by Railway)
 // Chain: *.up.railway.app → R13 → ISRG Root X1
@@ -64,10 +86,7 @@ emyPxgcYxn/eR44/KJ4EBs+lVDR3veyJm+kXQ99b21/+jh5Xos1AnX5iItreGCc=
 #define BLE_GPS_CONFIG_CHAR_UUID   "12345678-1234-5678-1234-56789abcdef3"
 #define BLE_STATUS_CHAR_UUID       "12345678-1234-5678-1234-56789abcdef4"
 
-// Hardware pins
-#define LED_PIN 12
-#define NUM_LEDS 12
-#define CAP_SENSOR_PIN 15
+// Hardware pins (LED_PIN and CAP_SENSOR_PIN in firmware_config.h)
 #define BUZZER_PIN 21
 #define BUZZER_CHANNEL LEDC_CHANNEL_0
 #define BUZZER_TIMER LEDC_TIMER_0
@@ -87,9 +106,11 @@ float longitude = 2.3833;
 String deviceId = "";        // Generated from MAC address
 String wifiSSID = "";
 String wifiPassword = "";
+ConfigStore configStore;  // wifiSSID, wifiPassword and location, kept in NVS
 String geoLocation = "";
-String lastWeatherCondition = "Unknown";
+WeatherCondition lastWeatherCondition = CONDITION_UNKNOWN;
 int lastTemperature = 0;
+float lastPrecipitation = 0;  // mm over the current hour
 struct tm timeinfo;
 
 // BLE globals
@@ -100,11 +121,17 @@ bool wifiConfigReceived = false;
 bool gpsConfigReceived = false;
 
 // WiFi connection status tracking
-bool wifiConnecting = false;
-int wifiAttempts = 0;
-unsigned long wifiConnectStartTime = 0;
+WiFiLink wifiLink;  // Joins, rejoins and times the station link (see wifi_link.h)
+volatile bool bleJoinRequested = false;  // Set on the BLE task, started by loop()
+bool bleJoinPending = false;  // The current join came from BLE, which expects a notification
+bool bleReleased = false;  // BLEDevice::deinit(true): BLE is gone until the next boot
+bool networkServicesStarted = false;  // mDNS, NTP and the relay, once per boot
+bool savedWiFiRetrying = false;  // Onboarding runs while the saved network is retried
+uint8_t timeSyncPolls = 0;  // Checks of the clock left before giving up on NTP
+bool relayWaitsForTime = false;  // The relay's TLS starts once NTP answered or gave up
 unsigned long apShutdownTime = 0;  // When to shut down AP after WiFi connects
 bool wifiJustConnected = false;  // Flag to send success response then shutdown
+unsigned long bootToConnectedMs = 0;  // Set on the first connection after boot
 bool successResponseSent = false;  // Track if we sent the final success response
 
 // HTTP Server (port 8080 for PWA compatibility)
@@ -114,41 +141,92 @@ WebServer server(8080);
 // WebSocket client for relay connection
 WebSocketsClient wsClient;
 bool wsConnected = false;
+bool relayMsgPack = false;    // The relay took MessagePack: frames go out binary
+WeatherEvents weatherEvents;  // Pushed to the relay (see weather_event.h)
+uint16_t relaySubscribers = 0;  // Relay clients that take the events, as the relay last said
 
-// NeoPixel
-Adafruit_NeoPixel strip = Adafruit_NeoPixel(NUM_LEDS, LED_PIN, NEO_GRB + NEO_KHZ800);
+// WS2812 ring, sent by the RMT peripheral (see led_strip.h)
+LedStrip<NUM_LEDS> strip(LED_PIN);
+LedAnimation<LedStrip<NUM_LEDS> > ledAnimation(strip);
 int weatherSymbol;
+
+// Touch pad gestures, recognised off the pin interrupt (see touch_input.h)
+TouchInput touchInput(CAP_SENSOR_PIN);
+
+// What loop() runs (see scheduler.h), in TASKS order
+enum MainTask : uint8_t {
+  TASK_NETWORK,  // HTTP server and relay socket
+  TASK_WIFI,     // Join requests, link changes, AP shutdown
+  TASK_TOUCH,    // Gestures from touchInput
+  TASK_WEATHER,  // Fetch results and refreshes
+  TASK_LED,      // Animation frames, while one runs
+  TASK_TIME,     // NTP
+  TASK_SLEEP,    // Deep sleep when idle
+  TASK_COUNT
+};
+// Task periods are in firmware_config.h
+
+// Deep sleep (see sleep_snapshot.h)
+RTC_DATA_ATTR SleepSnapshot sleepSnapshot;  // Survives deep sleep, not power loss
+unsigned long sleepAfterIdleMs = SLEEP_AFTER_IDLE_MS;  // 0: stay awake
+unsigned long lastActivityMs = 0;  // Last touch or request
 int currentTemperature;
 
 // Meteomatics API
+// One filtered entry of a "dates" array: { "date": "<ISO time>", "value": <number> },
+// the date copied out of the stream
+#define FORECAST_DATE_DOC_SIZE (JSON_OBJECT_SIZE(2) + 32)
 String apiUser = "myself_pro_card";
 String apiPass = "j4G22VmrUE";
-String apiUrlBase = "https://api.meteomatics.com/";
+ApiConnection meteomaticsApi("api.meteomatics.com");  // Used by the weather fetch task only
 
 // NTP
 const char* ntpServer = "pool.ntp.org";
 const long gmtOffset_sec = 3600;
 const int daylightOffset_sec = 3600;
 
+// Weather cache (readers serve from RAM, loop() revalidates in the background)
+WeatherCache weatherCache(WEATHER_CACHE_TTL_MS);
+bool weatherRefreshRequested = false;
+bool showWeatherWhenFetched = false;  // Touch arrived before anything was cached
+unsigned long lastWeatherRefreshAttempt = 0;
+
+// Weather fetch task (see weather_fetch.h)
+QueueHandle_t weatherFetchRequests = nullptr;
+QueueHandle_t weatherFetchResults = nullptr;
+volatile uint32_t weatherFetchGeneration = 0;  // Id of the newest request; older ones are cancelled
+WeatherFetchRequest weatherFetchPending = {};  // Valid while weatherFetchPending.id != 0
+unsigned long weatherFetchWorstLoopUs = 0;     // Longest loop() pass during the current fetch
+uint32_t weatherFetchesDone = 0;               // Fetches that ended, in success or not
+
+// Logging (see log.h); drained to Serial by the log task
+Logger logger;
+
 // Animation state
 bool animationActive = false;
 
-// Buzzer state
-static unsigned long lastToneTime = 0;
-bool isToneActive = false;
-unsigned long toneStartTime = 0;
-uint32_t toneDuration = 0;
-uint32_t toneFrequency = 0;
+// Buzzer melodies, played off the esp_timer task (see melody_player.h)
+MelodyPlayer buzzer(BUZZER_MODE, BUZZER_TIMER, BUZZER_CHANNEL);
 
 // Function declarations
 void setupBLE();
 void setupWiFiAP();
 void connectToWiFiViaBLE();
-void getWeatherForecast(int &code, int &temperature);
-void parseWeatherSymbol(JsonDocument &doc, int &code, int &temperature);
-void playToneIfNecessary(String weatherCondition);
+void startOnboarding();
+void onWiFiConnected();
+void onWiFiGaveUp();
+void webSocketEvent(WStype_t type, uint8_t * payload, size_t length);
+bool getWeatherForecast(const WeatherFetchRequest &request, ForecastStore &forecast);
+bool serveCachedWeather();
+bool weatherIsFresh();
+void startWeatherFetchTask();
+void requestWeatherFetch();
+void collectWeatherFetch();
+bool parseForecastStream(Stream &stream, uint32_t startHour, ForecastStore &forecast,
+                         const WeatherFetchRequest *request = nullptr);
+void playToneIfNecessary(WeatherCondition condition);
 void setLEDRGB(int temperature);
-void interpretWeatherSymbol(int code, int temperature);
+void interpretWeatherSymbol(int code);
 void addCORSHeaders();
 void handleCORSPreflight();
 void handleRootPage();
@@ -161,9 +239,76 @@ void handleConfigSubmission();
 void handleLocationSubmission();
 void handleOTAPage();
 void handleOTAUpdate();
-String encodeBase64(String input);
-String getCurrentISOTime();
-void playCloudyMelody();
+void registerRoutes();
+void startLogTask();
+bool loadConfig();
+void saveConfig();
+void setupOutputs();
+bool showSleepSnapshot();
+void noteActivity();
+void sleepWhenIdle();
+void handleTouch(const TouchEvent &event);
+void pollNetwork();
+void pushWeatherEvent();
+void monitorWiFi();
+void takeTouchGestures();
+void updateWeather();
+void renderLEDFrame();
+void syncTime();
+void startTimeSync();
+void startRelay();
+void handleTasksEndpoint();
+
+// ============================================================================
+// ROUTES
+// ============================================================================
+
+// Every local API endpoint, for the WebServer and the relay alike. Sorted by
+// path, then method (HTTP_GET < HTTP_POST < HTTP_OPTIONS) so the relay can
+// binary-search it. HTML pages, OTA and CORS preflights stay off the relay.
+constexpr Route ROUTES[] = {
+  { "/", HTTP_GET, handleRootPage, false },
+  { "/config", HTTP_POST, handleConfigSubmission, true },
+  { "/config", HTTP_OPTIONS, handleCORSPreflight, false },
+  { "/connection-status", HTTP_GET, handleConnectionStatus, true },
+  { "/connection-status", HTTP_OPTIONS, handleCORSPreflight, false },
+  { "/device-info", HTTP_GET, handleDeviceInfo, true },  // For AP mode onboarding
+  { "/device-info", HTTP_OPTIONS, handleCORSPreflight, false },
+  { "/health", HTTP_GET, handleHealthEndpoint, true },  // For PWA validation
+  { "/health", HTTP_OPTIONS, handleCORSPreflight, false },
+  { "/location", HTTP_POST, handleLocationSubmission, true },
+  { "/location", HTTP_OPTIONS, handleCORSPreflight, false },
+  { "/ota", HTTP_GET, handleOTAPage, false },
+  { "/otaUpdate", HTTP_POST, handleOTAUpdate, false },
+  { "/setup", HTTP_GET, handleSetupPage, false },  // For iOS fallback (avoids mixed content blocking)
+  { "/tasks", HTTP_GET, handleTasksEndpoint, true },  // Scheduler statistics
+  { "/weather", HTTP_GET, handleWeatherEndpoint, true },  // For PWA weather display
+  { "/weather", HTTP_OPTIONS, handleCORSPreflight, false },
+};
+static_assert(route_table::isSorted(ROUTES), "ROUTES must be sorted by path, then method");
+
+// ============================================================================
+// MAIN LOOP TASKS
+// ============================================================================
+
+// Periods 0: run when notified or scheduled by what starts them
+constexpr ScheduledTask TASKS[] = {
+  { "network", pollNetwork, NETWORK_POLL_MS },
+  { "wifi", monitorWiFi, WIFI_MONITOR_MS },
+  { "touch", takeTouchGestures, 0 },
+  { "weather", updateWeather, WEATHER_CHECK_MS },
+  { "led", renderLEDFrame, 0 },
+  { "time", syncTime, TIME_CHECK_MS },
+  { "sleep", sleepWhenIdle, SLEEP_CHECK_MS },
+};
+static_assert(sizeof(TASKS) / sizeof(TASKS[0]) == TASK_COUNT, "TASKS must follow MainTask");
+static_assert(TASK_COUNT <= SCHEDULER_MAX_TASKS, "Too many tasks");
+
+Scheduler scheduler(TASKS, TASK_COUNT);
+
+// Hooks for the WiFi event task and the touch interrupt
+static void wakeWiFiTask() { scheduler.notify(TASK_WIFI); }
+static void IRAM_ATTR wakeTouchTask() { scheduler.notify(TASK_TOUCH); }
 
 // ============================================================================
 // BLE CALLBACKS
@@ -183,8 +328,8 @@ class WiFiConfigCallback : public BLECharacteristicCallbacks {
         wifiSSID = doc["ssid"].as<String>();
         wifiPassword = doc["password"].as<String>();
 
-        Serial.println("WiFi credentials received via BLE:");
-        Serial.println("SSID: " + wifiSSID);
+        WP_LOGI("WiFi credentials received via BLE, SSID: %s", wifiSSID.c_str());
+        saveConfig();
         wifiConfigReceived = true;
 
         // If both WiFi and GPS received, connect
@@ -192,7 +337,7 @@ class WiFiConfigCallback : public BLECharacteristicCallbacks {
           connectToWiFiViaBLE();
         }
       } else {
-        Serial.println("Failed to parse WiFi JSON");
+        WP_LOGW("Failed to parse WiFi JSON");
       }
     }
   }
@@ -212,7 +357,8 @@ class GPSConfigCallback : public BLECharacteristicCallbacks {
         latitude = doc["lat"].as<float>();
         longitude = doc["lon"].as<float>();
 
-        Serial.printf("GPS coordinates received via BLE: %.6f, %.6f\n", latitude, longitude);
+        WP_LOGI("GPS coordinates received via BLE: %.6f, %.6f", latitude, longitude);
+        saveConfig();
         gpsConfigReceived = true;
 
         // If both WiFi and GPS received, connect
@@ -220,7 +366,7 @@ class GPSConfigCallback : public BLECharacteristicCallbacks {
           connectToWiFiViaBLE();
         }
       } else {
-        Serial.println("Failed to parse GPS JSON");
+        WP_LOGW("Failed to parse GPS JSON");
       }
     }
   }
@@ -239,7 +385,7 @@ class StatusCallback : public BLECharacteristicCallbacks {
         String action = doc["action"].as<String>();
 
         if (action == "disable_ble" && bleEnabled) {
-          Serial.println("BLE disable command received");
+          WP_LOGI("BLE disable command received");
 
           // Notify that we're disabling
           String response = "{\"status\":\"ble_disabled\",\"message\":\"Switching to HTTP only\"}";
@@ -252,7 +398,7 @@ class StatusCallback : public BLECharacteristicCallbacks {
           BLEDevice::deinit();
           bleEnabled = false;
 
-          Serial.println("BLE disabled successfully");
+          WP_LOGI("BLE disabled successfully");
         }
       }
     }
@@ -262,17 +408,17 @@ class StatusCallback : public BLECharacteristicCallbacks {
 // BLE Server Callbacks - Handle connections
 class ServerCallbacks : public BLEServerCallbacks {
   void onConnect(BLEServer* pServer) {
-    Serial.println("BLE client connected");
+    WP_LOGI("BLE client connected");
     // Don't stop advertising - allow reconnections
   }
 
   void onDisconnect(BLEServer* pServer) {
-    Serial.println("BLE client disconnected");
+    WP_LOGI("BLE client disconnected");
     // Restart advertising so other devices can connect
     if (bleEnabled) {
       delay(500); // Give some time before restarting
       BLEDevice::startAdvertising();
-      Serial.println("BLE advertising restarted");
+      WP_LOGD("BLE advertising restarted");
     }
   }
 };
@@ -282,11 +428,9 @@ class ServerCallbacks : public BLEServerCallbacks {
 // ============================================================================
 
 void setupBLE() {
-  Serial.println("Initializing BLE...");
-
   // Create BLE device name: "Potato-{DEVICEID}"
   String bleName = "Potato-" + deviceId;
-  Serial.println("BLE Device Name: " + bleName);
+  WP_LOGI("Initializing BLE as %s", bleName.c_str());
 
   // Initialize BLE
   BLEDevice::init(bleName.c_str());
@@ -345,7 +489,7 @@ void setupBLE() {
   pAdvertising->start();
 
   bleEnabled = true;
-  Serial.println("BLE advertising started");
+  WP_LOGI("BLE advertising started");
 }
 
 // ============================================================================
@@ -353,8 +497,7 @@ void setupBLE() {
 // ============================================================================
 
 void setupWiFiAP() {
-  Serial.println("========================================");
-  Serial.println("🌐 Setting up Access Point...");
+  WP_LOGI("🌐 Setting up Access Point...");
 
   // Configure AP network parameters explicitly
   IPAddress local_ip(192, 168, 4, 1);
@@ -369,29 +512,18 @@ void setupWiFiAP() {
 
   if (apStarted) {
     IPAddress ip = WiFi.softAPIP();
-    Serial.println("✅ Access Point started successfully!");
-    Serial.print("   SSID: ");
-    Serial.println(apSSID);
-    Serial.print("   Password: ");
-    Serial.println(apPassword);
-    Serial.print("   IP Address: ");
-    Serial.println(ip);
-    Serial.print("   Gateway: ");
-    Serial.println(gateway);
-    Serial.print("   Subnet: ");
-    Serial.println(subnet);
-    Serial.print("   Clients can connect and access: http://");
-    Serial.print(ip);
-    Serial.println(":8080");
-    Serial.println("========================================");
+    WP_LOGI("✅ Access Point \"%s\" started: http://%u.%u.%u.%u:8080", apSSID, ip[0], ip[1], ip[2], ip[3]);
+    WP_LOGD("   Password: %s, gateway %u.%u.%u.%u, subnet %u.%u.%u.%u", apPassword,
+            gateway[0], gateway[1], gateway[2], gateway[3], subnet[0], subnet[1], subnet[2], subnet[3]);
   } else {
-    Serial.println("❌ Access Point failed to start!");
-    Serial.println("========================================");
+    WP_LOGE("❌ Access Point failed to start!");
   }
 }
 
+// Called on the BLE task: the join itself is started by loop(), which owns
+// wifiLink, and the outcome is notified from onWiFiConnected()/onWiFiGaveUp()
 void connectToWiFiViaBLE() {
-  Serial.println("Connecting to WiFi via BLE credentials...");
+  WP_LOGI("Connecting to WiFi via BLE credentials...");
 
   // Notify: Starting connection
   if (bleEnabled && statusCharacteristic) {
@@ -400,54 +532,50 @@ void connectToWiFiViaBLE() {
     statusCharacteristic->notify();
   }
 
-  WiFi.begin(wifiSSID.c_str(), wifiPassword.c_str());
+  bleJoinRequested = true;
+  scheduler.notify(TASK_WIFI);
+}
 
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 60) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
+// BLE and the soft AP, for a device without a (working) saved network.
+// Whatever is already up is left alone.
+void startOnboarding() {
+  if (!bleEnabled && !bleReleased) {
+    WP_LOGI("No WiFi connection. Starting BLE for onboarding...");
+    setupBLE();
   }
-  Serial.println();
 
-  if (WiFi.status() == WL_CONNECTED) {
-    IPAddress ip = WiFi.localIP();
-    Serial.println("WiFi connected!");
-    Serial.print("IP address: ");
-    Serial.println(ip);
-
-    // Setup mDNS
-    if (MDNS.begin("weatherpotato")) {
-      Serial.println("mDNS responder started: weatherpotato.local");
-      MDNS.addService("http", "tcp", 8080);
-    } else {
-      Serial.println("Error setting up mDNS");
-    }
+  // Also start AP mode as backup
+  if (WiFi.softAPIP() == IPAddress()) {
+    setupWiFiAP();
+    WP_LOGI("✅ Setup page (AP mode): http://192.168.4.1:8080/setup");
+  }
+}
 
-    // Setup HTTP server endpoints
-    server.on("/", HTTP_GET, handleRootPage);
-    server.on("/setup", HTTP_GET, handleSetupPage);  // For iOS fallback (avoids mixed content blocking)
-    server.on("/device-info", HTTP_GET, handleDeviceInfo);  // For AP mode onboarding
-    server.on("/connection-status", HTTP_GET, handleConnectionStatus);
-    server.on("/health", HTTP_GET, handleHealthEndpoint);  // For PWA validation
-    server.on("/weather", HTTP_GET, handleWeatherEndpoint);  // For PWA weather display
-    server.on("/config", HTTP_POST, handleConfigSubmission);
-    server.on("/location", HTTP_POST, handleLocationSubmission);
-    server.on("/ota", HTTP_GET, handleOTAPage);
-    server.on("/otaUpdate", HTTP_POST, handleOTAUpdate);
-
-    // Handle CORS preflight requests
-    server.on("/device-info", HTTP_OPTIONS, handleCORSPreflight);
-    server.on("/connection-status", HTTP_OPTIONS, handleCORSPreflight);
-    server.on("/health", HTTP_OPTIONS, handleCORSPreflight);
-    server.on("/weather", HTTP_OPTIONS, handleCORSPreflight);
-    server.on("/config", HTTP_OPTIONS, handleCORSPreflight);
-    server.on("/location", HTTP_OPTIONS, handleCORSPreflight);
-
-    server.begin();
-    Serial.println("HTTP server started on port 8080 with CORS enabled");
-
-    // Notify success via BLE
+// The link came up, for the first time or again. Network services start on
+// the first connection; whoever asked for the join hears about it.
+void onWiFiConnected() {
+  IPAddress ip = WiFi.localIP();
+  IPAddress gateway = WiFi.gatewayIP();
+  WP_LOGI("✅ WiFi Connected! SSID: %s", WiFi.SSID().c_str());
+  WP_LOGI("   IP: %u.%u.%u.%u, gateway: %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3],
+          gateway[0], gateway[1], gateway[2], gateway[3]);
+
+  if (bootToConnectedMs == 0) {
+    bootToConnectedMs = millis();
+    WP_LOGI("Connected %lu ms after boot", bootToConnectedMs);
+  }
+  wifiJustConnected = true;  // Flag for next status poll
+  if (savedWiFiRetrying) {
+    // Back on the saved network: nobody is using the setup AP
+    savedWiFiRetrying = false;
+    WiFi.softAPdisconnect(true);
+    WP_LOGI("🔌 Saved network is back, Access Point shut down");
+  }
+  scheduler.notify(TASK_WEATHER);  // A refresh may have waited for the link
+
+  if (bleJoinPending) {
+    // BLE stays up: the app sends disable_ble once it has read this
+    bleJoinPending = false;
     if (bleEnabled && statusCharacteristic) {
       String successJson = "{";
       successJson += "\"status\":\"wifi_connected\",";
@@ -460,15 +588,59 @@ void connectToWiFiViaBLE() {
       statusCharacteristic->setValue(successJson.c_str());
       statusCharacteristic->notify();
 
-      Serial.println("Sent WiFi success notification via BLE");
+      WP_LOGD("Sent WiFi success notification via BLE");
     }
+  } else if (bleEnabled) {
+    // Free BLE memory now that WiFi is connected (BLE uses ~50KB RAM, needed for SSL)
+    BLEDevice::deinit(true);
+    bleEnabled = false;
+    bleReleased = true;
+    WP_LOGD("Free heap after BLE shutdown: %d bytes", ESP.getFreeHeap());
+  }
 
-    // Initialize time
-    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
+  if (networkServicesStarted) {
+    return;  // A rejoin: mDNS, the server and the relay carry on
+  }
+  networkServicesStarted = true;
 
+  // Setup mDNS
+  if (MDNS.begin("weatherpotato")) {
+    WP_LOGI("✅ mDNS started: weatherpotato.local");
+    MDNS.addService("http", "tcp", 8080);
   } else {
-    Serial.println("WiFi connection failed");
+    WP_LOGW("⚠️  mDNS failed to start");
+  }
+
+  // CRITICAL: Restart HTTP server for WiFi interface
+  // The server was bound to AP interface (192.168.4.1)
+  // Now we need to rebind to the new WiFi IP
+  server.close();  // Stop the server, its handlers stay registered
+  server.begin();  // Restart server on WiFi interface
+  WP_LOGI("✅ HTTP server restarted: http://%u.%u.%u.%u:8080", ip[0], ip[1], ip[2], ip[3]);
+
+  // Configure NTP for time sync (must happen before SSL connections): the
+  // time task polls for the answer and then starts the relay
+  relayWaitsForTime = true;
+  startTimeSync();
+}
+
+// Initialize WebSocket relay connection (WSS with Let's Encrypt CA cert)
+void startRelay() {
+  WP_LOGD("[WS] Free heap before SSL: %d bytes", ESP.getFreeHeap());
+  wsClient.beginSslWithCA("weather-potato-production.up.railway.app", 443, "/", isrg_root_x1_ca);
+  wsClient.setReconnectInterval(5000);
+  wsClient.onEvent(webSocketEvent);
+  WP_LOGI("🎉 SETUP COMPLETE - Ready for requests!");
+}
+
+// The join timed out. A saved network that is gone sends the device back
+// to onboarding; wifiLink keeps retrying it meanwhile, in case it was only
+// down (router rebooting after a power cut).
+void onWiFiGaveUp() {
+  WP_LOGE("❌ WiFi Connection Failed: timeout after %lu seconds", (unsigned long)(wifiLink.elapsedMs() / 1000));
 
+  if (bleJoinPending) {
+    bleJoinPending = false;
     // Notify failure via BLE
     if (bleEnabled && statusCharacteristic) {
       String failJson = "{\"status\":\"wifi_failed\",\"message\":\"Connection timeout or invalid credentials\"}";
@@ -476,18 +648,164 @@ void connectToWiFiViaBLE() {
       statusCharacteristic->notify();
     }
   }
+  savedWiFiRetrying = wifiLink.state() == WIFI_LINK_CONNECTING;
+  startOnboarding();
 }
 
 // ============================================================================
 // HTTP ENDPOINTS
 // ============================================================================
 
+// A request arriving over the WebSocket relay rather than the WebServer: the
+// handler reads `body` instead of server.arg("plain"), and JsonResponse
+// writes its reply straight into `reply`, a slot in the outgoing relay frame.
+struct RelayExchange {
+  const char *body;
+  int status;
+  char *reply;
+  size_t replySize;
+  size_t replyLength;  // 0 until a complete reply was sent
+  bool msgpack;        // Reply in MessagePack rather than JSON
+};
+
+static RelayExchange *relayExchange = nullptr;  // Set while a relayed request runs
+
+void registerRoutes() {
+  static const char *headerKeys[] = {
+    "If-None-Match",  // Conditional GETs of static pages
+    "Accept",         // application/msgpack for the JSON endpoints
+  };
+  server.collectHeaders(headerKeys, 2);
+  for (const Route &route : ROUTES) {
+    const Route *r = &route;
+    server.on(route.path, route.method, [r]() {
+      noteActivity();
+      r->handler();
+    });
+  }
+}
+
+// Body of the request being handled, from either transport
+String requestBody() {
+  return relayExchange ? String(relayExchange->body) : server.arg("plain");
+}
+
+// One line per request: the endpoint and who asked for it
+void logRequest(const char *path) {
+  if (relayExchange) {
+    WP_LOGI("📡 %s via relay", path);
+    return;
+  }
+  IPAddress ip = server.client().remoteIP();
+  WP_LOGI("📡 %s from %u.%u.%u.%u", path, ip[0], ip[1], ip[2], ip[3]);
+}
+
 // Helper: Add CORS headers to allow HTTPS PWA access
+// (built once: sendHeader() takes Strings, and temporaries would allocate on every request)
 void addCORSHeaders() {
-  server.sendHeader("Access-Control-Allow-Origin", "*");
-  server.sendHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-  server.sendHeader("Access-Control-Allow-Headers", "Content-Type, Access-Control-Request-Private-Network");
-  server.sendHeader("Access-Control-Allow-Private-Network", "true");  // Enable Private Network Access for HTTPS→HTTP
+  if (relayExchange) {
+    return;  // Not HTTP: nothing to add them to
+  }
+  static const String headers[][2] = {
+    { "Access-Control-Allow-Origin", "*" },
+    { "Access-Control-Allow-Methods", "GET, POST, OPTIONS" },
+    { "Access-Control-Allow-Headers", "Content-Type, Access-Control-Request-Private-Network" },
+    { "Access-Control-Allow-Private-Network", "true" },  // Enable Private Network Access for HTTPS→HTTP
+  };
+  for (const auto &header : headers) {
+    server.sendHeader(header[0], header[1]);
+  }
+}
+
+// JSON reply for the local API, written into a fixed buffer instead of a
+// String. A document that fits goes out in one write with its Content-Length;
+// one that outgrows the buffer switches to chunked transfer as it fills.
+// Relayed requests write into relayExchange->reply instead, in place in the
+// relay frame; a reply too big for it is dropped.
+//
+// Clients sending Accept: application/msgpack, and a relay that took
+// MessagePack, get the same document in MessagePack. It is not streamed (see
+// JsonWriter), so it has to fit the buffer: a third smaller than the JSON,
+// every reply here does. The buffer is JSON_RESPONSE_BUFFER bytes
+// (firmware_config.h).
+
+// Longest request body passed on to a handler from a relay message
+#define RELAY_BODY_MAX 512
+
+// Holds JsonResponse's HTTP buffer; a base class so it exists before the
+// JsonWriter that is pointed at it
+struct JsonResponseBuffer {
+  char storage[JSON_RESPONSE_BUFFER];
+};
+
+class JsonResponse : private JsonResponseBuffer, public JsonWriter {
+ public:
+  explicit JsonResponse(int code = 200)
+      : JsonWriter(relayExchange ? relayExchange->reply : storage,
+                   relayExchange ? relayExchange->replySize : sizeof(storage)),
+        code(code) {
+    if (relayExchange ? relayExchange->msgpack : acceptsMsgPack()) {
+      useMsgPack();
+    } else if (!relayExchange) {
+      onFlush(sendChunk, this);
+    }
+  }
+
+  // Send whatever is still buffered and finish the response
+  void send() {
+    if (isMsgPack()) {
+      WP_LOGD("   -> %d (%u bytes of MessagePack)", code, (unsigned)length());
+    } else {
+      WP_LOGD("   -> %d %s", code, c_str());
+    }
+    if (relayExchange) {
+      relayExchange->status = code;
+      relayExchange->replyLength = ok() ? length() : 0;
+      return;
+    }
+    if (isMsgPack()) {
+      if (ok()) {
+        server.send_P(code, "application/msgpack", c_str(), bufferedLength());
+      } else {
+        server.send(500, "text/plain", "Reply too large for MessagePack");
+      }
+      return;
+    }
+    if (!chunked) {
+      server.send_P(code, "application/json", c_str(), bufferedLength());
+      return;
+    }
+    server.sendContent(c_str(), bufferedLength());
+    server.sendContent("");  // Last chunk
+  }
+
+ private:
+  static void sendChunk(void *context, const char *data, size_t length) {
+    JsonResponse *self = (JsonResponse *)context;
+    if (!self->chunked) {
+      server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+      server.send(self->code, "application/json", "");
+      self->chunked = true;
+    }
+    server.sendContent(data, length);
+  }
+
+  static bool acceptsMsgPack() {
+    return server.hasHeader("Accept") && strstr(server.header("Accept").c_str(), "application/msgpack");
+  }
+
+  int code;
+  bool chunked = false;
+};
+
+// {"success":false,"error":"<message>"}
+void sendJsonError(int code, const char *message) {
+  JsonResponse json(code);
+  json.beginObject();
+  json.key("success").value(false);
+  json.key("error").value(message);
+  json.endObject();
+  json.send();
 }
 
 // Handle CORS preflight requests
@@ -498,433 +816,144 @@ void handleCORSPreflight() {
 
 // Health endpoint for PWA validation
 void handleHealthEndpoint() {
-  Serial.println("========================================");
-  Serial.println("📡 INCOMING REQUEST: /health");
-  Serial.print("   Client IP: ");
-  Serial.println(server.client().remoteIP());
-  Serial.print("   WiFi Status: ");
-  Serial.println(WiFi.status() == WL_CONNECTED ? "CONNECTED" : "NOT CONNECTED");
-  Serial.print("   Local IP: ");
-  Serial.println(WiFi.localIP());
+  logRequest("/health");
 
   addCORSHeaders();  // Add CORS for HTTPS PWA access
 
-  String response = "{";
-  response += "\"device_id\":\"" + deviceId + "\",";
-  response += "\"status\":\"ready\",";
-  response += "\"firmware_version\":\"1.0.0\",";
-  response += "\"local_ip\":\"" + WiFi.localIP().toString() + "\"";
-  response += "}";
-
-  Serial.print("   Response: ");
-  Serial.println(response);
-
-  server.send(200, "application/json", response);
-  Serial.println("✅ /health responded with 200 OK");
-  Serial.println("========================================");
+  JsonResponse json;
+  json.beginObject();
+  json.key("device_id").value(deviceId);
+  json.key("status").value("ready");
+  json.key("firmware_version").value("1.0.0");
+  json.key("local_ip").value(WiFi.localIP());
+  json.endObject();
+  json.send();
 }
 
 // Weather endpoint for PWA display
 void handleWeatherEndpoint() {
-  Serial.println("========================================");
-  Serial.println("📡 INCOMING REQUEST: /weather");
-  Serial.print("   Method: ");
-  Serial.println(server.method() == HTTP_GET ? "GET" : "OTHER");
-  Serial.print("   Client IP: ");
-  Serial.println(server.client().remoteIP());
-  Serial.print("   WiFi Status: ");
-  Serial.println(WiFi.status() == WL_CONNECTED ? "CONNECTED" : "NOT CONNECTED");
-  Serial.print("   Local IP: ");
-  Serial.println(WiFi.localIP());
+  logRequest("/weather");
 
   addCORSHeaders();  // Add CORS for HTTPS PWA access
+  serveCachedWeather();
+
+  JsonResponse json;
+  json.beginObject();
+  json.key("device_id").value(deviceId);
+  json.key("condition").value(conditionName(lastWeatherCondition));
+  json.key("temperature").value(lastTemperature);
+  json.key("precipitation").value(lastPrecipitation, 2);
+  json.key("symbol").value(weatherSymbol);
+  json.key("location").beginObject();
+  json.key("latitude").value(latitude, 4);
+  json.key("longitude").value(longitude, 4);
+  json.endObject();
+  json.key("timestamp").value(millis());
+  json.endObject();
+  json.send();
+}
 
-  String response = "{";
-  response += "\"device_id\":\"" + deviceId + "\",";
-  response += "\"condition\":\"" + lastWeatherCondition + "\",";
-  response += "\"temperature\":" + String(lastTemperature) + ",";
-  response += "\"symbol\":" + String(weatherSymbol) + ",";
-  response += "\"location\":{";
-  response += "\"latitude\":" + String(latitude, 4) + ",";
-  response += "\"longitude\":" + String(longitude, 4);
-  response += "},";
-  response += "\"timestamp\":" + String(millis());
-  response += "}";
-
-  Serial.print("   Response: ");
-  Serial.println(response);
-
-  server.send(200, "application/json", response);
-  Serial.println("✅ /weather responded with 200 OK");
-  Serial.println("========================================");
+// Values for the %NAME% fields of web/index.tmpl.html
+static void rootPageField(const char *name, Print &out) {
+  if (strcmp(name, "DEVICEID") == 0) {
+    out.print(deviceId);
+  } else if (strcmp(name, "WEATHER") == 0) {
+    out.print(conditionName(lastWeatherCondition));
+  } else if (strcmp(name, "TEMP") == 0) {
+    out.print(lastTemperature);
+  } else if (strcmp(name, "IP") == 0) {
+    out.print(WiFi.localIP());
+  }
 }
 
+// Status page, streamed from the pre-split template in flash
 void handleRootPage() {
-  String html = R"rawliteral(
-    <!DOCTYPE html>
-    <html>
-    <head>
-      <title>Weather Potato Config</title>
-      <meta name="viewport" content="width=device-width, initial-scale=1">
-      <style>
-        body { font-family: Arial, sans-serif; margin: 20px; }
-        h1 { color: #FF6B6B; }
-        input[type=text] { width: 100%; padding: 8px; margin: 8px 0; }
-        input[type=submit] { background: #4ECDC4; color: white; padding: 10px 20px; border: none; cursor: pointer; }
-      </style>
-    </head>
-    <body>
-      <h1>🥔 Weather Potato Configuration</h1>
-      <form action="/location" method="POST">
-        <label for="latitude">Latitude:</label><br>
-        <input type="text" id="latitude" name="latitude" value="" placeholder="48.9075"><br><br>
-        <label for="longitude">Longitude:</label><br>
-        <input type="text" id="longitude" name="longitude" value="" placeholder="2.3833"><br><br>
-        <input type="submit" value="Update Location">
-      </form>
-      <hr>
-      <h2>Current Status</h2>
-      <p><b>Device ID:</b> %DEVICEID%</p>
-      <p><b>Weather:</b> %WEATHER%</p>
-      <p><b>Temperature:</b> %TEMP%°C</p>
-      <p><b>Local IP:</b> %IP%</p>
-      <p><b>mDNS:</b> weatherpotato.local:8080</p>
-      <hr>
-      <h2>OTA Update</h2>
-      <p><a href="/ota">Click here to update firmware</a></p>
-    </body>
-    </html>
-  )rawliteral";
-
-  html.replace("%DEVICEID%", deviceId);
-  html.replace("%WEATHER%", lastWeatherCondition);
-  html.replace("%TEMP%", String(lastTemperature));
-  html.replace("%IP%", WiFi.localIP().toString());
-
-  server.send(200, "text/html", html);
-}
-
-// Setup page for iOS fallback (HTTP page to avoid mixed content blocking)
-void handleSetupPage() {
-  Serial.println("========================================");
-  Serial.println("📡 INCOMING REQUEST: /setup");
-  Serial.print("   Client IP: ");
-  Serial.println(server.client().remoteIP());
-  Serial.print("   Query string: ");
-  Serial.println(server.uri());
-  String html = R"rawliteral(
-<!DOCTYPE html>
-<html>
-<head>
-  <meta charset="UTF-8">
-  <meta name="viewport" content="width=device-width, initial-scale=1.0">
-  <title>Weather Potato Setup</title>
-  <style>
-    * { margin: 0; padding: 0; box-sizing: border-box; }
-    body {
-      font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', sans-serif;
-      background: linear-gradient(135deg, #667eea 0%, #764ba2 100%);
-      min-height: 100vh;
-      display: flex;
-      align-items: center;
-      justify-content: center;
-      padding: 20px;
-    }
-    .container {
-      background: white;
-      border-radius: 20px;
-      padding: 30px;
-      max-width: 500px;
-      width: 100%;
-      box-shadow: 0 20px 60px rgba(0,0,0,0.3);
-    }
-    h1 { text-align: center; margin-bottom: 10px; color: #333; }
-    .potato { text-align: center; font-size: 60px; margin-bottom: 20px; }
-    .form-group { margin-bottom: 20px; }
-    label { display: block; font-weight: 600; margin-bottom: 5px; color: #555; }
-    input { width: 100%; padding: 12px; border: 2px solid #ddd; border-radius: 10px; font-size: 16px; }
-    input:focus { outline: none; border-color: #667eea; }
-    button {
-      width: 100%;
-      padding: 15px;
-      background: linear-gradient(135deg, #667eea, #764ba2);
-      color: white;
-      border: none;
-      border-radius: 10px;
-      font-size: 18px;
-      font-weight: 600;
-      cursor: pointer;
-      transition: transform 0.2s;
-    }
-    button:hover { transform: scale(1.02); }
-    button:disabled { opacity: 0.6; cursor: not-allowed; }
-    .message {
-      padding: 15px;
-      border-radius: 10px;
-      margin-bottom: 20px;
-      display: none;
-    }
-    .success { background: #d4edda; color: #155724; display: block; }
-    .error { background: #f8d7da; color: #721c24; display: block; }
-    .info { background: #d1ecf1; color: #0c5460; }
-    small { color: #888; font-size: 12px; }
-  </style>
-</head>
-<body>
-  <div class="container">
-    <div class="potato">🥔</div>
-    <h1>Weather Potato Setup</h1>
-    <p style="text-align: center; color: #666; margin-bottom: 30px;">Configure your device</p>
-
-    <div id="message" class="message"></div>
-
-    <form id="configForm">
-      <div class="form-group">
-        <label>WiFi Network (SSID)</label>
-        <input type="text" id="ssid" required>
-      </div>
-
-      <div class="form-group">
-        <label>WiFi Password</label>
-        <input type="password" id="password" required>
-        <small>Your home WiFi password</small>
-      </div>
-
-      <div class="form-group">
-        <label>Latitude</label>
-        <input type="text" id="latitude" pattern="-?[0-9]+\.?[0-9]*" required placeholder="48.888590">
-        <small>Full precision (e.g., 48.888590317034)</small>
-      </div>
-
-      <div class="form-group">
-        <label>Longitude</label>
-        <input type="text" id="longitude" pattern="-?[0-9]+\.?[0-9]*" required placeholder="2.381029">
-        <small>Full precision (e.g., 2.381029489226)</small>
-      </div>
-
-      <button type="submit" id="submitBtn">Send Configuration</button>
-    </form>
-  </div>
-
-  <script>
-    // Auto-fill from URL parameters or localStorage
-    const params = new URLSearchParams(window.location.search);
-    const stored = localStorage.getItem('weatherPotato_pendingConfig');
-
-    if (params.has('ssid')) {
-      document.getElementById('ssid').value = params.get('ssid') || '';
-      document.getElementById('password').value = params.get('password') || '';
-      document.getElementById('latitude').value = params.get('lat') || '';
-      document.getElementById('longitude').value = params.get('lon') || '';
-    } else if (stored) {
-      try {
-        const data = JSON.parse(stored);
-        document.getElementById('ssid').value = data.ssid || '';
-        document.getElementById('password').value = data.password || '';
-        document.getElementById('latitude').value = data.latitude || '';
-        document.getElementById('longitude').value = data.longitude || '';
-      } catch (e) {}
-    }
-
-    // Poll connection status
-    let pollInterval = null;
-    function checkConnectionStatus() {
-      fetch('/connection-status')
-        .then(r => r.json())
-        .then(data => {
-          const message = document.getElementById('message');
-
-          if (data.connected) {
-            clearInterval(pollInterval);
-            message.className = 'message success';
-            message.innerHTML = `
-              ✅ <strong>Connected to WiFi!</strong><br>
-              Network: ${data.ssid}<br>
-              IP: ${data.ip}<br><br>
-              <strong>Success!</strong> Reconnect to "${data.ssid}" WiFi and open the PWA!<br><br>
-              <small>Redirecting in 3 seconds...</small>
-            `;
-
-            // Get device ID and redirect to PWA
-            fetch('/device-info')
-              .then(r => r.json())
-              .then(info => {
-                const deviceId = info.device_id || 'unknown';
-
-                // Redirect to PWA onboarding complete page with device info
-                setTimeout(() => {
-                  const redirectUrl = new URL('https://weather-potato-vercel-127v.vercel.app/onboarding-complete');
-                  redirectUrl.searchParams.set('deviceId', deviceId);
-                  redirectUrl.searchParams.set('ssid', data.ssid);
-                  redirectUrl.searchParams.set('ip', data.ip);
-                  window.location.href = redirectUrl.toString();
-                }, 3000);
-              })
-              .catch(() => {
-                // Fallback: redirect to dashboard without device ID
-                setTimeout(() => {
-                  window.location.href = 'https://weather-potato-vercel-127v.vercel.app/dashboard';
-                }, 3000);
-              });
-          } else if (data.status === 'connecting') {
-            message.className = 'message info';
-            message.innerHTML = `🔄 Connecting to ${data.ssid}... (${data.attempt}/30)`;
-            message.style.display = 'block';
-          } else if (data.status === 'failed') {
-            clearInterval(pollInterval);
-            message.className = 'message error';
-            message.innerHTML = `❌ Failed to connect to WiFi.<br>Please check your password and try again.`;
-            document.getElementById('submitBtn').disabled = false;
-            document.getElementById('submitBtn').textContent = 'Send Configuration';
-          }
-        })
-        .catch(err => {
-          // If we can't reach the ESP32, it might have shut down AP (success!)
-          console.log('Connection status check failed (AP might be off):', err);
-        });
-    }
-
-    document.getElementById('configForm').addEventListener('submit', async (e) => {
-      e.preventDefault();
-
-      const submitBtn = document.getElementById('submitBtn');
-      const message = document.getElementById('message');
-
-      submitBtn.disabled = true;
-      submitBtn.textContent = 'Sending...';
-      message.className = 'message';
-      message.style.display = 'none';
-
-      const config = {
-        ssid: document.getElementById('ssid').value,
-        password: document.getElementById('password').value,
-        latitude: parseFloat(document.getElementById('latitude').value),
-        longitude: parseFloat(document.getElementById('longitude').value)
-      };
-
-      try {
-        const response = await fetch('/config', {
-          method: 'POST',
-          headers: { 'Content-Type': 'application/json' },
-          body: JSON.stringify(config)
-        });
-
-        if (response.ok) {
-          message.className = 'message info';
-          message.textContent = '✅ Configuration sent! Connecting to WiFi...';
-          message.style.display = 'block';
-          localStorage.removeItem('weatherPotato_pendingConfig');
-
-          // Start polling connection status
-          pollInterval = setInterval(checkConnectionStatus, 2000);
-          setTimeout(checkConnectionStatus, 500); // Check immediately
-        } else {
-          throw new Error('HTTP ' + response.status);
-        }
-      } catch (error) {
-        message.className = 'message error';
-        message.textContent = '❌ Failed to send configuration: ' + error.message;
-        message.style.display = 'block';
-        submitBtn.disabled = false;
-        submitBtn.textContent = 'Send Configuration';
-      }
-    });
-  </script>
-</body>
-</html>
-)rawliteral";
+  serveCachedWeather();
+  sendPageTemplate(server, INDEX_HTML, rootPageField);
+}
 
-  server.send(200, "text/html", html);
-  Serial.println("✅ /setup responded with HTML page");
-  Serial.println("========================================");
+// Setup page for iOS fallback (HTTP page to avoid mixed content blocking).
+// Lives in web/setup.html; served gzipped from flash.
+void handleSetupPage() {
+  logRequest("/setup");
+  serveStaticPage(server, SETUP_HTML);
 }
 
 // Device info endpoint for AP mode onboarding
 void handleDeviceInfo() {
-  Serial.println("========================================");
-  Serial.println("📡 INCOMING REQUEST: /device-info");
-  Serial.print("   Method: ");
-  Serial.println(server.method() == HTTP_GET ? "GET" : "OTHER");
-  Serial.print("   Client IP: ");
-  Serial.println(server.client().remoteIP());
-  Serial.print("   Headers: ");
-  Serial.println(server.headers());
+  logRequest("/device-info");
 
   addCORSHeaders();  // Add CORS for PWA access
 
-  String response = "{";
-  response += "\"device_id\":\"" + deviceId + "\",";
-  response += "\"mac_address\":\"" + WiFi.macAddress() + "\",";
-  response += "\"firmware_version\":\"1.0.0\",";
-  response += "\"ap_ssid\":\"" + String(apSSID) + "\",";
-  response += "\"ap_ip\":\"" + WiFi.softAPIP().toString() + "\",";
-  response += "\"mode\":\"AP\"";
-  response += "}";
-
-  Serial.print("   Response: ");
-  Serial.println(response);
-
-  server.send(200, "application/json", response);
-  Serial.println("✅ /device-info responded with 200 OK");
-  Serial.println("========================================");
+  uint8_t mac[6];
+  char macAddress[18];
+  WiFi.macAddress(mac);
+  snprintf(macAddress, sizeof(macAddress), "%02X:%02X:%02X:%02X:%02X:%02X",
+           mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+  JsonResponse json;
+  json.beginObject();
+  json.key("device_id").value(deviceId);
+  json.key("mac_address").value(macAddress);
+  json.key("firmware_version").value("1.0.0");
+  json.key("ap_ssid").value(apSSID);
+  json.key("ap_ip").value(WiFi.softAPIP());
+  json.key("mode").value("AP");
+  json.endObject();
+  json.send();
 }
 
 // Connection status endpoint for setup page polling
 void handleConnectionStatus() {
-  Serial.println("[Status] Connection status requested");
+  WP_LOGD("[Status] Connection status requested");
 
   addCORSHeaders();
 
-  String response = "{";
+  JsonResponse json;
+  json.beginObject();
 
   if (WiFi.status() == WL_CONNECTED) {
-    response += "\"connected\":true,";
-    response += "\"status\":\"connected\",";
-    response += "\"ssid\":\"" + WiFi.SSID() + "\",";
-    response += "\"ip\":\"" + WiFi.localIP().toString() + "\"";
+    json.key("connected").value(true);
+    json.key("status").value("connected");
+    json.key("ssid").value(WiFi.SSID());
+    json.key("ip").value(WiFi.localIP());
 
     // Mark that we sent the success response
     if (wifiJustConnected && !successResponseSent) {
       successResponseSent = true;
-      Serial.println("[Status] Success response sent - AP will shutdown in 5 seconds");
+      WP_LOGI("[Status] Success response sent - AP will shutdown in 5 seconds");
       apShutdownTime = millis() + 5000;  // Shutdown AP in 5 seconds
     }
-  } else if (wifiConnecting) {
-    response += "\"connected\":false,";
-    response += "\"status\":\"connecting\",";
-    response += "\"ssid\":\"" + wifiSSID + "\",";
-    response += "\"attempt\":" + String(wifiAttempts);
+  } else if (wifiLink.state() == WIFI_LINK_CONNECTING) {
+    json.key("connected").value(false);
+    json.key("status").value("connecting");
+    json.key("ssid").value(wifiSSID);
+    json.key("attempt").value(wifiLink.elapsedMs() / 1000);  // Seconds, shown by the setup page
+  } else if (wifiLink.state() == WIFI_LINK_FAILED) {
+    json.key("connected").value(false);
+    json.key("status").value("failed");
   } else {
-    response += "\"connected\":false,";
-    response += "\"status\":\"idle\"";
+    json.key("connected").value(false);
+    json.key("status").value("idle");
   }
 
-  response += "}";
-
-  server.send(200, "application/json", response);
-  Serial.println("[Status] Sent: " + response);
+  json.endObject();
+  json.send();
 }
 
 void handleConfigSubmission() {
-  Serial.println("========================================");
-  Serial.println("📡 INCOMING REQUEST: /config");
-  Serial.print("   Method: POST | Client IP: ");
-  Serial.println(server.client().remoteIP());
-
+  logRequest("/config");
   addCORSHeaders();  // Add CORS for PWA access
 
   // Parse JSON body
-  String body = server.arg("plain");
-  Serial.print("   Request body: ");
-  Serial.println(body);
+  String body = requestBody();
 
   StaticJsonDocument<300> doc;
   DeserializationError error = deserializeJson(doc, body);
 
   if (error) {
-    Serial.printf("JSON parse error: %s\n", error.c_str());
-    String response = "{\"success\":false,\"error\":\"Invalid JSON\"}";
-    server.send(400, "application/json", response);
+    WP_LOGW("JSON parse error: %s", error.c_str());
+    sendJsonError(400, "Invalid JSON");
     return;
   }
 
@@ -933,61 +962,50 @@ void handleConfigSubmission() {
     wifiSSID = doc["ssid"].as<String>();
     wifiPassword = doc["password"].as<String>();
 
-    Serial.println("WiFi credentials updated via HTTP/AP");
-    Serial.println("SSID: " + wifiSSID);
+    WP_LOGI("WiFi credentials updated via HTTP/AP, SSID: %s", wifiSSID.c_str());
 
     // Optional: Extract GPS coordinates if provided
     if (doc.containsKey("latitude") && doc.containsKey("longitude")) {
       latitude = doc["latitude"].as<float>();
       longitude = doc["longitude"].as<float>();
-      Serial.printf("GPS coordinates also received: %.6f, %.6f\n", latitude, longitude);
+      WP_LOGI("GPS coordinates also received: %.6f, %.6f", latitude, longitude);
     }
+    saveConfig();
 
     // Send success response
-    String response = "{";
-    response += "\"success\":true,";
-    response += "\"message\":\"Connecting to WiFi...\",";
-    response += "\"ssid\":\"" + wifiSSID + "\"";
-    response += "}";
-
-    Serial.print("   ✅ Sending response: ");
-    Serial.println(response);
-
-    server.send(200, "application/json", response);
-
-    Serial.println("✅ /config responded with 200 OK");
-    Serial.println("🔌 Attempting to connect to WiFi...");
-    Serial.println("========================================");
+    JsonResponse json;
+    json.beginObject();
+    json.key("success").value(true);
+    json.key("message").value("Connecting to WiFi...");
+    json.key("ssid").value(wifiSSID);
+    json.endObject();
+    json.send();
 
     // Start WiFi connection (non-blocking - handled in loop())
-    WiFi.disconnect();
-    WiFi.begin(wifiSSID.c_str(), wifiPassword.c_str());
-
-    wifiConnecting = true;
-    wifiAttempts = 0;
-    wifiConnectStartTime = millis();
+    bleJoinPending = false;
+    savedWiFiRetrying = false;
+    wifiLink.begin(wifiSSID.c_str(), wifiPassword.c_str(), WIFI_ONBOARDING_TIMEOUT_MS);
+    scheduler.notify(TASK_WIFI);
 
-    Serial.println("📶 WiFi connection initiated (non-blocking)");
+    WP_LOGI("📶 WiFi connection initiated (non-blocking)");
   } else {
-    Serial.println("   ❌ ERROR: Missing ssid or password in request");
-    String response = "{\"success\":false,\"error\":\"Missing ssid or password\"}";
-    server.send(400, "application/json", response);
-    Serial.println("========================================");
+    WP_LOGW("❌ /config: missing ssid or password");
+    sendJsonError(400, "Missing ssid or password");
   }
 }
 
 void handleLocationSubmission() {
+  logRequest("/location");
   addCORSHeaders();  // Add CORS for HTTPS PWA access
 
   // Parse JSON body
-  String body = server.arg("plain");
+  String body = requestBody();
   StaticJsonDocument<200> doc;
   DeserializationError error = deserializeJson(doc, body);
 
   if (error) {
-    Serial.printf("JSON parse error: %s\n", error.c_str());
-    String response = "{\"success\":false,\"error\":\"Invalid JSON\"}";
-    server.send(400, "application/json", response);
+    WP_LOGW("JSON parse error: %s", error.c_str());
+    sendJsonError(400, "Invalid JSON");
     return;
   }
 
@@ -996,55 +1014,38 @@ void handleLocationSubmission() {
     latitude = doc["latitude"].as<float>();
     longitude = doc["longitude"].as<float>();
 
-    Serial.printf("Location updated via HTTP: %.6f, %.6f\n", latitude, longitude);
+    WP_LOGI("Location updated via HTTP: %.6f, %.6f", latitude, longitude);
+    saveConfig();
 
     // Send success response
-    String response = "{";
-    response += "\"success\":true,";
-    response += "\"latitude\":" + String(latitude, 6) + ",";
-    response += "\"longitude\":" + String(longitude, 6) + ",";
-    response += "\"message\":\"Location updated, fetching weather...\"";
-    response += "}";
-    server.send(200, "application/json", response);
+    JsonResponse json;
+    json.beginObject();
+    json.key("success").value(true);
+    json.key("latitude").value(latitude, 6);
+    json.key("longitude").value(longitude, 6);
+    json.key("message").value("Location updated, fetching weather...");
+    json.endObject();
+    json.send();
 
     // Trigger weather update in background
-    Serial.println("Triggering weather update for new location...");
+    WP_LOGD("Triggering weather update for new location...");
     // Weather will be fetched in next loop cycle
+    serveCachedWeather();
   } else {
-    String response = "{\"success\":false,\"error\":\"Missing latitude or longitude\"}";
-    server.send(400, "application/json", response);
+    sendJsonError(400, "Missing latitude or longitude");
   }
 }
 
+// web/ota.html, gzipped in flash
 void handleOTAPage() {
-  String html = R"rawliteral(
-    <!DOCTYPE html>
-    <html>
-    <head>
-      <title>ESP32 OTA Update</title>
-      <style>
-        body { font-family: Arial, sans-serif; margin: 20px; }
-        h1 { color: #FF6B6B; }
-      </style>
-    </head>
-    <body>
-      <h1>🔧 OTA Firmware Update</h1>
-      <form method="POST" action="/otaUpdate" enctype="multipart/form-data">
-        <input type="file" name="firmware">
-        <input type="submit" value="Upload Firmware">
-      </form>
-    </body>
-    </html>
-  )rawliteral";
-
-  server.send(200, "text/html", html);
+  serveStaticPage(server, OTA_HTML);
 }
 
 void handleOTAUpdate() {
   HTTPUpload& upload = server.upload();
 
   if (upload.status == UPLOAD_FILE_START) {
-    Serial.printf("OTA Update: %s\n", upload.filename.c_str());
+    WP_LOGI("OTA Update: %s", upload.filename.c_str());
     if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
       Update.printError(Serial);
     }
@@ -1054,9 +1055,10 @@ void handleOTAUpdate() {
     }
   } else if (upload.status == UPLOAD_FILE_END) {
     if (Update.end(true)) {
-      Serial.printf("OTA Update Success: %u bytes\n", upload.totalSize);
+      WP_LOGI("OTA Update Success: %u bytes", (unsigned)upload.totalSize);
       server.send(200, "text/plain", "Update successful. Rebooting...");
       delay(1000);
+      logger.drain(Serial);
       ESP.restart();
     } else {
       Update.printError(Serial);
@@ -1071,112 +1073,362 @@ void handleOTAUpdate() {
 // WEBSOCKET RELAY HANDLERS
 // ============================================================================
 
-String processLocalRequest(const char* method, const char* path, JsonVariant body) {
-  String response;
-
-  if (strcmp(path, "/health") == 0) {
-    StaticJsonDocument<256> doc;
-    doc["device_id"] = deviceId;
-    doc["status"] = "ready";
-    doc["firmware_version"] = "1.0.0";
-    doc["local_ip"] = WiFi.localIP().toString();
-    serializeJson(doc, response);
-
-  } else if (strcmp(path, "/weather") == 0) {
-    StaticJsonDocument<512> doc;
-    doc["device_id"] = deviceId;
-    doc["condition"] = lastWeatherCondition;
-    doc["temperature"] = lastTemperature;
-    doc["symbol"] = weatherSymbol;
-
-    JsonObject location = doc.createNestedObject("location");
-    location["latitude"] = latitude;
-    location["longitude"] = longitude;
-
-    doc["timestamp"] = millis();
-    serializeJson(doc, response);
-
-  } else if (strcmp(path, "/device-info") == 0) {
-    StaticJsonDocument<256> doc;
-    doc["device_id"] = deviceId;
-    doc["mac_address"] = WiFi.macAddress();
-    doc["firmware_version"] = "1.0.0";
-    serializeJson(doc, response);
-
-  } else if (strcmp(path, "/location") == 0 && strcmp(method, "POST") == 0) {
-    // Update location from body
-    if (!body.isNull()) {
-      float newLat = body["latitude"];
-      float newLon = body["longitude"];
-
-      latitude = newLat;
-      longitude = newLon;
-
-      Serial.printf("[WS] Location updated: %.4f, %.4f\n", latitude, longitude);
+// Run a relayed request through the same handler the WebServer would use.
+// The handler's reply, JSON or MessagePack as the relay takes it, is written
+// to `reply` (at most `replySize` bytes with a NUL after it) and its length
+// to `replyLength`: 0 when it did not fit. Returns the handler's HTTP status.
+int processLocalRequest(const char *method, const char *path, JsonVariant body, char *reply, size_t replySize,
+                        size_t &replyLength) {
+  char bodyText[RELAY_BODY_MAX] = "";
+  if (!body.isNull()) {
+    serializeJson(body, bodyText, sizeof(bodyText));
+  }
 
-      StaticJsonDocument<256> doc;
-      doc["success"] = true;
-      doc["latitude"] = latitude;
-      doc["longitude"] = longitude;
-      serializeJson(doc, response);
+  reply[0] = '\0';
+  RelayExchange exchange = { bodyText, 500, reply, replySize, 0, relayMsgPack };
+  relayExchange = &exchange;
+
+  const Route *route = findRoute(ROUTES, path, httpMethodFromName(method));
+  if (route && route->relay) {
+    noteActivity();
+    route->handler();
+  } else {
+    sendJsonError(404, "Not found");
+  }
+
+  relayExchange = nullptr;
+  replyLength = exchange.replyLength;
+  return exchange.status;
+}
+
+// Requests in, response frames out. One request, one frame:
+//   {"type":"request","id":"<id>","method":"GET","path":"/health","body":{...}}
+//   -> {"id":"<id>","type":"response","data":<handler reply>,"status":<code>}
+// Several requests, one frame with a response for each, in any order:
+//   {"type":"batch","requests":[<request>,...]}
+//   -> {"type":"batch","responses":[<response>,...]}
+// A GET /weather with "fresh":true while the forecast is out of date is
+// parked until the refresh ends, then answered in a frame of its own, so it
+// holds up neither its batch nor the requests behind it. Responses are
+// matched to requests by id only.
+//
+// Each response is written in one pass: the envelope head, the handler's
+// reply right after it, then "status", known only once the handler ran.
+//
+// The device offers MessagePack when it registers; once the relay answers
+// {"type":"registered","encoding":"msgpack"}, every frame the device sends
+// is MessagePack, in a binary frame, with the same members. Requests are
+// taken in either encoding, whatever the frame type says. Frames are at most
+// RELAY_FRAME_MAX bytes (firmware_config.h).
+#define RELAY_BATCH_MAX 8        // Requests in a batch; the relay splits longer ones
+#define RELAY_PENDING_MAX 4      // Parked requests; more are answered from the cache
+// Longest a parked request waits: a fetch started when it was parked is over
+#define RELAY_PENDING_MS (WEATHER_FETCH_DEADLINE_MS + WEATHER_FETCH_GRACE_MS)
+#define RELAY_ID_MAX 40
+// Members of a relay request, its body's included
+#define RELAY_REQUEST_DOC_SIZE (JSON_OBJECT_SIZE(7) + JSON_OBJECT_SIZE(6))
+// Strings are copied out of the payload, which stays intact for a second,
+// ids-only parse when a message does not fit: a request's id, method, path
+// and body strings, and member names, stored once
+#define RELAY_REQUEST_STRINGS 160
+#define RELAY_KEY_STRINGS 64
+#define RELAY_MESSAGE_DOC_SIZE                                                                     \
+  (JSON_OBJECT_SIZE(4) + JSON_ARRAY_SIZE(RELAY_BATCH_MAX) +                                        \
+   RELAY_BATCH_MAX * (RELAY_REQUEST_DOC_SIZE + RELAY_REQUEST_STRINGS) + RELAY_KEY_STRINGS)
+// Room kept behind a reply: ,"status":NNN} or null in its place (MessagePack
+// needs less)
+#define RELAY_RESPONSE_TAIL_MAX 20
+// A batch frame with less room than this left is sent before the next reply
+#define RELAY_BATCH_ROOM_MIN 1024
+
+static char relayFrame[RELAY_FRAME_MAX];  // Loop task only: pollNetwork() and pushWeatherEvent()
+
+struct ParkedRelayRequest {
+  char id[RELAY_ID_MAX];  // "": free
+  unsigned long sinceMs;
+  uint32_t fetchesDone;  // weatherFetchesDone when parked
+};
+
+static ParkedRelayRequest parkedRelayRequests[RELAY_PENDING_MAX];
+
+// Writes {"id":..,"type":"response","data":..,"status":..} at relayFrame + at,
+// in at most `room` bytes. Returns its length: 0 when not even the envelope
+// fit, in which case the handler is not run. A `failStatus` answers with that
+// status and null data, without running the handler.
+static size_t writeRelayResponse(size_t at, size_t room, const char *id, const char *method, const char *path,
+                                 JsonVariant body, int failStatus = 0) {
+  if (failStatus) {
+    WP_LOGW("[WS] Request %s answered with %d", id ? id : "", failStatus);
+  } else {
+    WP_LOGI("[WS] Request: %s %s (id=%s)", method, path, id);
+  }
+  if (room <= RELAY_RESPONSE_TAIL_MAX) {
+    return 0;
+  }
+  char *frame = relayFrame + at;
+  size_t length = 0;
+  if (relayMsgPack) {
+    frame[length++] = (char)0x84;  // fixmap of 4: id, type, data and status
+  }
+  JsonWriter head(frame + length, room - length);
+  if (relayMsgPack) {
+    head.useMsgPack();
+  } else {
+    head.beginObject();
+  }
+  head.key("id").value(id);
+  head.key("type").value("response");
+  head.key("data");
+  length += head.bufferedLength();
+  if (!head.ok() || length + RELAY_RESPONSE_TAIL_MAX > room) {
+    WP_LOGW("[WS] No room to answer %s", id ? id : "");
+    return 0;
+  }
 
-      // Trigger weather fetch (async)
-      // fetchWeather(); // Uncomment if you want immediate weather update
+  size_t replyLength = 0;
+  int status = failStatus;
+  if (!failStatus) {
+    status = processLocalRequest(method, path ? path : "", body, frame + length,
+                                 room - length - RELAY_RESPONSE_TAIL_MAX, replyLength);
+  }
+  if (replyLength == 0) {
+    if (relayMsgPack) {
+      frame[length] = (char)0xc0;  // nil
+      replyLength = 1;
+    } else {
+      memcpy(frame + length, "null", 4);
+      replyLength = 4;
+    }
+    if (!failStatus) {
+      WP_LOGW("[WS] No reply to send for %s", path);
+      status = 500;
     }
   }
+  length += replyLength;
+  if (relayMsgPack) {
+    JsonWriter tail(frame + length, room - length);
+    tail.useMsgPack();
+    tail.key("status").value(status);
+    length += tail.bufferedLength();
+  } else {
+    length += snprintf(frame + length, room - length, ",\"status\":%d}", status);
+  }
+  return length;
+}
 
-  return response;
+static void sendRelayFrame(size_t length) {
+  if (relayMsgPack) {
+    wsClient.sendBIN((const uint8_t *)relayFrame, length);
+  } else {
+    wsClient.sendTXT(relayFrame, length);
+  }
 }
 
-void handleWebSocketMessage(const char* payload) {
-  StaticJsonDocument<1024> doc;
-  DeserializationError error = deserializeJson(doc, payload);
+static void sendRelayResponse(const char *id, const char *method, const char *path, JsonVariant body,
+                              int failStatus = 0) {
+  size_t length = writeRelayResponse(0, sizeof(relayFrame), id, method, path, body, failStatus);
+  if (length) {
+    sendRelayFrame(length);
+  }
+}
 
-  if (error) {
-    Serial.println("[WS] Failed to parse message");
+// Holds back a GET /weather that asked for a fresh forecast while the cached
+// one is not, and starts the refresh. False: answer it now.
+static bool parkRelayRequest(JsonObject request) {
+  const char *id = request["id"];
+  const char *method = request["method"];
+  const char *path = request["path"];
+  if (!request["fresh"].as<bool>() || !id || strlen(id) >= RELAY_ID_MAX || !method || strcmp(method, "GET") != 0 ||
+      !path || strcmp(path, "/weather") != 0 || weatherIsFresh()) {
+    return false;
+  }
+  for (ParkedRelayRequest &parked : parkedRelayRequests) {
+    if (parked.id[0] == '\0') {
+      strcpy(parked.id, id);
+      parked.sinceMs = millis();
+      parked.fetchesDone = weatherFetchesDone;
+      serveCachedWeather();  // Starts the refresh
+      WP_LOGI("[WS] Request %s waits for the weather refresh", id);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Answers parked requests whose refresh has ended, or that waited too long
+void answerParkedRelayRequests() {
+  for (ParkedRelayRequest &parked : parkedRelayRequests) {
+    if (parked.id[0] != '\0' &&
+        (parked.fetchesDone != weatherFetchesDone || millis() - parked.sinceMs >= RELAY_PENDING_MS)) {
+      sendRelayResponse(parked.id, "GET", "/weather", JsonVariant());
+      parked.id[0] = '\0';
+    }
+  }
+}
+
+// Tells the relay what changed in the weather since the last event, if
+// anything did. The relay passes it on to its clients, so they need not
+// poll /weather.
+void pushWeatherEvent() {
+  if (!wsConnected) {
     return;
   }
+  WeatherState now = { lastWeatherCondition, lastTemperature, lastPrecipitation, weatherSymbol, latitude, longitude };
+  JsonWriter json(relayFrame, sizeof(relayFrame));
+  if (relayMsgPack) {
+    json.useMsgPack();
+  }
+  if (weatherEvents.write(now, json)) {
+    sendRelayFrame(json.bufferedLength());
+  }
+}
 
-  const char* type = doc["type"];
-  if (strcmp(type, "request") != 0) {
-    return;  // Ignore non-request messages
+// Their ids mean nothing to the next connection
+static void dropParkedRelayRequests() {
+  for (ParkedRelayRequest &parked : parkedRelayRequests) {
+    parked.id[0] = '\0';
   }
+}
 
-  const char* requestId = doc["id"];
-  const char* method = doc["method"];
-  const char* path = doc["path"];
+// Batch frame heads. The MessagePack one ends in an array16 whose count is
+// filled in when the frame is sent.
+static const char RELAY_BATCH_HEAD[] = "{\"type\":\"batch\",\"responses\":[";
+static const char RELAY_BATCH_HEAD_MSGPACK[] = "\x82\xa4" "type" "\xa5" "batch" "\xa9" "responses" "\xdc\x00\x00";
 
-  Serial.printf("[WS] Request: %s %s (id=%s)\n", method, path, requestId);
+static void sendRelayBatch(size_t length, size_t answered) {
+  if (relayMsgPack) {
+    relayFrame[sizeof(RELAY_BATCH_HEAD_MSGPACK) - 3] = (char)(answered >> 8);
+    relayFrame[sizeof(RELAY_BATCH_HEAD_MSGPACK) - 2] = (char)answered;
+  } else {
+    relayFrame[length++] = ']';
+    relayFrame[length++] = '}';
+  }
+  sendRelayFrame(length);
+}
 
-  // Process request internally
-  String responseData = processLocalRequest(method, path, doc["body"]);
+// One frame for the batch, or more when the replies outgrow it. A
+// `failStatus` answers every request with it (see writeRelayResponse()).
+static void handleRelayBatch(JsonArray requests, int failStatus = 0) {
+  size_t at = 0;
+  size_t answered = 0;  // In this frame
+  for (JsonObject request : requests) {
+    if (!failStatus && parkRelayRequest(request)) {
+      continue;
+    }
+    bool flush = answered > 0 && sizeof(relayFrame) - at < RELAY_BATCH_ROOM_MIN;
+    size_t comma, length;
+    for (;;) {
+      if (flush) {
+        sendRelayBatch(at, answered);
+        answered = 0;
+      }
+      if (answered == 0) {
+        const char *head = relayMsgPack ? RELAY_BATCH_HEAD_MSGPACK : RELAY_BATCH_HEAD;
+        at = (relayMsgPack ? sizeof(RELAY_BATCH_HEAD_MSGPACK) : sizeof(RELAY_BATCH_HEAD)) - 1;
+        memcpy(relayFrame, head, at);
+      }
+      comma = answered > 0 && !relayMsgPack ? 1 : 0;
+      if (comma) {
+        relayFrame[at] = ',';
+      }
+      // Leaves ]} room to close the frame
+      length = writeRelayResponse(at + comma, sizeof(relayFrame) - at - comma - 2, request["id"],
+                                  request["method"], request["path"], request["body"], failStatus);
+      if (length || answered == 0) {
+        break;
+      }
+      flush = true;  // No room behind the others: send them, then again on its own
+    }
+    if (length) {
+      at += comma + length;
+      answered++;
+    }
+  }
+  if (answered > 0) {
+    sendRelayBatch(at, answered);
+  }
+}
+
+static StaticJsonDocument<RELAY_MESSAGE_DOC_SIZE> relayMessage;  // Too big for the loop task's stack
+
+// A message that did not parse: parse it again for its request ids alone,
+// which fit where bodies and all did not, and answer each with `status`.
+// Input that is not JSON or MessagePack at all gets nothing.
+static void answerUnparsedRelayMessage(const char *payload, size_t length, bool binary, int status) {
+  static StaticJsonDocument<JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(1) + JSON_OBJECT_SIZE(1)> filter;
+  if (filter.isNull()) {
+    filter["type"] = true;
+    filter["id"] = true;
+    filter["requests"][0]["id"] = true;
+  }
+
+  JsonDocument &doc = relayMessage;
+  DeserializationOption::Filter ids(filter);
+  DeserializationError error =
+      binary ? deserializeMsgPack(doc, payload, length, ids) : deserializeJson(doc, payload, length, ids);
+  if (error) {
+    WP_LOGW("[WS] No request ids in the message either: %s", error.c_str());
+    return;
+  }
+  const char *type = doc["type"];
+  if (type && strcmp(type, "batch") == 0) {
+    handleRelayBatch(doc["requests"], status);
+  } else if (type && strcmp(type, "request") == 0 && doc["id"].is<const char *>()) {
+    sendRelayResponse(doc["id"], nullptr, nullptr, JsonVariant(), status);
+  }
+}
 
-  // Send response back to relay
-  StaticJsonDocument<2048> responseDoc;
-  responseDoc["id"] = requestId;
-  responseDoc["type"] = "response";
-  responseDoc["status"] = 200;
+void handleWebSocketMessage(char *payload, size_t length, bool binary) {
+  JsonDocument &doc = relayMessage;
+  // Parsed from a const pointer: strings are copied, the payload left as it was
+  const char *input = payload;
+  DeserializationError error = binary ? deserializeMsgPack(doc, input, length) : deserializeJson(doc, input, length);
 
-  // Parse response data into JSON object
-  StaticJsonDocument<1024> dataDoc;
-  deserializeJson(dataDoc, responseData);
-  responseDoc["data"] = dataDoc.as<JsonObject>();
+  if (error) {
+    WP_LOGW("[WS] Failed to parse message: %s", error.c_str());
+    // Too big for the document: still tell the relay, so no client waits
+    bool tooLarge = error == DeserializationError::NoMemory || error == DeserializationError::TooDeep;
+    answerUnparsedRelayMessage(input, length, binary, tooLarge ? 413 : 500);
+    return;
+  }
 
-  String responseMsg;
-  serializeJson(responseDoc, responseMsg);
-  wsClient.sendTXT(responseMsg);
+  const char* type = doc["type"];
+  if (!type) {
+    return;
+  }
+  if (strcmp(type, "batch") == 0) {
+    handleRelayBatch(doc["requests"]);
+  } else if (strcmp(type, "request") == 0) {
+    if (!parkRelayRequest(doc.as<JsonObject>())) {
+      sendRelayResponse(doc["id"], doc["method"], doc["path"], doc["body"]);
+    }
+  } else if (strcmp(type, "subscribers") == 0) {
+    relaySubscribers = doc["count"] | 0;
+    WP_LOGI("[WS] %u relay client(s) subscribed", relaySubscribers);
+    scheduler.notify(TASK_WEATHER);  // A first one gets the latest state now
+  } else if (strcmp(type, "registered") == 0) {
+    const char *encoding = doc["encoding"];
+    relayMsgPack = encoding && strcmp(encoding, "msgpack") == 0;
+    WP_LOGI("[WS] Relay takes %s", relayMsgPack ? "MessagePack" : "JSON");
+  }
+  // Anything else is not for the device
 }
 
 void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
   switch(type) {
     case WStype_DISCONNECTED:
-      Serial.println("[WS] Disconnected from relay");
+      WP_LOGW("[WS] Disconnected from relay");
       wsConnected = false;
+      relayMsgPack = false;
+      relaySubscribers = 0;
+      dropParkedRelayRequests();
       break;
 
     case WStype_CONNECTED:
-      Serial.println("[WS] ✅ Connected to relay");
+      WP_LOGI("[WS] ✅ Connected to relay");
       wsConnected = true;
+      relayMsgPack = false;  // Until the relay says otherwise
+      relaySubscribers = 0;  // Likewise
 
       // Send registration message
       {
@@ -1184,21 +1436,30 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
         regDoc["type"] = "register";
         regDoc["device_id"] = deviceId;
         regDoc["firmware_version"] = "1.0.0";
+        JsonArray encodings = regDoc.createNestedArray("encodings");  // Ours, by preference
+        encodings.add("msgpack");
+        encodings.add("json");
 
         String regMsg;
         serializeJson(regDoc, regMsg);
         wsClient.sendTXT(regMsg);
-        Serial.println("[WS] Sent registration");
+        WP_LOGD("[WS] Sent registration");
       }
+      weatherEvents.restart();  // The relay gets the whole state first
       break;
 
     case WStype_TEXT:
-      Serial.printf("[WS] Received: %s\n", payload);
-      handleWebSocketMessage((char*)payload);
+      WP_LOGD("[WS] Received: %.*s", (int)length, (const char *)payload);
+      handleWebSocketMessage((char *)payload, length, false);
+      break;
+
+    case WStype_BIN:
+      WP_LOGD("[WS] Received %u bytes of MessagePack", (unsigned)length);
+      handleWebSocketMessage((char *)payload, length, true);
       break;
 
     case WStype_ERROR:
-      Serial.println("[WS] Error occurred");
+      WP_LOGE("[WS] Error occurred");
       break;
 
     default:
@@ -1212,153 +1473,84 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
 
 void setup() {
   Serial.begin(115200);
-  delay(1000);
-  Serial.println("\n\n=== Weather Potato Starting ===");
+  startLogTask();
+  scheduler.begin();
+
+  // LEDs and buzzer first: a touch wake from deep sleep shows the weather
+  // kept in RTC memory before anything slower runs
+  setupOutputs();
+  bool woke = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0 && showSleepSnapshot();
+
+  // Saved network first: the radio associates while the hardware below
+  // initialises
+  bool savedWiFi = loadConfig() && wifiSSID.length() > 0;
+  WiFi.mode(WIFI_STA);
+  wifiLink.attach(wakeWiFiTask);
+  if (savedWiFi) {
+    wifiLink.begin(wifiSSID.c_str(), wifiPassword.c_str(), WIFI_SAVED_TIMEOUT_MS, true);
+  }
+
+  if (!woke) {
+    delay(1000);
+  }
+  WP_LOGI("=== Weather Potato Starting%s ===", woke ? " (touch wake)" : "");
 
   // Generate Device ID from MAC address (first 8 hex chars, uppercase)
   String mac = WiFi.macAddress();
   mac.replace(":", "");
   deviceId = mac.substring(0, 8);
   deviceId.toUpperCase();
-  Serial.println("Device ID: " + deviceId);
-  Serial.println("MAC Address: " + WiFi.macAddress());
+  WP_LOGI("Device ID: %s, MAC Address: %s", deviceId.c_str(), WiFi.macAddress().c_str());
 
   // Setup hardware
   pinMode(CAP_SENSOR_PIN, INPUT);
-  pinMode(BUZZER_PIN, OUTPUT);
+  touchInput.begin(wakeTouchTask);
 
-  // Initialize NeoPixel
-  strip.begin();
-  strip.show();
-  strip.setBrightness(50);
-
-  // LED test (red flash)
-  strip.setPixelColor(0, strip.Color(255, 0, 0));
-  strip.show();
-  delay(1000);
-  strip.setPixelColor(0, strip.Color(0, 0, 0));
-  strip.show();
-
-  // Setup buzzer LEDC
-  ledc_timer_config_t ledc_timer = {
-    .speed_mode = BUZZER_MODE,
-    .duty_resolution = BUZZER_RESOLUTION,
-    .timer_num = BUZZER_TIMER,
-    .freq_hz = BUZZER_FREQUENCY,
-    .clk_cfg = LEDC_AUTO_CLK
-  };
-  ESP_ERROR_CHECK(ledc_timer_config(&ledc_timer));
-
-  ledc_channel_config_t ledc_channel = {
-    .gpio_num = BUZZER_PIN,
-    .speed_mode = BUZZER_MODE,
-    .channel = BUZZER_CHANNEL,
-    .intr_type = LEDC_INTR_DISABLE,
-    .timer_sel = BUZZER_TIMER,
-    .duty = 0,
-    .hpoint = 0
-  };
-  ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
+  // LED test (red flash), not over the weather a wake is showing
+  if (!woke) {
+    strip.setPixelColor(0, strip.Color(255, 0, 0));
+    strip.show();
+    delay(1000);
+    strip.setPixelColor(0, strip.Color(0, 0, 0));
+    strip.show();
+  }
 
-  Serial.println("Hardware setup complete");
+  WP_LOGI("Hardware setup complete");
 
-  // TODO: Check EEPROM for saved WiFi credentials
-  // For now, check if we have credentials in variables
+  startWeatherFetchTask();
 
-  // Try to connect with existing credentials (if any)
-  WiFi.mode(WIFI_STA);
+  // HTTP server endpoints, on the AP now and on the station once it joins
+  registerRoutes();
+  server.begin();
+  WP_LOGI("✅ HTTP server started on port 8080");
+  noteActivity();  // The idle timer starts now
 
-  if (wifiSSID.length() > 0) {
-    Serial.println("Found existing WiFi credentials, attempting connection...");
-    WiFi.begin(wifiSSID.c_str(), wifiPassword.c_str());
+  // The saved network is still being joined (from the top of setup());
+  // loop() goes on to onboarding if that fails
+  if (savedWiFi) {
+    WP_LOGI("=== Setup Complete: joining saved WiFi \"%s\" ===", wifiSSID.c_str());
+    return;
+  }
 
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-      delay(500);
-      Serial.print(".");
-      attempts++;
-    }
-    Serial.println();
+  startOnboarding();
+  WP_LOGI("=== Setup Complete ===");
+}
 
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.println("Connected to existing WiFi!");
-      Serial.print("IP: ");
-      Serial.println(WiFi.localIP());
+void loop() {
+  unsigned long passStart = micros();
 
-      // Setup mDNS and HTTP server
-      if (MDNS.begin("weatherpotato")) {
-        Serial.println("mDNS started: weatherpotato.local");
-        MDNS.addService("http", "tcp", 8080);
-      }
+  uint32_t idleMs = scheduler.runDue();
 
-      server.on("/", HTTP_GET, handleRootPage);
-      server.on("/setup", HTTP_GET, handleSetupPage);
-      server.on("/device-info", HTTP_GET, handleDeviceInfo);
-      server.on("/health", HTTP_GET, handleHealthEndpoint);
-      server.on("/weather", HTTP_GET, handleWeatherEndpoint);
-      server.on("/config", HTTP_POST, handleConfigSubmission);
-      server.on("/location", HTTP_POST, handleLocationSubmission);
-      server.on("/ota", HTTP_GET, handleOTAPage);
-      server.on("/otaUpdate", HTTP_POST, handleOTAUpdate);
-
-      // Handle CORS preflight requests
-      server.on("/device-info", HTTP_OPTIONS, handleCORSPreflight);
-      server.on("/health", HTTP_OPTIONS, handleCORSPreflight);
-      server.on("/weather", HTTP_OPTIONS, handleCORSPreflight);
-      server.on("/config", HTTP_OPTIONS, handleCORSPreflight);
-      server.on("/location", HTTP_OPTIONS, handleCORSPreflight);
-
-      server.begin();
-      Serial.println("HTTP server started on port 8080");
-
-      configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
-
-      Serial.println("=== Setup Complete ===\n");
-      return; // Skip BLE setup
-    }
+  if (weatherFetchPending.id != 0) {
+    unsigned long passUs = micros() - passStart;
+    if (passUs > weatherFetchWorstLoopUs) weatherFetchWorstLoopUs = passUs;
   }
 
-  // No WiFi connection - Start BLE for onboarding
-  Serial.println("No WiFi connection. Starting BLE for onboarding...");
-  setupBLE();
-
-  // Also start AP mode as backup
-  setupWiFiAP();
-
-  // CRITICAL: Register HTTP server endpoints for AP mode!
-  Serial.println("🌐 Starting HTTP server for AP mode...");
-
-  server.on("/", HTTP_GET, handleRootPage);
-  server.on("/setup", HTTP_GET, handleSetupPage);
-  server.on("/device-info", HTTP_GET, handleDeviceInfo);
-  server.on("/connection-status", HTTP_GET, handleConnectionStatus);
-  server.on("/health", HTTP_GET, handleHealthEndpoint);
-  server.on("/weather", HTTP_GET, handleWeatherEndpoint);
-  server.on("/config", HTTP_POST, handleConfigSubmission);
-  server.on("/location", HTTP_POST, handleLocationSubmission);
-  server.on("/ota", HTTP_GET, handleOTAPage);
-  server.on("/otaUpdate", HTTP_POST, handleOTAUpdate);
-
-  // Handle CORS preflight requests
-  server.on("/device-info", HTTP_OPTIONS, handleCORSPreflight);
-  server.on("/connection-status", HTTP_OPTIONS, handleCORSPreflight);
-  server.on("/health", HTTP_OPTIONS, handleCORSPreflight);
-  server.on("/weather", HTTP_OPTIONS, handleCORSPreflight);
-  server.on("/config", HTTP_OPTIONS, handleCORSPreflight);
-  server.on("/location", HTTP_OPTIONS, handleCORSPreflight);
-
-  server.begin();
-  Serial.println("✅ HTTP server started on port 8080 (AP mode)");
-  Serial.println("========================================");
-  Serial.println("📡 Server is ready to accept requests!");
-  Serial.println("   Access from: http://192.168.4.1:8080");
-  Serial.println("   Try: http://192.168.4.1:8080/setup");
-  Serial.println("========================================");
-
-  Serial.println("=== Setup Complete ===\n");
+  // Nothing to do until the next deadline, unless something notifies
+  scheduler.wait(idleMs);
 }
 
-void loop() {
+void pollNetwork() {
   // mDNS runs automatically on ESP32, no update() needed
 
   // Handle HTTP requests (CRITICAL: Must work in both AP mode and STA mode!)
@@ -1369,482 +1561,694 @@ void loop() {
   // Handle WebSocket relay connection (only when WiFi connected)
   if (WiFi.status() == WL_CONNECTED) {
     wsClient.loop();
+    answerParkedRelayRequests();
   }
+}
 
-  // Monitor WiFi connection progress (non-blocking)
-  if (wifiConnecting) {
-    wl_status_t status = WiFi.status();
-
-    // Debug: Print status every 5 seconds
-    static unsigned long lastStatusPrint = 0;
-    if (millis() - lastStatusPrint > 5000) {
-      Serial.printf("[DEBUG] wifiConnecting=true, status=%d, elapsed=%lus\n",
-                    status, (millis() - wifiConnectStartTime) / 1000);
-      lastStatusPrint = millis();
-    }
+void monitorWiFi() {
+  // Credentials that arrived over BLE
+  if (bleJoinRequested) {
+    bleJoinRequested = false;
+    bleJoinPending = true;
+    savedWiFiRetrying = false;
+    wifiLink.begin(wifiSSID.c_str(), wifiPassword.c_str(), WIFI_ONBOARDING_TIMEOUT_MS);
+  }
 
-    if (status == WL_CONNECTED) {
-      // SUCCESS! WiFi connected
-      Serial.println("========================================");
-      Serial.println("✅ WiFi Connected!");
-      Serial.print("   SSID: ");
-      Serial.println(WiFi.SSID());
-      Serial.print("   IP: ");
-      Serial.println(WiFi.localIP());
-      Serial.print("   Gateway: ");
-      Serial.println(WiFi.gatewayIP());
-      Serial.print("   DNS: ");
-      Serial.println(WiFi.dnsIP());
-      Serial.println("   Waiting for setup page to poll status...");
-      Serial.println("   AP will shutdown after sending success response");
-      Serial.println("========================================");
-
-      wifiConnecting = false;
-      wifiJustConnected = true;  // Flag for next status poll
-
-      // Free BLE memory now that WiFi is connected (BLE uses ~50KB RAM, needed for SSL)
-      if (bleEnabled) {
-        Serial.println("[DEBUG] Shutting down BLE to free memory for SSL...");
-        BLEDevice::deinit(true);
-        bleEnabled = false;
-        Serial.printf("[DEBUG] Free heap after BLE shutdown: %d bytes\n", ESP.getFreeHeap());
-      }
+  // Act on what the WiFi event task recorded (non-blocking)
+  switch (wifiLink.update()) {
+    case WIFI_LINK_UP:
+      onWiFiConnected();
+      break;
+    case WIFI_LINK_DOWN:  // Already rejoining; the server and relay wait for it
+      break;
+    case WIFI_LINK_GAVE_UP:
+      onWiFiGaveUp();
+      break;
+    default:
+      break;
+  }
+  if (wifiLink.state() == WIFI_LINK_CONNECTING) {
+    scheduler.runIn(TASK_WIFI, WIFI_JOIN_POLL_MS);
+  }
 
-      // Setup mDNS
-      Serial.println("[DEBUG] Setting up mDNS...");
-      if (MDNS.begin("weatherpotato")) {
-        Serial.println("✅ mDNS started: weatherpotato.local");
-        MDNS.addService("http", "tcp", 8080);
-        Serial.println("✅ mDNS HTTP service registered");
-      } else {
-        Serial.println("⚠️  mDNS failed to start");
-      }
+  // Shutdown AP after successful WiFi connection
+  if (apShutdownTime > 0 && millis() > apShutdownTime) {
+    WiFi.softAPdisconnect(true);
+    WP_LOGI("🔌 Access Point shut down, device now in STA mode only");
+    apShutdownTime = 0;  // Clear flag
+  }
+}
 
-      // CRITICAL: Restart HTTP server for WiFi interface
-      // The server was bound to AP interface (192.168.4.1)
-      // Now we need to rebind to the new WiFi IP
-      Serial.println("[DEBUG] About to restart HTTP server...");
-      Serial.println("🔄 Restarting HTTP server for WiFi interface...");
-
-      Serial.println("[DEBUG] Closing existing server...");
-      server.close();  // Stop the server
-
-      Serial.println("[DEBUG] Registering endpoints...");
-      // Re-register all endpoints
-      server.on("/", HTTP_GET, handleRootPage);
-      server.on("/setup", HTTP_GET, handleSetupPage);
-      server.on("/device-info", HTTP_GET, handleDeviceInfo);
-      server.on("/connection-status", HTTP_GET, handleConnectionStatus);
-      server.on("/health", HTTP_GET, handleHealthEndpoint);
-      server.on("/weather", HTTP_GET, handleWeatherEndpoint);
-      server.on("/config", HTTP_POST, handleConfigSubmission);
-      server.on("/location", HTTP_POST, handleLocationSubmission);
-      server.on("/ota", HTTP_GET, handleOTAPage);
-      server.on("/otaUpdate", HTTP_POST, handleOTAUpdate);
-      Serial.println("[DEBUG] Endpoints registered");
-
-      Serial.println("[DEBUG] Registering CORS preflight handlers...");
-      // Re-register CORS preflight
-      server.on("/device-info", HTTP_OPTIONS, handleCORSPreflight);
-      server.on("/connection-status", HTTP_OPTIONS, handleCORSPreflight);
-      server.on("/health", HTTP_OPTIONS, handleCORSPreflight);
-      server.on("/weather", HTTP_OPTIONS, handleCORSPreflight);
-      server.on("/config", HTTP_OPTIONS, handleCORSPreflight);
-      server.on("/location", HTTP_OPTIONS, handleCORSPreflight);
-      Serial.println("[DEBUG] CORS handlers registered");
-
-      Serial.println("[DEBUG] Starting server...");
-      server.begin();  // Restart server on WiFi interface
-      Serial.println("✅ HTTP server restarted on WiFi interface");
-      Serial.print("   Access from: http://");
-      Serial.print(WiFi.localIP());
-      Serial.println(":8080");
-      Serial.print("   Or via mDNS: http://weatherpotato.local:8080");
-      Serial.println();
-      Serial.println("[DEBUG] Server is now listening for requests");
-
-      // Configure NTP for time sync (must happen before SSL connections)
-      Serial.println("[DEBUG] Configuring NTP...");
-      configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
-      // Wait for NTP sync (SSL cert validation needs correct time)
-      Serial.print("[DEBUG] Waiting for NTP sync");
-      time_t now = 0;
-      int ntpRetries = 0;
-      while (now < 1700000000 && ntpRetries < 20) {  // Wait until time is reasonable (after 2023)
-        delay(500);
-        time(&now);
-        Serial.print(".");
-        ntpRetries++;
-      }
-      Serial.println(now > 1700000000 ? " OK" : " TIMEOUT (continuing anyway)");
+// Gestures the touch interrupt recognised since the last run
+void takeTouchGestures() {
+  TouchEvent touchEvent;
+  while (touchInput.next(touchEvent)) {
+    handleTouch(touchEvent);
+  }
+}
 
-      // Initialize WebSocket relay connection (WSS with Let's Encrypt CA cert)
-      Serial.printf("[WS] Free heap before SSL: %d bytes\n", ESP.getFreeHeap());
-      Serial.println("[WS] Connecting to relay server...");
-      wsClient.beginSslWithCA("weather-potato-production.up.railway.app", 443, "/", isrg_root_x1_ca);
-      wsClient.setReconnectInterval(5000);
-      wsClient.onEvent(webSocketEvent);
-      Serial.println("[WS] WebSocket client initialized");
+// Publish a finished fetch, then start one if the cache asked for it
+void updateWeather() {
+  collectWeatherFetch();
+  // Relay clients get the weather pushed rather than asking for it: keep the
+  // published hour current and the cache revalidated on their behalf, while
+  // the relay says anyone subscribed
+  if (wsConnected && relaySubscribers > 0) {
+    serveCachedWeather();
+    pushWeatherEvent();
+  }
+  if (weatherRefreshRequested && WiFi.status() == WL_CONNECTED &&
+      (lastWeatherRefreshAttempt == 0 || millis() - lastWeatherRefreshAttempt >= WEATHER_REFRESH_RETRY_MS)) {
+    requestWeatherFetch();
+  }
+}
 
-      Serial.println("========================================");
-      Serial.println("🎉 SETUP COMPLETE - Ready for requests!");
-      Serial.println("========================================");
+// Ask NTP for the time, and have the time task poll the clock every
+// TIME_SYNC_POLL_MS until it is set
+void startTimeSync() {
+  configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
+  timeSyncPolls = TIME_SYNC_POLLS;
+  scheduler.runIn(TASK_TIME, TIME_SYNC_POLL_MS);
+}
 
+// Sync time if needed (only when connected to WiFi as client). Right after
+// startTimeSync(), wait for the answer instead: SSL cert validation needs
+// the correct time, so the relay starts once it came or TIME_SYNC_POLLS ran out.
+void syncTime() {
+  if (timeSyncPolls > 0) {
+    time_t now = time(nullptr);
+    if (now < TIME_VALID_AFTER && --timeSyncPolls > 0) {
+      scheduler.runIn(TASK_TIME, TIME_SYNC_POLL_MS);
+      return;
+    }
+    timeSyncPolls = 0;
+    if (now >= TIME_VALID_AFTER) {
+      WP_LOGI("NTP sync OK");
     } else {
-      // Still connecting - update attempt counter
-      unsigned long elapsed = millis() - wifiConnectStartTime;
-      wifiAttempts = elapsed / 1000;  // Convert to seconds
-
-      if (wifiAttempts > 30) {
-        // Connection failed after 30 seconds
-        Serial.println("========================================");
-        Serial.println("❌ WiFi Connection Failed");
-        Serial.println("   Timeout after 30 seconds");
-        Serial.println("========================================");
-        wifiConnecting = false;
-        wifiAttempts = 0;
-      }
+      WP_LOGW("NTP sync TIMEOUT (continuing anyway)");
     }
+    if (relayWaitsForTime) {
+      relayWaitsForTime = false;
+      startRelay();
+    }
+    return;
   }
 
-  // Shutdown AP after successful WiFi connection
-  if (apShutdownTime > 0 && millis() > apShutdownTime) {
-    Serial.println("========================================");
-    Serial.println("🔌 Shutting down Access Point...");
-    WiFi.softAPdisconnect(true);
-    Serial.println("✅ AP shutdown complete");
-    Serial.println("   Device now in STA mode only");
-    Serial.println("========================================");
-    apShutdownTime = 0;  // Clear flag
+  if (WiFi.status() == WL_CONNECTED && getLocalTime(&timeinfo, 0)) {
+    return;
   }
-
-  // Sync time if needed (only when connected to WiFi as client)
-  if (WiFi.status() == WL_CONNECTED && !getLocalTime(&timeinfo)) {
+  if (WiFi.status() == WL_CONNECTED) {
     configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
-    delay(1000);
   }
+  scheduler.runIn(TASK_TIME, TIME_RETRY_MS);
+}
 
-  // Handle capacitive touch for weather display
-  static unsigned long lastTouchTime = 0;
-  unsigned long currentTime = millis();
+// Per-task run time and lateness, for tuning the periods above
+void handleTasksEndpoint() {
+  logRequest("/tasks");
+  addCORSHeaders();
 
-  if (digitalRead(CAP_SENSOR_PIN) == HIGH) {
-    if (!animationActive && (currentTime - lastTouchTime > 10000)) {
-      Serial.println("Capacitive touch detected!");
+  JsonResponse json;
+  json.beginObject();
+  json.key("tasks").beginArray();
+  for (uint8_t i = 0; i < scheduler.count(); i++) {
+    const ScheduledTaskStats &stats = scheduler.stats(i);
+    json.beginObject();
+    json.key("name").value(scheduler.name(i));
+    json.key("runs").value(stats.runs);
+    json.key("avg_us").value(stats.runs ? (uint32_t)(stats.totalUs / stats.runs) : 0);
+    json.key("max_us").value(stats.maxUs);
+    json.key("max_late_us").value(stats.maxLateUs);
+    json.key("missed").value(stats.missed);
+    json.endObject();
+  }
+  json.endArray();
+  json.endObject();
+  json.send();
+}
 
-      if (WiFi.status() == WL_CONNECTED) {
-        getWeatherForecast(weatherSymbol, currentTemperature);
-        interpretWeatherSymbol(weatherSymbol, currentTemperature);
-        setLEDRGB(currentTemperature);
-      } else {
-        Serial.println("WiFi not connected, skipping weather fetch");
-      }
+// Tap: show the weather. Double tap: show it and fetch a fresh forecast.
+// Long press: silence the LEDs and the buzzer.
+void handleTouch(const TouchEvent &event) {
+  noteActivity();
+  WP_LOGI("Touch gesture %d (%lu us ago)", event.gesture, (unsigned long)(esp_timer_get_time() - event.atUs));
 
-      lastTouchTime = currentTime;
+  if (event.gesture == TOUCH_LONG_PRESS) {
+    if (animationActive) {
+      ledAnimation.stop();
+      animationActive = false;
     }
+    buzzer.stop();
+    return;
   }
 
-  // Continue animation if active
+  if (event.gesture == TOUCH_DOUBLE_TAP) {
+    weatherRefreshRequested = true;
+    lastWeatherRefreshAttempt = 0;  // Skip the retry wait
+    scheduler.notify(TASK_WEATHER);
+  }
   if (animationActive) {
-    setLEDRGB(currentTemperature);
+    return;
   }
 
-  // Handle buzzer
-  playToneIfNecessary("");
-
-  delay(10);
+  // Render whatever is cached right away; a stale entry is refreshed by loop()
+  if (serveCachedWeather()) {
+    currentTemperature = lastTemperature;
+    interpretWeatherSymbol(weatherSymbol);
+    setLEDRGB(currentTemperature);
+  } else if (WiFi.status() == WL_CONNECTED) {
+    showWeatherWhenFetched = true;
+  } else {
+    WP_LOGW("WiFi not connected, skipping weather fetch");
+  }
 }
 
 // ============================================================================
 // WEATHER & API FUNCTIONS
 // ============================================================================
 
-String getCurrentISOTime() {
-  struct tm timeinfo;
-  if (!getLocalTime(&timeinfo)) {
-    Serial.println("Failed to obtain time");
-    return "2024-10-18T12:00:00Z";
+// True once a newer request superseded this one or its deadline passed
+static bool weatherFetchCancelled(const WeatherFetchRequest &request) {
+  return request.id != weatherFetchGeneration || (long)(millis() - request.deadline) > 0;
+}
+
+// Fetch FORECAST_HOURS hourly values of every parameter in one request,
+// starting at the current UTC hour. Runs on the weather fetch task.
+bool getWeatherForecast(const WeatherFetchRequest &request, ForecastStore &forecast) {
+  if (WiFi.status() != WL_CONNECTED) {
+    WP_LOGW("WiFi not connected");
+    return false;
+  }
+
+  time_t now = time(nullptr);
+  if (now < TIME_VALID_AFTER) {
+    WP_LOGW("Time not synced yet, skipping weather fetch");
+    return false;
+  }
+  uint32_t startHour = now / 3600;
+
+  // Fixed buffers: nothing on the request path touches the heap. The
+  // Authorization header is only re-encoded when the credentials change.
+  static WeatherRequestBuilder weatherRequest;
+  const char *path = weatherRequest.path(startHour, request.latitude, request.longitude);
+
+  WP_LOGD("API path: %s", path);
+
+  // HTTP/1.1 keep-alive; responseBody() undoes any chunked framing
+  bool ok = false;
+  int httpResponseCode = meteomaticsApi.get(path, weatherRequest.authorization(apiUser.c_str(), apiPass.c_str()),
+                                            WEATHER_CONNECT_TIMEOUT_MS, WEATHER_READ_TIMEOUT_MS);
+  if (weatherFetchCancelled(request)) {
+    WP_LOGI("Weather fetch #%u cancelled", request.id);
+  } else if (httpResponseCode > 0) {
+    uint32_t heapBefore = ESP.getFreeHeap();
+    unsigned long parseStart = micros();
+
+    if (parseForecastStream(meteomaticsApi.responseBody(), startHour, forecast, &request)) {
+      WP_LOGI("Forecast received: %u hours", forecast.size());
+      ok = forecast.size() > 0;
+    } else {
+      WP_LOGW("Forecast parse failed or cancelled");
+    }
+
+    WP_LOGD("Weather parse: %lu us, heap used: %d B",
+            micros() - parseStart, (int)heapBefore - (int)ESP.getFreeHeap());
+  } else {
+    WP_LOGE("HTTP Error: %d", httpResponseCode);
   }
 
-  char isoTime[30];
-  strftime(isoTime, sizeof(isoTime), "%Y-%m-%dT%H:%M:%SZ", &timeinfo);
-  return String(isoTime);
+  // A body left half-read (failed or cancelled parse) is not worth draining
+  meteomaticsApi.end(ok);
+
+  const ApiConnectionStats &net = meteomaticsApi.statistics();
+  if (net.lastReused) {
+    WP_LOGD("Meteomatics: reused, %u B out, %u B in", net.lastBytesOut, net.lastBytesIn);
+  } else {
+    WP_LOGD("Meteomatics: TLS %u ms, %u B out, %u B in",
+            net.lastHandshakeMs, net.lastBytesOut, net.lastBytesIn);
+  }
+  WP_LOGD("Meteomatics: %u req, %u reused, %u TLS, %u DNS",
+          net.requests, net.reused, net.handshakes, net.dnsLookups);
+  return ok;
 }
 
-String encodeBase64(String input) {
-  const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-  String encoded = "";
-  int i = 0, j = 0;
-  unsigned char char_array_3[3], char_array_4[4];
+// Current forecast hour (UTC hours since epoch), the cache's time key
+static uint32_t currentForecastHour() {
+  return (uint32_t)(time(nullptr) / 3600);
+}
 
-  for (size_t n = 0; n < input.length(); n++) {
-    char_array_3[i++] = input[n];
-    if (i == 3) {
-      char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-      char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-      char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-      char_array_4[3] = char_array_3[2] & 0x3f;
+// Publish the cached forecast for the current location/hour into the globals
+// the handlers read. Returns false when nothing is cached yet. Anything not
+// fresh schedules a background refresh; the caller is never blocked.
+bool serveCachedWeather() {
+  static bool published = false;
+  WeatherSample sample;
+  WeatherCache::Freshness freshness =
+      weatherCache.get(latitude, longitude, currentForecastHour(), millis(), sample);
+
+  if (freshness != WeatherCache::FRESH && !weatherRefreshRequested) {
+    weatherRefreshRequested = true;
+    scheduler.notify(TASK_WEATHER);
+  }
+  if (freshness == WeatherCache::MISS) {
+    return false;
+  }
 
-      for (i = 0; (i < 4); i++)
-        encoded += base64_chars[char_array_4[i]];
-      i = 0;
-    }
+  if (!published || sample.symbol != weatherSymbol || sample.temperature != lastTemperature) {
+    published = true;
+    weatherSymbol = sample.symbol;
+    lastTemperature = sample.temperature;
+    lastWeatherCondition = weatherCondition(sample.symbol);
   }
+  lastPrecipitation = sample.precipCenti / (float)FORECAST_PRECIP_SCALE;
+  return true;
+}
 
-  if (i) {
-    for (j = i; j < 3; j++)
-      char_array_3[j] = '\0';
+// Cached for the current location and hour, and younger than the TTL
+bool weatherIsFresh() {
+  WeatherSample sample;
+  return weatherCache.get(latitude, longitude, currentForecastHour(), millis(), sample) == WeatherCache::FRESH;
+}
 
-    char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-    char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-    char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-    char_array_4[3] = char_array_3[2] & 0x3f;
+// ============================================================================
+// WEATHER FETCH TASK
+// ============================================================================
 
-    for (j = 0; (j < i + 1); j++)
-      encoded += base64_chars[char_array_4[j]];
+void weatherFetchTask(void *param) {
+  (void)param;
+  static WeatherFetchResult result;  // Kept off the task stack
+  WeatherFetchRequest request;
 
-    while ((i++ < 3))
-      encoded += '=';
-  }
+  for (;;) {
+    if (xQueueReceive(weatherFetchRequests, &request, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
 
-  return encoded;
+    unsigned long start = millis();
+    result.id = request.id;
+    result.latitude = request.latitude;
+    result.longitude = request.longitude;
+    result.ok = !weatherFetchCancelled(request) && getWeatherForecast(request, result.forecast);
+    result.durationMs = millis() - start;
+    xQueueOverwrite(weatherFetchResults, &result);
+    scheduler.notify(TASK_WEATHER);
+  }
 }
 
-void getWeatherForecast(int &code, int &temperature) {
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("WiFi not connected");
+void startWeatherFetchTask() {
+  weatherFetchRequests = xQueueCreate(1, sizeof(WeatherFetchRequest));
+  weatherFetchResults = xQueueCreate(1, sizeof(WeatherFetchResult));
+  if (!weatherFetchRequests || !weatherFetchResults ||
+      xTaskCreatePinnedToCore(weatherFetchTask, "weatherFetch", WEATHER_TASK_STACK, nullptr,
+                              WEATHER_TASK_PRIORITY, nullptr, WEATHER_TASK_CORE) != pdPASS) {
+    WP_LOGE("❌ Failed to start weather fetch task");
     return;
   }
+  WP_LOGI("Weather fetch task started on core %d", WEATHER_TASK_CORE);
+}
 
-  HTTPClient http;
-  String currentISOTime = getCurrentISOTime();
-  String apiUrl = apiUrlBase + currentISOTime + "/t_2m:C,weather_symbol_1h:idx/" +
-                  String(latitude, 6) + "," + String(longitude, 6) + "/json?model=mix";
-
-  String auth = apiUser + ":" + apiPass;
-  String encodedAuth = encodeBase64(auth);
+// Hand a fetch for the current location to the task. A fetch already in
+// flight for the same location is left alone; one for another location is
+// cancelled by the newer id.
+void requestWeatherFetch() {
+  weatherRefreshRequested = false;
+  if (!weatherFetchRequests) {
+    return;
+  }
+  if (weatherFetchPending.id != 0 &&
+      weatherFetchPending.latitude == latitude && weatherFetchPending.longitude == longitude) {
+    return;
+  }
 
-  Serial.println("API URL: " + apiUrl);
+  lastWeatherRefreshAttempt = millis();
+  if (lastWeatherRefreshAttempt == 0) lastWeatherRefreshAttempt = 1;
 
-  http.begin(apiUrl);
-  http.addHeader("Authorization", "Basic " + encodedAuth);
+  if (weatherFetchPending.id != 0) {
+    WP_LOGI("Location changed, cancelling weather fetch #%u", weatherFetchPending.id);
+  }
+  WeatherFetchRequest request = { weatherFetchGeneration + 1, latitude, longitude,
+                                  millis() + WEATHER_FETCH_DEADLINE_MS };
+  weatherFetchGeneration = request.id;
+  xQueueOverwrite(weatherFetchRequests, &request);  // Replaces one not started yet
+  weatherFetchPending = request;
+  weatherFetchWorstLoopUs = 0;
+}
 
-  int httpResponseCode = http.GET();
-  if (httpResponseCode > 0) {
-    String payload = http.getString();
-    StaticJsonDocument<1024> doc;
-    DeserializationError error = deserializeJson(doc, payload);
+// Pick up the task's result (never blocks) and store it in the cache
+void collectWeatherFetch() {
+  static WeatherFetchResult result;  // Kept off the loop() stack
+  if (weatherFetchPending.id == 0) {
+    return;
+  }
 
-    if (!error) {
-      parseWeatherSymbol(doc, code, temperature);
-      Serial.printf("Weather Code: %d, Temperature: %d°C\n", code, temperature);
-    } else {
-      Serial.println("JSON deserialization error");
+  if (xQueueReceive(weatherFetchResults, &result, 0) != pdTRUE) {
+    // Task wedged past its deadline: stop waiting and retry later
+    if ((long)(millis() - weatherFetchPending.deadline) > (long)WEATHER_FETCH_GRACE_MS) {
+      WP_LOGW("Weather fetch #%u timed out", weatherFetchPending.id);
+      weatherFetchGeneration = weatherFetchGeneration + 1;
+      weatherFetchPending.id = 0;
+      weatherFetchesDone++;
+      weatherRefreshRequested = true;
     }
-  } else {
-    Serial.printf("HTTP Error: %d\n", httpResponseCode);
-    Serial.println(http.errorToString(httpResponseCode).c_str());
+    return;
+  }
+  if (result.id != weatherFetchPending.id) {
+    return;  // Superseded request, its answer is dropped
+  }
+  weatherFetchPending.id = 0;
+  weatherFetchesDone++;
+
+  WP_LOGI("Weather fetch #%u: %s in %lu ms, worst loop() pass meanwhile %lu us",
+          result.id, result.ok ? "ok" : "failed", result.durationMs, weatherFetchWorstLoopUs);
+  if (!result.ok) {
+    WP_LOGW("Weather refresh failed, keeping cached forecast");
+    weatherRefreshRequested = true;  // Retry after WEATHER_REFRESH_RETRY_MS
+    return;
+  }
+
+  // A refresh asked for while this fetch ran is answered by it; if the
+  // current location still is not fresh, serveCachedWeather() asks again
+  weatherRefreshRequested = false;
+  weatherCache.put(result.latitude, result.longitude, millis(), result.forecast);
+  serveCachedWeather();
+  WP_LOGI("Forecast cached: %u hours ahead, %d°C now",
+          result.forecast.hoursRemaining(currentForecastHour()), lastTemperature);
+
+  if (showWeatherWhenFetched) {
+    showWeatherWhenFetched = false;
+    currentTemperature = lastTemperature;
+    interpretWeatherSymbol(weatherSymbol);
+    setLEDRGB(currentTemperature);
+  } else if (animationActive) {
+    currentTemperature = lastTemperature;  // Running animation picks up the new value
   }
+}
 
-  http.end();
+// Skip JSON whitespace; true when the character after it is `c` (consumed)
+static bool skipJsonSpaceTo(Stream &stream, char c) {
+  int next;
+  do {
+    next = stream.read();
+  } while (next == ' ' || next == '\t' || next == '\r' || next == '\n');
+  return next == c;
 }
 
-void parseWeatherSymbol(JsonDocument &doc, int &code, int &temperature) {
-  code = -1;
-  temperature = -999;
+// Move past `quotedKey` and the ':' after it, however they are spaced
+static bool findJsonKey(Stream &stream, const char *quotedKey) {
+  return stream.find(quotedKey) && skipJsonSpaceTo(stream, ':');
+}
 
-  JsonArray dataArray = doc["data"];
+// One bit per forecast slot, for the hours a series has filled
+static_assert(FORECAST_HOURS <= 64, "A series' hours must fit a uint64_t");
+
+// Parse the Meteomatics answer straight off the socket. For each series, read
+// its "parameter" name, then deserialize the "dates" array one element at a
+// time (filtered down to "date" and "value") into the slot for its date. Only
+// a single date entry is ever held in RAM, however many hours were requested.
+// Hours may come in any order, but a series with an hour missing or outside
+// the request is rejected, and so is an answer whose series cover different
+// hours or that lacks one of the parameters: a short series would otherwise
+// read as zeros. A cancelled request stops the parse between two entries.
+bool parseForecastStream(Stream &stream, uint32_t startHour, ForecastStore &forecast,
+                         const WeatherFetchRequest *request) {
+  static StaticJsonDocument<JSON_OBJECT_SIZE(2)> filter;
+  if (filter.isNull()) {
+    filter["date"] = true;
+    filter["value"] = true;
+  }
+
+  forecast.clear(startHour);
 
-  for (JsonObject dataObject : dataArray) {
-    const char* parameter = dataObject["parameter"];
+  uint8_t seen = 0;       // One bit per ForecastParam
+  uint64_t hours = 0;     // The hours of the first series; every other must match
+  char parameter[32];
+  while (findJsonKey(stream, "\"parameter\"")) {
+    if (!skipJsonSpaceTo(stream, '"')) {
+      break;
+    }
+    size_t len = stream.readBytesUntil('"', parameter, sizeof(parameter) - 1);
+    parameter[len] = '\0';
+    ForecastParam param = forecastParamFromName(parameter);
 
-    if (strcmp(parameter, "t_2m:C") == 0) {
-      temperature = dataObject["coordinates"][0]["dates"][0]["value"];
+    if (!findJsonKey(stream, "\"dates\"") || !skipJsonSpaceTo(stream, '[')) {
+      break;
     }
 
-    if (strcmp(parameter, "weather_symbol_1h:idx") == 0) {
-      code = dataObject["coordinates"][0]["dates"][0]["value"];
+    uint64_t filled = 0;
+    do {
+      if (request && weatherFetchCancelled(*request)) {
+        return false;
+      }
+      StaticJsonDocument<FORECAST_DATE_DOC_SIZE> entry;
+      DeserializationError error = deserializeJson(entry, stream, DeserializationOption::Filter(filter));
+      if (error) {
+        WP_LOGE("Weather JSON error in %s: %s", parameter, error.c_str());
+        return false;
+      }
+      uint32_t hour;
+      if (!parseIsoHour(entry["date"], hour) || hour < startHour || hour >= startHour + FORECAST_HOURS) {
+        WP_LOGE("Weather JSON: %s has a date outside the request", parameter);
+        return false;
+      }
+      forecast.set(param, hour - startHour, entry["value"].as<float>());
+      filled |= 1ULL << (hour - startHour);
+    } while (stream.findUntil(",", "]"));
+
+    if (filled & (filled + 1)) {  // Not every hour from startHour on
+      WP_LOGE("Weather JSON: %s is missing hours", parameter);
+      return false;
+    }
+    if (param == FORECAST_UNKNOWN) {
+      continue;
     }
+    if (seen && filled != hours) {
+      WP_LOGE("Weather JSON: %s covers other hours than the rest", parameter);
+      return false;
+    }
+    hours = filled;
+    seen |= 1 << param;
   }
 
-  lastTemperature = temperature;
+  if (seen != (1 << FORECAST_UNKNOWN) - 1) {
+    WP_LOGE("Weather JSON: a parameter is missing");
+    return false;
+  }
+  return true;
 }
 
 // ============================================================================
-// LED & BUZZER FUNCTIONS
+// CONFIGURATION
 // ============================================================================
 
-void setLEDRGB(int temperature) {
-  static unsigned long animationStartTime = 0;
-  static unsigned long lastUpdateTime = 0;
-  static int animationStep = 0;
+// Restore the saved network and location; false when nothing valid is saved
+bool loadConfig() {
+  ConfigRecord record;
+  if (!configStore.load(record)) {
+    WP_LOGI("No saved configuration");
+    return false;
+  }
+  wifiSSID = record.ssid;
+  wifiPassword = record.password;
+  latitude = record.latitude;
+  longitude = record.longitude;
+  WP_LOGI("Loaded saved configuration: SSID \"%s\", %.4f, %.4f", record.ssid, latitude, longitude);
+  return true;
+}
 
-  const unsigned long animationDuration = 10000;
-  const unsigned long updateInterval = 100;
+// Persist the current network and location (a no-op when nothing changed)
+void saveConfig() {
+  ConfigRecord record;
+  strncpy(record.ssid, wifiSSID.c_str(), CONFIG_SSID_MAX);
+  strncpy(record.password, wifiPassword.c_str(), CONFIG_PASSWORD_MAX);
+  record.latitude = latitude;
+  record.longitude = longitude;
+  if (!configStore.save(record)) {
+    WP_LOGE("Failed to save configuration");
+  }
+}
 
-  unsigned long currentTime = millis();
+// ============================================================================
+// DEEP SLEEP
+// ============================================================================
 
-  if (!animationActive) {
-    Serial.println("Starting LED animation...");
-    animationStartTime = currentTime;
-    lastUpdateTime = currentTime;
-    animationStep = 0;
-    animationActive = true;
+void noteActivity() {
+  lastActivityMs = millis();
+}
+
+// Put back what sleepWhenIdle() kept in RTC memory and render it: the cached
+// forecast for the current hour when the clock (kept by the RTC through
+// sleep) says which hour that is, else what was on display. Stale weather
+// is refreshed by loop() once WiFi is back. False after a power-on.
+bool showSleepSnapshot() {
+  if (!sleepSnapshotValid(sleepSnapshot)) {
+    return false;
+  }
+  unsigned long start = micros();
+  latitude = sleepSnapshot.latitude;
+  longitude = sleepSnapshot.longitude;
+
+  ForecastStore forecast;
+  memcpy(&forecast, sleepSnapshot.forecast, sizeof(forecast));
+  time_t now = time(nullptr);
+  if (forecast.size() > 0 && now >= TIME_VALID_AFTER && (uint32_t)now >= sleepSnapshot.fetchedAt) {
+    unsigned long ageMs = (unsigned long)(now - sleepSnapshot.fetchedAt) * 1000UL;
+    weatherCache.put(latitude, longitude, millis() - ageMs, forecast);
   }
 
-  if (animationActive && (currentTime - animationStartTime >= animationDuration)) {
-    Serial.println("Ending LED animation...");
-    for (int i = 0; i < NUM_LEDS; i++) {
-      strip.setPixelColor(i, strip.Color(0, 0, 0));
-    }
-    strip.show();
-    animationActive = false;
+  if (serveCachedWeather()) {
+    currentTemperature = lastTemperature;
+  } else {
+    weatherSymbol = sleepSnapshot.symbol;
+    lastTemperature = currentTemperature = sleepSnapshot.temperature;
+  }
+  interpretWeatherSymbol(weatherSymbol);
+  setLEDRGB(currentTemperature);
+  WP_LOGI("Woken by touch: weather on display %lu us into setup()", micros() - start);
+  return true;
+}
+
+// Deep sleep once nothing has happened for sleepAfterIdleMs and nothing is
+// left to finish: the animation and tone, a weather fetch, onboarding (BLE or
+// the AP). The touch pad's digital output wakes the chip (ext0, high).
+void sleepWhenIdle() {
+  if (sleepAfterIdleMs == 0 || millis() - lastActivityMs < sleepAfterIdleMs) {
+    return;
+  }
+  if (animationActive || buzzer.playing() || weatherFetchPending.id != 0 || bleEnabled ||
+      WiFi.softAPIP() != IPAddress() || wifiSSID.length() == 0) {
     return;
   }
 
-  if (animationActive && (currentTime - lastUpdateTime >= updateInterval)) {
-    lastUpdateTime = currentTime;
+  SleepSnapshot &snapshot = sleepSnapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  snapshot.latitude = latitude;
+  snapshot.longitude = longitude;
+  snapshot.symbol = weatherSymbol;
+  snapshot.temperature = lastTemperature;
+  const ForecastStore *forecast = weatherCache.forecast(latitude, longitude);
+  unsigned long ageMs;
+  if (forecast && weatherCache.age(latitude, longitude, millis(), ageMs)) {
+    memcpy(snapshot.forecast, forecast, sizeof(*forecast));
+    snapshot.fetchedAt = (uint32_t)(time(nullptr) - (time_t)(ageMs / 1000));
+  }
+  sealSleepSnapshot(snapshot);
 
-    if (temperature <= 0) {
-      // Cold: Blue gradient rotation
-      for (int i = 0; i < NUM_LEDS; i++) {
-        float factor = 1.0 - (((i + animationStep) % NUM_LEDS) / (float)NUM_LEDS);
-        int adjustedBlue = map(temperature, -10, 0, 128, 255) * factor;
-        strip.setPixelColor((i + animationStep) % NUM_LEDS, strip.Color(0, 0, adjustedBlue));
-      }
-      animationStep = (animationStep + 1) % NUM_LEDS;
-    } else if (temperature > 0 && temperature <= 25) {
-      // Moderate: Pulsing cyan/green
-      static int brightness = 0;
-      static bool increasing = true;
-
-      if (increasing) {
-        brightness += 15;
-        if (brightness >= 255) increasing = false;
-      } else {
-        brightness -= 15;
-        if (brightness <= 0) increasing = true;
-      }
+  WP_LOGI("💤 Idle for %lu s, deep sleep until touched", (millis() - lastActivityMs) / 1000);
+  strip.clear();
+  strip.show();
+  strip.flush();
+  wsClient.disconnect();
+  WiFi.disconnect(true);
+  logger.drain(Serial);
+  Serial.flush();
+
+  esp_sleep_enable_ext0_wakeup((gpio_num_t)CAP_SENSOR_PIN, HIGH);
+  esp_deep_sleep_start();
+}
 
-      int red = map(temperature, 0, 25, 0, 128);
-      int green = map(temperature, 0, 25, 255, 128);
-      int blue = map(temperature, 0, 25, 255, 64);
+// ============================================================================
+// LOGGING
+// ============================================================================
 
-      for (int i = 0; i < NUM_LEDS; i++) {
-        int adjustedRed = red * brightness / 255;
-        int adjustedGreen = green * brightness / 255;
-        int adjustedBlue = blue * brightness / 255;
-        strip.setPixelColor(i, strip.Color(adjustedRed, adjustedGreen, adjustedBlue));
-      }
-    } else if (temperature > 25) {
-      // Hot: Flame effect
-      for (int i = 0; i < NUM_LEDS; i++) {
-        if (random(10) > 7) {
-          strip.setPixelColor(i, strip.Color(255, random(64, 128), 0));
-        } else {
-          strip.setPixelColor(i, strip.Color(128, random(32, 64), 0));
-        }
-      }
+// Sole consumer of the log ring: writes queued lines to Serial, so only this
+// task ever waits on the UART
+void logDrainTask(void *param) {
+  (void)param;
+  for (;;) {
+    if (logger.drain(Serial) == 0) {
+      vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_IDLE_MS));
     }
+  }
+}
 
-    strip.show();
+void startLogTask() {
+  static bool started = false;
+  if (started) {
+    return;
+  }
+  started = xTaskCreate(logDrainTask, "logDrain", LOG_TASK_STACK, nullptr, LOG_TASK_PRIORITY, nullptr) == pdPASS;
+  if (!started) {
+    Serial.println("Failed to start log task, logging is disabled");
   }
 }
 
-void playCloudyMelody() {
-  int melody[] = {261, 294, 330, 294, 261};
-  int noteDurations[] = {400, 400, 600, 400, 600};
+// ============================================================================
+// LED & BUZZER FUNCTIONS
+// ============================================================================
 
-  for (int i = 0; i < 5; i++) {
-    tone(BUZZER_PIN, melody[i], noteDurations[i]);
-    delay(noteDurations[i] * 1.3);
-  }
-  noTone(BUZZER_PIN);
+void setupOutputs() {
+  pinMode(BUZZER_PIN, OUTPUT);
+
+  // LED ring on the RMT
+  strip.begin();
+  strip.show();
+  strip.setBrightness(50);
+
+  // Setup buzzer LEDC
+  ledc_timer_config_t ledc_timer = {
+    .speed_mode = BUZZER_MODE,
+    .duty_resolution = BUZZER_RESOLUTION,
+    .timer_num = BUZZER_TIMER,
+    .freq_hz = BUZZER_FREQUENCY,
+    .clk_cfg = LEDC_AUTO_CLK
+  };
+  ESP_ERROR_CHECK(ledc_timer_config(&ledc_timer));
+
+  ledc_channel_config_t ledc_channel = {
+    .gpio_num = BUZZER_PIN,
+    .speed_mode = BUZZER_MODE,
+    .channel = BUZZER_CHANNEL,
+    .intr_type = LEDC_INTR_DISABLE,
+    .timer_sel = BUZZER_TIMER,
+    .duty = 0,
+    .hpoint = 0
+  };
+  ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
+  buzzer.begin();
 }
 
-void playToneIfNecessary(String weatherCondition) {
+// Starts the weather animation for `temperature`, or shows its next frame
+// when one is due (see led_animation.h)
+void setLEDRGB(int temperature) {
   unsigned long currentTime = millis();
 
-  if (!isToneActive) {
-    if (weatherCondition == "clear_sky") {
-      toneFrequency = 1000;
-      toneDuration = 500;
-    } else if (weatherCondition == "light_clouds" || weatherCondition == "partly_cloudy") {
-      toneFrequency = 800;
-      toneDuration = 400;
-    } else if (weatherCondition == "cloudy" || weatherCondition == "overcast") {
-      playCloudyMelody();
-      return;
-    } else if (weatherCondition == "rain" || weatherCondition == "rain_shower" || weatherCondition == "drizzle") {
-      toneFrequency = 500 + random(-100, 100);
-      toneDuration = 200;
-    } else if (weatherCondition == "thunderstorm") {
-      toneFrequency = 200;
-      toneDuration = 700;
-    } else if (weatherCondition == "snow" || weatherCondition == "snow_shower") {
-      toneFrequency = 1200;
-      toneDuration = 300;
-    } else if (weatherCondition == "light_fog") {
-      toneFrequency = 400;
-      toneDuration = 800;
-    } else if (weatherCondition == "dense_fog") {
-      toneFrequency = 300;
-      toneDuration = 1000;
-    } else if (weatherCondition == "freezing_rain") {
-      toneFrequency = 700;
-      toneDuration = 300;
-    } else if (weatherCondition == "sandstorm") {
-      toneFrequency = 300 + random(-50, 50);
-      toneDuration = 200;
-    } else {
-      toneFrequency = 0;
-      toneDuration = 0;
-    }
-
-    if (toneFrequency > 0 && toneDuration > 0) {
-      ledc_set_freq(BUZZER_MODE, BUZZER_TIMER, toneFrequency);
-      ledc_set_duty(BUZZER_MODE, BUZZER_CHANNEL, 128);
-      ledc_update_duty(BUZZER_MODE, BUZZER_CHANNEL);
-      toneStartTime = currentTime;
-      isToneActive = true;
-    }
+  if (!animationActive) {
+    WP_LOGD("Starting LED animation...");
+    ledAnimation.start(currentTime);
+    animationActive = true;
+    scheduler.every(TASK_LED, LED_FRAME_MS);
   }
 
-  if (isToneActive && currentTime - toneStartTime >= toneDuration) {
-    ledc_set_duty(BUZZER_MODE, BUZZER_CHANNEL, 0);
-    ledc_update_duty(BUZZER_MODE, BUZZER_CHANNEL);
-    isToneActive = false;
+  if (!ledAnimation.update(temperature, currentTime)) {
+    WP_LOGD("Ending LED animation...");
+    animationActive = false;
+    scheduler.every(TASK_LED, 0);
   }
 }
 
-void interpretWeatherSymbol(int code, int temperature) {
-  if (code >= 100) {
-    code -= 100;
+// The LED task: next frame of the running animation
+void renderLEDFrame() {
+  if (animationActive) {
+    setLEDRGB(currentTemperature);
+  } else {
+    scheduler.every(TASK_LED, 0);  // Stopped from elsewhere (long press, deep sleep)
   }
+}
 
-  String weatherCondition = "";
-
-  switch (code) {
-    case 0: weatherCondition = ""; break;
-    case 1: weatherCondition = "clear_sky"; break;
-    case 2: weatherCondition = "light_clouds"; break;
-    case 3: weatherCondition = "partly_cloudy"; break;
-    case 4: weatherCondition = "cloudy"; break;
-    case 5: weatherCondition = "rain"; break;
-    case 6: weatherCondition = "rain_and_snow"; break;
-    case 7: weatherCondition = "snow"; break;
-    case 8: weatherCondition = "rain_shower"; break;
-    case 9: weatherCondition = "snow_shower"; break;
-    case 10: weatherCondition = "sleet_shower"; break;
-    case 11: weatherCondition = "light_fog"; break;
-    case 12: weatherCondition = "dense_fog"; break;
-    case 13: weatherCondition = "freezing_rain"; break;
-    case 14: weatherCondition = "thunderstorm"; break;
-    case 15: weatherCondition = "drizzle"; break;
-    case 16: weatherCondition = "sandstorm"; break;
-    default: weatherCondition = ""; break;
+// Starts the condition's melody unless one is still playing. Returns at
+// once: the notes play in the background.
+void playToneIfNecessary(WeatherCondition condition) {
+  const ConditionInfo &info = conditionInfo(condition);
+  if (!info.melody || buzzer.playing()) {
+    return;
   }
+  int16_t detuneHz = info.detuneHz ? (int16_t)random(-info.detuneHz, info.detuneHz) : 0;
+  buzzer.play(info.melody, info.melodyLength, detuneHz);
+}
+
+void interpretWeatherSymbol(int code) {
+  WeatherCondition condition = weatherCondition(code);
 
-  playToneIfNecessary(weatherCondition);
-  lastWeatherCondition = weatherCondition;
+  playToneIfNecessary(condition);
+  lastWeatherCondition = condition;
 }
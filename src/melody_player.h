@@ -0,0 +1,142 @@
+#ifndef MELODY_PLAYER_H
+#define MELODY_PLAYER_H
+
+#include <Arduino.h>
+#include "driver/ledc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+// LEDC duty at full volume: a 50% square wave, the loudest a piezo gets
+// (8-bit duty resolution)
+#define MELODY_FULL_DUTY 128
+
+struct Note {
+  uint16_t frequencyHz;  // 0: a rest
+  uint16_t durationMs;
+  uint8_t volume;        // % of MELODY_FULL_DUTY
+};
+
+// Plays note tables on the buzzer's LEDC channel in the background. play()
+// and stop() only leave a command and fire the esp_timer; every note change
+// is made by the timer callback on the esp_timer task, so no caller waits on
+// a note and LEDC writes never race. Note tables must outlive the melody
+// (static const arrays).
+class MelodyPlayer {
+ public:
+  MelodyPlayer(ledc_mode_t mode, ledc_timer_t timer, ledc_channel_t channel)
+      : mode_(mode), ledcTimer_(timer), channel_(channel) {}
+
+  // After the LEDC timer and channel are configured
+  void begin() {
+    if (timer_) {
+      return;
+    }
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.arg = this;
+    args.name = "melody";
+    esp_timer_create(&args, &timer_);
+  }
+
+  // Starts `count` notes, each pitched `detuneHz` off, cutting off whatever
+  // is playing. Returns at once.
+  void play(const Note *notes, uint8_t count, int16_t detuneHz = 0) {
+    portENTER_CRITICAL(&mux_);
+    pendingNotes_ = notes;
+    pendingCount_ = count;
+    pendingDetuneHz_ = detuneHz;
+    command_ = COMMAND_PLAY;
+    playing_ = count > 0;
+    kick();
+    portEXIT_CRITICAL(&mux_);
+  }
+
+  // Silences the buzzer at once
+  void stop() {
+    portENTER_CRITICAL(&mux_);
+    command_ = COMMAND_STOP;
+    playing_ = false;
+    kick();
+    portEXIT_CRITICAL(&mux_);
+  }
+
+  // From play() until the last note has ended
+  bool playing() const { return playing_; }
+
+ private:
+  enum Command : uint8_t { COMMAND_NONE, COMMAND_PLAY, COMMAND_STOP };
+
+  static void onTimer(void *arg) { ((MelodyPlayer *)arg)->step(); }
+
+  // Under mux_: the callback runs as soon as the esp_timer task gets to it
+  void kick() {
+    if (timer_) {
+      esp_timer_stop(timer_);
+      esp_timer_start_once(timer_, 0);
+    }
+  }
+
+  // esp_timer task: take a command, or move on to the next note
+  void step() {
+    uint16_t frequencyHz = 0;
+    uint8_t volume = 0;
+    portENTER_CRITICAL(&mux_);
+    if (command_ == COMMAND_PLAY) {
+      notes_ = pendingNotes_;
+      count_ = pendingCount_;
+      detuneHz_ = pendingDetuneHz_;
+      next_ = 0;
+    } else if (command_ == COMMAND_STOP) {
+      count_ = 0;
+      next_ = 0;
+    }
+    command_ = COMMAND_NONE;
+    if (next_ < count_) {
+      const Note &note = notes_[next_++];
+      if (note.frequencyHz) {
+        frequencyHz = (uint16_t)max(1, note.frequencyHz + detuneHz_);
+        volume = note.volume;
+      }
+      esp_timer_start_once(timer_, (uint64_t)note.durationMs * 1000);
+    } else {
+      count_ = 0;
+      playing_ = false;
+    }
+    portEXIT_CRITICAL(&mux_);
+
+    // Unchanged pitch or silence again: no LEDC writes
+    uint32_t duty = frequencyHz ? (uint32_t)volume * MELODY_FULL_DUTY / 100 : 0;
+    if (frequencyHz && frequencyHz != frequencyHz_) {
+      ledc_set_freq(mode_, ledcTimer_, frequencyHz);
+      frequencyHz_ = frequencyHz;
+    }
+    if (duty != duty_) {
+      ledc_set_duty(mode_, channel_, duty);
+      ledc_update_duty(mode_, channel_);
+      duty_ = duty;
+    }
+  }
+
+  ledc_mode_t mode_;
+  ledc_timer_t ledcTimer_;
+  ledc_channel_t channel_;
+  esp_timer_handle_t timer_ = nullptr;
+  portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+
+  // Left by play()/stop() for the next step()
+  Command command_ = COMMAND_NONE;
+  const Note *pendingNotes_ = nullptr;
+  uint8_t pendingCount_ = 0;
+  int16_t pendingDetuneHz_ = 0;
+
+  // What step() is playing; esp_timer task only, besides playing_
+  const Note *notes_ = nullptr;
+  uint8_t count_ = 0;
+  uint8_t next_ = 0;
+  int16_t detuneHz_ = 0;
+  volatile bool playing_ = false;
+  uint16_t frequencyHz_ = 0;  // Last written to LEDC
+  uint32_t duty_ = 0;
+};
+
+#endif // MELODY_PLAYER_H
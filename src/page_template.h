@@ -0,0 +1,107 @@
+#ifndef PAGE_TEMPLATE_H
+#define PAGE_TEMPLATE_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Bytes a TemplateRenderer gathers before passing them on as one chunk
+#define TEMPLATE_CHUNK_MAX 256
+
+// A web/*.tmpl.html page with %NAME% fields, split at build time by
+// scripts/embed_web_pages.py (see the generated web_pages.h). Each segment
+// is literal text followed by the field that comes after it; the last
+// segment has no field.
+struct TemplateSegment {
+  const char *text;
+  size_t length;
+  const char *field;
+};
+
+struct PageTemplate {
+  const char *contentType;
+  const TemplateSegment *segments;
+  size_t count;
+};
+
+// Streams a PageTemplate through one fixed buffer, so a page costs the same
+// memory however long it is. Field values are printed into the renderer
+// (it is a Print), so print(int) or print(IPAddress) need no String.
+// Literal text too long to gather is passed on straight from flash.
+class TemplateRenderer : public Print {
+ public:
+  typedef void (*Flush)(void *context, const char *data, size_t length);
+  // Prints the value of the field called `name`; unknown names print nothing
+  typedef void (*Field)(const char *name, Print &out);
+
+  TemplateRenderer(Flush fn, void *fnContext) : flush(fn), context(fnContext) {}
+
+  // Renders every segment and flushes what is left; returns the bytes produced
+  size_t render(const PageTemplate &page, Field field) {
+    for (size_t i = 0; i < page.count; i++) {
+      const TemplateSegment &segment = page.segments[i];
+      if (segment.length >= sizeof(buf)) {
+        emitBuffer();
+        emit(segment.text, segment.length);
+      } else {
+        write((const uint8_t *)segment.text, segment.length);
+      }
+      if (segment.field) {
+        field(segment.field, *this);
+      }
+    }
+    emitBuffer();
+    return total;
+  }
+
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *data, size_t length) override {
+    size_t left = length;
+    while (left > 0) {
+      if (used == sizeof(buf)) {
+        emitBuffer();
+      }
+      size_t n = left < sizeof(buf) - used ? left : sizeof(buf) - used;
+      memcpy(buf + used, data, n);
+      used += n;
+      data += n;
+      left -= n;
+    }
+    return length;
+  }
+
+ private:
+  void emitBuffer() {
+    emit(buf, used);
+    used = 0;
+  }
+
+  // Never hands on an empty chunk: for chunked HTTP that would end the body
+  void emit(const char *data, size_t length) {
+    if (length == 0) return;
+    flush(context, data, length);
+    total += length;
+  }
+
+  Flush flush;
+  void *context;
+  char buf[TEMPLATE_CHUNK_MAX];
+  size_t used = 0;
+  size_t total = 0;
+};
+
+// Sends a rendered template as a chunked 200 response
+inline void sendPageTemplate(WebServer &server, const PageTemplate &page, TemplateRenderer::Field field) {
+  struct Chunk {
+    static void send(void *context, const char *data, size_t length) {
+      ((WebServer *)context)->sendContent(data, length);
+    }
+  };
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, page.contentType, "");
+  TemplateRenderer renderer(Chunk::send, &server);
+  renderer.render(page, field);
+  server.sendContent("");  // Last chunk
+}
+
+#endif // PAGE_TEMPLATE_H
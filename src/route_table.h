@@ -0,0 +1,68 @@
+#ifndef ROUTE_TABLE_H
+#define ROUTE_TABLE_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// One endpoint of the local API. The firmware keeps a single table of these:
+// the WebServer registers every entry, and the WebSocket relay looks requests
+// up in it, so both see the same endpoints.
+struct Route {
+  const char *path;
+  HTTPMethod method;
+  void (*handler)();
+  bool relay;  // Also reachable through the relay (JSON endpoints only)
+};
+
+// Written as single-expression recursions so they stay constexpr under the
+// ESP32 toolchain's C++11.
+namespace route_table {
+
+constexpr int compare(const char *a, const char *b) {
+  return *a != *b ? (int)(unsigned char)*a - (int)(unsigned char)*b : (*a == '\0' ? 0 : compare(a + 1, b + 1));
+}
+
+// Table order: by path, then method
+constexpr int compare(const Route &route, const char *path, HTTPMethod method) {
+  return compare(route.path, path) != 0 ? compare(route.path, path) : (int)route.method - (int)method;
+}
+
+template <size_t N>
+constexpr bool isSorted(const Route (&table)[N], size_t i = 1) {
+  return i >= N || (compare(table[i - 1], table[i].path, table[i].method) < 0 && isSorted(table, i + 1));
+}
+
+}  // namespace route_table
+
+// Binary search of a table that passed route_table::isSorted(); nullptr when
+// no entry matches
+template <size_t N>
+const Route *findRoute(const Route (&table)[N], const char *path, HTTPMethod method) {
+  size_t lo = 0, hi = N;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    int c = route_table::compare(table[mid], path, method);
+    if (c == 0) return &table[mid];
+    if (c < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return nullptr;
+}
+
+// "GET", "POST", ... as used in relay messages; HTTP_ANY when unknown
+inline HTTPMethod httpMethodFromName(const char *name) {
+  if (!name) return HTTP_ANY;
+  if (strcmp(name, "GET") == 0) return HTTP_GET;
+  if (strcmp(name, "POST") == 0) return HTTP_POST;
+  if (strcmp(name, "OPTIONS") == 0) return HTTP_OPTIONS;
+  if (strcmp(name, "PUT") == 0) return HTTP_PUT;
+  if (strcmp(name, "DELETE") == 0) return HTTP_DELETE;
+  if (strcmp(name, "PATCH") == 0) return HTTP_PATCH;
+  if (strcmp(name, "HEAD") == 0) return HTTP_HEAD;
+  return HTTP_ANY;
+}
+
+#endif // ROUTE_TABLE_H
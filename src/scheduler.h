@@ -0,0 +1,198 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Most tasks one Scheduler runs; one bit each in the notification mask
+#define SCHEDULER_MAX_TASKS 16
+
+// One job of the main loop. `periodMs` 0: runs only when asked with runIn()
+// or notify(). The table entry is constant; every() changes the period of
+// the running schedule.
+struct ScheduledTask {
+  const char *name;
+  void (*run)();
+  uint32_t periodMs;
+};
+
+// What a task cost and how far behind its deadlines it ran
+struct ScheduledTaskStats {
+  uint32_t runs;
+  uint32_t missed;       // Whole periods skipped because the task fell that far behind
+  uint64_t totalUs;      // Time spent running
+  uint32_t maxUs;
+  uint64_t totalLateUs;  // Start past the deadline, summed over deadline runs
+  uint32_t maxLateUs;
+};
+
+// Runs a fixed table of tasks from loop(), each at its own period or
+// deadline, and works out how long loop() may sleep before the next one is
+// due. Other tasks, the esp_timer task and ISRs hand work to it with
+// notify(), which also cuts that sleep short.
+//
+// Tasks are few, so the next deadline is found by scanning them, not from a
+// timer wheel or heap: 8 tasks compare in well under a microsecond.
+class Scheduler {
+ public:
+  Scheduler(const ScheduledTask *tasks, uint8_t count) : tasks_(tasks), count_(count) {}
+
+  // From the task that will call runDue() and wait(), before either. Every
+  // periodic task is due at once; the others wait to be asked.
+  void begin() {
+    loopTask_ = xTaskGetCurrentTaskHandle();
+    int64_t now = esp_timer_get_time();
+    for (uint8_t i = 0; i < count_; i++) {
+      periodUs_[i] = (int64_t)tasks_[i].periodMs * 1000;
+      dueUs_[i] = periodUs_[i] ? now : (int64_t)NEVER;
+      stats_[i] = ScheduledTaskStats();
+    }
+    pending_ = 0;
+    notified_.store(0);
+  }
+
+  // Run `task` once, `ms` from now, on top of its period. Loop task only.
+  void runIn(uint8_t task, uint32_t ms) {
+    dueUs_[task] = esp_timer_get_time() + (int64_t)ms * 1000;
+    rescheduled_ |= bit(task);
+  }
+
+  // Run `task` every `periodMs` from now on, the first time one period from
+  // now; 0 stops it. Loop task only.
+  void every(uint8_t task, uint32_t periodMs) {
+    periodUs_[task] = (int64_t)periodMs * 1000;
+    dueUs_[task] = periodMs ? esp_timer_get_time() + periodUs_[task] : (int64_t)NEVER;
+    rescheduled_ |= bit(task);
+  }
+
+  // Run `task` at the next pass and end wait() early. Any task or ISR.
+  void IRAM_ATTR notify(uint8_t task) {
+    notified_.fetch_or(bit(task));
+    if (!loopTask_) {
+      return;
+    }
+    if (xPortInIsrContext()) {
+      BaseType_t woken = pdFALSE;
+      vTaskNotifyGiveFromISR(loopTask_, &woken);
+      if (woken) {
+        portYIELD_FROM_ISR();
+      }
+    } else {
+      xTaskNotifyGive(loopTask_);
+    }
+  }
+
+  // Run every task that is due or was notified, earliest deadline first,
+  // each at most once per call. Returns the ms until the next deadline.
+  uint32_t runDue() {
+    uint32_t ran = 0;
+    for (;;) {
+      int64_t now = esp_timer_get_time();
+      pending_ |= notified_.exchange(0);
+
+      int next = -1;
+      int64_t nextDue = 0;
+      for (uint8_t i = 0; i < count_; i++) {
+        if (ran & bit(i)) {
+          continue;
+        }
+        int64_t due = (pending_ & bit(i)) ? now : dueUs_[i];
+        if (due <= now && (next < 0 || due < nextDue)) {
+          next = i;
+          nextDue = due;
+        }
+      }
+      if (next < 0) {
+        break;
+      }
+      ran |= bit(next);
+      run(next, now);
+    }
+    return msUntilNextDue();
+  }
+
+  // Sleep until the next deadline or a notify(), whichever comes first
+  void wait(uint32_t ms) {
+    if (ms > 0) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+    }
+  }
+
+  uint8_t count() const { return count_; }
+  const char *name(uint8_t task) const { return tasks_[task].name; }
+  const ScheduledTaskStats &stats(uint8_t task) const { return stats_[task]; }
+
+ private:
+  // Used in ?: only as (int64_t)NEVER: a plain NEVER binds to a reference
+  // there, which needs an out-of-line definition before C++17
+  static constexpr int64_t NEVER = INT64_MAX;
+
+  static uint32_t bit(uint8_t task) { return 1u << task; }
+
+  void run(uint8_t task, int64_t now) {
+    int64_t due = dueUs_[task];
+    bool onDeadline = due <= now;
+    pending_ &= ~bit(task);
+    rescheduled_ &= ~bit(task);
+
+    tasks_[task].run();
+
+    ScheduledTaskStats &stats = stats_[task];
+    uint32_t tookUs = (uint32_t)(esp_timer_get_time() - now);
+    stats.runs++;
+    stats.totalUs += tookUs;
+    if (tookUs > stats.maxUs) stats.maxUs = tookUs;
+    if (!onDeadline) {
+      return;  // Notified early: the deadline still stands
+    }
+    uint32_t lateUs = (uint32_t)min(now - due, (int64_t)UINT32_MAX);
+    stats.totalLateUs += lateUs;
+    if (lateUs > stats.maxLateUs) stats.maxLateUs = lateUs;
+
+    if (rescheduled_ & bit(task)) {
+      return;  // The task set its own next deadline
+    }
+    if (!periodUs_[task]) {
+      dueUs_[task] = NEVER;
+      return;
+    }
+    // Next period from the deadline, not from now, so the cadence does not
+    // drift; periods already over are skipped, not run back to back
+    dueUs_[task] += periodUs_[task];
+    if (dueUs_[task] <= now) {
+      int64_t behind = (now - dueUs_[task]) / periodUs_[task] + 1;
+      stats.missed += (uint32_t)behind;
+      dueUs_[task] += behind * periodUs_[task];
+    }
+  }
+
+  uint32_t msUntilNextDue() const {
+    if (pending_ || notified_.load()) {
+      return 0;
+    }
+    int64_t next = NEVER;
+    for (uint8_t i = 0; i < count_; i++) {
+      if (dueUs_[i] < next) next = dueUs_[i];
+    }
+    if (next == NEVER) {
+      return UINT32_MAX;
+    }
+    int64_t waitUs = next - esp_timer_get_time();
+    return waitUs <= 0 ? 0 : (uint32_t)min((waitUs + 999) / 1000, (int64_t)UINT32_MAX);
+  }
+
+  const ScheduledTask *tasks_;
+  uint8_t count_;
+  TaskHandle_t loopTask_ = nullptr;
+  int64_t periodUs_[SCHEDULER_MAX_TASKS];
+  int64_t dueUs_[SCHEDULER_MAX_TASKS];
+  ScheduledTaskStats stats_[SCHEDULER_MAX_TASKS];
+  uint32_t pending_ = 0;      // Notified, not run yet
+  uint32_t rescheduled_ = 0;  // runIn() or every() since the task last started
+  std::atomic<uint32_t> notified_{0};
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,42 @@
+#ifndef SLEEP_SNAPSHOT_H
+#define SLEEP_SNAPSHOT_H
+
+#include <Arduino.h>
+#include "config_store.h"
+#include "forecast_store.h"
+
+// Idle time after which the device deep-sleeps until the touch pad is
+// pressed. 0 (the default) never sleeps: WiFi, the HTTP server and the relay
+// stay up. -DSLEEP_AFTER_IDLE_MS=60000 in build_flags for battery builds.
+#ifndef SLEEP_AFTER_IDLE_MS
+#define SLEEP_AFTER_IDLE_MS 0
+#endif
+
+// Change when SleepSnapshot changes
+#define SLEEP_SNAPSHOT_MAGIC 0x57505331u  // "WPS1"
+
+// What the device was showing, kept in RTC slow memory (RTC_DATA_ATTR)
+// through deep sleep so a wake can render before WiFi or even NVS is up.
+// Plain data on purpose: a constructor would run on every boot and wipe it.
+// RTC memory starts out zeroed after power-on, which fails the magic check.
+struct SleepSnapshot {
+  uint32_t magic;
+  float latitude;
+  float longitude;
+  uint32_t fetchedAt;  // Wall clock (s) of the forecast fetch; millis() restarts on wake
+  int symbol;          // Last rendered, for a wake where the forecast has no current hour
+  int temperature;
+  uint8_t forecast[sizeof(ForecastStore)];  // A ForecastStore, copied byte for byte
+  uint32_t crc;        // CRC-32 of every byte before it
+};
+
+inline void sealSleepSnapshot(SleepSnapshot &snapshot) {
+  snapshot.magic = SLEEP_SNAPSHOT_MAGIC;
+  snapshot.crc = crc32(&snapshot, offsetof(SleepSnapshot, crc));
+}
+
+inline bool sleepSnapshotValid(const SleepSnapshot &snapshot) {
+  return snapshot.magic == SLEEP_SNAPSHOT_MAGIC && snapshot.crc == crc32(&snapshot, offsetof(SleepSnapshot, crc));
+}
+
+#endif // SLEEP_SNAPSHOT_H
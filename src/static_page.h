@@ -0,0 +1,39 @@
+#ifndef STATIC_PAGE_H
+#define STATIC_PAGE_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// A page from web/, gzipped at build time by scripts/embed_web_pages.py and
+// kept in flash (see the generated web_pages.h).
+struct StaticPage {
+  const char *contentType;
+  const uint8_t *gzip;
+  size_t length;
+  const char *etag;  // Strong validator, quotes included
+};
+
+// True when an If-None-Match value lists `etag` or is "*". If-None-Match uses
+// the weak comparison, so W/"x" matches "x" too.
+inline bool etagMatches(const char *ifNoneMatch, const char *etag) {
+  while (*ifNoneMatch == ' ') ifNoneMatch++;
+  if (ifNoneMatch[0] == '*') return true;
+  return strstr(ifNoneMatch, etag) != nullptr;
+}
+
+// 304 when the client already holds this version, otherwise the gzipped bytes
+// straight from flash, never copied to RAM. Every browser the onboarding flow
+// supports accepts gzip, so there is no uncompressed copy to fall back to.
+// The server must collect If-None-Match (see registerRoutes()).
+inline void serveStaticPage(WebServer &server, const StaticPage &page) {
+  server.sendHeader("ETag", page.etag);
+  server.sendHeader("Cache-Control", "no-cache");  // Revalidate, usually for a 304
+  if (server.hasHeader("If-None-Match") && etagMatches(server.header("If-None-Match").c_str(), page.etag)) {
+    server.send(304);
+    return;
+  }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, page.contentType, (PGM_P)page.gzip, page.length);
+}
+
+#endif // STATIC_PAGE_H
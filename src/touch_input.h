@@ -0,0 +1,176 @@
+#ifndef TOUCH_INPUT_H
+#define TOUCH_INPUT_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+// Edges closer than this to the last accepted one are contact bounce
+#define TOUCH_DEBOUNCE_US 30000
+// Held this long, a press is a long press instead of a tap
+#define TOUCH_LONG_PRESS_US 800000
+// A tap pressed this soon after the last tap's release makes a double tap
+#define TOUCH_DOUBLE_TAP_US 300000
+// Gestures waiting for loop(); a power of two
+#define TOUCH_QUEUE_LENGTH 8
+
+enum TouchGesture : uint8_t {
+  TOUCH_NONE,
+  TOUCH_TAP,         // Reported on release, without waiting out the double-tap window
+  TOUCH_DOUBLE_TAP,  // The second tap of a pair, reported instead of its TAP
+  TOUCH_LONG_PRESS,  // Reported once the press has been held long enough, not on release
+};
+
+struct TouchEvent {
+  TouchGesture gesture;
+  int64_t atUs;  // esp_timer_get_time() when the gesture was recognised
+};
+
+// Touch pad input off the pin-change interrupt. The ISR timestamps each edge
+// and runs the recogniser; an esp_timer fires the long press and re-reads the
+// pin after a bounce was dropped, so a quick release inside the debounce window
+// is not lost. Recognised gestures go into a single-reader ring: loop() takes
+// them with next() whenever it gets there, and a press shorter than a loop()
+// pass is still seen.
+class TouchInput {
+ public:
+  explicit TouchInput(uint8_t pin) : pin_(pin) {}
+
+  // After pinMode(). A pad already held (the touch that woke the device) is
+  // not a gesture: its release is ignored. `onGesture`, if given, is called
+  // after each queued gesture, from the ISR or the esp_timer task.
+  void begin(void (*onGesture)() = nullptr) {
+    onGesture_ = onGesture;
+    pressed_ = digitalRead(pin_) == HIGH;
+    longFired_ = pressed_;
+    lastEdgeUs_ = esp_timer_get_time();
+
+    if (!timer_) {
+      esp_timer_create_args_t args = {};
+      args.callback = onTimer;
+      args.arg = this;
+      args.name = "touch";
+      esp_timer_create(&args, &timer_);
+    }
+    attachInterruptArg(digitalPinToInterrupt(pin_), onEdge, this, CHANGE);
+  }
+
+  // The oldest gesture not taken yet. Lock-free: only loop() calls this.
+  bool next(TouchEvent &event) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    event = events_[head & (TOUCH_QUEUE_LENGTH - 1)];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Gestures lost because loop() left the queue full
+  uint32_t dropped() const { return dropped_; }
+
+ private:
+  static void IRAM_ATTR onEdge(void *arg) {
+    TouchInput *self = (TouchInput *)arg;
+    int64_t now = esp_timer_get_time();
+    bool level = digitalRead(self->pin_) == HIGH;
+    uint32_t queued = self->tail_.load(std::memory_order_relaxed);
+    portENTER_CRITICAL_ISR(&self->mux_);
+    self->edge(level, now);
+    portEXIT_CRITICAL_ISR(&self->mux_);
+    self->notify(queued);
+  }
+
+  // esp_timer task
+  static void onTimer(void *arg) {
+    TouchInput *self = (TouchInput *)arg;
+    int64_t now = esp_timer_get_time();
+    bool level = digitalRead(self->pin_) == HIGH;
+    uint32_t queued = self->tail_.load(std::memory_order_relaxed);
+    portENTER_CRITICAL(&self->mux_);
+    self->edge(level, now);  // An edge dropped as bounce that turned out to be real
+    if (self->pressed_ && !self->longFired_) {
+      if (now - self->pressedAtUs_ >= TOUCH_LONG_PRESS_US) {
+        self->longFired_ = true;
+        self->push(TOUCH_LONG_PRESS, now);
+      } else {
+        self->arm(self->pressedAtUs_ + TOUCH_LONG_PRESS_US, now);
+      }
+    }
+    portEXIT_CRITICAL(&self->mux_);
+    self->notify(queued);
+  }
+
+  // Outside the critical section: the hook may call into FreeRTOS
+  void IRAM_ATTR notify(uint32_t queuedBefore) {
+    if (onGesture_ && tail_.load(std::memory_order_relaxed) != queuedBefore) {
+      onGesture_();
+    }
+  }
+
+  // The rest runs under mux_
+  void IRAM_ATTR edge(bool level, int64_t now) {
+    if (level == pressed_) {
+      return;
+    }
+    if (now - lastEdgeUs_ < TOUCH_DEBOUNCE_US) {
+      arm(lastEdgeUs_ + TOUCH_DEBOUNCE_US, now);  // Look again once the bounce is over
+      return;
+    }
+    lastEdgeUs_ = now;
+    pressed_ = level;
+
+    if (pressed_) {
+      pressedAtUs_ = now;
+      longFired_ = false;
+      arm(now + TOUCH_LONG_PRESS_US, now);
+      return;
+    }
+    esp_timer_stop(timer_);
+    if (longFired_) {
+      return;
+    }
+    if (lastTapUs_ != 0 && pressedAtUs_ - lastTapUs_ <= TOUCH_DOUBLE_TAP_US) {
+      lastTapUs_ = 0;
+      push(TOUCH_DOUBLE_TAP, now);
+    } else {
+      lastTapUs_ = now;
+      push(TOUCH_TAP, now);
+    }
+  }
+
+  void IRAM_ATTR arm(int64_t atUs, int64_t now) {
+    esp_timer_stop(timer_);
+    esp_timer_start_once(timer_, atUs > now ? (uint64_t)(atUs - now) : 1);
+  }
+
+  void IRAM_ATTR push(TouchGesture gesture, int64_t now) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= TOUCH_QUEUE_LENGTH) {
+      dropped_++;
+      return;
+    }
+    events_[tail & (TOUCH_QUEUE_LENGTH - 1)] = { gesture, now };
+    tail_.store(tail + 1, std::memory_order_release);
+  }
+
+  uint8_t pin_;
+  void (*onGesture_)() = nullptr;
+  esp_timer_handle_t timer_ = nullptr;
+  portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+
+  // Recogniser state
+  bool pressed_ = false;
+  bool longFired_ = false;  // This press already reported its long press
+  int64_t lastEdgeUs_ = 0;
+  int64_t pressedAtUs_ = 0;
+  int64_t lastTapUs_ = 0;   // Release of the last TAP, 0 once it was paired
+
+  TouchEvent events_[TOUCH_QUEUE_LENGTH];
+  std::atomic<uint32_t> head_{0};  // Advanced by next()
+  std::atomic<uint32_t> tail_{0};  // Advanced by push()
+  uint32_t dropped_ = 0;
+};
+
+#endif // TOUCH_INPUT_H
@@ -0,0 +1,116 @@
+#ifndef WEATHER_CACHE_H
+#define WEATHER_CACHE_H
+
+#include <Arduino.h>
+#include "forecast_store.h"
+
+// Age of a cached forecast after which readers trigger a background refresh.
+// Each fetch covers FORECAST_HOURS, so a stale store keeps serving the
+// current hour until the series runs out. Override with
+// -DWEATHER_CACHE_TTL_MS=... in build_flags.
+#ifndef WEATHER_CACHE_TTL_MS
+#define WEATHER_CACHE_TTL_MS (3UL * 60UL * 60UL * 1000UL)
+#endif
+
+// Minimum gap between refresh attempts after a failed fetch
+#ifndef WEATHER_REFRESH_RETRY_MS
+#define WEATHER_REFRESH_RETRY_MS 30000UL
+#endif
+
+#define WEATHER_CACHE_ENTRIES 2
+
+// Forecast cache keyed by location (0.01° grid, ~1 km) and UTC hour. Each
+// entry is the hourly ForecastStore fetched for one location.
+//
+// Readers always get an answer straight from RAM when the store covers the
+// requested hour: FRESH while younger than the TTL, STALE once older. A
+// STALE answer is still served; the caller is expected to schedule a
+// refresh (stale-while-revalidate).
+class WeatherCache {
+ public:
+  enum Freshness { MISS, STALE, FRESH };
+
+  explicit WeatherCache(unsigned long ttlMs) : ttlMs(ttlMs) {
+    for (int i = 0; i < WEATHER_CACHE_ENTRIES; i++) {
+      entries[i].valid = false;
+    }
+  }
+
+  void setTtl(unsigned long newTtlMs) { ttlMs = newTtlMs; }
+  unsigned long ttl() const { return ttlMs; }
+
+  Freshness get(float lat, float lon, uint32_t hour, unsigned long now, WeatherSample &out) const {
+    const Entry *e = find(locationKey(lat), locationKey(lon));
+    if (!e || !e->forecast.sample(hour, out)) {
+      return MISS;
+    }
+    return (now - e->fetchedAt < ttlMs) ? FRESH : STALE;
+  }
+
+  // Whole stored series for a location, or nullptr
+  const ForecastStore *forecast(float lat, float lon) const {
+    const Entry *e = find(locationKey(lat), locationKey(lon));
+    return e ? &e->forecast : nullptr;
+  }
+
+  // Time since this location was fetched; false when it is not cached
+  bool age(float lat, float lon, unsigned long now, unsigned long &ageMs) const {
+    const Entry *e = find(locationKey(lat), locationKey(lon));
+    if (!e) return false;
+    ageMs = now - e->fetchedAt;
+    return true;
+  }
+
+  void put(float lat, float lon, unsigned long now, const ForecastStore &forecast) {
+    int32_t latKey = locationKey(lat);
+    int32_t lonKey = locationKey(lon);
+
+    // Reuse this location's slot, else an empty one, else the oldest fetch
+    Entry *slot = const_cast<Entry *>(find(latKey, lonKey));
+    for (int i = 0; !slot && i < WEATHER_CACHE_ENTRIES; i++) {
+      if (!entries[i].valid) slot = &entries[i];
+    }
+    if (!slot) {
+      slot = &entries[0];
+      for (int i = 1; i < WEATHER_CACHE_ENTRIES; i++) {
+        if (now - entries[i].fetchedAt > now - slot->fetchedAt) slot = &entries[i];
+      }
+    }
+
+    slot->valid = true;
+    slot->latKey = latKey;
+    slot->lonKey = lonKey;
+    slot->fetchedAt = now;
+    slot->forecast = forecast;
+  }
+
+  void clear() {
+    for (int i = 0; i < WEATHER_CACHE_ENTRIES; i++) {
+      entries[i].valid = false;
+    }
+  }
+
+ private:
+  struct Entry {
+    bool valid;
+    int32_t latKey;
+    int32_t lonKey;
+    unsigned long fetchedAt;
+    ForecastStore forecast;
+  };
+
+  static int32_t locationKey(float degrees) { return (int32_t)lroundf(degrees * 100.0f); }
+
+  const Entry *find(int32_t latKey, int32_t lonKey) const {
+    for (int i = 0; i < WEATHER_CACHE_ENTRIES; i++) {
+      const Entry &e = entries[i];
+      if (e.valid && e.latKey == latKey && e.lonKey == lonKey) return &e;
+    }
+    return nullptr;
+  }
+
+  Entry entries[WEATHER_CACHE_ENTRIES];
+  unsigned long ttlMs;
+};
+
+#endif // WEATHER_CACHE_H
@@ -0,0 +1,104 @@
+#ifndef WEATHER_CONDITION_H
+#define WEATHER_CONDITION_H
+
+#include <Arduino.h>
+#include "melody_player.h"
+
+// Meteomatics weather symbols (weather_symbol_1h) by their day number; the
+// night symbols are the same plus WEATHER_SYMBOL_NIGHT
+enum WeatherCondition : uint8_t {
+  CONDITION_UNKNOWN = 0,
+  CONDITION_CLEAR_SKY = 1,
+  CONDITION_LIGHT_CLOUDS = 2,
+  CONDITION_PARTLY_CLOUDY = 3,
+  CONDITION_CLOUDY = 4,
+  CONDITION_RAIN = 5,
+  CONDITION_RAIN_AND_SNOW = 6,
+  CONDITION_SNOW = 7,
+  CONDITION_RAIN_SHOWER = 8,
+  CONDITION_SNOW_SHOWER = 9,
+  CONDITION_SLEET_SHOWER = 10,
+  CONDITION_LIGHT_FOG = 11,
+  CONDITION_DENSE_FOG = 12,
+  CONDITION_FREEZING_RAIN = 13,
+  CONDITION_THUNDERSTORM = 14,
+  CONDITION_DRIZZLE = 15,
+  CONDITION_SANDSTORM = 16,
+  CONDITION_COUNT
+};
+
+#define WEATHER_SYMBOL_NIGHT 100
+
+struct ConditionInfo {
+  const char *name;      // As reported by /weather and the root page
+  const Note *melody;    // Played when the condition is shown; nullptr: none
+  uint8_t melodyLength;
+  int16_t detuneHz;      // The melody pitched up to this much off either way, at random
+};
+
+// Melodies. A rest (frequency 0) between notes keeps them apart.
+namespace condition_melodies {
+
+constexpr Note CLEAR_SKY[] = { { 1000, 500, 100 } };
+constexpr Note LIGHT_CLOUDS[] = { { 800, 400, 100 } };
+constexpr Note CLOUDY[] = {
+  { 261, 400, 100 }, { 0, 120, 0 },
+  { 294, 400, 100 }, { 0, 120, 0 },
+  { 330, 600, 100 }, { 0, 180, 0 },
+  { 294, 400, 100 }, { 0, 120, 0 },
+  { 261, 600, 100 },
+};
+constexpr Note RAIN[] = { { 500, 200, 100 } };
+constexpr Note SNOW[] = { { 1200, 300, 100 } };
+constexpr Note LIGHT_FOG[] = { { 400, 800, 100 } };
+constexpr Note DENSE_FOG[] = { { 300, 1000, 100 } };
+constexpr Note FREEZING_RAIN[] = { { 700, 300, 100 } };
+constexpr Note THUNDERSTORM[] = { { 200, 700, 100 } };
+constexpr Note SANDSTORM[] = { { 300, 200, 100 } };
+
+}  // namespace condition_melodies
+
+#define CONDITION_MELODY(notes) condition_melodies::notes, (uint8_t)(sizeof(condition_melodies::notes) / sizeof(Note))
+#define CONDITION_SILENT nullptr, 0
+
+// Everything the firmware does per condition, indexed by WeatherCondition.
+// The LED animation follows the temperature, not the condition.
+constexpr ConditionInfo CONDITIONS[] = {
+  { "Unknown", CONDITION_SILENT, 0 },
+  { "clear_sky", CONDITION_MELODY(CLEAR_SKY), 0 },
+  { "light_clouds", CONDITION_MELODY(LIGHT_CLOUDS), 0 },
+  { "partly_cloudy", CONDITION_MELODY(LIGHT_CLOUDS), 0 },
+  { "cloudy", CONDITION_MELODY(CLOUDY), 0 },
+  { "rain", CONDITION_MELODY(RAIN), 100 },
+  { "rain_and_snow", CONDITION_SILENT, 0 },
+  { "snow", CONDITION_MELODY(SNOW), 0 },
+  { "rain_shower", CONDITION_MELODY(RAIN), 100 },
+  { "snow_shower", CONDITION_MELODY(SNOW), 0 },
+  { "sleet_shower", CONDITION_SILENT, 0 },
+  { "light_fog", CONDITION_MELODY(LIGHT_FOG), 0 },
+  { "dense_fog", CONDITION_MELODY(DENSE_FOG), 0 },
+  { "freezing_rain", CONDITION_MELODY(FREEZING_RAIN), 0 },
+  { "thunderstorm", CONDITION_MELODY(THUNDERSTORM), 0 },
+  { "drizzle", CONDITION_MELODY(RAIN), 100 },
+  { "sandstorm", CONDITION_MELODY(SANDSTORM), 50 },
+};
+static_assert(sizeof(CONDITIONS) / sizeof(CONDITIONS[0]) == CONDITION_COUNT, "CONDITIONS must follow WeatherCondition");
+
+constexpr WeatherCondition dayCondition(int symbol) {
+  return symbol > CONDITION_UNKNOWN && symbol < CONDITION_COUNT ? (WeatherCondition)symbol : CONDITION_UNKNOWN;
+}
+
+// Day and night symbols alike; anything else is CONDITION_UNKNOWN
+constexpr WeatherCondition weatherCondition(int symbol) {
+  return dayCondition(symbol >= WEATHER_SYMBOL_NIGHT ? symbol - WEATHER_SYMBOL_NIGHT : symbol);
+}
+
+static_assert(weatherCondition(104) == CONDITION_CLOUDY, "Night symbols are day symbols + 100");
+
+inline const ConditionInfo &conditionInfo(WeatherCondition condition) {
+  return CONDITIONS[condition < CONDITION_COUNT ? condition : CONDITION_UNKNOWN];
+}
+
+inline const char *conditionName(WeatherCondition condition) { return conditionInfo(condition).name; }
+
+#endif // WEATHER_CONDITION_H
@@ -0,0 +1,83 @@
+#ifndef WEATHER_EVENT_H
+#define WEATHER_EVENT_H
+
+#include <Arduino.h>
+#include "json_writer.h"
+#include "weather_condition.h"
+
+// What /weather reports, less the device id and timestamp
+struct WeatherState {
+  WeatherCondition condition;
+  int temperature;
+  float precipitation;
+  int symbol;
+  float latitude;
+  float longitude;
+};
+
+// Weather pushed to the relay, one event per change, each holding only the
+// fields that differ from the event before:
+//   {"type":"event","event":"weather","version":4,"data":{"temperature":8}}
+// Versions count the events sent on one connection. The first one, and any
+// after an event that could not be written, is marked "complete" and holds
+// every field; a receiver applies each later one over what it has.
+class WeatherEvents {
+ public:
+  // A new connection: start over with a complete event
+  void restart() {
+    version_ = 0;
+    complete_ = true;
+  }
+
+  uint32_t version() const { return version_; }
+
+  // Writes the event that brings a receiver of the last one up to `now`.
+  // False, with nothing written, when nothing changed.
+  bool write(const WeatherState &now, JsonWriter &json) {
+    bool condition = complete_ || now.condition != sent_.condition;
+    bool temperature = complete_ || now.temperature != sent_.temperature;
+    bool precipitation = complete_ || now.precipitation != sent_.precipitation;
+    bool symbol = complete_ || now.symbol != sent_.symbol;
+    bool location = complete_ || now.latitude != sent_.latitude || now.longitude != sent_.longitude;
+    if (!(condition || temperature || precipitation || symbol || location)) {
+      return false;
+    }
+
+    json.beginObject();
+    json.key("type").value("event");
+    json.key("event").value("weather");
+    json.key("version").value(version_ + 1);
+    if (complete_) {
+      json.key("complete").value(true);
+    }
+    json.key("data").beginObject();
+    if (condition) json.key("condition").value(conditionName(now.condition));
+    if (temperature) json.key("temperature").value(now.temperature);
+    if (precipitation) json.key("precipitation").value(now.precipitation, 2);
+    if (symbol) json.key("symbol").value(now.symbol);
+    if (location) {
+      json.key("location").beginObject();
+      json.key("latitude").value(now.latitude, 4);
+      json.key("longitude").value(now.longitude, 4);
+      json.endObject();
+    }
+    json.endObject();
+    json.endObject();
+    if (!json.ok()) {
+      complete_ = true;  // Not sent: the next one has to stand on its own
+      return false;
+    }
+
+    version_++;
+    complete_ = false;
+    sent_ = now;
+    return true;
+  }
+
+ private:
+  WeatherState sent_ = {};
+  uint32_t version_ = 0;
+  bool complete_ = true;
+};
+
+#endif // WEATHER_EVENT_H
@@ -0,0 +1,50 @@
+#ifndef WEATHER_FETCH_H
+#define WEATHER_FETCH_H
+
+#include <Arduino.h>
+#include "forecast_store.h"
+
+// Meteomatics fetches run on their own FreeRTOS task so DNS, the TLS
+// handshake and the HTTP read never block loop(). loop() posts a
+// WeatherFetchRequest and later collects a WeatherFetchResult; both queues
+// hold a single item.
+//
+// The task is pinned to core 0 next to the WiFi/lwIP tasks; loop() runs on
+// core 1.
+#define WEATHER_TASK_STACK 8192
+#define WEATHER_TASK_PRIORITY 1
+#define WEATHER_TASK_CORE 0
+
+// TCP/TLS connect, and silence between two reads of the body
+#ifndef WEATHER_CONNECT_TIMEOUT_MS
+#define WEATHER_CONNECT_TIMEOUT_MS 5000
+#endif
+#ifndef WEATHER_READ_TIMEOUT_MS
+#define WEATHER_READ_TIMEOUT_MS 5000
+#endif
+
+// Whole fetch, request to parsed forecast. Past it the task abandons the
+// transfer, and loop() stops waiting (plus a grace period for the task to
+// notice).
+#ifndef WEATHER_FETCH_DEADLINE_MS
+#define WEATHER_FETCH_DEADLINE_MS 20000UL
+#endif
+#define WEATHER_FETCH_GRACE_MS 2000UL
+
+struct WeatherFetchRequest {
+  uint32_t id;             // Cancelled as soon as a newer id is issued
+  float latitude;
+  float longitude;
+  unsigned long deadline;  // millis() by which the fetch must be done
+};
+
+struct WeatherFetchResult {
+  uint32_t id;
+  bool ok;
+  float latitude;
+  float longitude;
+  unsigned long durationMs;
+  ForecastStore forecast;
+};
+
+#endif // WEATHER_FETCH_H
@@ -0,0 +1,135 @@
+#ifndef WEATHER_REQUEST_H
+#define WEATHER_REQUEST_H
+
+#include <Arduino.h>
+#include "forecast_store.h"
+
+// Longest request path and Authorization value the builder will produce.
+// The path is ~150 chars for FORECAST_PARAMETERS; credentials up to 96 chars
+// encode to 128 chars of base64.
+#define WEATHER_PATH_MAX 192
+#define WEATHER_AUTH_MAX 144
+
+// "YYYY-MM-DDTHH:MM:SSZ" for a UTC timestamp. `out` needs 21 bytes.
+inline size_t formatIsoTime(time_t t, char *out, size_t size) {
+  struct tm utc;
+  gmtime_r(&t, &utc);
+  return strftime(out, size, "%Y-%m-%dT%H:%M:%SZ", &utc);
+}
+
+// UTC hours since epoch of a "YYYY-MM-DDTHH..." timestamp (minutes and
+// seconds are ignored). False when `text` is not one.
+inline bool parseIsoHour(const char *text, uint32_t &hour) {
+  static const uint8_t widths[] = { 4, 2, 2, 2 };
+  static const char separators[] = "--T";
+  int fields[4];
+  const char *p = text;
+  if (!p) return false;
+  for (int i = 0; i < 4; i++) {
+    int v = 0;
+    for (uint8_t n = 0; n < widths[i]; n++, p++) {
+      if (*p < '0' || *p > '9') return false;
+      v = v * 10 + (*p - '0');
+    }
+    if (i < 3 && *p++ != separators[i]) return false;
+    fields[i] = v;
+  }
+  int year = fields[0], month = fields[1], day = fields[2];
+  if (year < 1970 || month < 1 || month > 12 || day < 1 || day > 31 || fields[3] > 23) return false;
+
+  // Days since 1970-01-01 in the proleptic Gregorian calendar, counting
+  // years from March so that the leap day comes last
+  if (month <= 2) year--;
+  uint32_t era = year / 400;
+  uint32_t yearOfEra = year - era * 400;
+  uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  hour = (era * 146097 + dayOfEra - 719468) * 24 + fields[3];
+  return true;
+}
+
+// Standard base64 of `len` bytes. Returns the encoded length, or 0 when `out`
+// is too small (it must hold 4 * ceil(len / 3) + 1 bytes).
+inline size_t base64Encode(const uint8_t *in, size_t len, char *out, size_t size) {
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t needed = (len + 2) / 3 * 4;
+  if (needed + 1 > size) return 0;
+
+  char *p = out;
+  for (size_t i = 0; i < len; i += 3) {
+    uint32_t chunk = (uint32_t)in[i] << 16;
+    if (i + 1 < len) chunk |= (uint32_t)in[i + 1] << 8;
+    if (i + 2 < len) chunk |= in[i + 2];
+    *p++ = alphabet[(chunk >> 18) & 0x3f];
+    *p++ = alphabet[(chunk >> 12) & 0x3f];
+    *p++ = i + 1 < len ? alphabet[(chunk >> 6) & 0x3f] : '=';
+    *p++ = i + 2 < len ? alphabet[chunk & 0x3f] : '=';
+  }
+  *p = '\0';
+  return needed;
+}
+
+// Builds the Meteomatics request in fixed buffers, so a fetch does not touch
+// the heap. The Authorization header is encoded once and only redone when the
+// credentials change.
+class WeatherRequestBuilder {
+ public:
+  // "/<start>--<end>:PT1H/<parameters>/<lat>,<lon>/json?model=mix" covering
+  // FORECAST_HOURS from startHour (UTC hours since epoch)
+  const char *path(uint32_t startHour, float latitude, float longitude) {
+    char start[24], end[24], lat[DEGREES_MAX], lon[DEGREES_MAX];
+    formatIsoTime((time_t)startHour * 3600, start, sizeof(start));
+    formatIsoTime((time_t)(startHour + FORECAST_HOURS - 1) * 3600, end, sizeof(end));
+    formatDegrees(latitude, lat);
+    formatDegrees(longitude, lon);
+    snprintf(pathBuf, sizeof(pathBuf), "/%s--%s:PT1H/" FORECAST_PARAMETERS "/%s,%s/json?model=mix",
+             start, end, lat, lon);
+    return pathBuf;
+  }
+
+  // "Basic <base64(user:pass)>"
+  const char *authorization(const char *user, const char *pass) {
+    uint32_t hash = credentialHash(user, pass);
+    if (authBuf[0] != '\0' && hash == authHash) {
+      return authBuf;
+    }
+
+    uint8_t plain[97];
+    int len = snprintf((char *)plain, sizeof(plain), "%s:%s", user, pass);
+    if (len < 0 || (size_t)len >= sizeof(plain)) {
+      authBuf[0] = '\0';
+      return authBuf;
+    }
+    memcpy(authBuf, "Basic ", 6);
+    base64Encode(plain, len, authBuf + 6, sizeof(authBuf) - 6);
+    memset(plain, 0, sizeof(plain));
+    authHash = hash;
+    return authBuf;
+  }
+
+ private:
+  // Sign, the whole degrees of any long, point, six decimals and the NUL
+  static const size_t DEGREES_MAX = 24;
+
+  // Six decimals (~0.1 m) without printf's float path, which may allocate
+  static void formatDegrees(float degrees, char *out) {
+    long micro = lroundf(degrees * 1000000.0f);
+    unsigned long magnitude = micro < 0 ? -micro : micro;
+    snprintf(out, DEGREES_MAX, "%s%lu.%06lu", micro < 0 ? "-" : "", magnitude / 1000000UL, magnitude % 1000000UL);
+  }
+
+  // FNV-1a over "user:pass"
+  static uint32_t credentialHash(const char *user, const char *pass) {
+    uint32_t h = 2166136261u;
+    for (const char *p = user; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+    h = (h ^ ':') * 16777619u;
+    for (const char *p = pass; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+    return h;
+  }
+
+  char pathBuf[WEATHER_PATH_MAX];
+  char authBuf[WEATHER_AUTH_MAX] = "";
+  uint32_t authHash = 0;
+};
+
+#endif // WEATHER_REQUEST_H
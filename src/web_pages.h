@@ -0,0 +1,250 @@
+// Generated by scripts/embed_web_pages.py from web/ -- do not edit.
+#ifndef WEB_PAGES_H
+#define WEB_PAGES_H
+
+#include "page_template.h"
+#include "static_page.h"
+
+// web/index.tmpl.html: 1200 bytes, 4 fields
+const TemplateSegment INDEX_HTML_SEGMENTS[] = {
+  { "<!DOCTYPE html>\n"
+    "<html>\n"
+    "<head>\n"
+    "  <title>Weather Potato Config</title>\n"
+    "  <meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">\n"
+    "  <style>\n"
+    "    body { font-family: Arial, sans-serif; margin: 20px; }\n"
+    "    h1 { color: #FF6B6B; }\n"
+    "    input[type=text] { width: 100%; padding: 8px; margin: 8px 0; }\n"
+    "    input[type=submit] { background: #4ECDC4; color: white; padding: 10px 20px; border: none; cursor: pointer; }\n"
+    "  </style>\n"
+    "</head>\n"
+    "<body>\n"
+    "  <h1>🥔 Weather Potato Configuration</h1>\n"
+    "  <form action=\"/location\" method=\"POST\">\n"
+    "    <label for=\"latitude\">Latitude:</label><br>\n"
+    "    <input type=\"text\" id=\"latitude\" name=\"latitude\" value=\"\" placeholder=\"48.9075\"><br><br>\n"
+    "    <label for=\"longitude\">Longitude:</label><br>\n"
+    "    <input type=\"text\" id=\"longitude\" name=\"longitude\" value=\"\" placeholder=\"2.3833\"><br><br>\n"
+    "    <input type=\"submit\" value=\"Update Location\">\n"
+    "  </form>\n"
+    "  <hr>\n"
+    "  <h2>Current Status</h2>\n"
+    "  <p><b>Device ID:</b> ",
+    930, "DEVICEID" },
+  { "</p>\n"
+    "  <p><b>Weather:</b> ",
+    26, "WEATHER" },
+  { "</p>\n"
+    "  <p><b>Temperature:</b> ",
+    30, "TEMP" },
+  { "°C</p>\n"
+    "  <p><b>Local IP:</b> ",
+    30, "IP" },
+  { "</p>\n"
+    "  <p><b>mDNS:</b> weatherpotato.local:8080</p>\n"
+    "  <hr>\n"
+    "  <h2>OTA Update</h2>\n"
+    "  <p><a href=\"/ota\">Click here to update firmware</a></p>\n"
+    "</body>\n"
+    "</html>\n",
+    155, nullptr },
+};
+const PageTemplate INDEX_HTML = { "text/html", INDEX_HTML_SEGMENTS, 5 };
+
+// web/ota.html: 411 bytes, 287 gzipped
+const uint8_t OTA_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x6d, 0x51, 0xcb, 0x4e, 0xc3, 0x30,
+  0x10, 0xbc, 0xf7, 0x2b, 0x16, 0x73, 0x25, 0x0a, 0x2d, 0x52, 0x0f, 0xa9, 0x13, 0xa9, 0x85, 0xe6,
+  0x9a, 0x48, 0x4d, 0x0f, 0x1c, 0xb7, 0x8d, 0x43, 0x2c, 0xf9, 0x11, 0x39, 0x1b, 0x20, 0x42, 0xfc,
+  0x05, 0x77, 0x8e, 0xfc, 0x1e, 0x9f, 0x40, 0x62, 0x43, 0x4f, 0x9c, 0x76, 0xd7, 0x33, 0xa3, 0x99,
+  0x91, 0xf9, 0xd5, 0x43, 0x71, 0x5f, 0x3d, 0x96, 0x7b, 0x68, 0x49, 0xab, 0x6c, 0xc1, 0xff, 0x86,
+  0xc0, 0x3a, 0x5b, 0x00, 0x70, 0x92, 0xa4, 0x44, 0xb6, 0x3f, 0x94, 0x77, 0x2b, 0x28, 0xaa, 0x2d,
+  0x1c, 0xbb, 0x1a, 0x49, 0xf0, 0x38, 0xbc, 0xcf, 0x8c, 0x9e, 0xc6, 0xb0, 0x01, 0x9c, 0x6c, 0x3d,
+  0xc2, 0x1b, 0x34, 0xd6, 0x50, 0xd4, 0xa0, 0x96, 0x6a, 0x4c, 0x60, 0xeb, 0x24, 0xaa, 0x1b, 0xe8,
+  0xd1, 0xf4, 0x51, 0x2f, 0x9c, 0x6c, 0x36, 0xa0, 0xd1, 0x3d, 0x49, 0x93, 0xc0, 0xea, 0xb6, 0x7b,
+  0xdd, 0xc0, 0xbb, 0x97, 0xb6, 0xcb, 0x49, 0x78, 0xb6, 0xca, 0xba, 0x04, 0xae, 0xf3, 0x7c, 0xbd,
+  0x5b, 0xef, 0x02, 0xc4, 0xe3, 0x5f, 0x03, 0x1e, 0x87, 0x50, 0x7c, 0x76, 0xf1, 0xce, 0xed, 0x32,
+  0xfb, 0xfe, 0xfc, 0xf8, 0xf2, 0xb9, 0x72, 0xe9, 0xf4, 0x0b, 0x3a, 0x71, 0x09, 0x38, 0x81, 0x33,
+  0xa7, 0xb1, 0x4e, 0x83, 0x16, 0xd4, 0xda, 0x3a, 0x65, 0x65, 0x71, 0xa8, 0x18, 0xe0, 0x99, 0xa4,
+  0x35, 0x29, 0x8b, 0x2d, 0x61, 0x60, 0x33, 0x10, 0xe6, 0x4c, 0x63, 0x27, 0x52, 0xa6, 0x07, 0x45,
+  0xb2, 0x43, 0x47, 0xf1, 0xac, 0x8c, 0x26, 0x14, 0x59, 0x28, 0xc7, 0xa5, 0xe9, 0x06, 0x82, 0x40,
+  0x6b, 0xa4, 0x9a, 0x54, 0x06, 0xb5, 0xdf, 0x83, 0xf5, 0x7f, 0xbc, 0x7e, 0x38, 0x69, 0x49, 0x0c,
+  0x9e, 0x51, 0x0d, 0xd3, 0x79, 0xec, 0x94, 0xc5, 0xfa, 0x12, 0xd6, 0x2b, 0xb8, 0x77, 0x9a, 0xfb,
+  0x85, 0x62, 0x53, 0x74, 0xff, 0x07, 0x3f, 0xc9, 0x2e, 0xb2, 0xd5, 0x9b, 0x01, 0x00, 0x00,
+};
+const StaticPage OTA_HTML = { "text/html", OTA_HTML_GZ, sizeof(OTA_HTML_GZ), "\"ecb307d5311e45be\"" };
+
+// web/setup.html: 8325 bytes, 2670 gzipped
+const uint8_t SETUP_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb5, 0x5a, 0xdd, 0x72, 0xdb, 0xc6,
+  0x15, 0xbe, 0xd7, 0x53, 0xac, 0xe9, 0x66, 0x00, 0x26, 0x04, 0xf8, 0x23, 0x51, 0x92, 0x29, 0x92,
+  0x9d, 0x44, 0xb6, 0x1a, 0x75, 0x1c, 0x9b, 0x63, 0xca, 0xe3, 0xc9, 0xb4, 0x9d, 0x64, 0x09, 0x2c,
+  0x88, 0x8d, 0x40, 0x2c, 0xba, 0xbb, 0x14, 0xcd, 0x3a, 0xba, 0x6b, 0xef, 0x7a, 0x99, 0xcb, 0x76,
+  0x72, 0xd5, 0x17, 0xcb, 0x13, 0xe4, 0x11, 0x7a, 0x76, 0x17, 0x0b, 0x80, 0x20, 0x29, 0x53, 0x4e,
+  0x2b, 0xcf, 0xd8, 0x00, 0xf6, 0xec, 0xf9, 0xdb, 0xef, 0xfc, 0xad, 0x3c, 0x7c, 0xf2, 0xfc, 0xf5,
+  0xe5, 0xcd, 0xb7, 0x93, 0x17, 0x28, 0x96, 0x8b, 0x64, 0x7c, 0x34, 0xb4, 0xff, 0x10, 0x1c, 0x8e,
+  0x8f, 0x10, 0x1a, 0x2e, 0x88, 0xc4, 0x28, 0x88, 0x31, 0x17, 0x44, 0x8e, 0x1a, 0x6f, 0x6f, 0xae,
+  0xbc, 0xf3, 0x46, 0xb9, 0x90, 0xe2, 0x05, 0x19, 0x35, 0xee, 0x28, 0x59, 0x65, 0x8c, 0xcb, 0x06,
+  0x0a, 0x58, 0x2a, 0x49, 0x0a, 0x84, 0x2b, 0x1a, 0xca, 0x78, 0x14, 0x92, 0x3b, 0x1a, 0x10, 0x4f,
+  0xbf, 0xb4, 0x10, 0x4d, 0xa9, 0xa4, 0x38, 0xf1, 0x44, 0x80, 0x13, 0x32, 0xea, 0xfa, 0x1d, 0xc3,
+  0x48, 0x52, 0x99, 0x90, 0xf1, 0x3b, 0x82, 0x65, 0x4c, 0x38, 0x9a, 0x30, 0x89, 0x25, 0x43, 0x53,
+  0x22, 0x97, 0xd9, 0xb0, 0x6d, 0xd6, 0x14, 0x95, 0x90, 0x6b, 0xf3, 0x84, 0xd0, 0xe7, 0xe8, 0x03,
+  0x5a, 0x60, 0x3e, 0xa7, 0xe9, 0x00, 0x75, 0x2e, 0x50, 0x86, 0xc3, 0x90, 0xa6, 0x73, 0xfd, 0x3c,
+  0x63, 0xef, 0x3d, 0x41, 0xff, 0xa6, 0x5f, 0x67, 0x8c, 0x87, 0x84, 0x7b, 0xf0, 0xe9, 0x02, 0xdd,
+  0xeb, 0x8d, 0x33, 0x16, 0xae, 0xd1, 0x07, 0xfd, 0x88, 0x50, 0x04, 0xaa, 0x7a, 0x11, 0x5e, 0xd0,
+  0x64, 0x3d, 0x40, 0x1e, 0xce, 0xb2, 0x84, 0x78, 0x62, 0x2d, 0x24, 0x59, 0xb4, 0xd0, 0x57, 0x09,
+  0x4d, 0x6f, 0xbf, 0xc1, 0xc1, 0x54, 0xbf, 0x5f, 0x01, 0x65, 0x0b, 0x39, 0x53, 0x32, 0x67, 0x04,
+  0xbd, 0xbd, 0x76, 0x5a, 0x48, 0xe0, 0x54, 0x78, 0x82, 0x70, 0x1a, 0x5d, 0xe4, 0xdc, 0x66, 0x38,
+  0xb8, 0x9d, 0x73, 0xb6, 0x4c, 0xc3, 0x01, 0x82, 0xcd, 0x04, 0x73, 0x6f, 0xce, 0x71, 0x48, 0xc1,
+  0x19, 0x6e, 0xf7, 0xb8, 0x1f, 0x92, 0x79, 0x0b, 0x3d, 0x3d, 0x3d, 0x3d, 0x23, 0x04, 0xa3, 0xce,
+  0x67, 0xf0, 0x7c, 0x76, 0x7a, 0x32, 0xc3, 0x3d, 0xd4, 0xed, 0x74, 0x3e, 0x6b, 0x5a, 0x26, 0x0b,
+  0x9a, 0x7a, 0x31, 0xa1, 0xf3, 0x58, 0x0e, 0xd4, 0xc2, 0x5d, 0x6c, 0x17, 0x42, 0x2a, 0xb2, 0x04,
+  0x83, 0x9e, 0x51, 0x42, 0xde, 0xdb, 0x8f, 0x38, 0xa1, 0xf3, 0xd4, 0xa3, 0xa0, 0xa0, 0x18, 0xa0,
+  0x00, 0x04, 0x11, 0x6e, 0x97, 0x7e, 0x58, 0x0a, 0x49, 0xa3, 0xb5, 0x97, 0x1f, 0x47, 0x7d, 0xb9,
+  0xf0, 0x58, 0xaf, 0x93, 0xe5, 0xec, 0x8c, 0x83, 0x7c, 0xb5, 0x01, 0x83, 0xfa, 0xbc, 0x70, 0x53,
+  0xd5, 0xb0, 0x55, 0x0c, 0xd2, 0x0a, 0x8b, 0x8d, 0x7b, 0x95, 0x91, 0x4b, 0x51, 0x65, 0x55, 0xe1,
+  0x7f, 0x5c, 0xf9, 0xb8, 0xc0, 0xef, 0x0d, 0x10, 0x06, 0xa8, 0xdf, 0xa9, 0x7c, 0xcf, 0xbf, 0x29,
+  0x47, 0x94, 0xac, 0xe1, 0x14, 0x63, 0x1c, 0xb2, 0x15, 0x1c, 0xaa, 0xe6, 0x8c, 0x4e, 0xd5, 0x5f,
+  0x7c, 0x3e, 0xc3, 0x6e, 0xa7, 0xa5, 0xff, 0xf8, 0xc7, 0xcd, 0xaa, 0xe6, 0x71, 0x17, 0x40, 0x21,
+  0xc9, 0x7b, 0xe9, 0x69, 0xb7, 0x14, 0x16, 0xe7, 0x40, 0x01, 0x14, 0x48, 0xc9, 0x16, 0x4a, 0x0c,
+  0x48, 0x06, 0x98, 0x26, 0x8c, 0x0f, 0xd0, 0xd3, 0xe3, 0xe3, 0x63, 0x8b, 0x0d, 0x3f, 0x33, 0xc0,
+  0xdb, 0xcd, 0x45, 0x83, 0x05, 0x80, 0x45, 0x06, 0x5a, 0x93, 0x2d, 0xb6, 0xda, 0x7a, 0xcb, 0x29,
+  0x62, 0x7c, 0xe1, 0x29, 0x9f, 0x65, 0x05, 0x50, 0x77, 0x12, 0x26, 0x78, 0x46, 0x12, 0x20, 0x29,
+  0x4e, 0x77, 0x96, 0xb0, 0xe0, 0x36, 0x17, 0xb6, 0xca, 0x71, 0x70, 0xda, 0xe9, 0x6c, 0x49, 0xeb,
+  0x57, 0x6d, 0xe8, 0xf7, 0xfb, 0x96, 0x21, 0x4d, 0xb3, 0xa5, 0x04, 0x86, 0x55, 0x97, 0x96, 0x87,
+  0xd1, 0xed, 0xa9, 0x6d, 0xe6, 0xd8, 0x40, 0x11, 0xf0, 0xa7, 0x60, 0x09, 0x0d, 0xd1, 0xd3, 0x30,
+  0x0c, 0x2f, 0xea, 0xc7, 0x69, 0xfc, 0x54, 0x31, 0xbb, 0x7b, 0x5a, 0x2a, 0xae, 0xe5, 0x0c, 0x22,
+  0x16, 0x2c, 0x05, 0x48, 0x63, 0x4b, 0xa9, 0x10, 0x3f, 0x40, 0x29, 0x4b, 0x49, 0xc1, 0xc8, 0xaa,
+  0x67, 0x30, 0x5f, 0x44, 0xe0, 0x12, 0x2c, 0x48, 0x0b, 0x70, 0xed, 0x38, 0xfb, 0x52, 0xdd, 0x7e,
+  0x89, 0x91, 0x47, 0x44, 0x57, 0x11, 0x5a, 0x45, 0x54, 0xe5, 0x9a, 0xec, 0x00, 0x6f, 0xae, 0xf2,
+  0x6e, 0x40, 0x77, 0x2b, 0x18, 0xad, 0xfa, 0xe1, 0xbc, 0xf6, 0xb9, 0x7a, 0x50, 0x56, 0xe2, 0x92,
+  0x0b, 0x25, 0x32, 0x63, 0xb4, 0x1a, 0x76, 0x92, 0x43, 0xda, 0x80, 0x14, 0xc8, 0x00, 0x58, 0xfa,
+  0x59, 0x01, 0x05, 0x75, 0xfc, 0x9e, 0xa8, 0x22, 0xd9, 0xb8, 0x68, 0x10, 0xb3, 0x3b, 0x15, 0x85,
+  0x25, 0xe1, 0x00, 0xe9, 0xbc, 0xe9, 0x42, 0xde, 0x04, 0xdb, 0x36, 0x89, 0x01, 0x41, 0x78, 0x96,
+  0x90, 0x50, 0x9d, 0x46, 0x86, 0x03, 0x2a, 0x01, 0x4c, 0x1d, 0xff, 0xf4, 0xa2, 0xd0, 0x24, 0x65,
+  0x0a, 0xd2, 0x09, 0x5b, 0x91, 0xb0, 0x80, 0xe9, 0x82, 0x08, 0x81, 0xe7, 0xa4, 0x38, 0x8c, 0xdd,
+  0x9e, 0xdf, 0xef, 0x94, 0x5d, 0xc8, 0xae, 0xe7, 0xab, 0xd2, 0xbf, 0xb9, 0x50, 0xb1, 0x0c, 0x02,
+  0x90, 0x0b, 0x8a, 0x56, 0xcf, 0xf4, 0x69, 0x78, 0x42, 0xc2, 0x10, 0x97, 0xa0, 0xee, 0xf6, 0xfb,
+  0x67, 0xbd, 0x93, 0x8b, 0xad, 0xd0, 0xc8, 0xb9, 0x10, 0xce, 0x19, 0xaf, 0xf3, 0x88, 0xce, 0xc3,
+  0xb3, 0x2a, 0x8f, 0xb3, 0x5e, 0x37, 0x78, 0x80, 0x07, 0x4d, 0x23, 0xb6, 0xa5, 0x46, 0x97, 0x04,
+  0x51, 0xb7, 0x64, 0xd1, 0x09, 0xfa, 0x27, 0xa7, 0x1d, 0xbb, 0x45, 0x2c, 0xc0, 0x85, 0xb0, 0xc5,
+  0xae, 0x9e, 0x9f, 0x9f, 0x6f, 0x86, 0x48, 0xcf, 0x86, 0xc8, 0xb0, 0x9d, 0x97, 0xab, 0x61, 0xdb,
+  0x14, 0xd2, 0xa1, 0x2a, 0x3d, 0xba, 0x8e, 0x85, 0xf4, 0x0e, 0x05, 0x09, 0x16, 0x62, 0xd4, 0x28,
+  0x92, 0x6d, 0xc3, 0xd4, 0xb5, 0xea, 0x9a, 0xc9, 0x46, 0x8d, 0xf1, 0xaf, 0x3f, 0xff, 0xe7, 0xa7,
+  0x61, 0x1b, 0x16, 0x72, 0x92, 0xb8, 0xbb, 0xa7, 0x52, 0xc2, 0x82, 0xa1, 0xc8, 0x90, 0x96, 0x3d,
+  0x6a, 0xec, 0xca, 0x63, 0x65, 0x54, 0x9e, 0x6e, 0x65, 0x15, 0x9d, 0xac, 0x1b, 0xe3, 0x4b, 0x96,
+  0x46, 0x74, 0xbe, 0xe4, 0x04, 0xad, 0xd9, 0x92, 0x23, 0x53, 0xc2, 0x87, 0xed, 0x6c, 0x7c, 0x54,
+  0x2a, 0x49, 0xc3, 0x51, 0x23, 0x87, 0x4f, 0xc3, 0x6a, 0x6c, 0xdf, 0xc7, 0xb9, 0xba, 0x86, 0x5a,
+  0x43, 0x5c, 0x91, 0x07, 0x9a, 0xed, 0x15, 0xbc, 0xe6, 0xd6, 0x6e, 0xda, 0x5b, 0xe6, 0xcc, 0x62,
+  0x19, 0x08, 0x74, 0x86, 0x1c, 0xbf, 0xa3, 0x57, 0x14, 0xbd, 0x22, 0x72, 0xc5, 0xf8, 0x2d, 0x72,
+  0xa7, 0xd3, 0xeb, 0xe7, 0xcd, 0x61, 0xdb, 0x2c, 0x95, 0xa4, 0x26, 0xf7, 0xc9, 0x75, 0x96, 0x5b,
+  0xde, 0xd0, 0x52, 0x85, 0xa0, 0x61, 0x03, 0x71, 0xf2, 0xd7, 0x25, 0xe5, 0x24, 0x2c, 0x04, 0x57,
+  0x34, 0x7c, 0xa4, 0x1a, 0x13, 0x20, 0x03, 0x3d, 0xc2, 0x87, 0x15, 0xc8, 0x72, 0x2a, 0xa3, 0x44,
+  0xf9, 0x56, 0x57, 0x44, 0xf5, 0x35, 0x0a, 0x54, 0xe3, 0x6f, 0x95, 0xab, 0x63, 0xb6, 0x20, 0x48,
+  0x4b, 0xc9, 0x0a, 0x29, 0x66, 0xf9, 0x37, 0xe9, 0xfd, 0x12, 0x43, 0x17, 0xb5, 0x0c, 0xc9, 0xa1,
+  0x3e, 0x4b, 0x72, 0xfa, 0x06, 0xa8, 0x21, 0x01, 0x35, 0xe9, 0xa8, 0xe1, 0xfd, 0xfe, 0x4f, 0x1d,
+  0xef, 0xd9, 0x5f, 0xbe, 0xf8, 0xb3, 0x6f, 0x1e, 0x3e, 0x2f, 0x4d, 0x41, 0x10, 0x5b, 0x01, 0x89,
+  0x59, 0x02, 0x69, 0x62, 0xd4, 0x38, 0x39, 0xf7, 0x21, 0x2a, 0xfa, 0xcf, 0x3a, 0x8d, 0x2d, 0x13,
+  0xaf, 0x96, 0x10, 0x3c, 0x19, 0x27, 0x01, 0x15, 0x90, 0x01, 0x91, 0x4b, 0xfc, 0xb9, 0xdf, 0x42,
+  0xc5, 0x86, 0xe3, 0xee, 0x59, 0xe7, 0xf8, 0xa4, 0xf9, 0xbf, 0xb1, 0x98, 0xa5, 0xf3, 0xc7, 0x99,
+  0x6c, 0x37, 0x7c, 0x8a, 0xcd, 0x3d, 0xff, 0xf8, 0xbc, 0xdb, 0xe9, 0x3d, 0x3b, 0xd4, 0x64, 0x4b,
+  0x7f, 0x72, 0xfe, 0xac, 0xd7, 0x3b, 0xfd, 0x88, 0xc5, 0x79, 0xc1, 0x34, 0x0a, 0x8b, 0xe5, 0x6c,
+  0x41, 0x2d, 0xb2, 0xf5, 0xf3, 0x57, 0x32, 0x6d, 0x8c, 0xa7, 0x24, 0x0d, 0x91, 0x0d, 0x5b, 0xac,
+  0xea, 0xcb, 0xb0, 0x6d, 0xf6, 0xe5, 0x29, 0xa1, 0xad, 0x9c, 0xa5, 0xb3, 0x4f, 0xc1, 0x7c, 0x28,
+  0x02, 0x4e, 0x33, 0x69, 0x08, 0xda, 0x6d, 0xf4, 0xe5, 0x52, 0x32, 0x2f, 0xa2, 0xa0, 0x6f, 0xc4,
+  0xd9, 0x02, 0xbd, 0x7d, 0xf3, 0x12, 0x3c, 0xc1, 0xa1, 0xbb, 0x07, 0x67, 0x08, 0x04, 0xc9, 0x16,
+  0x72, 0x27, 0x4e, 0xa6, 0x92, 0x71, 0x88, 0xf1, 0x23, 0x53, 0x56, 0x53, 0x21, 0x0d, 0x91, 0x40,
+  0x23, 0x94, 0x92, 0x95, 0xda, 0x35, 0x85, 0xda, 0x1c, 0xc4, 0x13, 0xfd, 0xd5, 0x5d, 0xd1, 0x14,
+  0x7a, 0x38, 0x5f, 0x6d, 0x55, 0x5a, 0xf9, 0x42, 0x2f, 0xe6, 0x85, 0xd9, 0xec, 0x17, 0xc0, 0x11,
+  0x1c, 0x3a, 0xda, 0xe0, 0xef, 0xcf, 0x89, 0xbc, 0x86, 0xbe, 0xd6, 0x75, 0x56, 0x26, 0xd7, 0x99,
+  0x54, 0xf7, 0x5d, 0x06, 0x86, 0x42, 0x85, 0x32, 0xa6, 0x3a, 0xc0, 0xc7, 0x74, 0x23, 0x11, 0x72,
+  0x8d, 0x1a, 0x7e, 0x8c, 0x85, 0xeb, 0xa8, 0x98, 0x77, 0x9a, 0xcd, 0xa2, 0xae, 0x85, 0xd0, 0xa7,
+  0x2c, 0x20, 0xff, 0x29, 0xae, 0x2f, 0x12, 0xa2, 0x1e, 0xbf, 0x5a, 0x5f, 0x87, 0x96, 0xd0, 0xbf,
+  0xc3, 0xc9, 0x92, 0x80, 0x06, 0x39, 0x0f, 0xa0, 0xb2, 0x4b, 0xe8, 0xc7, 0x1f, 0x91, 0xe3, 0x5c,
+  0x7c, 0x8c, 0x8f, 0x8d, 0xd6, 0x3d, 0xbc, 0xca, 0xe5, 0x03, 0xf9, 0xd9, 0x00, 0xdc, 0xc3, 0x0f,
+  0x96, 0x0f, 0x67, 0x65, 0x81, 0xbd, 0x8f, 0x17, 0x4b, 0x37, 0x79, 0xdd, 0x23, 0x92, 0x08, 0xa2,
+  0x7d, 0x6a, 0x8e, 0xa6, 0xf4, 0xa3, 0xe4, 0xe5, 0xf0, 0x64, 0x8f, 0x2f, 0xc4, 0x30, 0x04, 0x8e,
+  0xd0, 0x1f, 0xa7, 0xaf, 0x5f, 0xf9, 0x99, 0x9a, 0x11, 0xed, 0xae, 0x8b, 0x82, 0xf0, 0x50, 0xf7,
+  0x2b, 0x56, 0xbe, 0xfa, 0xb6, 0x69, 0xda, 0xe3, 0xfc, 0xae, 0x99, 0xd8, 0xef, 0x07, 0x33, 0xda,
+  0xe1, 0x70, 0xcd, 0xc8, 0x7e, 0x3f, 0x9c, 0xd1, 0x0e, 0x77, 0x1b, 0x4e, 0x76, 0x61, 0x93, 0xd5,
+  0x3d, 0x82, 0xc8, 0x08, 0x62, 0xc8, 0x0c, 0xe0, 0xe6, 0xfb, 0xbc, 0x4f, 0xb2, 0x21, 0x39, 0x61,
+  0x10, 0x8d, 0xe0, 0xe6, 0x94, 0x04, 0x2a, 0x7a, 0x20, 0x54, 0xb0, 0x5c, 0x0a, 0x33, 0x39, 0x10,
+  0x88, 0x3c, 0x58, 0xbe, 0x56, 0x55, 0x1d, 0x04, 0xa9, 0xf8, 0x83, 0x5c, 0x63, 0xd8, 0x46, 0xcb,
+  0xd4, 0x6c, 0x08, 0x62, 0x12, 0xdc, 0x5e, 0x16, 0x0c, 0xa6, 0x7a, 0xbf, 0x5b, 0x1e, 0x68, 0x44,
+  0x40, 0xb6, 0xeb, 0xb4, 0x4b, 0x19, 0x9e, 0x91, 0xe1, 0x34, 0x0b, 0x53, 0x7d, 0x08, 0xbf, 0xd4,
+  0xe5, 0x68, 0x34, 0x46, 0xdc, 0xff, 0x41, 0xb0, 0xd4, 0x6d, 0xd6, 0x17, 0x0d, 0x06, 0xc6, 0x15,
+  0x6c, 0x58, 0x74, 0xd8, 0x0e, 0x73, 0xb4, 0xdf, 0x63, 0x39, 0x49, 0x11, 0xcc, 0xe6, 0x47, 0xc1,
+  0x4f, 0xfb, 0x2d, 0x57, 0xad, 0x0a, 0xc3, 0x5c, 0x40, 0x02, 0xb9, 0xc4, 0x9a, 0xef, 0x56, 0x7d,
+  0x51, 0x81, 0x9e, 0xee, 0x52, 0x8d, 0x00, 0x5f, 0x97, 0x8d, 0x57, 0x90, 0xd0, 0x40, 0x1b, 0x2b,
+  0x15, 0xe5, 0xdd, 0xa8, 0xb3, 0x7b, 0x0b, 0x05, 0xd9, 0xfc, 0xeb, 0x9b, 0x6f, 0x5e, 0xc2, 0x96,
+  0xef, 0x37, 0x28, 0x10, 0xfa, 0xe5, 0x5f, 0xff, 0x50, 0x77, 0x12, 0x1c, 0xce, 0x75, 0x7c, 0x69,
+  0x95, 0x44, 0xd0, 0x8e, 0xa9, 0xfa, 0xfd, 0x44, 0xf5, 0x7f, 0x7a, 0x69, 0x38, 0xe3, 0xe3, 0xda,
+  0xce, 0xbc, 0x91, 0x19, 0xa0, 0xdf, 0x7d, 0x28, 0x20, 0x7f, 0xbf, 0x83, 0xee, 0x7a, 0x52, 0x90,
+  0xd0, 0x4c, 0x13, 0xec, 0x20, 0xb2, 0x2a, 0x4c, 0x8d, 0x21, 0xa5, 0x60, 0xf4, 0x86, 0xe4, 0xbe,
+  0x53, 0x4a, 0x35, 0xaa, 0xb2, 0x1a, 0xa6, 0xc7, 0xc0, 0x50, 0x34, 0x18, 0x64, 0x54, 0x04, 0x87,
+  0x88, 0x26, 0xef, 0xbe, 0x7c, 0xb2, 0x57, 0x84, 0x2e, 0x4f, 0x6f, 0x48, 0x08, 0xa5, 0x0f, 0x50,
+  0x92, 0xce, 0x61, 0xfe, 0x43, 0xc7, 0x48, 0x28, 0x01, 0xa1, 0xf0, 0x7d, 0xbf, 0x56, 0xc1, 0xcc,
+  0xcf, 0xf7, 0x1b, 0x07, 0xaa, 0x01, 0xfd, 0x07, 0x40, 0xad, 0x69, 0x27, 0xd1, 0xf5, 0x73, 0x2d,
+  0x9f, 0xe7, 0x4c, 0x95, 0x8e, 0xa0, 0xc2, 0xc6, 0x06, 0x8b, 0xce, 0xfc, 0x0e, 0x49, 0xb5, 0xeb,
+  0x15, 0x5c, 0x1e, 0x80, 0xce, 0x2a, 0x89, 0x6e, 0xf6, 0x6b, 0x18, 0xdd, 0xc8, 0x63, 0x5a, 0xc8,
+  0xb5, 0x2a, 0x44, 0x8a, 0xd4, 0x37, 0xef, 0xdf, 0xe5, 0xc9, 0x68, 0x99, 0xde, 0xa6, 0x6c, 0x95,
+  0x3a, 0x35, 0x93, 0x72, 0xb3, 0xde, 0x6c, 0x1a, 0x81, 0x58, 0x3a, 0x63, 0x98, 0xab, 0x42, 0x05,
+  0xcc, 0x17, 0x19, 0xc4, 0x2a, 0x81, 0x9c, 0x0b, 0x68, 0x5b, 0x51, 0x19, 0x5b, 0x07, 0x28, 0x29,
+  0x5b, 0xcc, 0x04, 0x91, 0x37, 0x74, 0x41, 0x60, 0xa0, 0x76, 0x21, 0x4c, 0x77, 0xaa, 0x6b, 0x15,
+  0xb6, 0x9e, 0x7b, 0xcb, 0x93, 0xb2, 0xf8, 0xba, 0x4e, 0x2c, 0x65, 0x26, 0x06, 0xed, 0x76, 0x5e,
+  0x37, 0x3d, 0x33, 0x46, 0x78, 0x30, 0x4a, 0x06, 0x24, 0xf1, 0xba, 0xbd, 0xb3, 0x3b, 0xdf, 0x3c,
+  0xfb, 0x38, 0xcb, 0xda, 0xa5, 0xa6, 0x9e, 0xd5, 0xd4, 0xa9, 0x85, 0x8f, 0xf9, 0xa9, 0x48, 0xcb,
+  0x8b, 0xb8, 0xa9, 0xf0, 0xf0, 0x02, 0x45, 0xc4, 0x3a, 0xcf, 0x69, 0x15, 0x7e, 0xfc, 0x04, 0x2e,
+  0xba, 0x1c, 0xb4, 0xca, 0x32, 0xf0, 0x09, 0x2c, 0x68, 0x66, 0x19, 0xd0, 0x6c, 0xe7, 0xf6, 0x7a,
+  0x43, 0x12, 0x73, 0x12, 0x81, 0xfb, 0xaa, 0x5c, 0x25, 0x9b, 0x4a, 0x0e, 0x1e, 0x71, 0x77, 0x30,
+  0xb8, 0x6f, 0xc1, 0x90, 0xd4, 0xe9, 0x6c, 0xad, 0xdc, 0x6f, 0x81, 0x4e, 0xa7, 0xf5, 0xbd, 0x87,
+  0x08, 0xa0, 0xb9, 0x82, 0x80, 0x51, 0xa3, 0xe7, 0x60, 0x23, 0x06, 0x42, 0x2c, 0x62, 0x7d, 0x24,
+  0x1a, 0x2b, 0x80, 0x83, 0x32, 0x5e, 0x3e, 0x0d, 0x2c, 0x7b, 0x0c, 0x7e, 0x24, 0x4e, 0x0a, 0xb5,
+  0x9c, 0xc7, 0xf8, 0xa4, 0xfa, 0xa5, 0xd2, 0x56, 0x98, 0x03, 0xd6, 0x75, 0x06, 0x8d, 0x46, 0xa0,
+  0x8b, 0x2d, 0x3f, 0x29, 0xb4, 0x74, 0x35, 0x23, 0x1e, 0x4c, 0xde, 0x3a, 0x23, 0x1c, 0x90, 0xb9,
+  0x7f, 0xfd, 0xf9, 0xa7, 0xbf, 0xa3, 0xcb, 0x42, 0x88, 0xf2, 0x73, 0x35, 0x1d, 0x42, 0x02, 0x43,
+  0x6e, 0xfe, 0x41, 0xf5, 0xfe, 0x8b, 0x4c, 0xde, 0xb7, 0x8f, 0x3b, 0xcd, 0xef, 0x77, 0xb3, 0xd6,
+  0xc3, 0xb5, 0x9f, 0xdf, 0x29, 0x28, 0x75, 0xf4, 0xad, 0x82, 0x73, 0xa8, 0xb1, 0x11, 0xa6, 0x09,
+  0x09, 0x9d, 0xff, 0x4f, 0x39, 0xd3, 0xd7, 0x22, 0x87, 0xb8, 0xe4, 0x97, 0x7f, 0xff, 0x13, 0x10,
+  0xa8, 0x34, 0x51, 0xde, 0xa8, 0x14, 0x0a, 0x55, 0x19, 0x7c, 0x55, 0x04, 0x26, 0xa0, 0x10, 0xd8,
+  0xa0, 0x5b, 0x08, 0x73, 0x11, 0x50, 0x74, 0x55, 0x2a, 0x71, 0xab, 0x5e, 0x10, 0xcf, 0x31, 0x4d,
+  0xfd, 0x9a, 0x9b, 0xf6, 0x77, 0x7b, 0x76, 0x5e, 0x81, 0xd6, 0xa8, 0xb8, 0xae, 0x1a, 0xa1, 0x08,
+  0x83, 0xab, 0x3e, 0x81, 0x85, 0x9a, 0xdd, 0x2e, 0xcd, 0xed, 0xb6, 0xf2, 0xc0, 0xf6, 0x08, 0xb4,
+  0x79, 0x22, 0x47, 0x3b, 0x42, 0x35, 0x0f, 0x52, 0x70, 0x5a, 0x3d, 0x7a, 0x20, 0x3e, 0xaf, 0x23,
+  0xb4, 0x02, 0xf3, 0x71, 0xea, 0xa8, 0x5c, 0x8b, 0xa1, 0x47, 0x53, 0x65, 0xf2, 0xc5, 0x74, 0x72,
+  0xdc, 0x6b, 0x21, 0x0a, 0xad, 0x8d, 0xba, 0xf4, 0x43, 0x31, 0xbe, 0x83, 0x26, 0x22, 0x56, 0x71,
+  0x0a, 0xf5, 0x01, 0x7d, 0x39, 0x81, 0xae, 0x39, 0xaf, 0xc4, 0xcd, 0x5a, 0x37, 0xc4, 0x00, 0x35,
+  0x09, 0x9b, 0xbb, 0xce, 0x65, 0xbd, 0xa3, 0xcb, 0x9d, 0x6c, 0x90, 0x81, 0x5c, 0x60, 0x62, 0x98,
+  0xcf, 0x08, 0x62, 0x51, 0xd4, 0x1c, 0x40, 0x4e, 0x03, 0x1d, 0x2b, 0x38, 0xb8, 0x2f, 0x6e, 0xbe,
+  0x8f, 0x1e, 0xf4, 0x57, 0x79, 0xe5, 0x02, 0x0e, 0xc3, 0x61, 0xf8, 0xe2, 0x0e, 0x96, 0x5e, 0x52,
+  0x01, 0x4e, 0x23, 0xdc, 0xba, 0x13, 0xb8, 0x63, 0xb1, 0x4e, 0x03, 0xdd, 0x83, 0x56, 0xfc, 0x40,
+  0x7c, 0x18, 0x5c, 0xd5, 0x86, 0xe7, 0x24, 0xc2, 0xcb, 0x44, 0xba, 0x65, 0x87, 0x96, 0x4f, 0x6e,
+  0xf6, 0x34, 0x1e, 0x6a, 0xef, 0x2a, 0x47, 0x76, 0x71, 0xf4, 0x9b, 0x5b, 0xc3, 0x82, 0x5b, 0x15,
+  0x41, 0x92, 0x2f, 0x0b, 0x00, 0x95, 0x04, 0x3b, 0xf0, 0x01, 0xb1, 0x0f, 0xb1, 0x5e, 0xe0, 0xe2,
+  0xa1, 0x48, 0xda, 0x22, 0xda, 0x8a, 0x7a, 0x75, 0xb1, 0xe9, 0xd4, 0x3c, 0x62, 0xfc, 0x0d, 0xab,
+  0x25, 0x96, 0x54, 0x86, 0x19, 0x1c, 0x36, 0x02, 0xb5, 0x8a, 0x4d, 0x36, 0xd2, 0x06, 0x87, 0x8f,
+  0x3e, 0xe5, 0x66, 0x3b, 0xb3, 0x0c, 0x90, 0x9e, 0xc7, 0xae, 0x12, 0x86, 0xa5, 0x7b, 0xf0, 0xe4,
+  0xd3, 0xac, 0x30, 0xb2, 0x23, 0xcb, 0x81, 0x9c, 0xea, 0xa3, 0x8f, 0x0d, 0x80, 0xfb, 0xc2, 0x4b,
+  0xbb, 0x06, 0x48, 0x4e, 0x44, 0x06, 0x0f, 0xca, 0xf9, 0x78, 0x85, 0x21, 0xb0, 0x2a, 0x43, 0x89,
+  0x1a, 0xf2, 0x5b, 0x1b, 0x81, 0xb9, 0x20, 0x50, 0x15, 0xc1, 0x2f, 0xce, 0xe4, 0xf5, 0xf4, 0xc6,
+  0x69, 0x55, 0x56, 0xd4, 0x35, 0x2b, 0xe1, 0x62, 0x80, 0x3e, 0x20, 0x27, 0x3f, 0x77, 0xef, 0x66,
+  0x9d, 0x11, 0x07, 0x88, 0xd5, 0xef, 0xf6, 0xa8, 0x29, 0x80, 0x6d, 0xd5, 0x24, 0x3a, 0x50, 0xb4,
+  0x2a, 0x5b, 0xd5, 0xd5, 0xec, 0xc0, 0x8c, 0xb0, 0x42, 0x97, 0x7e, 0x1a, 0xad, 0x5d, 0x23, 0xbe,
+  0xb9, 0x11, 0x73, 0x47, 0xd5, 0xf1, 0xc4, 0x2a, 0xee, 0xb3, 0xdb, 0x66, 0x4d, 0xc7, 0xc7, 0xd4,
+  0x2c, 0x4b, 0x5d, 0xc3, 0xab, 0x1a, 0x2f, 0x36, 0xd2, 0x19, 0x94, 0xfb, 0x54, 0x3e, 0xa9, 0x95,
+  0x31, 0x9d, 0xad, 0x2b, 0x90, 0x7e, 0x64, 0x9d, 0xda, 0xb8, 0x72, 0xe1, 0x64, 0xc1, 0xee, 0xc8,
+  0xe1, 0xb7, 0x2e, 0x45, 0xa6, 0x84, 0xb1, 0x92, 0x9b, 0x69, 0xd4, 0x74, 0xbc, 0xbb, 0xe6, 0xd5,
+  0x1c, 0xd7, 0x9b, 0x13, 0x2b, 0x34, 0x30, 0x45, 0xc5, 0xdb, 0x39, 0xaa, 0xb6, 0x50, 0xaf, 0xde,
+  0x59, 0x54, 0x9a, 0x9e, 0x3d, 0x5b, 0xfa, 0x6a, 0x87, 0xd2, 0xeb, 0x52, 0x67, 0x55, 0xba, 0x58,
+  0x40, 0x7f, 0x85, 0x25, 0x49, 0xd6, 0x47, 0xb5, 0xfa, 0x5c, 0x3d, 0x34, 0x19, 0x73, 0xb6, 0xd2,
+  0x6d, 0xf4, 0x0b, 0x55, 0x43, 0x5d, 0xe7, 0xeb, 0x9b, 0x9b, 0x09, 0x72, 0xd0, 0x17, 0x05, 0x40,
+  0xf3, 0x2a, 0x5e, 0x4d, 0xc3, 0x5b, 0x43, 0xbc, 0xda, 0x5a, 0x05, 0xc3, 0xa3, 0x8a, 0xf5, 0x3e,
+  0x24, 0x6c, 0x94, 0x6a, 0xa1, 0xea, 0x5c, 0x50, 0x05, 0xc6, 0x40, 0x6b, 0xa9, 0x99, 0xd9, 0xdf,
+  0xe8, 0x6c, 0xf3, 0xfc, 0x28, 0x18, 0x76, 0x66, 0xd6, 0x5a, 0x6d, 0x7e, 0x30, 0xb9, 0xee, 0x29,
+  0xbe, 0xf9, 0x9d, 0x86, 0xf6, 0x1a, 0x8c, 0x89, 0xf9, 0x9d, 0xe3, 0xb0, 0x6d, 0x7e, 0x1d, 0x32,
+  0x6c, 0x9b, 0xff, 0x6d, 0xf0, 0x5f, 0x72, 0x3d, 0x5b, 0x93, 0x85, 0x20, 0x00, 0x00,
+};
+const StaticPage SETUP_HTML = { "text/html", SETUP_HTML_GZ, sizeof(SETUP_HTML_GZ), "\"8c93f849325a2c1a\"" };
+
+#endif // WEB_PAGES_H
@@ -0,0 +1,318 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <atomic>
+#include "config_store.h"
+#include "log.h"
+
+// How long a join through the cached AP and lease may take before falling
+// back to a full scan and DHCP
+#define WIFI_FAST_CONNECT_MS 3000
+// Wait after a failed full join, doubled per failure while reconnecting
+#define WIFI_RETRY_MS 1000
+#define WIFI_RETRY_MAX_MS 30000
+
+// Bump when WiFiFastConnect changes; NVS key next to the ConfigRecord
+#define WIFI_FAST_CONNECT_VERSION 1
+#define WIFI_FAST_CONNECT_KEY "wifi"
+
+// What the last good connection learned. The BSSID and channel let the next
+// join go straight to authentication instead of scanning every channel, and
+// the DHCP lease is set as a static address so no DHCP exchange is needed.
+// Home routers keep giving a device the same address, so the lease outlives
+// its expiry in practice. A join through the cache that fails (AP replaced,
+// channel changed) falls back to a scan and DHCP, which refreshes the cache.
+struct WiFiFastConnect {
+  uint16_t version;
+  uint16_t size;  // sizeof(WiFiFastConnect) when written
+  uint32_t ssidHash;  // CRC-32 of the SSID: a cache from another network is not used
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+  uint32_t crc;  // CRC-32 of every byte before it
+
+  WiFiFastConnect() { memset(this, 0, sizeof(*this)); }
+};
+
+// Where the time of the last join went, in ms
+struct WiFiTimings {
+  uint32_t associateMs;  // Join started to associated: channel scan and authentication
+  uint32_t addressMs;    // Associated to IP: DHCP, or next to nothing with the cached lease
+  uint32_t totalMs;      // Asked for (or link lost) to IP, a failed fast join included
+  bool fast;             // Joined through the cache
+};
+
+enum WiFiLinkState : uint8_t {
+  WIFI_LINK_IDLE,
+  WIFI_LINK_CONNECTING,  // Joining, or rejoining after the link dropped
+  WIFI_LINK_CONNECTED,
+  WIFI_LINK_FAILED,      // Gave up; begin() tries again
+};
+
+// What an update() call changed
+enum WiFiLinkChange : uint8_t {
+  WIFI_LINK_NO_CHANGE,
+  WIFI_LINK_UP,       // Connected, first time or again
+  WIFI_LINK_DOWN,     // Lost the AP; already rejoining
+  WIFI_LINK_GAVE_UP,  // begin()'s timeout passed without a connection
+};
+
+// The station side of the radio as one state machine. The WiFi event task
+// only records what happened (WiFi.onEvent()); update(), called from loop(),
+// acts on it, so nothing waits on the radio and everything runs on one task.
+// The link rejoins by itself when the AP drops it, through the cache first.
+class WiFiLink {
+ public:
+  // Once, before the first begin(). `hook`, if given, is called on the
+  // WiFi event task after each event update() will act on, to wake loop().
+  void attach(void (*hook)() = nullptr) {
+    instance() = this;
+    eventHook = hook;
+    WiFi.persistent(false);        // Credentials live in the ConfigRecord
+    WiFi.setAutoReconnect(false);  // update() rejoins, through the cache
+    WiFi.onEvent(onEvent);
+  }
+
+  // Join `ssid`, giving up after `timeoutMs`. With `keepTrying` (a network
+  // known to work) the timeout is still reported, but the link stays
+  // CONNECTING and goes on retrying with backoff, as after a lost link.
+  // Also switches networks while connected. loop() context only.
+  void begin(const char *ssid, const char *password, uint32_t timeoutMs, bool keepTrying = false) {
+    strlcpy(this->ssid, ssid, sizeof(this->ssid));
+    strlcpy(this->password, password, sizeof(this->password));
+    this->timeoutMs = timeoutMs;
+    this->keepTrying = keepTrying;
+    loadCache();
+
+    if (linkState != WIFI_LINK_IDLE) {
+      WiFi.disconnect();  // Its event is ignored: see ownDisconnect()
+    }
+    events.store(0, std::memory_order_relaxed);
+    requestedAt = millis();
+    retryMs = WIFI_RETRY_MS;
+    linkState = WIFI_LINK_CONNECTING;
+    join(cacheUsable());
+  }
+
+  WiFiLinkChange update() {
+    uint8_t happened = events.exchange(0, std::memory_order_acquire);
+    uint32_t now = millis();
+
+    if (linkState == WIFI_LINK_CONNECTED) {
+      if ((happened & EVENT_DISCONNECTED) && !ownDisconnect()) {
+        WP_LOGW("WiFi link lost (reason %u), rejoining", disconnectReason.load(std::memory_order_relaxed));
+        requestedAt = now;
+        timeoutMs = 0;  // An established link keeps trying
+        retryMs = WIFI_RETRY_MS;
+        linkState = WIFI_LINK_CONNECTING;
+        join(cacheUsable());
+        return WIFI_LINK_DOWN;
+      }
+      return WIFI_LINK_NO_CHANGE;
+    }
+    if (linkState != WIFI_LINK_CONNECTING) {
+      return WIFI_LINK_NO_CHANGE;
+    }
+
+    if (happened & EVENT_GOT_IP) {
+      // The link may already have dropped again: leave that for the next call
+      if ((happened & EVENT_DISCONNECTED) &&
+          (int32_t)(disconnectedAt.load(std::memory_order_relaxed) - gotIpAt.load(std::memory_order_relaxed)) >= 0) {
+        events.fetch_or(EVENT_DISCONNECTED, std::memory_order_relaxed);
+      }
+      connected();
+      return WIFI_LINK_UP;
+    }
+
+    bool refused = (happened & EVENT_DISCONNECTED) && !ownDisconnect();
+    if (joinFast && (refused || now - joinedAt >= WIFI_FAST_CONNECT_MS)) {
+      WP_LOGI("Cached AP and lease did not work (%lu ms), scanning", (unsigned long)(now - joinedAt));
+      join(false);
+      return WIFI_LINK_NO_CHANGE;
+    }
+    if (timeoutMs != 0 && now - requestedAt >= timeoutMs) {
+      WiFi.disconnect();
+      WP_LOGE("WiFi: could not join \"%s\" in %lu s", ssid, (unsigned long)(timeoutMs / 1000));
+      if (!keepTrying) {
+        linkState = WIFI_LINK_FAILED;
+        return WIFI_LINK_GAVE_UP;
+      }
+      WP_LOGI("WiFi: retrying \"%s\" in the background", ssid);
+      timeoutMs = 0;  // Reported once
+      backOff(now);
+      return WIFI_LINK_GAVE_UP;
+    }
+    if (refused) {
+      WP_LOGD("WiFi join refused (reason %u), retrying in %lu ms", disconnectReason.load(std::memory_order_relaxed),
+              (unsigned long)retryMs);
+      backOff(now);
+    }
+    if (retrying && (int32_t)(now - retryAt) >= 0) {
+      join(false);
+    }
+    return WIFI_LINK_NO_CHANGE;
+  }
+
+  WiFiLinkState state() const { return linkState; }
+  const WiFiTimings &timings() const { return lastTimings; }
+  // Time spent on the current join
+  uint32_t elapsedMs() const { return millis() - requestedAt; }
+
+ private:
+  enum : uint8_t {
+    EVENT_GOT_IP = 1 << 0,
+    EVENT_DISCONNECTED = 1 << 1,
+  };
+
+  // C++11: no inline static members, and the event callback is a plain function
+  static WiFiLink *&instance() {
+    static WiFiLink *link = nullptr;
+    return link;
+  }
+
+  // WiFi event task: timestamps and flags only
+  static void onEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    WiFiLink *link = instance();
+    if (!link) return;
+    switch (event) {
+      case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+        link->associatedAt.store(millis(), std::memory_order_relaxed);
+        break;
+      case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+        link->gotIpAt.store(millis(), std::memory_order_relaxed);
+        link->events.fetch_or(EVENT_GOT_IP, std::memory_order_release);
+        break;
+      case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        link->disconnectReason.store(info.wifi_sta_disconnected.reason, std::memory_order_relaxed);
+        link->disconnectedAt.store(millis(), std::memory_order_relaxed);
+        link->events.fetch_or(EVENT_DISCONNECTED, std::memory_order_release);
+        break;
+      default:
+        return;
+    }
+    if (link->eventHook) {
+      link->eventHook();
+    }
+  }
+
+  // Our own WiFi.disconnect() (switching networks, giving up) reports as
+  // leaving the AP; only the AP or the radio can drop the link otherwise
+  bool ownDisconnect() const {
+    return disconnectReason.load(std::memory_order_relaxed) == WIFI_REASON_ASSOC_LEAVE;
+  }
+
+  void join(bool fast) {
+    joinFast = fast;
+    joinedAt = millis();
+    retrying = false;
+    if (fast) {
+      WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+      WiFi.begin(ssid, password, cache.channel, cache.bssid);
+    } else {
+      WiFi.config(IPAddress(), IPAddress(), IPAddress());  // Back to DHCP
+      WiFi.begin(ssid, password);
+    }
+  }
+
+  // Join again after retryMs, and wait twice as long after the next failure
+  void backOff(uint32_t now) {
+    retryAt = now + retryMs;
+    retrying = true;
+    retryMs = retryMs * 2 < WIFI_RETRY_MAX_MS ? retryMs * 2 : WIFI_RETRY_MAX_MS;
+  }
+
+  void connected() {
+    uint32_t ipAt = gotIpAt.load(std::memory_order_relaxed);
+    uint32_t assocAt = associatedAt.load(std::memory_order_relaxed);
+    if ((int32_t)(assocAt - joinedAt) < 0) assocAt = ipAt;  // From an earlier join
+
+    lastTimings.associateMs = assocAt - joinedAt;
+    lastTimings.addressMs = ipAt - assocAt;
+    lastTimings.totalMs = ipAt - requestedAt;
+    lastTimings.fast = joinFast;
+    linkState = WIFI_LINK_CONNECTED;
+    WP_LOGI("WiFi joined in %lu ms (%s: associate %lu ms, address %lu ms)", (unsigned long)lastTimings.totalMs,
+            joinFast ? "cached AP and lease" : "scan and DHCP", (unsigned long)lastTimings.associateMs,
+            (unsigned long)lastTimings.addressMs);
+
+    WiFiFastConnect learned;
+    learned.ssidHash = crc32(ssid, strlen(ssid));
+    memcpy(learned.bssid, WiFi.BSSID(), sizeof(learned.bssid));
+    learned.channel = WiFi.channel();
+    learned.ip = WiFi.localIP();
+    learned.gateway = WiFi.gatewayIP();
+    learned.subnet = WiFi.subnetMask();
+    learned.dns = WiFi.dnsIP(0);
+    saveCache(learned);
+  }
+
+  bool cacheUsable() const {
+    return cache.version == WIFI_FAST_CONNECT_VERSION && cache.channel != 0 && cache.ip != 0 &&
+           cache.ssidHash == crc32(ssid, strlen(ssid));
+  }
+
+  // Same checks as ConfigStore::load(); a bad record just means a full join
+  void loadCache() {
+    WiFiFastConnect stored;
+    Preferences prefs;
+    if (!prefs.begin(CONFIG_NAMESPACE, true)) {
+      return;
+    }
+    bool ok = prefs.getBytesLength(WIFI_FAST_CONNECT_KEY) == sizeof(stored) &&
+              prefs.getBytes(WIFI_FAST_CONNECT_KEY, &stored, sizeof(stored)) == sizeof(stored);
+    prefs.end();
+    if (ok && stored.version == WIFI_FAST_CONNECT_VERSION && stored.size == sizeof(stored) &&
+        stored.crc == crc32(&stored, offsetof(WiFiFastConnect, crc))) {
+      cache = stored;
+    }
+  }
+
+  // Written only when something changed: every rejoin through the cache
+  // learns the same values again
+  void saveCache(WiFiFastConnect &learned) {
+    learned.version = WIFI_FAST_CONNECT_VERSION;
+    learned.size = sizeof(learned);
+    learned.crc = crc32(&learned, offsetof(WiFiFastConnect, crc));
+    if (memcmp(&learned, &cache, sizeof(cache)) == 0) {
+      return;
+    }
+    cache = learned;
+    Preferences prefs;
+    if (prefs.begin(CONFIG_NAMESPACE, false)) {
+      prefs.putBytes(WIFI_FAST_CONNECT_KEY, &cache, sizeof(cache));
+      prefs.end();
+    }
+  }
+
+  char ssid[CONFIG_SSID_MAX + 1] = "";
+  char password[CONFIG_PASSWORD_MAX + 1] = "";
+  WiFiFastConnect cache;
+  WiFiTimings lastTimings = {};
+  WiFiLinkState linkState = WIFI_LINK_IDLE;
+
+  uint32_t timeoutMs = 0;    // 0: never give up
+  bool keepTrying = false;   // Retry on after timeoutMs, see begin()
+  uint32_t requestedAt = 0;  // begin(), or the link dropping
+  uint32_t joinedAt = 0;     // This WiFi.begin()
+  bool joinFast = false;
+  bool retrying = false;
+  uint32_t retryAt = 0;
+  uint32_t retryMs = WIFI_RETRY_MS;
+  void (*eventHook)() = nullptr;
+
+  // Written by the WiFi event task
+  std::atomic<uint8_t> events{0};
+  std::atomic<uint32_t> associatedAt{0};
+  std::atomic<uint32_t> gotIpAt{0};
+  std::atomic<uint32_t> disconnectedAt{0};
+  std::atomic<uint8_t> disconnectReason{0};
+};
+
+#endif // WIFI_LINK_H
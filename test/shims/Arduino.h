@@ -0,0 +1,600 @@
+#ifndef ARDUINO_SHIM_H
+#define ARDUINO_SHIM_H
+
+// Minimal host stand-in for the ESP32 Arduino core. Only what src/main.cpp
+// touches is provided; behaviour follows the real core closely enough for the
+// firmware logic to run unchanged on Linux.
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+#include "fake_hal.h"
+
+using std::max;
+using std::min;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define PROGMEM
+#define PGM_P const char*
+#define F(s) (s)
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// newlib has it; glibc only from 2.38
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t length = strlen(src);
+  if (size > 0) {
+    size_t n = length < size - 1 ? length : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return length;
+}
+#endif
+
+// ============================================================================
+// Time
+// ============================================================================
+
+inline unsigned long millis() { return (unsigned long)(fake::clock().nowUs / 1000); }
+inline unsigned long micros() { return (unsigned long)fake::clock().nowUs; }
+
+inline void delay(uint32_t ms) {
+  fake::clock().advanceMs(ms);
+  fake::clock().blockedUs += (uint64_t)ms * 1000;
+}
+
+inline void delayMicroseconds(uint32_t us) {
+  fake::clock().advanceUs(us);
+  fake::clock().blockedUs += us;
+}
+
+inline void yield() {}
+
+// Wall clock starts at a fixed, NTP-synced looking instant (2026-01-15 12:00 UTC).
+static const time_t kFakeEpochBase = 1768478400;
+
+inline bool getLocalTime(struct tm* info, uint32_t ms = 5000) {
+  (void)ms;
+  time_t now = kFakeEpochBase + (time_t)(millis() / 1000);
+  gmtime_r(&now, info);
+  return true;
+}
+
+inline void configTime(long gmtOffset_sec, int daylightOffset_sec, const char* server1,
+                       const char* server2 = nullptr, const char* server3 = nullptr) {
+  (void)gmtOffset_sec; (void)daylightOffset_sec; (void)server1; (void)server2; (void)server3;
+}
+
+// ============================================================================
+// Math / random
+// ============================================================================
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  if (in_max == in_min) return out_min;
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+inline uint32_t& fakeRandomState() {
+  static uint32_t s = 0x12345678;
+  return s;
+}
+
+inline void randomSeed(unsigned long seed) { fakeRandomState() = seed ? (uint32_t)seed : 1; }
+
+inline long random(long howbig) {
+  if (howbig <= 0) return 0;
+  uint32_t& s = fakeRandomState();
+  s = s * 1664525u + 1013904223u;
+  return (long)(s % (uint32_t)howbig);
+}
+
+inline long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+// ============================================================================
+// GPIO / tone
+// ============================================================================
+
+inline void pinMode(uint8_t pin, uint8_t mode) { fake::pins().mode[pin & 63] = mode; }
+inline int digitalRead(uint8_t pin) { return fake::pins().level[pin & 63]; }
+inline void digitalWrite(uint8_t pin, uint8_t val) { fake::pins().level[pin & 63] = val; }
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define digitalPinToInterrupt(p) (p)
+
+// Harness: fake::drivePin() raises the interrupt
+inline void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode) {
+  fake::pins().isr[pin & 63] = isr;
+  fake::pins().isrArg[pin & 63] = arg;
+  fake::pins().isrMode[pin & 63] = mode;
+}
+inline void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+  attachInterruptArg(pin, [](void* arg) { ((void (*)(void))arg)(); }, (void*)isr, mode);
+}
+inline void detachInterrupt(uint8_t pin) { fake::pins().isr[pin & 63] = nullptr; }
+
+inline void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0) {
+  (void)pin; (void)frequency;
+  // The ESP32 core's tone() blocks for the note duration.
+  delay(duration);
+}
+
+inline void noTone(uint8_t pin) { (void)pin; }
+
+// ============================================================================
+// String (same growth and API shape as the core's WString)
+// ============================================================================
+
+class String {
+ public:
+  String(const char* cstr = "") { init(); if (cstr) copy(cstr, strlen(cstr)); }
+  String(const char* cstr, unsigned int length) { init(); if (cstr) copy(cstr, length); }
+  String(const String& str) { init(); *this = str; }
+  String(String&& rval) { init(); move(rval); }
+  String(const std::string& str) { init(); copy(str.c_str(), str.size()); }
+  explicit String(char c) { init(); char buf[2] = {c, 0}; copy(buf, 1); }
+  explicit String(unsigned char v, unsigned char base = 10) { init(); fromUnsigned(v, base); }
+  explicit String(int v, unsigned char base = 10) { init(); fromSigned(v, base); }
+  explicit String(unsigned int v, unsigned char base = 10) { init(); fromUnsigned(v, base); }
+  explicit String(long v, unsigned char base = 10) { init(); fromSigned(v, base); }
+  explicit String(unsigned long v, unsigned char base = 10) { init(); fromUnsigned(v, base); }
+  explicit String(long long v, unsigned char base = 10) { init(); fromSigned(v, base); }
+  explicit String(unsigned long long v, unsigned char base = 10) { init(); fromUnsigned(v, base); }
+  explicit String(float v, unsigned int decimalPlaces = 2) { init(); fromDouble(v, decimalPlaces); }
+  explicit String(double v, unsigned int decimalPlaces = 2) { init(); fromDouble(v, decimalPlaces); }
+  ~String() { fake::heapFree(buffer_); }
+
+  String& operator=(const String& rhs) {
+    if (this == &rhs) return *this;
+    if (rhs.buffer_) copy(rhs.buffer_, rhs.len_);
+    else invalidate();
+    return *this;
+  }
+  String& operator=(String&& rval) {
+    if (this != &rval) move(rval);
+    return *this;
+  }
+  String& operator=(const char* cstr) {
+    if (cstr) copy(cstr, strlen(cstr));
+    else invalidate();
+    return *this;
+  }
+
+  bool reserve(unsigned int size) {
+    if (buffer_ && capacity_ >= size) return true;
+    if (changeBuffer(size)) {
+      if (len_ == 0) buffer_[0] = 0;
+      return true;
+    }
+    return false;
+  }
+
+  unsigned int length() const { return len_; }
+  bool isEmpty() const { return len_ == 0; }
+  const char* c_str() const { return buffer_ ? buffer_ : ""; }
+  char* begin() { return buffer_; }
+  char* end() { return buffer_ + len_; }
+
+  bool concat(const char* cstr, unsigned int length) {
+    if (!cstr) return false;
+    if (length == 0) return true;
+    unsigned int newlen = len_ + length;
+    if (!reserve(newlen)) return false;
+    memmove(buffer_ + len_, cstr, length);
+    len_ = newlen;
+    buffer_[len_] = 0;
+    return true;
+  }
+  bool concat(const String& s) { return concat(s.c_str(), s.len_); }
+  bool concat(const char* cstr) { return cstr ? concat(cstr, strlen(cstr)) : false; }
+  bool concat(char c) { return concat(&c, 1); }
+  bool concat(int v) { return concat(String(v)); }
+  bool concat(unsigned int v) { return concat(String(v)); }
+  bool concat(long v) { return concat(String(v)); }
+  bool concat(unsigned long v) { return concat(String(v)); }
+  bool concat(float v) { return concat(String(v)); }
+  bool concat(double v) { return concat(String(v)); }
+
+  template <typename T>
+  String& operator+=(const T& rhs) { concat(rhs); return *this; }
+
+  int compareTo(const String& s) const { return strcmp(c_str(), s.c_str()); }
+  bool equals(const String& s) const { return len_ == s.len_ && compareTo(s) == 0; }
+  bool equals(const char* cstr) const { return strcmp(c_str(), cstr ? cstr : "") == 0; }
+  bool operator==(const String& rhs) const { return equals(rhs); }
+  bool operator==(const char* cstr) const { return equals(cstr); }
+  bool operator!=(const String& rhs) const { return !equals(rhs); }
+  bool operator!=(const char* cstr) const { return !equals(cstr); }
+  bool operator<(const String& rhs) const { return compareTo(rhs) < 0; }
+  bool equalsIgnoreCase(const String& s) const { return len_ == s.len_ && strcasecmp(c_str(), s.c_str()) == 0; }
+  bool startsWith(const String& prefix) const {
+    return prefix.len_ <= len_ && strncmp(c_str(), prefix.c_str(), prefix.len_) == 0;
+  }
+  bool endsWith(const String& suffix) const {
+    return suffix.len_ <= len_ && strcmp(c_str() + len_ - suffix.len_, suffix.c_str()) == 0;
+  }
+
+  char charAt(unsigned int index) const { return index < len_ ? buffer_[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char& operator[](unsigned int index) {
+    static char dummy;
+    if (index >= len_ || !buffer_) { dummy = 0; return dummy; }
+    return buffer_[index];
+  }
+
+  int indexOf(char ch, unsigned int fromIndex = 0) const {
+    if (fromIndex >= len_) return -1;
+    const char* p = strchr(buffer_ + fromIndex, ch);
+    return p ? (int)(p - buffer_) : -1;
+  }
+  int indexOf(const String& s, unsigned int fromIndex = 0) const {
+    if (fromIndex >= len_) return -1;
+    const char* p = strstr(buffer_ + fromIndex, s.c_str());
+    return p ? (int)(p - buffer_) : -1;
+  }
+
+  String substring(unsigned int beginIndex) const { return substring(beginIndex, len_); }
+  String substring(unsigned int left, unsigned int right) const {
+    if (left > right) std::swap(left, right);
+    if (left >= len_) return String();
+    if (right > len_) right = len_;
+    return String(buffer_ + left, right - left);
+  }
+
+  void replace(const String& find, const String& replace) {
+    if (len_ == 0 || find.len_ == 0) return;
+    std::string out;
+    const char* readFrom = buffer_;
+    const char* foundAt;
+    while ((foundAt = strstr(readFrom, find.c_str())) != nullptr) {
+      out.append(readFrom, foundAt - readFrom);
+      out.append(replace.c_str(), replace.len_);
+      readFrom = foundAt + find.len_;
+    }
+    out.append(readFrom);
+    // Mirror the core: the buffer is rewritten (and grown) in place.
+    if (out.size() > capacity_ && !changeBuffer(out.size())) return;
+    memcpy(buffer_, out.c_str(), out.size() + 1);
+    len_ = out.size();
+  }
+  void replace(char find, char replace) {
+    for (unsigned int i = 0; i < len_; i++) {
+      if (buffer_[i] == find) buffer_[i] = replace;
+    }
+  }
+
+  void remove(unsigned int index) { remove(index, (unsigned int)-1); }
+  void remove(unsigned int index, unsigned int count) {
+    if (index >= len_) return;
+    if (count > len_ - index) count = len_ - index;
+    memmove(buffer_ + index, buffer_ + index + count, len_ - index - count + 1);
+    len_ -= count;
+  }
+
+  void toUpperCase() { for (unsigned int i = 0; i < len_; i++) buffer_[i] = (char)toupper(buffer_[i]); }
+  void toLowerCase() { for (unsigned int i = 0; i < len_; i++) buffer_[i] = (char)tolower(buffer_[i]); }
+  void trim() {
+    if (!buffer_ || len_ == 0) return;
+    unsigned int b = 0, e = len_;
+    while (b < e && isspace((unsigned char)buffer_[b])) b++;
+    while (e > b && isspace((unsigned char)buffer_[e - 1])) e--;
+    len_ = e - b;
+    if (b) memmove(buffer_, buffer_ + b, len_);
+    buffer_[len_] = 0;
+  }
+
+  long toInt() const { return buffer_ ? atol(buffer_) : 0; }
+  float toFloat() const { return buffer_ ? (float)atof(buffer_) : 0; }
+  double toDouble() const { return buffer_ ? atof(buffer_) : 0; }
+
+ private:
+  char* buffer_;
+  unsigned int capacity_;
+  unsigned int len_;
+
+  void init() { buffer_ = nullptr; capacity_ = 0; len_ = 0; }
+  void invalidate() { fake::heapFree(buffer_); init(); }
+
+  bool changeBuffer(unsigned int maxStrLen) {
+    char* newbuffer = (char*)fake::heapRealloc(buffer_, maxStrLen + 1);
+    if (!newbuffer) return false;
+    buffer_ = newbuffer;
+    capacity_ = maxStrLen;
+    return true;
+  }
+
+  void copy(const char* cstr, unsigned int length) {
+    if (!reserve(length)) { invalidate(); return; }
+    len_ = length;
+    memmove(buffer_, cstr, length);
+    buffer_[len_] = 0;
+  }
+
+  void move(String& rhs) {
+    fake::heapFree(buffer_);
+    buffer_ = rhs.buffer_;
+    capacity_ = rhs.capacity_;
+    len_ = rhs.len_;
+    rhs.init();
+  }
+
+  void fromSigned(long long v, unsigned char base) {
+    if (v < 0 && base == 10) {
+      char buf[24];
+      snprintf(buf, sizeof(buf), "%lld", v);
+      copy(buf, strlen(buf));
+    } else {
+      fromUnsigned((unsigned long long)v, base);
+    }
+  }
+
+  void fromUnsigned(unsigned long long v, unsigned char base) {
+    char buf[66];
+    char* p = buf + sizeof(buf) - 1;
+    *p = 0;
+    if (base < 2) base = 10;
+    do {
+      unsigned d = (unsigned)(v % base);
+      *--p = (char)(d < 10 ? '0' + d : 'a' + d - 10);
+      v /= base;
+    } while (v);
+    copy(p, strlen(p));
+  }
+
+  void fromDouble(double v, unsigned int decimalPlaces) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, v);
+    copy(buf, strlen(buf));
+  }
+};
+
+// ArduinoJson's String adapter also names the core's concatenation helper.
+class StringSumHelper : public String {
+ public:
+  StringSumHelper(const String& s) : String(s) {}
+  StringSumHelper(const char* p) : String(p) {}
+};
+
+inline String operator+(const String& lhs, const String& rhs) { String s(lhs); s += rhs; return s; }
+inline String operator+(const String& lhs, const char* rhs) { String s(lhs); s += rhs; return s; }
+inline String operator+(const char* lhs, const String& rhs) { String s(lhs); s += rhs; return s; }
+inline String operator+(const String& lhs, char rhs) { String s(lhs); s += rhs; return s; }
+inline String operator+(String&& lhs, const String& rhs) { lhs += rhs; return std::move(lhs); }
+inline String operator+(String&& lhs, const char* rhs) { lhs += rhs; return std::move(lhs); }
+inline String operator+(String&& lhs, char rhs) { lhs += rhs; return std::move(lhs); }
+
+// ============================================================================
+// Print / Stream
+// ============================================================================
+
+class Print;
+
+class Printable {
+ public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+  size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+  // Like the core: formats on a 64-byte stack buffer and only allocates for
+  // longer output.
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char loc[64];
+    va_list arg;
+    va_start(arg, format);
+    int len = vsnprintf(loc, sizeof(loc), format, arg);
+    va_end(arg);
+    if (len < 0) return 0;
+    if ((size_t)len < sizeof(loc)) return write((const uint8_t*)loc, len);
+    char* big = (char*)fake::heapAlloc(len + 1);
+    va_start(arg, format);
+    vsnprintf(big, len + 1, format, arg);
+    va_end(arg);
+    size_t n = write((const uint8_t*)big, len);
+    fake::heapFree(big);
+    return n;
+  }
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned int v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  size_t print(const Printable& p) { return p.printTo(*this); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T& v) { size_t n = print(v); return n + println(); }
+  size_t println(double v, int digits) { size_t n = print(v, digits); return n + println(); }
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() {}
+
+  void setTimeout(unsigned long timeout) { timeout_ = timeout; }
+  unsigned long getTimeout() const { return timeout_; }
+
+  virtual size_t readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0) break;
+      *buffer++ = (char)c;
+      count++;
+    }
+    return count;
+  }
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+
+  size_t readBytesUntil(char terminator, char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0 || c == terminator) break;
+      *buffer++ = (char)c;
+      count++;
+    }
+    return count;
+  }
+
+  String readStringUntil(char terminator) {
+    String s;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator) s += (char)c;
+    return s;
+  }
+
+  bool find(const char* target) { return findUntil(target, nullptr); }
+
+  // Consume input until `target` is matched (true) or `terminator` is matched
+  // or the stream ends (false), like the Arduino core.
+  bool findUntil(const char* target, const char* terminator) {
+    size_t targetLen = strlen(target);
+    size_t termLen = terminator ? strlen(terminator) : 0;
+    size_t t = 0, u = 0;
+    int c;
+    while ((c = timedRead()) >= 0) {
+      t = (c == target[t]) ? t + 1 : (c == target[0] ? 1 : 0);
+      if (t == targetLen) return true;
+      if (termLen) {
+        u = (c == terminator[u]) ? u + 1 : (c == terminator[0] ? 1 : 0);
+        if (u == termLen) return false;
+      }
+    }
+    return false;
+  }
+
+ protected:
+  // Like the core, a read() that comes up empty is retried until the timeout
+  // has passed: here the wait moves the fake clock instead of spinning.
+  int timedRead() {
+    int c = read();
+    if (c < 0 && timeout_ > 0) delay(timeout_);
+    return c;
+  }
+
+  unsigned long timeout_ = 1000;
+};
+
+// ============================================================================
+// IPAddress
+// ============================================================================
+
+class IPAddress : public Printable {
+ public:
+  IPAddress() : addr_{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr_{a, b, c, d} {}
+  explicit IPAddress(uint32_t raw) {
+    memcpy(addr_, &raw, 4);
+  }
+
+  operator uint32_t() const { uint32_t raw; memcpy(&raw, addr_, 4); return raw; }
+  uint8_t operator[](int index) const { return addr_[index]; }
+  uint8_t& operator[](int index) { return addr_[index]; }
+  bool operator==(const IPAddress& o) const { return memcmp(addr_, o.addr_, 4) == 0; }
+
+  bool fromString(const char* s) {
+    unsigned a, b, c, d;
+    if (sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) return false;
+    addr_[0] = a; addr_[1] = b; addr_[2] = c; addr_[3] = d;
+    return true;
+  }
+
+  String toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", addr_[0], addr_[1], addr_[2], addr_[3]);
+    return String(buf);
+  }
+
+  // Octet by octet like the core, without building a String
+  size_t printTo(Print& p) const override {
+    size_t n = 0;
+    for (int i = 0; i < 4; i++) {
+      if (i > 0) n += p.print('.');
+      n += p.print((unsigned int)addr_[i]);
+    }
+    return n;
+  }
+
+ private:
+  uint8_t addr_[4];
+};
+
+// ============================================================================
+// Serial / ESP
+// ============================================================================
+
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long baud) { fake::uart().baud = baud; }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    fake::uart().bytesWritten += size;
+    fake::Uart::threadBytes() += size;
+    if (fake::uart().echo) fwrite(buffer, 1, size, stdout);
+    return size;
+  }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  operator bool() const { return true; }
+};
+
+inline HardwareSerial Serial;
+
+class EspClass {
+ public:
+  uint32_t getFreeHeap() { return (uint32_t)(fake::Heap::kTotalBytes - fake::heap().bytesInUse); }
+  uint32_t getMinFreeHeap() { return (uint32_t)(fake::Heap::kTotalBytes - fake::heap().peakBytes); }
+  uint32_t getMaxAllocHeap() { return getFreeHeap(); }
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint64_t getEfuseMac() { return 0x0000CCDDEEFF0A24ULL; }
+  void restart() { restarts++; }
+  int restarts = 0;
+};
+
+inline EspClass ESP;
+
+#endif // ARDUINO_SHIM_H
@@ -0,0 +1,8 @@
+#ifndef BLE2902_SHIM_H
+#define BLE2902_SHIM_H
+
+#include <BLEDevice.h>
+
+class BLE2902 : public BLEDescriptor {};
+
+#endif // BLE2902_SHIM_H
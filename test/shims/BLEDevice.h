@@ -0,0 +1,113 @@
+#ifndef BLE_DEVICE_SHIM_H
+#define BLE_DEVICE_SHIM_H
+
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+class BLECharacteristic;
+class BLEServer;
+
+class BLECharacteristicCallbacks {
+ public:
+  virtual ~BLECharacteristicCallbacks() {}
+  virtual void onWrite(BLECharacteristic* pCharacteristic) { (void)pCharacteristic; }
+  virtual void onRead(BLECharacteristic* pCharacteristic) { (void)pCharacteristic; }
+};
+
+class BLEServerCallbacks {
+ public:
+  virtual ~BLEServerCallbacks() {}
+  virtual void onConnect(BLEServer* pServer) { (void)pServer; }
+  virtual void onDisconnect(BLEServer* pServer) { (void)pServer; }
+};
+
+class BLEDescriptor {
+ public:
+  virtual ~BLEDescriptor() {}
+};
+
+class BLECharacteristic {
+ public:
+  static const uint32_t PROPERTY_READ = 1 << 0;
+  static const uint32_t PROPERTY_WRITE = 1 << 1;
+  static const uint32_t PROPERTY_NOTIFY = 1 << 2;
+  static const uint32_t PROPERTY_INDICATE = 1 << 3;
+  static const uint32_t PROPERTY_WRITE_NR = 1 << 5;
+
+  explicit BLECharacteristic(const char* uuid) : uuid_(uuid) {}
+
+  void setCallbacks(BLECharacteristicCallbacks* callbacks) { callbacks_ = callbacks; }
+  void addDescriptor(BLEDescriptor* descriptor) { (void)descriptor; }
+  void setValue(const char* value) { value_ = value; }
+  void setValue(const std::string& value) { value_ = value; }
+  void setValue(uint8_t* data, size_t len) { value_.assign((const char*)data, len); }
+  std::string getValue() { return value_; }
+  void notify() { notifications++; }
+  const std::string& uuid() const { return uuid_; }
+
+  // Harness API: simulates a central writing to this characteristic.
+  void fakeWrite(const std::string& value) {
+    value_ = value;
+    if (callbacks_) callbacks_->onWrite(this);
+  }
+
+  int notifications = 0;
+
+ private:
+  std::string uuid_;
+  std::string value_;
+  BLECharacteristicCallbacks* callbacks_ = nullptr;
+};
+
+class BLEService {
+ public:
+  BLECharacteristic* createCharacteristic(const char* uuid, uint32_t properties) {
+    (void)properties;
+    characteristics.push_back(new BLECharacteristic(uuid));
+    return characteristics.back();
+  }
+  void start() {}
+
+  std::vector<BLECharacteristic*> characteristics;
+};
+
+class BLEServer {
+ public:
+  void setCallbacks(BLEServerCallbacks* callbacks) { callbacks_ = callbacks; }
+  BLEService* createService(const char* uuid) {
+    (void)uuid;
+    services.push_back(new BLEService());
+    return services.back();
+  }
+
+  std::vector<BLEService*> services;
+
+ private:
+  BLEServerCallbacks* callbacks_ = nullptr;
+};
+
+class BLEAdvertising {
+ public:
+  void addServiceUUID(const char* uuid) { (void)uuid; }
+  void start() {}
+  void stop() {}
+};
+
+class BLEDevice {
+ public:
+  static void init(const std::string& deviceName) { (void)deviceName; }
+  static void deinit(bool release_memory = false) { (void)release_memory; }
+  static BLEServer* createServer() {
+    static BLEServer server;
+    return &server;
+  }
+  static BLEAdvertising* getAdvertising() {
+    static BLEAdvertising advertising;
+    return &advertising;
+  }
+  static void startAdvertising() {}
+};
+
+#endif // BLE_DEVICE_SHIM_H
@@ -0,0 +1,6 @@
+#ifndef BLESERVER_SHIM_H
+#define BLESERVER_SHIM_H
+
+#include <BLEDevice.h>
+
+#endif // BLESERVER_SHIM_H
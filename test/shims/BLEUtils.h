@@ -0,0 +1,6 @@
+#ifndef BLEUTILS_SHIM_H
+#define BLEUTILS_SHIM_H
+
+#include <BLEDevice.h>
+
+#endif // BLEUTILS_SHIM_H
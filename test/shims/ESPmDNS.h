@@ -0,0 +1,18 @@
+#ifndef ESPMDNS_SHIM_H
+#define ESPMDNS_SHIM_H
+
+#include <Arduino.h>
+
+class MDNSResponder {
+ public:
+  bool begin(const char* hostName) { (void)hostName; return true; }
+  void end() {}
+  bool addService(const char* service, const char* proto, uint16_t port) {
+    (void)service; (void)proto; (void)port;
+    return true;
+  }
+};
+
+inline MDNSResponder MDNS;
+
+#endif // ESPMDNS_SHIM_H
@@ -0,0 +1,232 @@
+#ifndef HTTP_CLIENT_SHIM_H
+#define HTTP_CLIENT_SHIM_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <WiFi.h>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM (-8)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// Stream over an in-memory response body, standing in for the TLS socket.
+class FakeBodyStream : public Stream {
+ public:
+  void load(const std::string& body) { body_ = body; pos_ = 0; }
+  size_t write(uint8_t c) override { (void)c; return 1; }
+  using Print::write;
+  int available() override { return (int)(body_.size() - pos_); }
+  int read() override { return pos_ < body_.size() ? (uint8_t)body_[pos_++] : -1; }
+  int peek() override { return pos_ < body_.size() ? (uint8_t)body_[pos_] : -1; }
+  size_t readBytes(char* buffer, size_t length) override {
+    size_t n = std::min(length, body_.size() - pos_);
+    memcpy(buffer, body_.data() + pos_, n);
+    pos_ += n;
+    return n;
+  }
+
+ private:
+  std::string body_;
+  size_t pos_ = 0;
+};
+
+namespace fake {
+
+struct HttpResponse {
+  int code = 200;
+  std::string body;
+};
+
+// Value of header `name` in a request or response head, "" when absent
+inline std::string headerValue(const std::string& head, const char* name) {
+  size_t len = strlen(name);
+  for (size_t pos = head.find("\r\n"); pos != std::string::npos; pos = head.find("\r\n", pos + 2)) {
+    if (strncasecmp(head.c_str() + pos + 2, name, len) == 0 && head.compare(pos + 2 + len, 1, ":") == 0) {
+      size_t start = head.find_first_not_of(' ', pos + 3 + len);
+      return head.substr(start, head.find("\r\n", start) - start);
+    }
+  }
+  return "";
+}
+
+// Transfer-Encoding: chunked, in chunks of at most `chunkSize` bytes
+inline std::string chunkEncode(const std::string& body, size_t chunkSize = 512) {
+  std::string out;
+  char line[16];
+  for (size_t pos = 0; pos < body.size(); pos += chunkSize) {
+    size_t n = std::min(chunkSize, body.size() - pos);
+    snprintf(line, sizeof(line), "%zx\r\n", n);
+    out += line;
+    out.append(body, pos, n);
+    out += "\r\n";
+  }
+  out += "0\r\n\r\n";
+  return out;
+}
+
+// Harness hook: decides what api.meteomatics.com answers for a given URL.
+// HTTP/1.1 requests get a chunked body when `chunked` is set, and the
+// connection is kept open when `keepAlive` is set (and the client did not ask
+// for Connection: close).
+struct HttpServer {
+  std::function<HttpResponse(const std::string& url)> responder;
+  uint32_t latencyMs = 0;  // real time before the response arrives, standing in for the server
+  bool chunked = false;
+  bool keepAlive = true;
+  std::atomic<int> requests{0};
+  std::string lastUrl;
+  std::string lastAuthorization;
+  std::string lastRequest;  // Full request head as written by the firmware
+
+  // Answer one request head written to `client`
+  void answer(WiFiClient& client, const std::string& head) {
+    size_t pathStart = head.find(' ') + 1;
+    size_t pathEnd = head.find(' ', pathStart);
+    bool http10 = head.compare(pathEnd + 1, 8, "HTTP/1.0") == 0;
+    {
+      fake::HeapPause pause;
+      requests++;
+      lastRequest = head;
+      lastUrl = "https://" + headerValue(head, "Host") + head.substr(pathStart, pathEnd - pathStart);
+      lastAuthorization = headerValue(head, "Authorization");
+    }
+    if (latencyMs) fake::networkWait(latencyMs);
+
+    fake::HeapPause pause;
+    HttpResponse r = responder ? responder(lastUrl) : HttpResponse{404, ""};
+    bool chunk = !http10 && chunked;
+    bool reuse = !http10 && keepAlive && strcasecmp(headerValue(head, "Connection").c_str(), "close") != 0;
+
+    char status[96];
+    snprintf(status, sizeof(status), "HTTP/1.1 %d OK\r\nContent-Type: application/json\r\n", r.code);
+    std::string response = status;
+    response += chunk ? "Transfer-Encoding: chunked\r\n" : "Content-Length: " + std::to_string(r.body.size()) + "\r\n";
+    response += reuse ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    response += chunk ? chunkEncode(r.body) : r.body;
+    client.fakeReceive(response);
+    if (!reuse) client.fakePeerClose();
+  }
+};
+
+inline HttpServer& http() {
+  static HttpServer s;
+  return s;
+}
+
+// Every WiFiClient talks to the fake API server
+inline const bool httpPeerInstalled = (peer() = [](WiFiClient& c, const std::string& head) { http().answer(c, head); }, true);
+
+}  // namespace fake
+
+// Request/response over a WiFiClient: the request is written to the client,
+// the fake server queues its response on it, and the client reads the status
+// line and headers back through the socket like on the device.
+class HTTPClient {
+ public:
+  bool begin(const String& url) { return begin(ownClient_, url.c_str()); }
+  bool begin(const char* url) { return begin(ownClient_, url); }
+  bool begin(WiFiClient& client, const String& url) { return begin(client, url.c_str()); }
+  bool begin(WiFiClient& client, const char* url) {
+    fake::HeapPause pause;
+    client_ = &client;
+    url_ = url;
+    std::string rest = url_.substr(url_.find("://") + 3);
+    size_t slash = rest.find('/');
+    host_ = rest.substr(0, slash);
+    path_ = slash == std::string::npos ? "/" : rest.substr(slash);
+    port_ = url_.compare(0, 5, "https") == 0 ? 443 : 80;
+    headers_.clear();
+    return true;
+  }
+  void end() {
+    if (client_ && !(reuse_ && canReuse_)) client_->stop();
+  }
+  bool connected() { return client_ && client_->connected(); }
+
+  void addHeader(const String& name, const String& value) {
+    fake::HeapPause pause;
+    headers_ += std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+  }
+  void setReuse(bool reuse) { reuse_ = reuse; }
+  void setTimeout(uint16_t timeout) { (void)timeout; }
+  void setConnectTimeout(int32_t timeout) { (void)timeout; }
+  void useHTTP10(bool use = true) { http10_ = use; }
+  void collectHeaders(const char* headerKeys[], const size_t headerKeysCount) { (void)headerKeys; (void)headerKeysCount; }
+  String header(const char* name) {
+    if (strcasecmp(name, "Transfer-Encoding") == 0 && chunked_) return String("chunked");
+    return String();
+  }
+
+  int GET() {
+    fake::HeapPause pause;
+    if (!client_->connected() && !client_->connect(host_.c_str(), port_)) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+    std::string request = "GET " + path_ + (http10_ ? " HTTP/1.0\r\n" : " HTTP/1.1\r\n") + "Host: " + host_ +
+                          "\r\nUser-Agent: ESP32HTTPClient\r\nConnection: " + (reuse_ ? "keep-alive" : "close") +
+                          "\r\nAccept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n" + headers_ + "\r\n";
+    if (client_->write((const uint8_t*)request.data(), request.size()) != request.size()) {
+      return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+
+    // Status line and headers, as the real client reads them
+    std::string head;
+    int c;
+    while (head.size() < 4 || head.compare(head.size() - 4, 4, "\r\n\r\n") != 0) {
+      if ((c = client_->read()) < 0) return HTTPC_ERROR_CONNECTION_LOST;
+      head += (char)c;
+    }
+    chunked_ = strcasecmp(fake::headerValue(head, "Transfer-Encoding").c_str(), "chunked") == 0;
+    canReuse_ = strcasecmp(fake::headerValue(head, "Connection").c_str(), "close") != 0;
+    std::string length = fake::headerValue(head, "Content-Length");
+    size_ = length.empty() ? -1 : atoi(length.c_str());
+    return atoi(head.c_str() + 9);
+  }
+
+  int getSize() { return size_; }
+  String getString() {
+    String s;
+    if (size_ > 0) s.reserve(size_);
+    if (!chunked_) {
+      int c;
+      while ((size_ < 0 || (int)s.length() < size_) && (c = client_->read()) >= 0) s += (char)c;
+      return s;
+    }
+    for (;;) {
+      String line = client_->readStringUntil('\n');
+      long n = strtol(line.c_str(), nullptr, 16);
+      if (n <= 0) break;
+      while (n-- > 0) s += (char)client_->read();
+      client_->read();  // CRLF after the chunk
+      client_->read();
+    }
+    client_->readStringUntil('\n');  // blank line after the last chunk
+    return s;
+  }
+  WiFiClient& getStream() { return *client_; }
+  WiFiClient* getStreamPtr() { return client_; }
+
+  static String errorToString(int error) { return String("HTTP error ") + String(error); }
+
+ private:
+  WiFiClient ownClient_;
+  WiFiClient* client_ = &ownClient_;
+  std::string url_;
+  std::string host_;
+  std::string path_;
+  std::string headers_;
+  uint16_t port_ = 443;
+  int size_ = -1;
+  bool reuse_ = true;  // the core's default
+  bool http10_ = false;
+  bool chunked_ = false;
+  bool canReuse_ = false;
+};
+
+#endif // HTTP_CLIENT_SHIM_H
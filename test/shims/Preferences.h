@@ -0,0 +1,54 @@
+#ifndef PREFERENCES_SHIM_H
+#define PREFERENCES_SHIM_H
+
+#include <Arduino.h>
+
+// Blob part of the Preferences API over fake::nvs()
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false) {
+    fake::HeapPause pause;
+    ns_ = name;
+    readOnly_ = readOnly;
+    open_ = true;
+    return true;
+  }
+  void end() { open_ = false; }
+
+  size_t getBytesLength(const char* key) {
+    const std::string* blob = find(key);
+    return blob ? blob->size() : 0;
+  }
+  size_t getBytes(const char* key, void* buf, size_t maxLen) {
+    const std::string* blob = find(key);
+    if (!blob || blob->size() > maxLen) return 0;
+    memcpy(buf, blob->data(), blob->size());
+    return blob->size();
+  }
+  size_t putBytes(const char* key, const void* value, size_t len) {
+    if (!open_ || readOnly_) return 0;
+    fake::HeapPause pause;
+    fake::nvs().entries[ns_ + "/" + key] = std::string((const char*)value, len);
+    fake::nvs().writes++;
+    return len;
+  }
+  bool remove(const char* key) {
+    if (!open_ || readOnly_) return false;
+    fake::HeapPause pause;
+    return fake::nvs().entries.erase(ns_ + "/" + key) > 0;
+  }
+
+ private:
+  const std::string* find(const char* key) {
+    if (!open_) return nullptr;
+    fake::HeapPause pause;
+    auto it = fake::nvs().entries.find(ns_ + "/" + key);
+    return it == fake::nvs().entries.end() ? nullptr : &it->second;
+  }
+
+  std::string ns_;
+  bool readOnly_ = false;
+  bool open_ = false;
+};
+
+#endif // PREFERENCES_SHIM_H
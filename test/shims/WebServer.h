@@ -0,0 +1,214 @@
+#ifndef WEB_SERVER_SHIM_H
+#define WEB_SERVER_SHIM_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <WiFi.h>
+
+typedef enum {
+  HTTP_DELETE = 0,
+  HTTP_GET = 1,
+  HTTP_HEAD = 2,
+  HTTP_POST = 3,
+  HTTP_PUT = 4,
+  HTTP_OPTIONS = 6,
+  HTTP_PATCH = 28,
+  HTTP_ANY = 255
+} HTTPMethod;
+
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+
+#define HTTP_UPLOAD_BUFLEN 1436
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+struct HTTPUpload {
+  HTTPUploadStatus status;
+  String filename;
+  String name;
+  String type;
+  size_t totalSize;
+  size_t currentSize;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+// What a handler put on the wire for one fake request.
+struct FakeHttpResponse {
+  int code = 0;
+  std::string contentType;
+  std::string body;
+  std::vector<std::pair<std::string, std::string>> headers;
+  size_t contentLength = CONTENT_LENGTH_NOT_SET;
+  bool chunked = false;
+
+  const char* header(const char* name) const {
+    for (const auto& h : headers) {
+      if (strcasecmp(h.first.c_str(), name) == 0) return h.second.c_str();
+    }
+    return nullptr;
+  }
+};
+
+class WebServer {
+ public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  explicit WebServer(int port = 80) : port_(port) {}
+
+  void begin() { listening_ = true; }
+  // Like the core, only the listener stops: the handlers stay registered
+  void close() { listening_ = false; }
+  void stop() { close(); }
+  void handleClient() {}
+
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn) { on(uri, method, fn, nullptr); }
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) {
+    routes_.push_back({uri.c_str(), method, fn, ufn});
+  }
+  void on(const String& uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+  void onNotFound(THandlerFunction fn) { notFound_ = fn; }
+
+  void collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    collected_.clear();
+    for (size_t i = 0; i < headerKeysCount; i++) collected_.push_back(headerKeys[i]);
+  }
+
+  String uri() { return String(uri_.c_str()); }
+  HTTPMethod method() { return method_; }
+  WiFiClient& client() { return client_; }
+  HTTPUpload& upload() { return upload_; }
+
+  String arg(const String& name) {
+    if (name == "plain") return String(body_.c_str());
+    return String();
+  }
+  bool hasArg(const String& name) { return name == "plain" && !body_.empty(); }
+  int args() { return body_.empty() ? 0 : 1; }
+
+  String header(const String& name) {
+    for (const auto& h : requestHeaders_) {
+      if (strcasecmp(h.first.c_str(), name.c_str()) == 0) return String(h.second.c_str());
+    }
+    return String();
+  }
+  bool hasHeader(const String& name) {
+    for (const auto& h : requestHeaders_) {
+      if (strcasecmp(h.first.c_str(), name.c_str()) == 0) return true;
+    }
+    return false;
+  }
+  int headers() { return (int)requestHeaders_.size(); }
+
+  void sendHeader(const String& name, const String& value, bool first = false) {
+    fake::HeapPause pause;
+    auto h = std::make_pair(std::string(name.c_str()), std::string(value.c_str()));
+    if (first) response_.headers.insert(response_.headers.begin(), h);
+    else response_.headers.push_back(h);
+  }
+  void setContentLength(const size_t contentLength) { response_.contentLength = contentLength; }
+
+  void send(int code, const char* content_type = nullptr, const String& content = String()) {
+    fake::HeapPause pause;
+    response_.code = code;
+    response_.contentType = content_type ? content_type : "";
+    if (response_.contentLength == CONTENT_LENGTH_UNKNOWN) {
+      response_.chunked = true;
+    } else if (response_.contentLength == CONTENT_LENGTH_NOT_SET) {
+      response_.contentLength = content.length();
+    }
+    response_.body.append(content.c_str(), content.length());
+  }
+  void send(int code, const String& content_type, const String& content) {
+    send(code, content_type.c_str(), content);
+  }
+  void send(int code, const char* content_type, const char* content) {
+    send(code, content_type, String(content));
+  }
+  void send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength) {
+    fake::HeapPause pause;
+    response_.code = code;
+    response_.contentType = content_type ? content_type : "";
+    response_.contentLength = contentLength;
+    response_.body.append(content, contentLength);
+  }
+  void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+  void sendContent(const char* content, size_t size) {
+    fake::HeapPause pause;
+    response_.body.append(content, size);
+  }
+  void sendContent_P(PGM_P content, size_t size) { sendContent(content, size); }
+
+  // --------------------------------------------------------------------------
+  // Harness API
+  // --------------------------------------------------------------------------
+
+  // Dispatches one request to the registered handler, as handleClient() would.
+  const FakeHttpResponse& fakeRequest(HTTPMethod method, const char* uri, const char* body = "",
+                                      std::vector<std::pair<std::string, std::string>> headers = {}) {
+    fake::HeapPause pause;
+    response_ = FakeHttpResponse();
+    method_ = method;
+    uri_ = uri;
+    body_ = body ? body : "";
+    // Like the real server, only headers named in collectHeaders() are kept
+    requestHeaders_.clear();
+    for (auto& h : headers) {
+      for (const std::string& key : collected_) {
+        if (strcasecmp(key.c_str(), h.first.c_str()) == 0) requestHeaders_.push_back(std::move(h));
+      }
+    }
+    for (const Route& r : routes_) {
+      if (r.uri == uri_ && (r.method == method || r.method == HTTP_ANY)) {
+        dispatch(r.fn);
+        return response_;
+      }
+    }
+    if (notFound_) dispatch(notFound_);
+    else send(404, "text/plain", "Not found");
+    return response_;
+  }
+
+  // A power cycle: the next setup() registers everything again
+  void fakePowerOff() {
+    close();
+    routes_.clear();
+    notFound_ = nullptr;
+  }
+
+  size_t routeCount() const { return routes_.size(); }
+  bool listening() const { return listening_; }
+  int port() const { return port_; }
+
+ private:
+  // Handlers run with counting resumed so their allocations show up.
+  void dispatch(const THandlerFunction& fn) {
+    fake::heapPauseDepth()--;
+    fn();
+    fake::heapPauseDepth()++;
+  }
+
+  struct Route {
+    std::string uri;
+    HTTPMethod method;
+    THandlerFunction fn;
+    THandlerFunction ufn;
+  };
+
+  int port_;
+  bool listening_ = false;
+  std::vector<Route> routes_;
+  THandlerFunction notFound_;
+  std::vector<std::string> collected_;
+
+  HTTPMethod method_ = HTTP_GET;
+  std::string uri_;
+  std::string body_;
+  std::vector<std::pair<std::string, std::string>> requestHeaders_;
+  WiFiClient client_;
+  HTTPUpload upload_{};
+  FakeHttpResponse response_;
+};
+
+#endif // WEB_SERVER_SHIM_H
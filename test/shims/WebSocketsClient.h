@@ -0,0 +1,89 @@
+#ifndef WEBSOCKETS_CLIENT_SHIM_H
+#define WEBSOCKETS_CLIENT_SHIM_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+typedef enum {
+  WStype_ERROR,
+  WStype_DISCONNECTED,
+  WStype_CONNECTED,
+  WStype_TEXT,
+  WStype_BIN,
+  WStype_FRAGMENT_TEXT_START,
+  WStype_FRAGMENT_BIN_START,
+  WStype_FRAGMENT,
+  WStype_FRAGMENT_FIN,
+  WStype_PING,
+  WStype_PONG,
+} WStype_t;
+
+// One frame the firmware handed to the socket.
+struct FakeWsFrame {
+  bool binary;
+  std::string payload;
+};
+
+class WebSocketsClient {
+ public:
+  typedef std::function<void(WStype_t type, uint8_t* payload, size_t length)> WebSocketClientEvent;
+
+  void begin(const char* host, uint16_t port, const char* url = "/", const char* protocol = "arduino") {
+    (void)host; (void)port; (void)url; (void)protocol;
+  }
+  void beginSslWithCA(const char* host, uint16_t port, const char* url = "/", const char* CA_cert = nullptr,
+                      const char* protocol = "arduino") {
+    (void)host; (void)port; (void)url; (void)CA_cert; (void)protocol;
+    fakeBegins++;
+  }
+  void onEvent(WebSocketClientEvent cbEvent) { event_ = cbEvent; }
+  void setReconnectInterval(unsigned long time) { (void)time; }
+  void loop() {}
+  void disconnect() {}
+  bool isConnected() { return connected_; }
+
+  bool sendTXT(const char* payload, size_t length = 0) {
+    if (!length) length = strlen(payload);
+    fake::HeapPause pause;
+    sent.push_back({false, std::string(payload, length)});
+    return true;
+  }
+  bool sendTXT(const uint8_t* payload, size_t length) { return sendTXT((const char*)payload, length); }
+  bool sendTXT(String& payload) { return sendTXT(payload.c_str(), payload.length()); }
+  bool sendBIN(const uint8_t* payload, size_t length) {
+    fake::HeapPause pause;
+    sent.push_back({true, std::string((const char*)payload, length)});
+    return true;
+  }
+
+  // --------------------------------------------------------------------------
+  // Harness API
+  // --------------------------------------------------------------------------
+
+  void fakeEvent(WStype_t type, const std::string& payload = std::string()) {
+    if (type == WStype_CONNECTED) connected_ = true;
+    if (type == WStype_DISCONNECTED) connected_ = false;
+    // The library hands callbacks a NUL-terminated, writable copy.
+    std::vector<uint8_t> buf;
+    {
+      fake::HeapPause pause;
+      buf.assign(payload.begin(), payload.end());
+      buf.push_back(0);
+    }
+    if (event_) event_(type, buf.data(), payload.size());
+    fake::HeapPause pause;
+    buf = std::vector<uint8_t>();
+  }
+
+  std::vector<FakeWsFrame> sent;
+  int fakeBegins = 0;
+
+ private:
+  WebSocketClientEvent event_;
+  bool connected_ = false;
+};
+
+#endif // WEBSOCKETS_CLIENT_SHIM_H
@@ -0,0 +1,362 @@
+#ifndef WIFI_SHIM_H
+#define WIFI_SHIM_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+typedef enum {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+// Station events as numbered by the ESP32 core; only the ones the firmware uses
+typedef enum {
+  ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+  ARDUINO_EVENT_MAX = 37
+} arduino_event_id_t;
+typedef arduino_event_id_t WiFiEvent_t;
+
+typedef enum {
+  WIFI_REASON_ASSOC_LEAVE = 8,
+  WIFI_REASON_BEACON_TIMEOUT = 200,
+  WIFI_REASON_NO_AP_FOUND = 201,
+  WIFI_REASON_AUTH_FAIL = 202,
+} wifi_err_reason_t;
+
+typedef struct {
+  uint8_t ssid[32];
+  uint8_t ssid_len;
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t authmode;
+} wifi_event_sta_connected_t;
+
+typedef struct {
+  uint8_t ssid[32];
+  uint8_t ssid_len;
+  uint8_t bssid[6];
+  uint8_t reason;
+  int8_t rssi;
+} wifi_event_sta_disconnected_t;
+
+typedef union {
+  wifi_event_sta_connected_t wifi_sta_connected;
+  wifi_event_sta_disconnected_t wifi_sta_disconnected;
+} arduino_event_info_t;
+typedef arduino_event_info_t WiFiEventInfo_t;
+
+typedef std::function<void(arduino_event_id_t, arduino_event_info_t)> WiFiEventFuncCb;
+
+class WiFiClient;
+
+namespace fake {
+
+// Harness hook: the far end of every WiFiClient. It is handed each complete
+// request head ("...\r\n\r\n") written to a client and answers through
+// WiFiClient::fakeReceive(). HTTPClient.h installs the fake API server here.
+inline std::function<void(WiFiClient&, const std::string&)>& peer() {
+  static std::function<void(WiFiClient&, const std::string&)> p;
+  return p;
+}
+
+// How the peer's bytes reach a WiFiClient. By default all of an answer is
+// readable by the time write() returns. With `pieceBytes` set it comes in the
+// way TLS records do over a real link: nothing is readable until `gapMs` of
+// fake time after it was sent, then `pieceBytes` more every `gapMs`, and a
+// read in between finds nothing.
+struct Delivery {
+  size_t pieceBytes = 0;
+  uint32_t gapMs = 0;
+};
+
+inline Delivery& delivery() {
+  static Delivery d;
+  return d;
+}
+
+}  // namespace fake
+
+// Socket with an in-memory receive buffer: the fake HTTP server queues its
+// response here and the firmware reads it back like network data.
+class WiFiClient : public Stream {
+ public:
+  virtual ~WiFiClient() {}
+  virtual int connect(const char* host, uint16_t port) { (void)host; (void)port; connected_ = true; return 1; }
+  virtual int connect(IPAddress ip, uint16_t port) { (void)ip; (void)port; connected_ = true; return 1; }
+  int connect(const char* host, uint16_t port, int32_t timeoutMs) { (void)timeoutMs; return connect(host, port); }
+  virtual void stop() {
+    connected_ = false;
+    fake::HeapPause pause;
+    rx_.clear();
+    rxPos_ = 0;
+    tx_.clear();
+    inFlight_.clear();
+  }
+  virtual uint8_t connected() { return connected_ || available() > 0 || !inFlight_.empty(); }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t size) override {
+    if (!connected_) return 0;
+    std::string request;
+    {
+      fake::HeapPause pause;
+      tx_.append((const char*)buf, size);
+      size_t end = tx_.find("\r\n\r\n");
+      if (end == std::string::npos || !fake::peer()) return size;
+      request = tx_.substr(0, end + 4);
+      tx_.erase(0, end + 4);
+    }
+    fake::peer()(*this, request);
+    return size;
+  }
+  using Print::write;
+  int available() override {
+    arrive();
+    return (int)(rx_.size() - rxPos_);
+  }
+  int read() override {
+    arrive();
+    return rxPos_ < rx_.size() ? (uint8_t)rx_[rxPos_++] : -1;
+  }
+  virtual int read(uint8_t* buf, size_t size) {
+    arrive();
+    size_t n = std::min(size, rx_.size() - rxPos_);
+    memcpy(buf, rx_.data() + rxPos_, n);
+    rxPos_ += n;
+    return (int)n;
+  }
+  int peek() override {
+    arrive();
+    return rxPos_ < rx_.size() ? (uint8_t)rx_[rxPos_] : -1;
+  }
+  size_t readBytes(char* buffer, size_t length) override { return read((uint8_t*)buffer, length); }
+  IPAddress remoteIP() const { return remoteIP_; }
+  void setTimeout(uint32_t seconds) { Stream::setTimeout(seconds * 1000); }
+  operator bool() { return connected_; }
+
+  // Harness hooks: bytes the peer sends next, and the peer closing its end
+  // (what was already received can still be read)
+  void fakePeerClose() { connected_ = false; }
+  void fakeReceive(const std::string& data) {
+    fake::HeapPause pause;
+    if (fake::delivery().pieceBytes) {
+      if (inFlight_.empty()) sentAtMs_ = millis();
+      inFlight_ += data;
+      return;
+    }
+    rx_.erase(0, rxPos_);
+    rxPos_ = 0;
+    rx_ += data;
+  }
+
+  IPAddress remoteIP_ = IPAddress(192, 168, 1, 50);
+
+ protected:
+  bool connected_ = false;
+  std::string rx_;
+  size_t rxPos_ = 0;
+  std::string tx_;
+
+ private:
+  // Move the pieces of fake::delivery() whose time has come into rx_
+  void arrive() {
+    if (inFlight_.empty()) return;
+    const fake::Delivery& d = fake::delivery();
+    fake::HeapPause pause;
+    while (!inFlight_.empty() && (!d.pieceBytes || millis() - sentAtMs_ >= d.gapMs)) {
+      size_t n = d.pieceBytes ? std::min(d.pieceBytes, inFlight_.size()) : inFlight_.size();
+      rx_.erase(0, rxPos_);
+      rxPos_ = 0;
+      rx_.append(inFlight_, 0, n);
+      inFlight_.erase(0, n);
+      sentAtMs_ += d.gapMs;
+    }
+  }
+
+  std::string inFlight_;  // Sent by the peer, not readable yet
+  unsigned long sentAtMs_ = 0;
+};
+
+class WiFiClass {
+ public:
+  // Host-side knobs: what the radio "does" when the firmware calls begin().
+  wl_status_t fakeStatus = WL_DISCONNECTED;
+  bool fakeConnectOnBegin = true;
+  IPAddress fakeLocalIP = IPAddress(192, 168, 1, 42);
+  String fakeSSID;
+  uint8_t fakeBSSID[6] = {0x9C, 0x53, 0x22, 0x10, 0x20, 0x30};
+  int32_t fakeChannel = 6;
+
+  // Radio model, in virtual ms. A begin() without BSSID and channel scans
+  // every channel before authenticating, and DHCP is skipped when config()
+  // set a static address. Rough figures for an ESP32 and a home router.
+  uint32_t fakeScanMs = 2000;
+  uint32_t fakeAuthMs = 150;
+  uint32_t fakeDhcpMs = 1000;
+
+  // Events are queued with the virtual time they happen at and delivered by
+  // fakeRunEvents(), standing in for the core's event task. Handlers see the
+  // clock at that time, as if the task had run on schedule.
+  void fakeRunEvents() {
+    for (;;) {
+      size_t next = pending_.size();
+      for (size_t i = 0; i < pending_.size(); i++) {
+        if (pending_[i].atUs <= fake::clock().nowUs && (next == pending_.size() || pending_[i].atUs < pending_[next].atUs)) {
+          next = i;
+        }
+      }
+      if (next == pending_.size()) return;
+      PendingEvent event = pending_[next];
+      {
+        fake::HeapPause pause;
+        pending_.erase(pending_.begin() + next);
+      }
+      if (event.id == ARDUINO_EVENT_WIFI_STA_GOT_IP) fakeStatus = WL_CONNECTED;
+      if (event.id == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) fakeStatus = WL_DISCONNECTED;
+      uint64_t nowUs = fake::clock().nowUs;
+      fake::clock().nowUs = event.atUs;
+      for (auto& handler : handlers_) handler(event.id, event.info);
+      fake::clock().nowUs = nowUs;
+    }
+  }
+
+  // The AP drops the station (out of range, router rebooting)
+  void fakeDropLink(uint8_t reason = WIFI_REASON_BEACON_TIMEOUT) {
+    cancelJoin();
+    fakeStatus = WL_DISCONNECTED;
+    post(0, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, reason);
+  }
+
+  wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0,
+                    const uint8_t* bssid = nullptr, bool connect = true) {
+    (void)passphrase; (void)connect;
+    fakeSSID = ssid ? ssid : "";
+    beginCalls++;
+    cancelJoin();
+    fakeStatus = WL_DISCONNECTED;
+    bool direct = bssid && channel;
+    if (!fakeConnectOnBegin) {
+      post(fakeScanMs, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_NO_AP_FOUND);
+    } else if (direct && (channel != fakeChannel || memcmp(bssid, fakeBSSID, 6) != 0)) {
+      post(fakeAuthMs, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_NO_AP_FOUND);
+    } else {
+      uint32_t associated = (direct ? 0 : fakeScanMs) + fakeAuthMs;
+      post(associated, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+      post(associated + (staticIP_ == IPAddress() ? fakeDhcpMs : 0), ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    }
+    return fakeStatus;
+  }
+  bool disconnect(bool wifioff = false, bool eraseap = false) {
+    (void)wifioff; (void)eraseap;
+    cancelJoin();
+    fakeStatus = WL_DISCONNECTED;
+    post(0, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE);
+    return true;
+  }
+  // A zero local address goes back to DHCP
+  bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress()) {
+    (void)gateway; (void)subnet; (void)dns1;
+    staticIP_ = local;
+    return true;
+  }
+  void persistent(bool persistent) { (void)persistent; }
+  bool setAutoReconnect(bool autoReconnect) { (void)autoReconnect; return true; }
+  void onEvent(WiFiEventFuncCb handler, arduino_event_id_t event = ARDUINO_EVENT_MAX) {
+    (void)event;
+    fake::HeapPause pause;
+    handlers_.push_back(handler);
+  }
+  bool mode(wifi_mode_t m) { mode_ = m; return true; }
+  wifi_mode_t getMode() { return mode_; }
+  wl_status_t status() { return fakeStatus; }
+  bool isConnected() { return fakeStatus == WL_CONNECTED; }
+
+  String macAddress() { return String("24:0A:C4:12:34:56"); }
+  uint8_t* macAddress(uint8_t* mac) {
+    static const uint8_t fakeMac[6] = {0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56};
+    memcpy(mac, fakeMac, 6);
+    return mac;
+  }
+  IPAddress localIP() {
+    if (fakeStatus != WL_CONNECTED) return IPAddress();
+    return staticIP_ == IPAddress() ? fakeLocalIP : staticIP_;
+  }
+  IPAddress gatewayIP() { return IPAddress(192, 168, 1, 1); }
+  IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+  IPAddress dnsIP(uint8_t n = 0) { (void)n; return IPAddress(192, 168, 1, 1); }
+  String SSID() { return fakeSSID; }
+  int8_t RSSI() { return -55; }
+  uint8_t* BSSID() { return fakeBSSID; }
+  int32_t channel() { return fakeChannel; }
+
+  bool softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet) {
+    (void)gateway; (void)subnet;
+    softAPIP_ = local_ip;
+    return true;
+  }
+  bool softAP(const char* ssid, const char* passphrase = nullptr) {
+    (void)ssid; (void)passphrase;
+    return true;
+  }
+  bool softAPdisconnect(bool wifioff = false) { (void)wifioff; softAPIP_ = IPAddress(); return true; }
+  IPAddress softAPIP() { return softAPIP_; }
+
+  int hostByName(const char* host, IPAddress& result) {
+    (void)host;
+    dnsLookups++;
+    result = IPAddress(34, 120, 10, 5);
+    return 1;
+  }
+
+  int beginCalls = 0;
+  int dnsLookups = 0;
+
+ private:
+  struct PendingEvent {
+    uint64_t atUs;
+    arduino_event_id_t id;
+    arduino_event_info_t info;
+  };
+
+  void post(uint32_t afterMs, arduino_event_id_t id, uint8_t reason = 0) {
+    PendingEvent event = {fake::clock().nowUs + (uint64_t)afterMs * 1000, id, {}};
+    if (id == ARDUINO_EVENT_WIFI_STA_CONNECTED) {
+      memcpy(event.info.wifi_sta_connected.bssid, fakeBSSID, 6);
+      event.info.wifi_sta_connected.channel = (uint8_t)fakeChannel;
+    } else if (id == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+      event.info.wifi_sta_disconnected.reason = reason;
+    }
+    fake::HeapPause pause;
+    pending_.push_back(event);
+  }
+
+  // A new begin() or a disconnect abandons the join in progress
+  void cancelJoin() {
+    fake::HeapPause pause;
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                  [](const PendingEvent& e) { return e.id != ARDUINO_EVENT_WIFI_STA_DISCONNECTED; }),
+                   pending_.end());
+  }
+
+  wifi_mode_t mode_ = WIFI_OFF;
+  IPAddress softAPIP_;
+  IPAddress staticIP_;
+  std::vector<PendingEvent> pending_;
+  std::vector<WiFiEventFuncCb> handlers_;
+};
+
+inline WiFiClass WiFi;
+
+#endif // WIFI_SHIM_H
@@ -0,0 +1,59 @@
+#ifndef WIFI_CLIENT_SECURE_SHIM_H
+#define WIFI_CLIENT_SECURE_SHIM_H
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <WiFi.h>
+
+namespace fake {
+
+// What the TLS peers look like: every connect() is a full handshake taking
+// handshakeMs of real time.
+struct Tls {
+  uint32_t handshakeMs = 0;
+  int handshakes = 0;
+  std::string lastSni;
+  IPAddress lastIp;
+};
+
+inline Tls& tls() {
+  static Tls t;
+  return t;
+}
+
+}  // namespace fake
+
+class WiFiClientSecure : public WiFiClient {
+ public:
+  void setCACert(const char* rootCA) { (void)rootCA; }
+  void setInsecure() {}
+  void setHandshakeTimeout(unsigned long seconds) { (void)seconds; }
+
+  int connect(const char* host, uint16_t port) override { return handshake(IPAddress(), port, host); }
+  int connect(IPAddress ip, uint16_t port) override { return handshake(ip, port, nullptr); }
+  int connect(IPAddress ip, uint16_t port, const char* host, const char* rootCA, const char* cert,
+              const char* key) {
+    (void)rootCA; (void)cert; (void)key;
+    return handshake(ip, port, host);
+  }
+
+ private:
+  int handshake(IPAddress ip, uint16_t port, const char* host) {
+    (void)port;
+    stop();
+    fake::Tls& t = fake::tls();
+    if (t.handshakeMs) fake::networkWait(t.handshakeMs);
+    {
+      fake::HeapPause pause;
+      t.handshakes++;
+      t.lastSni = host ? host : "";
+      t.lastIp = ip;
+    }
+    connected_ = true;
+    return 1;
+  }
+};
+
+#endif // WIFI_CLIENT_SECURE_SHIM_H
@@ -0,0 +1,86 @@
+#ifndef LEDC_SHIM_H
+#define LEDC_SHIM_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef enum { LEDC_HIGH_SPEED_MODE = 0, LEDC_LOW_SPEED_MODE, LEDC_SPEED_MODE_MAX } ledc_mode_t;
+typedef enum { LEDC_TIMER_0 = 0, LEDC_TIMER_1, LEDC_TIMER_2, LEDC_TIMER_3, LEDC_TIMER_MAX } ledc_timer_t;
+typedef enum { LEDC_CHANNEL_0 = 0, LEDC_CHANNEL_1, LEDC_CHANNEL_2, LEDC_CHANNEL_3, LEDC_CHANNEL_MAX = 8 } ledc_channel_t;
+typedef enum { LEDC_INTR_DISABLE = 0, LEDC_INTR_FADE_END } ledc_intr_type_t;
+typedef enum { LEDC_AUTO_CLK = 0 } ledc_clk_cfg_t;
+typedef enum {
+  LEDC_TIMER_1_BIT = 1, LEDC_TIMER_2_BIT, LEDC_TIMER_3_BIT, LEDC_TIMER_4_BIT, LEDC_TIMER_5_BIT,
+  LEDC_TIMER_6_BIT, LEDC_TIMER_7_BIT, LEDC_TIMER_8_BIT, LEDC_TIMER_9_BIT, LEDC_TIMER_10_BIT
+} ledc_timer_bit_t;
+
+// Field order matches ESP-IDF 4.4 so designated initializers compile.
+typedef struct {
+  ledc_mode_t speed_mode;
+  ledc_timer_bit_t duty_resolution;
+  ledc_timer_t timer_num;
+  uint32_t freq_hz;
+  ledc_clk_cfg_t clk_cfg;
+} ledc_timer_config_t;
+
+typedef struct {
+  int gpio_num;
+  ledc_mode_t speed_mode;
+  ledc_channel_t channel;
+  ledc_intr_type_t intr_type;
+  ledc_timer_t timer_sel;
+  uint32_t duty;
+  int hpoint;
+  struct {
+    unsigned int output_invert : 1;
+  } flags;
+} ledc_channel_config_t;
+
+namespace fake {
+
+// Last values programmed into the buzzer's LEDC timer/channel.
+struct Ledc {
+  uint32_t freqHz = 0;
+  uint32_t duty = 0;
+  uint32_t pendingDuty = 0;
+  uint32_t dutyUpdates = 0;
+};
+
+inline Ledc& ledc() {
+  static Ledc l;
+  return l;
+}
+
+}  // namespace fake
+
+inline esp_err_t ledc_timer_config(const ledc_timer_config_t* cfg) {
+  fake::ledc().freqHz = cfg->freq_hz;
+  return ESP_OK;
+}
+
+inline esp_err_t ledc_channel_config(const ledc_channel_config_t* cfg) {
+  fake::ledc().duty = cfg->duty;
+  return ESP_OK;
+}
+
+inline esp_err_t ledc_set_freq(ledc_mode_t mode, ledc_timer_t timer, uint32_t freq_hz) {
+  (void)mode; (void)timer;
+  fake::ledc().freqHz = freq_hz;
+  return ESP_OK;
+}
+
+inline esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty) {
+  (void)mode; (void)channel;
+  fake::ledc().pendingDuty = duty;
+  return ESP_OK;
+}
+
+inline esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel) {
+  (void)mode; (void)channel;
+  fake::ledc().duty = fake::ledc().pendingDuty;
+  fake::ledc().dutyUpdates++;
+  return ESP_OK;
+}
+
+#endif // LEDC_SHIM_H
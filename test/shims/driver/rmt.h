@@ -0,0 +1,191 @@
+#ifndef RMT_SHIM_H
+#define RMT_SHIM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "esp_err.h"
+#include "esp_sleep.h"
+#include "fake_hal.h"
+#include "freertos/FreeRTOS.h"
+
+typedef enum { RMT_CHANNEL_0 = 0, RMT_CHANNEL_1, RMT_CHANNEL_2, RMT_CHANNEL_3, RMT_CHANNEL_MAX = 8 } rmt_channel_t;
+typedef enum { RMT_MODE_TX = 0, RMT_MODE_RX } rmt_mode_t;
+typedef enum { RMT_CARRIER_LEVEL_LOW = 0, RMT_CARRIER_LEVEL_HIGH } rmt_carrier_level_t;
+typedef enum { RMT_IDLE_LEVEL_LOW = 0, RMT_IDLE_LEVEL_HIGH } rmt_idle_level_t;
+
+typedef struct {
+  union {
+    struct {
+      uint32_t duration0 : 15;
+      uint32_t level0 : 1;
+      uint32_t duration1 : 15;
+      uint32_t level1 : 1;
+    };
+    uint32_t val;
+  };
+} rmt_item32_t;
+
+typedef struct {
+  uint32_t carrier_freq_hz;
+  rmt_carrier_level_t carrier_level;
+  rmt_idle_level_t idle_level;
+  uint8_t carrier_duty_percent;
+  uint32_t loop_count;
+  bool carrier_en;
+  bool loop_en;
+  bool idle_output_en;
+} rmt_tx_config_t;
+
+// Field order matches ESP-IDF 4.4 so RMT_DEFAULT_CONFIG_TX compiles. The rx
+// half of the union is left out.
+typedef struct {
+  rmt_mode_t rmt_mode;
+  rmt_channel_t channel;
+  gpio_num_t gpio_num;
+  uint8_t clk_div;
+  uint8_t mem_block_num;
+  uint32_t flags;
+  rmt_tx_config_t tx_config;
+} rmt_config_t;
+
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id) \
+  {                                             \
+    .rmt_mode = RMT_MODE_TX,                    \
+    .channel = channel_id,                      \
+    .gpio_num = gpio,                           \
+    .clk_div = 80,                              \
+    .mem_block_num = 1,                         \
+    .flags = 0,                                 \
+    .tx_config = {                              \
+      .carrier_freq_hz = 38000,                 \
+      .carrier_level = RMT_CARRIER_LEVEL_HIGH,  \
+      .idle_level = RMT_IDLE_LEVEL_LOW,         \
+      .carrier_duty_percent = 33,               \
+      .loop_count = 0,                          \
+      .carrier_en = false,                      \
+      .loop_en = false,                         \
+      .idle_output_en = true,                   \
+    }                                           \
+  }
+
+typedef void (*sample_to_rmt_t)(const void* src, rmt_item32_t* dest, size_t src_size, size_t wanted_num,
+                                size_t* translated_size, size_t* item_num);
+
+namespace fake {
+
+// One RMT transmit channel. A write translates the whole sample buffer up
+// front, as the driver's refill interrupt would over the transfer, and the
+// channel stays busy for as long as the pulses take on the wire. The caller's
+// clock does not move: transmission is the peripheral's time, not the CPU's.
+struct Rmt {
+  rmt_config_t config = {};
+  bool installed = false;
+  sample_to_rmt_t translator = nullptr;
+
+  const uint8_t* src = nullptr;  // The caller's buffer, which must hold still until done
+  std::vector<uint8_t> sent;     // What it held when written
+  std::vector<rmt_item32_t> items;
+  uint64_t busyUntilUs = 0;
+  uint32_t writes = 0;
+  uint64_t firstLitUs = 0;  // Virtual time of the first write with a byte on; 0 re-arms
+
+  bool busy() const { return fake::clock().nowUs < busyUntilUs; }
+};
+
+inline Rmt& rmt(int channel = RMT_CHANNEL_0) {
+  static Rmt r[RMT_CHANNEL_MAX];
+  return r[channel];
+}
+
+}  // namespace fake
+
+inline esp_err_t rmt_config(const rmt_config_t* config) {
+  if (config->rmt_mode != RMT_MODE_TX || config->clk_div == 0 || config->mem_block_num == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  fake::rmt(config->channel).config = *config;
+  return ESP_OK;
+}
+
+inline esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags) {
+  (void)rx_buf_size; (void)intr_alloc_flags;
+  if (fake::rmt(channel).installed) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  fake::rmt(channel).installed = true;
+  return ESP_OK;
+}
+
+inline esp_err_t rmt_driver_uninstall(rmt_channel_t channel) {
+  fake::rmt(channel) = fake::Rmt();
+  return ESP_OK;
+}
+
+inline esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn) {
+  fake::rmt(channel).translator = fn;
+  return ESP_OK;
+}
+
+inline esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time) {
+  fake::Rmt& r = fake::rmt(channel);
+  if (!r.busy()) {
+    return ESP_OK;
+  }
+  if (wait_time == 0) {
+    return ESP_ERR_TIMEOUT;
+  }
+  uint64_t waitUs = r.busyUntilUs - fake::clock().nowUs;
+  fake::clock().advanceUs(waitUs);
+  fake::clock().blockedUs += waitUs;
+  return ESP_OK;
+}
+
+inline esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t* src, size_t src_size, bool wait_tx_done) {
+  fake::Rmt& r = fake::rmt(channel);
+  if (!r.installed || !r.translator) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  rmt_wait_tx_done(channel, portMAX_DELAY);  // The driver takes one transfer at a time
+
+  r.src = src;
+  r.sent.assign(src, src + src_size);
+  r.items.clear();
+  uint64_t ticks = 0;
+  // Half the channel memory per refill, as the driver asks for
+  size_t wanted = 32 * r.config.mem_block_num;
+  size_t done = 0;
+  while (done < src_size) {
+    size_t at = r.items.size();
+    r.items.resize(at + wanted);
+    size_t translated = 0, num = 0;
+    r.translator(src + done, &r.items[at], src_size - done, wanted, &translated, &num);
+    if (translated == 0) {
+      return ESP_FAIL;
+    }
+    r.items.resize(at + num);
+    for (size_t i = at; i < at + num; i++) {
+      ticks += r.items[i].duration0 + r.items[i].duration1;
+    }
+    done += translated;
+  }
+
+  r.writes++;
+  if (r.firstLitUs == 0) {
+    for (size_t i = 0; i < src_size; i++) {
+      if (src[i]) {
+        r.firstLitUs = fake::clock().nowUs;
+        break;
+      }
+    }
+  }
+  // APB runs at 80 MHz
+  r.busyUntilUs = fake::clock().nowUs + (ticks * r.config.clk_div + 79) / 80;
+  if (wait_tx_done) {
+    rmt_wait_tx_done(channel, portMAX_DELAY);
+  }
+  return ESP_OK;
+}
+
+#endif // RMT_SHIM_H
@@ -0,0 +1,33 @@
+#ifndef ESP_SLEEP_SHIM_H
+#define ESP_SLEEP_SHIM_H
+
+#include "esp_err.h"
+#include "fake_hal.h"
+
+typedef enum { GPIO_NUM_NC = -1, GPIO_NUM_MAX = 40 } gpio_num_t;
+
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+  ESP_SLEEP_WAKEUP_ALL,
+  ESP_SLEEP_WAKEUP_EXT0,
+  ESP_SLEEP_WAKEUP_EXT1,
+  ESP_SLEEP_WAKEUP_TIMER,
+  ESP_SLEEP_WAKEUP_TOUCHPAD,
+} esp_sleep_source_t;
+typedef esp_sleep_source_t esp_sleep_wakeup_cause_t;
+
+inline esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level) {
+  fake::sleep().ext0Pin = gpio_num;
+  fake::sleep().ext0Level = level;
+  return ESP_OK;
+}
+
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+  return (esp_sleep_wakeup_cause_t)fake::sleep().wakeCause;
+}
+
+// Never returns on the chip. Here it does, and the harness plays the wake by
+// calling setup() again.
+inline void esp_deep_sleep_start() { fake::sleep().entered++; }
+
+#endif // ESP_SLEEP_SHIM_H
@@ -0,0 +1,99 @@
+#ifndef ESP_TIMER_SHIM_H
+#define ESP_TIMER_SHIM_H
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "esp_err.h"
+#include "fake_hal.h"
+
+// One-shot and periodic timers on the virtual clock. Nothing fires on its
+// own: fake::runTimers() plays the esp_timer task and runs every callback
+// that is due, in order, with the clock set to its due time.
+
+typedef void (*esp_timer_cb_t)(void* arg);
+typedef enum { ESP_TIMER_TASK = 0 } esp_timer_dispatch_t;
+
+typedef struct {
+  esp_timer_cb_t callback;
+  void* arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char* name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+namespace fake {
+
+struct Timer {
+  esp_timer_cb_t callback;
+  void* arg;
+  uint64_t dueUs = 0;
+  uint64_t periodUs = 0;
+  bool armed = false;
+};
+
+inline std::vector<Timer*>& timers() {
+  static std::vector<Timer*> all;
+  return all;
+}
+
+inline void runTimers() {
+  for (;;) {
+    Timer* next = nullptr;
+    for (Timer* t : timers()) {
+      if (t->armed && t->dueUs <= clock().nowUs && (!next || t->dueUs < next->dueUs)) next = t;
+    }
+    if (!next) return;
+    uint64_t nowUs = clock().nowUs;
+    clock().nowUs = next->dueUs;
+    if (next->periodUs) {
+      next->dueUs += next->periodUs;
+    } else {
+      next->armed = false;
+    }
+    next->callback(next->arg);
+    clock().nowUs = nowUs;
+  }
+}
+
+}  // namespace fake
+
+typedef fake::Timer* esp_timer_handle_t;
+
+inline int64_t esp_timer_get_time() { return (int64_t)fake::clock().nowUs; }
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  fake::HeapPause pause;
+  fake::Timer* t = new fake::Timer{args->callback, args->arg};
+  fake::timers().push_back(t);
+  *out = t;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeoutUs) {
+  if (t->armed) return ESP_ERR_INVALID_STATE;
+  t->dueUs = fake::clock().nowUs + timeoutUs;
+  t->periodUs = 0;
+  t->armed = true;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t periodUs) {
+  if (t->armed) return ESP_ERR_INVALID_STATE;
+  t->dueUs = fake::clock().nowUs + periodUs;
+  t->periodUs = periodUs;
+  t->armed = true;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+  if (!t->armed) return ESP_ERR_INVALID_STATE;
+  t->armed = false;
+  return ESP_OK;
+}
+
+inline bool esp_timer_is_active(esp_timer_handle_t t) { return t->armed; }
+
+#endif // ESP_TIMER_SHIM_H
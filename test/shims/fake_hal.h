@@ -0,0 +1,213 @@
+#ifndef FAKE_HAL_H
+#define FAKE_HAL_H
+
+// Host-side state behind the Arduino/ESP shims. Everything the firmware would
+// normally get from the chip (clock, heap, pins, UART) lives here so the
+// benchmark harness can drive it and read it back.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace fake {
+
+// ----------------------------------------------------------------------------
+// Virtual clock: delay() advances it instantly so blocking firmware code runs
+// at host speed, while millis()/micros() stay consistent with the delays.
+// Atomic because FreeRTOS tasks run on real host threads.
+// ----------------------------------------------------------------------------
+struct Clock {
+  std::atomic<uint64_t> nowUs{0};
+  std::atomic<uint64_t> blockedUs{0};  // total time spent inside delay()
+
+  void advanceUs(uint64_t us) { nowUs += us; }
+  void advanceMs(uint32_t ms) { nowUs += (uint64_t)ms * 1000; }
+};
+
+inline Clock& clock() {
+  static Clock c;
+  return c;
+}
+
+// Real time the calling thread spent waiting on the fake network. A wait on
+// a task's thread is that task's, whatever else shares the host CPU.
+inline uint64_t& threadWaitUs() {
+  static thread_local uint64_t us = 0;
+  return us;
+}
+
+// Blocks the calling thread for `ms` of real time, like a network round trip
+inline void networkWait(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  threadWaitUs() += (uint64_t)ms * 1000;
+}
+
+// ----------------------------------------------------------------------------
+// Heap accounting: the String shim and the harness's operator new route through
+// here so benchmarks can report allocations and peak bytes per request.
+// ----------------------------------------------------------------------------
+struct Heap {
+  static const size_t kTotalBytes = 320 * 1024;  // ESP32 DRAM ballpark
+
+  size_t allocations = 0;
+  size_t frees = 0;
+  size_t bytesInUse = 0;
+  size_t peakBytes = 0;
+  std::mutex lock;  // tasks allocate from their own threads
+
+  void resetCounters() {
+    std::lock_guard<std::mutex> guard(lock);
+    allocations = 0;
+    frees = 0;
+    peakBytes = bytesInUse;
+  }
+};
+
+inline Heap& heap() {
+  static Heap h;
+  return h;
+}
+
+// >0 while shim bookkeeping allocates on the calling thread
+inline int& heapPauseDepth() {
+  static thread_local int depth = 0;
+  return depth;
+}
+
+// Allocation header keeps the block size so frees can be accounted for.
+struct alignas(16) AllocHeader {
+  size_t size;
+  bool counted;
+};
+
+// Shim internals (recorded responses, sent frames...) allocate inside a
+// HeapPause so the numbers reflect only what the firmware itself allocates.
+struct HeapPause {
+  HeapPause() { heapPauseDepth()++; }
+  ~HeapPause() { heapPauseDepth()--; }
+};
+
+inline void* heapAlloc(size_t size) {
+  AllocHeader* h = (AllocHeader*)::malloc(sizeof(AllocHeader) + size);
+  if (!h) return nullptr;
+  h->size = size;
+  h->counted = heapPauseDepth() == 0;
+  if (!h->counted) return h + 1;
+  Heap& hp = heap();
+  std::lock_guard<std::mutex> guard(hp.lock);
+  hp.allocations++;
+  hp.bytesInUse += size;
+  if (hp.bytesInUse > hp.peakBytes) hp.peakBytes = hp.bytesInUse;
+  return h + 1;
+}
+
+inline void heapFree(void* ptr) {
+  if (!ptr) return;
+  AllocHeader* h = (AllocHeader*)ptr - 1;
+  if (h->counted) {
+    Heap& hp = heap();
+    std::lock_guard<std::mutex> guard(hp.lock);
+    hp.frees++;
+    hp.bytesInUse -= h->size;
+  }
+  ::free(h);
+}
+
+inline void* heapRealloc(void* ptr, size_t size) {
+  if (!ptr) return heapAlloc(size);
+  void* fresh = heapAlloc(size);
+  if (!fresh) return nullptr;
+  AllocHeader* h = (AllocHeader*)ptr - 1;
+  memcpy(fresh, ptr, h->size < size ? h->size : size);
+  heapFree(ptr);
+  return fresh;
+}
+
+// ----------------------------------------------------------------------------
+// GPIO and UART
+// ----------------------------------------------------------------------------
+struct Pins {
+  int level[64] = {0};
+  int mode[64] = {0};
+  void (*isr[64])(void*) = {};
+  void* isrArg[64] = {};
+  int isrMode[64] = {0};  // RISING 1, FALLING 2, CHANGE 3, as in the core
+};
+
+inline Pins& pins() {
+  static Pins p;
+  return p;
+}
+
+// An external signal on `pin`: sets the level and, on an edge the attached
+// interrupt listens for, runs its handler right away like the CPU would
+inline void drivePin(uint8_t pin, int level) {
+  Pins& p = pins();
+  int old = p.level[pin & 63];
+  p.level[pin & 63] = level;
+  if (old == level || !p.isr[pin & 63]) return;
+  int edge = level ? 1 : 2;
+  if (p.isrMode[pin & 63] & edge) p.isr[pin & 63](p.isrArg[pin & 63]);
+}
+
+struct Uart {
+  uint32_t baud = 115200;
+  std::atomic<uint64_t> bytesWritten{0};
+  bool echo = false;  // set WP_ECHO_SERIAL=1 to see firmware logs
+
+  // Time a real UART would have spent shifting out everything written so far
+  // (10 bits per byte on the wire).
+  uint64_t wireTimeUs() const { return baud ? bytesWritten * 10ULL * 1000000ULL / baud : 0; }
+
+  // Bytes written by the calling thread alone. Benchmarks read this so a
+  // background log task draining to Serial is not billed to the request.
+  static uint64_t& threadBytes() {
+    static thread_local uint64_t bytes = 0;
+    return bytes;
+  }
+};
+
+inline Uart& uart() {
+  static Uart u;
+  return u;
+}
+
+// ----------------------------------------------------------------------------
+// NVS: "namespace/key" -> blob, with a count of writes for flash-wear checks
+// ----------------------------------------------------------------------------
+struct Nvs {
+  std::map<std::string, std::string> entries;
+  uint32_t writes = 0;
+};
+
+inline Nvs& nvs() {
+  static Nvs n;
+  return n;
+}
+
+// ----------------------------------------------------------------------------
+// Deep sleep: how the chip was told to wake, and why it "woke" this boot
+// ----------------------------------------------------------------------------
+struct Sleep {
+  int wakeCause = 0;  // esp_sleep_source_t reported by the next boot
+  int ext0Pin = -1;
+  int ext0Level = -1;
+  uint32_t entered = 0;  // esp_deep_sleep_start() calls
+};
+
+inline Sleep& sleep() {
+  static Sleep s;
+  return s;
+}
+
+}  // namespace fake
+
+#endif // FAKE_HAL_H
@@ -0,0 +1,85 @@
+#ifndef FREERTOS_SHIM_H
+#define FREERTOS_SHIM_H
+
+// Just enough FreeRTOS for the firmware's tasks and queues. Tasks are real
+// host threads and queues block on real time, so a harness can measure what
+// loop() does while another task is busy.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fake_hal.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_FULL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7fffffff
+
+namespace fake {
+
+struct Queue {
+  std::mutex lock;
+  std::condition_variable changed;
+  std::deque<std::vector<uint8_t>> items;
+  size_t length;
+  size_t itemSize;
+
+  // Wait for `ready` under the lock; false once `ticks` have elapsed
+  template <typename Pred>
+  bool waitFor(std::unique_lock<std::mutex>& held, TickType_t ticks, Pred ready) {
+    if (ticks == portMAX_DELAY) {
+      changed.wait(held, ready);
+      return true;
+    }
+    return changed.wait_for(held, std::chrono::milliseconds(ticks), ready);
+  }
+};
+
+struct Task {
+  const char* name;
+  int core;
+  std::atomic<uint32_t> notifications{0};
+};
+
+}  // namespace fake
+
+// Critical sections: a spinlock, so a "task" and an "ISR" (harness calls on
+// any thread) exclude each other
+typedef struct {
+  std::atomic_flag locked = ATOMIC_FLAG_INIT;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED \
+  {}
+
+inline void vPortEnterCritical(portMUX_TYPE* mux) {
+  while (mux->locked.test_and_set(std::memory_order_acquire)) {
+  }
+}
+inline void vPortExitCritical(portMUX_TYPE* mux) { mux->locked.clear(std::memory_order_release); }
+#define portENTER_CRITICAL(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux) vPortExitCritical(mux)
+
+typedef fake::Queue* QueueHandle_t;
+typedef fake::Task* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#endif // FREERTOS_SHIM_H
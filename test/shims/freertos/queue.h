@@ -0,0 +1,55 @@
+#ifndef FREERTOS_QUEUE_SHIM_H
+#define FREERTOS_QUEUE_SHIM_H
+
+#include "freertos/FreeRTOS.h"
+
+// Items are copied in and out by value, as on the real kernel.
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  fake::HeapPause pause;
+  fake::Queue* q = new fake::Queue;
+  q->length = length;
+  q->itemSize = itemSize;
+  return q;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t ticks) {
+  fake::HeapPause pause;
+  std::unique_lock<std::mutex> held(q->lock);
+  if (!q->waitFor(held, ticks, [q] { return q->items.size() < q->length; })) return errQUEUE_FULL;
+  const uint8_t* bytes = (const uint8_t*)item;
+  q->items.emplace_back(bytes, bytes + q->itemSize);
+  q->changed.notify_all();
+  return pdPASS;
+}
+
+inline BaseType_t xQueueSendToBack(QueueHandle_t q, const void* item, TickType_t ticks) {
+  return xQueueSend(q, item, ticks);
+}
+
+// Length-1 queues only, like the kernel: replaces whatever is waiting
+inline BaseType_t xQueueOverwrite(QueueHandle_t q, const void* item) {
+  fake::HeapPause pause;
+  std::lock_guard<std::mutex> held(q->lock);
+  const uint8_t* bytes = (const uint8_t*)item;
+  q->items.clear();
+  q->items.emplace_back(bytes, bytes + q->itemSize);
+  q->changed.notify_all();
+  return pdPASS;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t ticks) {
+  fake::HeapPause pause;
+  std::unique_lock<std::mutex> held(q->lock);
+  if (!q->waitFor(held, ticks, [q] { return !q->items.empty(); })) return pdFALSE;
+  memcpy(item, q->items.front().data(), q->itemSize);
+  q->items.pop_front();
+  q->changed.notify_all();
+  return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  std::lock_guard<std::mutex> held(q->lock);
+  return (UBaseType_t)q->items.size();
+}
+
+#endif // FREERTOS_QUEUE_SHIM_H
@@ -0,0 +1,59 @@
+#ifndef FREERTOS_TASK_SHIM_H
+#define FREERTOS_TASK_SHIM_H
+
+#include "freertos/FreeRTOS.h"
+
+// Each task gets its own detached thread; stack size, priority and core are
+// recorded but not enforced.
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                          void* param, UBaseType_t priority, TaskHandle_t* handle,
+                                          BaseType_t core) {
+  (void)stackDepth; (void)priority;
+  fake::Task* task;
+  {
+    fake::HeapPause pause;
+    task = new fake::Task{name, (int)core};
+  }
+  if (handle) *handle = task;
+  std::thread([fn, param] { fn(param); }).detach();
+  return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                              UBaseType_t priority, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, tskNO_AFFINITY);
+}
+
+inline void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks)); }
+
+inline void vTaskDelete(TaskHandle_t task) { (void)task; }
+
+inline BaseType_t xPortGetCoreID() { return 1; }
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+  static thread_local fake::Task self{"thread", 1};
+  return &self;
+}
+
+// Task notifications as a counting semaphore. A wait that is not satisfied
+// right away passes its whole timeout on the virtual clock, like delay().
+inline void xTaskNotifyGive(TaskHandle_t task) { task->notifications++; }
+
+inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+  task->notifications++;
+  if (woken) *woken = pdTRUE;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+  std::atomic<uint32_t>& count = xTaskGetCurrentTaskHandle()->notifications;
+  if (count == 0) {
+    fake::clock().advanceMs(ticks);
+    fake::clock().blockedUs += (uint64_t)ticks * 1000;
+  }
+  return clearOnExit ? count.exchange(0) : (count ? count-- : 0);
+}
+
+inline BaseType_t xPortInIsrContext() { return pdFALSE; }
+#define portYIELD_FROM_ISR(...)
+
+#endif // FREERTOS_TASK_SHIM_H
@@ -0,0 +1,112 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Tiny microbenchmark runner for the native environment. Each case reports
+// host CPU time, heap allocations, peak heap growth, bytes the calling thread
+// pushed to Serial and virtual time spent blocked in delay() -- all per
+// operation.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <Arduino.h>
+
+struct BenchResult {
+  const char* name;
+  uint32_t iterations;
+  double cpuNsPerOp;
+  double allocsPerOp;
+  size_t peakHeapBytes;
+  double serialBytesPerOp;
+  double blockedUsPerOp;
+};
+
+inline uint64_t benchThreadCpuNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Width of the benchmark-name column, shared by the header and the rows.
+#define BENCH_NAME_WIDTH 40
+
+inline void benchPrintHeader() {
+  printf("\n%-*s %8s %12s %10s %12s %12s %12s\n", BENCH_NAME_WIDTH, "benchmark", "iters", "cpu ns/op",
+         "allocs/op", "peak heap B", "serial B/op", "blocked us/op");
+}
+
+inline void benchPrint(const BenchResult& r) {
+  printf("%-*s %8u %12.0f %10.2f %12zu %12.1f %12.0f\n", BENCH_NAME_WIDTH, r.name, r.iterations, r.cpuNsPerOp,
+         r.allocsPerOp, r.peakHeapBytes, r.serialBytesPerOp, r.blockedUsPerOp);
+}
+
+template <typename Fn>
+BenchResult runBench(const char* name, uint32_t iterations, Fn&& fn) {
+  fake::Heap& heap = fake::heap();
+  fake::Uart& uart = fake::uart();
+  fake::Clock& clk = fake::clock();
+
+  fn();  // warm-up: first-call statics and lazy buffers are not per-request cost
+
+  heap.resetCounters();
+  size_t baseBytes = heap.bytesInUse;
+  uint64_t baseSerial = uart.threadBytes();
+  uint64_t baseBlocked = clk.blockedUs;
+  uint64_t start = benchThreadCpuNs();
+
+  for (uint32_t i = 0; i < iterations; i++) fn();
+
+  uint64_t elapsed = benchThreadCpuNs() - start;
+  BenchResult r;
+  r.name = name;
+  r.iterations = iterations;
+  r.cpuNsPerOp = (double)elapsed / iterations;
+  r.allocsPerOp = (double)heap.allocations / iterations;
+  r.peakHeapBytes = heap.peakBytes - baseBytes;
+  r.serialBytesPerOp = (double)(uart.threadBytes() - baseSerial) / iterations;
+  r.blockedUsPerOp = (double)(clk.blockedUs - baseBlocked) / iterations;
+  benchPrint(r);
+  return r;
+}
+
+// Stack bytes `fn` touches, like uxTaskGetStackHighWaterMark(): it runs once
+// on a thread whose stack was painted first, and the untouched paint is
+// measured. The thread's own start-up use is taken off.
+inline size_t benchStackBytes(void (*fn)()) {
+  static const size_t kStackBytes = 256 * 1024;
+  struct Run {
+    static void* go(void* arg) {
+      void (*f)() = (void (*)())arg;
+      if (f) f();
+      return nullptr;
+    }
+    static size_t used(void (*f)()) {
+      uint8_t* stack;
+      {
+        fake::HeapPause pause;
+        stack = (uint8_t*)malloc(kStackBytes);
+      }
+      memset(stack, 0xA5, kStackBytes);
+      pthread_attr_t attr;
+      pthread_attr_init(&attr);
+      pthread_attr_setstack(&attr, stack, kStackBytes);
+      pthread_t thread;
+      pthread_create(&thread, &attr, go, (void*)f);
+      pthread_join(thread, nullptr);
+      pthread_attr_destroy(&attr);
+      size_t untouched = 0;
+      while (untouched < kStackBytes && stack[untouched] == 0xA5) untouched++;
+      fake::HeapPause pause;
+      free(stack);
+      return kStackBytes - untouched;
+    }
+  };
+  size_t idle = Run::used(nullptr);
+  size_t busy = Run::used(fn);
+  return busy > idle ? busy - idle : 0;
+}
+
+#endif // BENCH_H
@@ -0,0 +1,84 @@
+#ifndef FIRMWARE_H
+#define FIRMWARE_H
+
+// Firmware symbols exercised by the harness. src/main.cpp has no header of its
+// own, so the declarations the tests need are mirrored here.
+
+#include <ArduinoJson.h>
+#include <WebServer.h>
+#include <WebSocketsClient.h>
+
+#include "api_connection.h"
+#include "config_store.h"
+#include "firmware_config.h"
+#include "json_writer.h"
+#include "led_animation.h"
+#include "led_strip.h"
+#include "log.h"
+#include "melody_player.h"
+#include "scheduler.h"
+#include "sleep_snapshot.h"
+#include "touch_input.h"
+#include "web_pages.h"
+#include "weather_cache.h"
+#include "weather_condition.h"
+#include "weather_event.h"
+#include "weather_fetch.h"
+#include "weather_request.h"
+#include "wifi_link.h"
+
+extern WebServer server;
+extern WebSocketsClient wsClient;
+extern WeatherEvents weatherEvents;
+extern bool relayMsgPack;
+extern LedStrip<NUM_LEDS> strip;
+extern String deviceId;
+extern WeatherCondition lastWeatherCondition;
+extern int lastTemperature;
+extern float lastPrecipitation;
+extern int weatherSymbol;
+extern int currentTemperature;
+extern WeatherCache weatherCache;
+extern ApiConnection meteomaticsApi;
+extern String apiUser;
+extern String apiPass;
+extern String wifiSSID;
+extern String wifiPassword;
+extern bool bleEnabled;
+extern WiFiLink wifiLink;
+extern TouchInput touchInput;
+extern SleepSnapshot sleepSnapshot;
+extern unsigned long sleepAfterIdleMs;
+extern unsigned long bootToConnectedMs;
+extern uint8_t timeSyncPolls;
+extern bool animationActive;
+extern MelodyPlayer buzzer;
+extern float latitude;
+extern float longitude;
+extern volatile uint32_t weatherFetchGeneration;
+extern WeatherFetchRequest weatherFetchPending;
+extern unsigned long weatherFetchWorstLoopUs;
+
+void setup();
+void loop();
+bool loadConfig();
+void saveConfig();
+void handleHealthEndpoint();
+void handleWeatherEndpoint();
+void handleDeviceInfo();
+void handleConnectionStatus();
+void handleConfigSubmission();
+void handleLocationSubmission();
+int processLocalRequest(const char* method, const char* path, JsonVariant body, char* reply, size_t replySize,
+                        size_t& replyLength);
+void handleWebSocketMessage(char* payload, size_t length, bool binary = false);
+void pushWeatherEvent();
+bool parseForecastStream(Stream& stream, uint32_t startHour, ForecastStore& forecast,
+                         const WeatherFetchRequest* request = nullptr);
+bool getWeatherForecast(const WeatherFetchRequest& request, ForecastStore& forecast);
+bool serveCachedWeather();
+void interpretWeatherSymbol(int code);
+void setLEDRGB(int temperature);
+void playToneIfNecessary(WeatherCondition condition);
+
+#endif // FIRMWARE_H
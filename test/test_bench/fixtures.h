@@ -0,0 +1,47 @@
+#ifndef FIXTURES_H
+#define FIXTURES_H
+
+#include <time.h>
+
+#include <string>
+
+#include "forecast_store.h"
+
+// Meteomatics answer for the single-instant query the firmware sends
+// (t_2m:C,weather_symbol_1h:idx at one location), as captured from the API.
+static const char kMeteomaticsNowResponse[] = R"json({"version":"3.0","user":"myself_pro_card","dateGenerated":"2026-01-15T12:00:01Z","status":"OK","data":[{"parameter":"t_2m:C","coordinates":[{"lat":48.9075,"lon":2.3833,"dates":[{"date":"2026-01-15T12:00:00Z","value":7.4}]}]},{"parameter":"weather_symbol_1h:idx","coordinates":[{"lat":48.9075,"lon":2.3833,"dates":[{"date":"2026-01-15T12:00:00Z","value":4}]}]}]})json";
+
+// Meteomatics answer for the range query the firmware sends: every
+// FORECAST_PARAMETERS series, hourly from `startHour` for `hours` hours.
+// Temperature starts at 7.4 °C and climbs 0.25 °C/h, the symbol cycles 1..4
+// starting at 4, and odd hours carry 0.1 mm of rain.
+inline std::string meteomaticsForecastResponse(uint32_t startHour, int hours = FORECAST_HOURS) {
+  static const char* const kParams[] = {"t_2m:C", "weather_symbol_1h:idx", "precip_1h:mm"};
+  std::string out =
+      "{\"version\":\"3.0\",\"user\":\"myself_pro_card\",\"dateGenerated\":\"2026-01-15T12:00:01Z\","
+      "\"status\":\"OK\",\"data\":[";
+  for (int p = 0; p < 3; p++) {
+    out += p ? ",{\"parameter\":\"" : "{\"parameter\":\"";
+    out += kParams[p];
+    out += "\",\"coordinates\":[{\"lat\":48.9075,\"lon\":2.3833,\"dates\":[";
+    for (int h = 0; h < hours; h++) {
+      time_t t = (time_t)(startHour + h) * 3600;
+      struct tm utc;
+      gmtime_r(&t, &utc);
+      char entry[80];
+      int n = strftime(entry, sizeof(entry), "{\"date\":\"%Y-%m-%dT%H:%M:%SZ\",\"value\":", &utc);
+      switch (p) {
+        case 0: snprintf(entry + n, sizeof(entry) - n, "%.2f}", 7.4 + 0.25 * h); break;
+        case 1: snprintf(entry + n, sizeof(entry) - n, "%d}", (h + 3) % 4 + 1); break;
+        default: snprintf(entry + n, sizeof(entry) - n, "%.1f}", (h % 2) ? 0.1 : 0.0); break;
+      }
+      if (h) out += ",";
+      out += entry;
+    }
+    out += "]}]}";
+  }
+  out += "]}";
+  return out;
+}
+
+#endif // FIXTURES_H
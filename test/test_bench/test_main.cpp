@@ -0,0 +1,2642 @@
+// Host benchmarks for the Weather Potato firmware logic.
+//
+//   pio test -e native -v
+//
+// Runs src/main.cpp against the fakes in test/shims and prints per-request CPU
+// time and allocation counts. Set WP_ECHO_SERIAL=1 to see the firmware's
+// Serial output.
+
+#include <chrono>
+#include <string>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <HTTPClient.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <unity.h>
+
+#include "bench.h"
+#include "firmware.h"
+#include "fixtures.h"
+
+// Route every C++ allocation through the fake heap so benchmarks see them.
+void* operator new(size_t size) {
+  void* p = fake::heapAlloc(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { fake::heapFree(p); }
+void operator delete[](void* p) noexcept { fake::heapFree(p); }
+void operator delete(void* p, size_t) noexcept { fake::heapFree(p); }
+void operator delete[](void* p, size_t) noexcept { fake::heapFree(p); }
+
+static const uint32_t kRequestIters = 2000;
+
+void setUp() {}
+void tearDown() {}
+
+// ============================================================================
+// HTTP handlers
+// ============================================================================
+
+static void test_setup_registers_routes() {
+  TEST_ASSERT_TRUE(server.listening());
+  TEST_ASSERT_EQUAL(17, server.routeCount());  // every ROUTES entry, once
+}
+
+static void bench_http_health() {
+  BenchResult r = runBench("http GET /health", kRequestIters, [] {
+    const FakeHttpResponse& res = server.fakeRequest(HTTP_GET, "/health");
+    TEST_ASSERT_EQUAL(200, res.code);
+  });
+  TEST_ASSERT_GREATER_THAN(0, r.iterations);
+  // Logging only queues: the handler itself never waits on the UART
+  TEST_ASSERT_EQUAL_FLOAT(0, r.serialBytesPerOp);
+}
+
+static void bench_http_weather() {
+  runBench("http GET /weather", kRequestIters, [] {
+    const FakeHttpResponse& res = server.fakeRequest(HTTP_GET, "/weather");
+    TEST_ASSERT_EQUAL(200, res.code);
+  });
+}
+
+static void bench_http_device_info() {
+  runBench("http GET /device-info", kRequestIters, [] {
+    const FakeHttpResponse& res = server.fakeRequest(HTTP_GET, "/device-info");
+    TEST_ASSERT_EQUAL(200, res.code);
+  });
+}
+
+static void bench_http_connection_status() {
+  runBench("http GET /connection-status", kRequestIters, [] {
+    const FakeHttpResponse& res = server.fakeRequest(HTTP_GET, "/connection-status");
+    TEST_ASSERT_EQUAL(200, res.code);
+  });
+}
+
+static void bench_http_location() {
+  runBench("http POST /location", kRequestIters, [] {
+    const FakeHttpResponse& res =
+        server.fakeRequest(HTTP_POST, "/location", "{\"latitude\":48.9075,\"longitude\":2.3833}");
+    TEST_ASSERT_EQUAL(200, res.code);
+  });
+}
+
+// Runs loop() and delivers the radio's events until the link is up, or
+// `maxMs` of virtual time passed; loop()'s own delay() moves the clock
+static bool joinWiFi(uint32_t maxMs = 20000) {
+  unsigned long start = millis();
+  while (millis() - start < maxMs) {
+    WiFi.fakeRunEvents();
+    loop();
+    if (wifiLink.state() == WIFI_LINK_CONNECTED) return true;
+  }
+  return false;
+}
+
+static void bench_http_config() {
+  runBench("http POST /config", kRequestIters, [] {
+    const FakeHttpResponse& res = server.fakeRequest(
+        HTTP_POST, "/config",
+        "{\"ssid\":\"PotatoNet\",\"password\":\"hunter22\",\"latitude\":48.9075,\"longitude\":2.3833}");
+    TEST_ASSERT_EQUAL(200, res.code);
+  });
+  TEST_ASSERT_TRUE(joinWiFi());  // The later tests expect a network
+  TEST_ASSERT_TRUE(server.listening());
+  TEST_ASSERT_EQUAL(17, server.routeCount());  // rebound, not registered again
+}
+
+// The first connection asks NTP for the time without waiting on the wifi
+// task; the time task polls the clock and then opens the relay
+static void test_time_sync_starts_relay() {
+  TEST_ASSERT_EQUAL(20, timeSyncPolls);
+  TEST_ASSERT_EQUAL(0, wsClient.fakeBegins);
+
+  unsigned long start = millis();
+  while (timeSyncPolls > 0 && millis() - start < 2000) loop();
+  TEST_ASSERT_EQUAL(0, timeSyncPolls);
+  TEST_ASSERT_EQUAL(1, wsClient.fakeBegins);
+}
+
+// Static pages come gzipped from flash with an ETag, and a matching
+// If-None-Match gets an empty 304
+static void test_static_pages_gzip_etag() {
+  const FakeHttpResponse& page = server.fakeRequest(HTTP_GET, "/setup");
+  TEST_ASSERT_EQUAL(200, page.code);
+  TEST_ASSERT_EQUAL_STRING("text/html", page.contentType.c_str());
+  TEST_ASSERT_EQUAL_STRING("gzip", page.header("Content-Encoding"));
+  TEST_ASSERT_EQUAL(page.body.size(), page.contentLength);
+  TEST_ASSERT_EQUAL(0x1f, (uint8_t)page.body[0]);  // gzip magic
+  TEST_ASSERT_EQUAL(0x8b, (uint8_t)page.body[1]);
+  std::string etag = page.header("ETag");
+  TEST_ASSERT_EQUAL('"', etag.front());
+
+  const FakeHttpResponse& cached = server.fakeRequest(HTTP_GET, "/setup", "", {{"If-None-Match", etag}});
+  TEST_ASSERT_EQUAL(304, cached.code);
+  TEST_ASSERT_EQUAL(0, cached.body.size());
+  TEST_ASSERT_EQUAL_STRING(etag.c_str(), cached.header("ETag"));
+
+  TEST_ASSERT_EQUAL(304, server.fakeRequest(HTTP_GET, "/setup", "", {{"If-None-Match", "W/" + etag}}).code);
+  TEST_ASSERT_EQUAL(304, server.fakeRequest(HTTP_GET, "/setup", "", {{"If-None-Match", "\"old\", " + etag}}).code);
+  TEST_ASSERT_EQUAL(200, server.fakeRequest(HTTP_GET, "/setup", "", {{"If-None-Match", "\"old\""}}).code);
+
+  // Each page has its own validator
+  const FakeHttpResponse& ota = server.fakeRequest(HTTP_GET, "/ota", "", {{"If-None-Match", etag}});
+  TEST_ASSERT_EQUAL(200, ota.code);
+  TEST_ASSERT_EQUAL_STRING("gzip", ota.header("Content-Encoding"));
+}
+
+static void bench_http_setup_page() {
+  // Size of the raw-literal page the handler used to copy into a String
+  const size_t legacyBytes = 8325;
+  BenchResult full = runBench("http GET /setup (gzip)", kRequestIters, [] {
+    TEST_ASSERT_EQUAL(200, server.fakeRequest(HTTP_GET, "/setup").code);
+  });
+  std::string etag = server.fakeRequest(HTTP_GET, "/setup").header("ETag");
+  size_t gzipBytes = server.fakeRequest(HTTP_GET, "/setup").body.size();
+  BenchResult revalidated = runBench("http GET /setup (304)", kRequestIters, [&] {
+    TEST_ASSERT_EQUAL(304, server.fakeRequest(HTTP_GET, "/setup", "", {{"If-None-Match", etag}}).code);
+  });
+  printf("  -> /setup body: %zu B before, %zu B gzipped, 0 B on a 304; peak heap %zu B vs %zu B\n", legacyBytes,
+         gzipBytes, full.peakHeapBytes, revalidated.peakHeapBytes);
+  TEST_ASSERT_LESS_THAN(legacyBytes / 2, gzipBytes);
+  TEST_ASSERT_LESS_THAN(legacyBytes, full.peakHeapBytes);  // The page is never copied to RAM
+}
+
+// Renderer output captured chunk by chunk
+struct CapturedChunks {
+  std::vector<std::string> chunks;
+  std::vector<const char*> pointers;
+
+  static void add(void* context, const char* data, size_t length) {
+    CapturedChunks* self = (CapturedChunks*)context;
+    self->chunks.emplace_back(data, length);
+    self->pointers.push_back(data);
+  }
+  std::string text() const {
+    std::string all;
+    for (const std::string& c : chunks) all += c;
+    return all;
+  }
+};
+
+static void test_page_template_renderer() {
+  // The generator's lengths match its literals
+  for (size_t i = 0; i < INDEX_HTML.count; i++) {
+    TEST_ASSERT_EQUAL(strlen(INDEX_HTML.segments[i].text), INDEX_HTML.segments[i].length);
+  }
+  TEST_ASSERT_NULL(INDEX_HTML.segments[INDEX_HTML.count - 1].field);
+
+  static const std::string longText(TEMPLATE_CHUNK_MAX + 10, 'x');
+  static const TemplateSegment segments[] = {
+    { "<p>", 3, "A" },
+    { " and ", 5, "B" },
+    { longText.c_str(), longText.size(), "A" },
+    { "</p>", 4, nullptr },
+  };
+  static const PageTemplate page = { "text/html", segments, 4 };
+  CapturedChunks out;
+  TemplateRenderer renderer(CapturedChunks::add, &out);
+  size_t total = renderer.render(page, [](const char* name, Print& value) {
+    if (strcmp(name, "A") == 0) value.print(21);
+    if (strcmp(name, "B") == 0) value.print(IPAddress(192, 168, 4, 1));
+  });
+
+  std::string expected = "<p>21 and 192.168.4.1" + longText + "21</p>";
+  TEST_ASSERT_EQUAL_STRING(expected.c_str(), out.text().c_str());
+  TEST_ASSERT_EQUAL(expected.size(), total);
+  // Short pieces are gathered, the long literal goes out as is, no empty chunks
+  TEST_ASSERT_EQUAL(3, out.chunks.size());
+  TEST_ASSERT_EQUAL_STRING("<p>21 and 192.168.4.1", out.chunks[0].c_str());
+  TEST_ASSERT_EQUAL_PTR(longText.c_str(), out.pointers[1]);
+  for (const std::string& c : out.chunks) TEST_ASSERT_GREATER_THAN(0, c.size());
+}
+
+static void test_root_page_fills_fields() {
+  const FakeHttpResponse& res = server.fakeRequest(HTTP_GET, "/");
+  TEST_ASSERT_EQUAL(200, res.code);
+  TEST_ASSERT_TRUE(res.chunked);
+  TEST_ASSERT_EQUAL(std::string::npos, res.body.find('%' + std::string("DEVICEID")));
+  std::string device = "<b>Device ID:</b> " + std::string(deviceId.c_str()) + "</p>";
+  std::string temperature = "<b>Temperature:</b> " + std::to_string(lastTemperature) + "°C";
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, res.body.find(device));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, res.body.find(temperature));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, res.body.find("<b>Local IP:</b> 192.168."));
+}
+
+// Old handler: the whole page copied into a String, then four replace() passes
+static void bench_root_page_replace_vs_template() {
+  static std::string legacyPage;
+  for (size_t i = 0; i < INDEX_HTML.count; i++) {
+    legacyPage += INDEX_HTML.segments[i].text;
+    if (INDEX_HTML.segments[i].field) legacyPage += std::string("%") + INDEX_HTML.segments[i].field + "%";
+  }
+
+  BenchResult legacy = runBench("root page: String::replace", kRequestIters, [] {
+    String html = legacyPage.c_str();
+    html.replace("%DEVICEID%", deviceId);
+    html.replace("%WEATHER%", conditionName(lastWeatherCondition));
+    html.replace("%TEMP%", String(lastTemperature));
+    html.replace("%IP%", WiFi.localIP().toString());
+    TEST_ASSERT_GREATER_THAN(0, html.length());
+  });
+  BenchResult streamed = runBench("http GET / (template)", kRequestIters, [] {
+    TEST_ASSERT_EQUAL(200, server.fakeRequest(HTTP_GET, "/").code);
+  });
+  printf("  -> root page: %.0f allocs, peak %zu B (replace) vs %.0f allocs, peak %zu B (streamed)\n",
+         legacy.allocsPerOp, legacy.peakHeapBytes, streamed.allocsPerOp, streamed.peakHeapBytes);
+  TEST_ASSERT_LESS_THAN(TEMPLATE_CHUNK_MAX, streamed.peakHeapBytes);
+}
+
+// The pre-JsonWriter /weather body: one String grown by += per field
+static String legacyWeatherJson() {
+  String response = "{";
+  response += "\"device_id\":\"" + String("potato-123456") + "\",";
+  response += "\"condition\":\"" + String(conditionName(lastWeatherCondition)) + "\",";
+  response += "\"temperature\":" + String(lastTemperature) + ",";
+  response += "\"precipitation\":" + String(lastPrecipitation, 2) + ",";
+  response += "\"symbol\":" + String(weatherSymbol) + ",";
+  response += "\"location\":{";
+  response += "\"latitude\":" + String(latitude, 4) + ",";
+  response += "\"longitude\":" + String(longitude, 4);
+  response += "},";
+  response += "\"timestamp\":" + String(millis());
+  response += "}";
+  return response;
+}
+
+static void test_json_writer() {
+  StaticJsonWriter<256> json;
+  json.beginObject();
+  json.key("s").value("a\"b\\c\n\t\x01é");
+  json.key("n").value(-42);
+  json.key("f").value(-0.125f, 2);
+  json.key("z").value(-0.001f, 2);
+  json.key("nan").value(NAN, 2);
+  json.key("ip").value(IPAddress(192, 168, 1, 42));
+  json.key("a").beginArray().value(true).value(false).value((const char*)nullptr).endArray();
+  json.key("o").beginObject().endObject();
+  json.endObject();
+  TEST_ASSERT_TRUE(json.ok());
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"s\":\"a\\\"b\\\\c\\n\\t\\u0001é\",\"n\":-42,\"f\":-0.13,\"z\":0.00,\"nan\":null,"
+      "\"ip\":\"192.168.1.42\",\"a\":[true,false,null],\"o\":{}}",
+      json.c_str());
+  TEST_ASSERT_EQUAL(strlen(json.c_str()), json.length());
+
+  // Too small without a flush: truncated and flagged
+  StaticJsonWriter<8> small;
+  small.beginObject().key("status").value("ready").endObject();
+  TEST_ASSERT_FALSE(small.ok());
+
+  // Too small with a flush: the pieces add up to the whole document
+  static std::string flushed;
+  flushed.clear();
+  StaticJsonWriter<8> chunked;
+  chunked.onFlush([](void*, const char* data, size_t length) { flushed.append(data, length); }, nullptr);
+  chunked.beginObject().key("status").value("ready").endObject();
+  TEST_ASSERT_TRUE(chunked.ok());
+  TEST_ASSERT_TRUE(chunked.hasFlushed());
+  TEST_ASSERT_EQUAL_STRING("{\"status\":\"ready\"}", (flushed + chunked.c_str()).c_str());
+
+  // Nested too deep: flagged, and what follows the deep part is still placed
+  // at its own level
+  flushed.clear();
+  StaticJsonWriter<8> deep;
+  deep.onFlush([](void*, const char* data, size_t length) { flushed.append(data, length); }, nullptr);
+  deep.beginArray().beginArray().value(1);
+  for (int i = 0; i < JSON_WRITER_MAX_DEPTH + 4; i++) deep.beginArray();
+  for (int i = 0; i < JSON_WRITER_MAX_DEPTH + 4; i++) deep.endArray();
+  deep.value(2).endArray().beginArray().value(3).endArray().endArray();
+  TEST_ASSERT_FALSE(deep.ok());
+  std::string nested = std::string(JSON_WRITER_MAX_DEPTH + 4, '[') + std::string(JSON_WRITER_MAX_DEPTH + 4, ']');
+  TEST_ASSERT_EQUAL_STRING(("[[1," + nested + ",2],[3]]").c_str(), (flushed + deep.c_str()).c_str());
+}
+
+// Handlers answer with Content-Length and a body identical to the old one
+static void bench_weather_json_string_vs_writer() {
+  const FakeHttpResponse& res = server.fakeRequest(HTTP_GET, "/weather");
+  TEST_ASSERT_EQUAL(res.body.size(), res.contentLength);
+  TEST_ASSERT_FALSE(res.chunked);
+  StaticJsonDocument<512> doc;
+  TEST_ASSERT_FALSE(deserializeJson(doc, res.body.c_str()));
+  TEST_ASSERT_EQUAL(lastTemperature, doc["temperature"].as<int>());
+
+  BenchResult legacy = runBench("/weather body: String +=", kRequestIters, [] {
+    TEST_ASSERT_GREATER_THAN(0, legacyWeatherJson().length());
+  });
+  BenchResult writer = runBench("/weather body: JsonWriter", kRequestIters, [] {
+    StaticJsonWriter<JSON_RESPONSE_BUFFER> json;
+    json.beginObject();
+    json.key("device_id").value("potato-123456");
+    json.key("condition").value(conditionName(lastWeatherCondition));
+    json.key("temperature").value(lastTemperature);
+    json.key("precipitation").value(lastPrecipitation, 2);
+    json.key("symbol").value(weatherSymbol);
+    json.key("location").beginObject();
+    json.key("latitude").value(latitude, 4);
+    json.key("longitude").value(longitude, 4);
+    json.endObject();
+    json.key("timestamp").value(millis());
+    json.endObject();
+    TEST_ASSERT_TRUE(json.ok());
+  });
+  printf("  -> /weather body: %.0f allocs, %.0f ns (String) vs %.0f allocs, %.0f ns (JsonWriter)\n",
+         legacy.allocsPerOp, legacy.cpuNsPerOp, writer.allocsPerOp, writer.cpuNsPerOp);
+  TEST_ASSERT_EQUAL_FLOAT(0, writer.allocsPerOp);
+}
+
+// The same calls in MessagePack, byte for byte
+static void test_json_writer_msgpack() {
+  StaticJsonWriter<256> json;
+  json.useMsgPack();
+  json.beginObject();
+  json.key("n").value(-42);
+  json.key("u").value(300);
+  json.key("f").value(-0.125f, 2);
+  json.key("nan").value(NAN, 2);
+  json.key("ip").value(IPAddress(192, 168, 1, 42));
+  json.key("a").beginArray().value(true).value(false).value((const char*)nullptr).endArray();
+  json.key("o").beginObject().endObject();
+  json.endObject();
+  TEST_ASSERT_TRUE(json.ok());
+  static const char kExpected[] =
+      "\x87"                                             // fixmap of 7
+      "\xa1" "n" "\xd0\xd6"                              // int8 -42
+      "\xa1" "u" "\xcd\x01\x2c"                          // uint16 300
+      "\xa1" "f" "\xcb\xbf\xc0\xa3\xd7\x0a\x3d\x70\xa4"  // float64 -0.13
+      "\xa3" "nan" "\xc0"
+      "\xa2" "ip" "\xac" "192.168.1.42"
+      "\xa1" "a" "\x93\xc3\xc2\xc0"
+      "\xa1" "o" "\x80";
+  TEST_ASSERT_EQUAL(sizeof(kExpected) - 1, json.length());
+  TEST_ASSERT_EQUAL_MEMORY(kExpected, json.c_str(), sizeof(kExpected) - 1);
+
+  // 16 members and more keep the 16-bit count; long strings get a length byte
+  StaticJsonWriter<256> big;
+  big.useMsgPack();
+  big.beginArray();
+  for (int i = 0; i < 16; i++) big.value(i);
+  big.value("a string longer than thirty-one bytes");
+  big.endArray();
+  TEST_ASSERT_TRUE(big.ok());
+  TEST_ASSERT_EQUAL(3 + 16 + 2 + 37, big.length());
+  TEST_ASSERT_EQUAL_MEMORY("\xdc\x00\x11\x00\x01", big.c_str(), 5);
+  TEST_ASSERT_EQUAL_MEMORY("\x0f\xd9\x25" "a string", big.c_str() + 18, 11);
+
+  // 64 KiB and up: a 32-bit length
+  static StaticJsonWriter<0x10010> huge;
+  static char text[0x10001];
+  memset(text, 'x', sizeof(text) - 1);
+  text[sizeof(text) - 1] = '\0';
+  huge.useMsgPack();
+  huge.value(text);
+  TEST_ASSERT_TRUE(huge.ok());
+  TEST_ASSERT_EQUAL(5 + 0x10000, huge.length());
+  TEST_ASSERT_EQUAL_MEMORY("\xdb\x00\x01\x00\x00x", huge.c_str(), 6);
+
+  // Never flushed: counts are filled in once a container is whole
+  StaticJsonWriter<8> small;
+  small.useMsgPack();
+  small.onFlush([](void*, const char*, size_t) {}, nullptr);
+  small.beginObject().key("status").value("ready").endObject();
+  TEST_ASSERT_FALSE(small.ok());
+  TEST_ASSERT_FALSE(small.hasFlushed());
+}
+
+// JSON endpoints answer Accept: application/msgpack with the same document
+static void test_http_msgpack() {
+  static const char* const kPaths[] = {"/health", "/weather", "/device-info", "/connection-status", "/tasks"};
+  for (const char* path : kPaths) {
+    std::string json = server.fakeRequest(HTTP_GET, path).body;
+    const FakeHttpResponse& res =
+        server.fakeRequest(HTTP_GET, path, "", {{"Accept", "application/msgpack, application/json"}});
+    TEST_ASSERT_EQUAL(200, res.code);
+    TEST_ASSERT_EQUAL_STRING("application/msgpack", res.contentType.c_str());
+    TEST_ASSERT_EQUAL(res.body.size(), res.contentLength);
+    TEST_ASSERT_LESS_THAN(json.size(), res.body.size());
+
+    StaticJsonDocument<2048> fromJson, fromMsgPack;
+    TEST_ASSERT_FALSE(deserializeJson(fromJson, json.c_str()));
+    TEST_ASSERT_FALSE(deserializeMsgPack(fromMsgPack, res.body));
+    std::string a, b;
+    serializeJson(fromJson, a);
+    serializeJson(fromMsgPack, b);
+    TEST_ASSERT_EQUAL_STRING(a.c_str(), b.c_str());
+  }
+  // Anyone else still gets JSON
+  TEST_ASSERT_EQUAL_STRING("application/json",
+                           server.fakeRequest(HTTP_GET, "/weather", "", {{"Accept", "*/*"}}).contentType.c_str());
+}
+
+// ============================================================================
+// Logging
+// ============================================================================
+
+// Print that keeps what it is given, to check drained log lines
+struct CapturePrint : public Print {
+  std::string text;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    text.append((const char*)buffer, size);
+    return size;
+  }
+};
+
+static void test_logger_lines_and_drops() {
+  static Logger log;  // Private ring; the firmware's is drained by its task
+  CapturePrint out;
+
+  fake::clock().nowUs = 12345000;
+  TEST_ASSERT_TRUE(log.print(WP_LOG_WARN, "temp %d", 21));
+  TEST_ASSERT_EQUAL(1, log.drain(out));
+  TEST_ASSERT_EQUAL_STRING("W (12345) temp 21\r\n", out.text.c_str());
+
+  // Long lines are cut to LOG_LINE_MAX - 1 characters
+  out.text.clear();
+  std::string longLine(300, 'x');
+  log.print(WP_LOG_INFO, "%s", longLine.c_str());
+  log.drain(out);
+  TEST_ASSERT_EQUAL(LOG_LINE_MAX - 1 + 2, out.text.size());
+
+  // A full ring drops (and counts) instead of waiting for the drain
+  out.text.clear();
+  for (int i = 0; i < LOG_QUEUE_LINES + 5; i++) {
+    log.print(WP_LOG_INFO, "line %d", i);
+  }
+  TEST_ASSERT_EQUAL(5, log.dropped());
+  TEST_ASSERT_EQUAL(LOG_QUEUE_LINES, log.drain(out));
+  TEST_ASSERT_EQUAL(0, out.text.find("W (12345) log: 5 lines dropped\r\n"));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, out.text.find("line 31\r\n"));
+  TEST_ASSERT_EQUAL(std::string::npos, out.text.find("line 32\r\n"));
+
+  // Space is back once drained, and the drop is only reported once
+  out.text.clear();
+  TEST_ASSERT_TRUE(log.print(WP_LOG_INFO, "again"));
+  TEST_ASSERT_EQUAL(1, log.drain(out));
+  TEST_ASSERT_EQUAL(0, out.text.find("I (12345) again"));
+}
+
+static void test_logger_levels_compile_out() {
+  int evaluated = 0;
+  WP_LOGD("debug %d", ++evaluated);  // Above the default WP_LOG_INFO
+  TEST_ASSERT_EQUAL(0, evaluated);
+
+  // The firmware's log task drains queued lines to Serial by itself
+  uint64_t before = fake::uart().bytesWritten;
+  WP_LOGI("drained by the log task");
+  for (int i = 0; i < 100 && fake::uart().bytesWritten == before; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(LOG_DRAIN_IDLE_MS));
+  }
+  TEST_ASSERT_GREATER_THAN(before, fake::uart().bytesWritten);
+}
+
+// Queueing a line vs printing the old banner straight to Serial
+static void bench_log_line_vs_serial() {
+  BenchResult serial = runBench("log: Serial.println banner", kRequestIters, [] {
+    Serial.println("========================================");
+    Serial.println("📡 INCOMING REQUEST: /health");
+  });
+  BenchResult queued = runBench("log: WP_LOGI line", kRequestIters, [] {
+    WP_LOGI("📡 %s from %u.%u.%u.%u", "/health", 192, 168, 4, 2);
+  });
+  BenchResult stripped = runBench("log: WP_LOGD line (stripped)", kRequestIters, [] {
+    WP_LOGD("📡 %s from %u.%u.%u.%u", "/health", 192, 168, 4, 2);
+  });
+  printf("  -> %.0f B/op on the caller's UART (%.0f us at 115200 baud) vs %.0f B queued, %.0f ns stripped\n",
+         serial.serialBytesPerOp, serial.serialBytesPerOp * 10 * 1000000 / 115200, queued.serialBytesPerOp,
+         stripped.cpuNsPerOp);
+  TEST_ASSERT_EQUAL_FLOAT(0, queued.serialBytesPerOp);
+  TEST_ASSERT_EQUAL_FLOAT(0, queued.allocsPerOp);
+}
+
+// ============================================================================
+// Relay dispatch
+// ============================================================================
+
+// A relayed request through processLocalRequest(): the reply as text
+static std::string relayReply(const char* method, const char* path, JsonVariant body, int& status) {
+  static char reply[RELAY_FRAME_MAX];
+  size_t length = 0;
+  status = processLocalRequest(method, path, body, reply, sizeof(reply), length);
+  return std::string(reply, length);
+}
+
+static void bench_relay_process_local_request() {
+  static const char* const kPaths[] = {"/health", "/weather", "/device-info", "/connection-status"};
+  for (const char* path : kPaths) {
+    char name[48];
+    snprintf(name, sizeof(name), "relay processLocalRequest %s", path);
+    runBench(name, kRequestIters, [path] {
+      int status = 0;
+      static char reply[RELAY_FRAME_MAX];
+      size_t length = 0;
+      status = processLocalRequest("GET", path, JsonVariant(), reply, sizeof(reply), length);
+      TEST_ASSERT_EQUAL(200, status);
+      TEST_ASSERT_GREATER_THAN(0, length);
+    });
+  }
+}
+
+// The relay reaches the same handlers as HTTP, and only the JSON endpoints
+static void test_relay_shares_http_routes() {
+  int status = 0;
+  std::string relayed = relayReply("GET", "/device-info", JsonVariant(), status);
+  TEST_ASSERT_EQUAL(200, status);
+  TEST_ASSERT_EQUAL_STRING(server.fakeRequest(HTTP_GET, "/device-info").body.c_str(), relayed.c_str());
+
+  StaticJsonDocument<128> body;
+  deserializeJson(body, "{\"latitude\":45.5,\"longitude\":-73.5}");
+  relayed = relayReply("POST", "/location", body.as<JsonVariant>(), status);
+  TEST_ASSERT_EQUAL(200, status);
+  TEST_ASSERT_EQUAL_FLOAT(45.5f, latitude);
+  TEST_ASSERT_NOT_NULL(strstr(relayed.c_str(), "\"longitude\":-73.500000"));
+
+  relayed = relayReply("POST", "/location", JsonVariant(), status);
+  TEST_ASSERT_EQUAL(400, status);
+  relayReply("GET", "/location", JsonVariant(), status);
+  TEST_ASSERT_EQUAL(404, status);
+  relayReply("GET", "/ota", JsonVariant(), status);
+  TEST_ASSERT_EQUAL(404, status);
+  relayed = relayReply("GET", "/nope", JsonVariant(), status);
+  TEST_ASSERT_EQUAL(404, status);
+  TEST_ASSERT_EQUAL_STRING("{\"success\":false,\"error\":\"Not found\"}", relayed.c_str());
+
+  // A reply that does not fit is dropped, not cut short
+  static char tiny[16];
+  size_t length = 1;
+  processLocalRequest("GET", "/device-info", JsonVariant(), tiny, sizeof(tiny), length);
+  TEST_ASSERT_EQUAL(0, length);
+
+  // Relayed replies carry no CORS headers and leave the HTTP side alone
+  TEST_ASSERT_EQUAL(200, server.fakeRequest(HTTP_GET, "/health").code);
+  TEST_ASSERT_NOT_NULL(server.fakeRequest(HTTP_GET, "/health").header("Access-Control-Allow-Origin"));
+  TEST_ASSERT_EQUAL(204, server.fakeRequest(HTTP_OPTIONS, "/weather").code);
+  latitude = 48.9075f;
+  longitude = 2.3833f;
+}
+
+static const char kRelayWeatherRequest[] = "{\"type\":\"request\",\"id\":\"r1\",\"method\":\"GET\",\"path\":\"/weather\"}";
+
+// The old relay path, kept as the baseline: the reply as a String, parsed
+// back into one document, copied into the envelope document, serialized again
+static void legacyRelayMessage(const char* payload) {
+  StaticJsonDocument<1024> doc;
+  if (deserializeJson(doc, payload)) return;
+  const char* requestId = doc["id"];
+  static char reply[RELAY_FRAME_MAX];
+  size_t length = 0;
+  int status = processLocalRequest(doc["method"], doc["path"], doc["body"], reply, sizeof(reply), length);
+  String responseData = reply;
+
+  StaticJsonDocument<2048> responseDoc;
+  responseDoc["id"] = requestId;
+  responseDoc["type"] = "response";
+  responseDoc["status"] = status;
+  StaticJsonDocument<1024> dataDoc;
+  deserializeJson(dataDoc, responseData);
+  responseDoc["data"] = dataDoc.as<JsonObject>();
+
+  String responseMsg;
+  serializeJson(responseDoc, responseMsg);
+  wsClient.sendTXT(responseMsg);
+}
+
+static void relayWeatherMessage() {
+  static char payload[sizeof(kRelayWeatherRequest)];
+  memcpy(payload, kRelayWeatherRequest, sizeof(payload));
+  handleWebSocketMessage(payload, sizeof(payload) - 1);
+}
+
+static void test_relay_response_envelope() {
+  wsClient.sent.clear();
+  wsClient.fakeEvent(WStype_TEXT, kRelayWeatherRequest);
+  TEST_ASSERT_EQUAL(1, wsClient.sent.size());
+  StaticJsonDocument<1024> frame;
+  TEST_ASSERT_FALSE(deserializeJson(frame, wsClient.sent[0].payload.c_str()));
+  TEST_ASSERT_EQUAL_STRING("r1", frame["id"]);
+  TEST_ASSERT_EQUAL_STRING("response", frame["type"]);
+  TEST_ASSERT_EQUAL(200, frame["status"].as<int>());
+  TEST_ASSERT_EQUAL(lastTemperature, frame["data"]["temperature"].as<int>());
+
+  // Same frame as the triple-pass path, members aside
+  legacyRelayMessage(kRelayWeatherRequest);
+  StaticJsonDocument<1024> legacy;
+  deserializeJson(legacy, wsClient.sent[1].payload.c_str());
+  std::string a, b;
+  serializeJson(frame["data"], a);
+  serializeJson(legacy["data"], b);
+  TEST_ASSERT_EQUAL_STRING(b.c_str(), a.c_str());
+
+  // Not found, and ids that need escaping
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"request\",\"id\":\"a\\\"b\",\"method\":\"GET\",\"path\":\"/nope\"}");
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"id\":\"a\\\"b\",\"type\":\"response\",\"data\":{\"success\":false,\"error\":\"Not found\"},\"status\":404}",
+      wsClient.sent[2].payload.c_str());
+
+  // Not requests, or not JSON: no reply
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"ping\"}");
+  wsClient.fakeEvent(WStype_TEXT, "{\"id\":\"x\"}");
+  wsClient.fakeEvent(WStype_TEXT, "not json");
+  TEST_ASSERT_EQUAL(3, wsClient.sent.size());
+  wsClient.sent.clear();
+}
+
+static void bench_relay_message_roundtrip() {
+  wsClient.sent.clear();
+  BenchResult legacy = runBench("relay /weather: triple JSON pass", kRequestIters, [] {
+    legacyRelayMessage(kRelayWeatherRequest);
+  });
+  BenchResult single = runBench("relay /weather: in-place frame", kRequestIters, relayWeatherMessage);
+  TEST_ASSERT_EQUAL(2 * (kRequestIters + 1), wsClient.sent.size());
+  wsClient.sent.clear();
+
+  size_t legacyStack = benchStackBytes([] { legacyRelayMessage(kRelayWeatherRequest); });
+  size_t singleStack = benchStackBytes(relayWeatherMessage);
+  wsClient.sent.clear();
+  printf("  -> relay /weather: %.0f ns, %.1f allocs, %zu B stack (in place) vs %.0f ns, %.1f allocs, %zu B stack\n",
+         single.cpuNsPerOp, single.allocsPerOp, singleStack, legacy.cpuNsPerOp, legacy.allocsPerOp, legacyStack);
+  TEST_ASSERT_LESS_THAN(legacy.cpuNsPerOp, single.cpuNsPerOp);
+  TEST_ASSERT_LESS_THAN(legacyStack - 2048, singleStack);
+  // What is left is the host ArduinoJson stand-in and the fake socket's copy
+  TEST_ASSERT_LESS_THAN(legacy.allocsPerOp, single.allocsPerOp);
+}
+
+static const char kRelayDashboardBatch[] =
+    "{\"type\":\"batch\",\"device_id\":\"D\",\"requests\":["
+    "{\"id\":\"h\",\"method\":\"GET\",\"path\":\"/health\"},"
+    "{\"id\":\"w\",\"method\":\"GET\",\"path\":\"/weather\"},"
+    "{\"id\":\"d\",\"method\":\"GET\",\"path\":\"/device-info\"}]}";
+
+// `data` of the response for `id` in a batch frame, as JSON text; "" if absent
+static std::string batchData(JsonDocument& frame, const char* id, int& status) {
+  for (JsonObject response : frame["responses"].as<JsonArray>()) {
+    if (strcmp(response["id"] | "", id) == 0) {
+      std::string data;
+      serializeJson(response["data"], data);
+      status = response["status"];
+      return data;
+    }
+  }
+  return "";
+}
+
+static void test_relay_batch() {
+  wsClient.sent.clear();
+  wsClient.fakeEvent(WStype_TEXT, kRelayDashboardBatch);
+  TEST_ASSERT_EQUAL(1, wsClient.sent.size());
+  StaticJsonDocument<2048> frame;
+  TEST_ASSERT_FALSE(deserializeJson(frame, wsClient.sent[0].payload.c_str()));
+  TEST_ASSERT_EQUAL_STRING("batch", frame["type"]);
+  TEST_ASSERT_EQUAL(3, frame["responses"].size());
+
+  // Each as the same request on its own would get it
+  static const char* const kIds[] = {"h", "w", "d"};
+  static const char* const kPaths[] = {"/health", "/weather", "/device-info"};
+  for (int i = 0; i < 3; i++) {
+    int status = 0, batchStatus = 0;
+    std::string single = relayReply("GET", kPaths[i], JsonVariant(), status);
+    StaticJsonDocument<1024> singleDoc;
+    deserializeJson(singleDoc, single.c_str());
+    single.clear();
+    serializeJson(singleDoc, single);  // Numbers as the batch frame's parse prints them
+    TEST_ASSERT_EQUAL_STRING(single.c_str(), batchData(frame, kIds[i], batchStatus).c_str());
+    TEST_ASSERT_EQUAL(status, batchStatus);
+  }
+  TEST_ASSERT_EQUAL_STRING("response", frame["responses"][0]["type"]);
+
+  // A batch whose replies outgrow a frame comes back in several, each whole
+  wsClient.sent.clear();
+  std::string big = "{\"type\":\"batch\",\"requests\":[";
+  for (int i = 0; i < 8; i++) {
+    big += std::string(i ? "," : "") + "{\"id\":\"t" + std::to_string(i) + "\",\"method\":\"GET\",\"path\":\"/tasks\"}";
+  }
+  big += "]}";
+  wsClient.fakeEvent(WStype_TEXT, big);
+  TEST_ASSERT_GREATER_THAN(1, wsClient.sent.size());
+  size_t answered = 0;
+  for (const FakeWsFrame& sent : wsClient.sent) {
+    TEST_ASSERT_FALSE(deserializeJson(frame, sent.payload.c_str()));
+    TEST_ASSERT_LESS_OR_EQUAL(RELAY_FRAME_MAX, sent.payload.size());
+    for (JsonObject response : frame["responses"].as<JsonArray>()) {
+      TEST_ASSERT_EQUAL(200, response["status"].as<int>());
+      TEST_ASSERT_EQUAL_STRING(("t" + std::to_string(answered++)).c_str(), response["id"]);
+    }
+  }
+  TEST_ASSERT_EQUAL(8, answered);
+
+  // Unknown paths are answered in place; an empty batch gets nothing
+  wsClient.sent.clear();
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"batch\",\"requests\":[{\"id\":\"x\",\"path\":\"/nope\"}]}");
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"batch\",\"requests\":[]}");
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"batch\"}");
+  TEST_ASSERT_EQUAL(1, wsClient.sent.size());
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"type\":\"batch\",\"responses\":[{\"id\":\"x\",\"type\":\"response\","
+      "\"data\":{\"success\":false,\"error\":\"Not found\"},\"status\":404}]}",
+      wsClient.sent[0].payload.c_str());
+  wsClient.sent.clear();
+}
+
+// Every request id gets an answer, whatever the device could not take
+static void test_relay_answers_every_id() {
+  // More requests than the message document holds: each id gets a 413
+  wsClient.sent.clear();
+  std::string many = "{\"type\":\"batch\",\"requests\":[";
+  for (int i = 0; i < 60; i++) {
+    many += std::string(i ? "," : "") + "{\"id\":\"m" + std::to_string(i) + "\",\"method\":\"GET\",\"path\":\"/health\"}";
+  }
+  many += "]}";
+  wsClient.fakeEvent(WStype_TEXT, many);
+  StaticJsonDocument<4096> frame;
+  size_t answered = 0;
+  for (const FakeWsFrame& sent : wsClient.sent) {
+    TEST_ASSERT_FALSE(deserializeJson(frame, sent.payload.c_str()));
+    TEST_ASSERT_LESS_OR_EQUAL(RELAY_FRAME_MAX, sent.payload.size());
+    for (JsonObject response : frame["responses"].as<JsonArray>()) {
+      TEST_ASSERT_EQUAL(413, response["status"].as<int>());
+      TEST_ASSERT_TRUE(response["data"].isNull());
+      TEST_ASSERT_EQUAL_STRING(("m" + std::to_string(answered++)).c_str(), response["id"]);
+    }
+  }
+  TEST_ASSERT_EQUAL(60, answered);
+
+  // A body too big to parse
+  wsClient.sent.clear();
+  std::string big = "{\"type\":\"request\",\"id\":\"b\",\"method\":\"POST\",\"path\":\"/location\",\"body\":{";
+  for (int i = 0; i < 300; i++) {
+    big += std::string(i ? "," : "") + "\"k" + std::to_string(i) + "\":" + std::to_string(i);
+  }
+  big += "}}";
+  wsClient.fakeEvent(WStype_TEXT, big);
+  TEST_ASSERT_EQUAL(1, wsClient.sent.size());
+  TEST_ASSERT_EQUAL_STRING("{\"id\":\"b\",\"type\":\"response\",\"data\":null,\"status\":413}",
+                           wsClient.sent[0].payload.c_str());
+
+  // A reply with no room behind the one before it goes out in a frame of its own
+  wsClient.sent.clear();
+  std::string first(800, 'f'), second(1100, 's');
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"batch\",\"requests\":["
+                                  "{\"id\":\"" + first + "\",\"method\":\"GET\",\"path\":\"/health\"},"
+                                  "{\"id\":\"" + second + "\",\"method\":\"GET\",\"path\":\"/health\"}]}");
+  TEST_ASSERT_EQUAL(2, wsClient.sent.size());
+  for (int i = 0; i < 2; i++) {
+    TEST_ASSERT_FALSE(deserializeJson(frame, wsClient.sent[i].payload.c_str()));
+    TEST_ASSERT_EQUAL(1, frame["responses"].size());
+    TEST_ASSERT_EQUAL((i ? second : first).size(), strlen(frame["responses"][0]["id"]));
+    TEST_ASSERT_EQUAL(200, frame["responses"][0]["status"].as<int>());
+  }
+  wsClient.sent.clear();
+}
+
+// A dashboard refresh: three requests one at a time, or as one batch
+static void bench_relay_batch_vs_singles() {
+  static const char* const kRequests[] = {
+      "{\"type\":\"request\",\"id\":\"h\",\"method\":\"GET\",\"path\":\"/health\"}",
+      "{\"type\":\"request\",\"id\":\"w\",\"method\":\"GET\",\"path\":\"/weather\"}",
+      "{\"type\":\"request\",\"id\":\"d\",\"method\":\"GET\",\"path\":\"/device-info\"}",
+  };
+  static char payload[512];
+  wsClient.sent.clear();
+  BenchResult singles = runBench("relay dashboard: 3 requests", kRequestIters, [] {
+    for (const char* request : kRequests) {
+      size_t length = strlen(request);
+      memcpy(payload, request, length + 1);
+      handleWebSocketMessage(payload, length);
+    }
+  });
+  size_t singleFrames = wsClient.sent.size();
+  wsClient.sent.clear();
+  BenchResult batch = runBench("relay dashboard: 1 batch", kRequestIters, [] {
+    size_t length = sizeof(kRelayDashboardBatch) - 1;
+    memcpy(payload, kRelayDashboardBatch, length + 1);
+    handleWebSocketMessage(payload, length);
+  });
+  size_t batchFrames = wsClient.sent.size();
+  wsClient.sent.clear();
+  printf("  -> relay dashboard refresh: %.0f frame, %.0f ns (batch) vs %.0f frames, %.0f ns (one by one)\n",
+         batchFrames / (kRequestIters + 1.0), batch.cpuNsPerOp, singleFrames / (kRequestIters + 1.0),
+         singles.cpuNsPerOp);
+  // One WAN round trip instead of three
+  TEST_ASSERT_EQUAL(3 * batchFrames, singleFrames);
+}
+
+// ============================================================================
+// Weather interpretation, LEDs, buzzer
+// ============================================================================
+
+// Pre-forecast fetch path, kept as the baseline: one instant per request,
+// whole body copied into a String, then parsed into a 1 KB document.
+static bool legacyParseWeather(HTTPClient& http, int& code, int& temperature) {
+  String payload = http.getString();
+  StaticJsonDocument<1024> doc;
+  if (deserializeJson(doc, payload)) return false;
+
+  code = -1;
+  temperature = -999;
+  for (JsonObject dataObject : doc["data"].as<JsonArray>()) {
+    const char* parameter = dataObject["parameter"];
+    if (strcmp(parameter, "t_2m:C") == 0) temperature = dataObject["coordinates"][0]["dates"][0]["value"];
+    if (strcmp(parameter, "weather_symbol_1h:idx") == 0) code = dataObject["coordinates"][0]["dates"][0]["value"];
+  }
+  return true;
+}
+
+static uint32_t nowHour() { return time(nullptr) / 3600; }
+
+// Request as the firmware would issue it, for calling the fetch path directly
+static WeatherFetchRequest testFetchRequest() {
+  return WeatherFetchRequest{weatherFetchGeneration, latitude, longitude, millis() + WEATHER_FETCH_DEADLINE_MS};
+}
+
+static double elapsedUs(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Keep looping (1 ms of real time apart) until the fetch task has answered and
+// loop() has published the result.
+static void waitForWeatherFetch() {
+  auto start = std::chrono::steady_clock::now();
+  while (weatherFetchPending.id != 0 && elapsedUs(start) < 10e6) {
+    loop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  TEST_ASSERT_EQUAL(0, weatherFetchPending.id);
+}
+
+static void serveForecastFixture() {
+  fake::http().responder = [](const std::string&) {
+    return fake::HttpResponse{200, meteomaticsForecastResponse(nowHour())};
+  };
+}
+
+static void test_parse_forecast_stream() {
+  std::string body = meteomaticsForecastResponse(1000);
+  FakeBodyStream stream;
+  stream.load(body);
+  ForecastStore forecast;
+  TEST_ASSERT_TRUE(parseForecastStream(stream, 1000, forecast));
+  TEST_ASSERT_EQUAL(FORECAST_HOURS, forecast.size());
+
+  WeatherSample sample;
+  TEST_ASSERT_TRUE(forecast.sample(1000, sample));
+  TEST_ASSERT_EQUAL(4, sample.symbol);
+  TEST_ASSERT_EQUAL(740, sample.tempCenti);
+  TEST_ASSERT_EQUAL(7, sample.temperature);
+  TEST_ASSERT_TRUE(forecast.sample(1000 + 11, sample));
+  TEST_ASSERT_EQUAL(3, sample.symbol);
+  TEST_ASSERT_EQUAL(1015, sample.tempCenti);
+  TEST_ASSERT_EQUAL(10, sample.precipCenti);
+  TEST_ASSERT_FALSE(forecast.sample(1000 + FORECAST_HOURS, sample));
+}
+
+// Hour 1000 since the epoch is 1970-02-11T16:00:00Z
+static std::string prettyForecastEntry(const char *date, int value) {
+  char entry[96];
+  snprintf(entry, sizeof(entry), "\n      {\n        \"date\" : \"%s\",\n        \"value\" : %d\n      }", date, value);
+  return entry;
+}
+
+// One pretty-printed series of a Meteomatics answer
+static std::string prettyForecastSeries(const char *parameter, const std::string &dates) {
+  return std::string("\n    {\n      \"parameter\" : \"") + parameter + "\",\n" +
+         "      \"coordinates\" : [ { \"lat\" : 48.9, \"lon\" : 2.4, \"dates\" : [" + dates + "\n      ] } ]\n    }";
+}
+
+static std::string prettyForecastBody(const std::string &series) {
+  return "{\n  \"data\" : [" + series + "\n  ]\n}\n";
+}
+
+static void test_parse_forecast_stream_by_date() {
+  std::string hour16 = prettyForecastEntry("1970-02-11T16:00:00Z", 2);
+  std::string hour17 = prettyForecastEntry("1970-02-11T17:00:00Z", 3);
+  std::string hour18 = prettyForecastEntry("1970-02-11T18:00:00Z", 1);
+  auto body = [](const std::string &dates) {  // Every parameter on the same dates
+    return prettyForecastBody(prettyForecastSeries("t_2m:C", dates) + "," +
+                              prettyForecastSeries("weather_symbol_1h:idx", dates) + "," +
+                              prettyForecastSeries("precip_1h:mm", dates));
+  };
+  ForecastStore forecast;
+  WeatherSample sample;
+  FakeBodyStream stream;
+
+  // Spaced out and out of order: each value lands on its own hour
+  stream.load(body(hour18 + "," + hour16 + " ,\n" + hour17));
+  TEST_ASSERT_TRUE(parseForecastStream(stream, 1000, forecast));
+  TEST_ASSERT_EQUAL(3, forecast.size());
+  TEST_ASSERT_TRUE(forecast.sample(1000, sample));
+  TEST_ASSERT_EQUAL(2, sample.symbol);
+  TEST_ASSERT_TRUE(forecast.sample(1001, sample));
+  TEST_ASSERT_EQUAL(3, sample.symbol);
+  TEST_ASSERT_TRUE(forecast.sample(1002, sample));
+  TEST_ASSERT_EQUAL(1, sample.symbol);
+
+  // A gap, or a date the request did not ask for, rejects the body
+  stream.load(body(hour16 + "," + hour18));
+  TEST_ASSERT_FALSE(parseForecastStream(stream, 1000, forecast));
+  stream.load(body(hour16 + "," + hour17));
+  TEST_ASSERT_FALSE(parseForecastStream(stream, 1001, forecast));
+}
+
+// Series that stop at different hours, or a parameter left out, would leave
+// zeros behind the short series: the body is rejected
+static void test_parse_forecast_stream_unequal_series() {
+  std::string hour16 = prettyForecastEntry("1970-02-11T16:00:00Z", 2);
+  std::string hour17 = prettyForecastEntry("1970-02-11T17:00:00Z", 3);
+  std::string both = hour16 + "," + hour17;
+  ForecastStore forecast;
+  FakeBodyStream stream;
+
+  stream.load(prettyForecastBody(prettyForecastSeries("t_2m:C", both) + "," +
+                                 prettyForecastSeries("weather_symbol_1h:idx", hour16) + "," +
+                                 prettyForecastSeries("precip_1h:mm", both)));
+  TEST_ASSERT_FALSE(parseForecastStream(stream, 1000, forecast));
+
+  stream.load(prettyForecastBody(prettyForecastSeries("t_2m:C", hour16) + "," +
+                                 prettyForecastSeries("weather_symbol_1h:idx", both) + "," +
+                                 prettyForecastSeries("precip_1h:mm", both)));
+  TEST_ASSERT_FALSE(parseForecastStream(stream, 1000, forecast));
+
+  stream.load(prettyForecastBody(prettyForecastSeries("t_2m:C", both) + "," +
+                                 prettyForecastSeries("weather_symbol_1h:idx", both)));
+  TEST_ASSERT_FALSE(parseForecastStream(stream, 1000, forecast));
+
+  // The fixture's full answer, cut short in its last series
+  std::string full = meteomaticsForecastResponse(1000);
+  std::string shortBody = meteomaticsForecastResponse(1000, FORECAST_HOURS / 2);
+  size_t lastSeries = shortBody.find("{\"parameter\":\"precip_1h:mm\"");
+  size_t fullLast = full.find("{\"parameter\":\"precip_1h:mm\"");
+  stream.load(full.substr(0, fullLast) + shortBody.substr(lastSeries));
+  TEST_ASSERT_FALSE(parseForecastStream(stream, 1000, forecast));
+}
+
+static void bench_weather_parse_legacy_vs_forecast() {
+  fake::http().responder = [](const std::string&) {
+    return fake::HttpResponse{200, kMeteomaticsNowResponse};
+  };
+  int code = 0, temperature = 0;
+  BenchResult legacy = runBench("weather parse: 1 h, getString + 1KB doc", kRequestIters, [&] {
+    HTTPClient http;
+    http.begin("https://api.meteomatics.com/");
+    TEST_ASSERT_EQUAL(200, http.GET());
+    TEST_ASSERT_TRUE(legacyParseWeather(http, code, temperature));
+    http.end();
+  });
+  TEST_ASSERT_EQUAL(4, code);
+  TEST_ASSERT_EQUAL(7, temperature);
+
+  serveForecastFixture();
+  ForecastStore forecast;
+  BenchResult stream = runBench("weather parse: 48 h x 3, streamed", kRequestIters / 10, [&] {
+    HTTPClient http;
+    http.begin("https://api.meteomatics.com/");
+    TEST_ASSERT_EQUAL(200, http.GET());
+    TEST_ASSERT_TRUE(parseForecastStream(http.getStream(), nowHour(), forecast));
+    http.end();
+  });
+  TEST_ASSERT_EQUAL(FORECAST_HOURS, forecast.size());
+
+  printf("  -> peak heap: %zu B for 1 h (getString) vs %zu B for %d h (stream); store is %zu B\n",
+         legacy.peakHeapBytes, stream.peakHeapBytes, FORECAST_HOURS, sizeof(ForecastStore));
+  printf("  -> parse time per forecast hour: %.0f ns vs %.0f ns\n", legacy.cpuNsPerOp,
+         stream.cpuNsPerOp / FORECAST_HOURS);
+}
+
+static void bench_get_weather_forecast() {
+  serveForecastFixture();
+  ForecastStore forecast;
+  runBench("getWeatherForecast 48 h (fake HTTPS)", kRequestIters / 10, [&] {
+    TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  });
+  TEST_ASSERT_EQUAL(nowHour(), forecast.startHour());
+  TEST_ASSERT_EQUAL(FORECAST_HOURS, forecast.size());
+  TEST_ASSERT_NOT_NULL(strstr(fake::http().lastUrl.c_str(), "--"));
+  TEST_ASSERT_NOT_NULL(strstr(fake::http().lastUrl.c_str(), FORECAST_PARAMETERS));
+}
+
+static void test_weather_request_builder() {
+  WeatherRequestBuilder builder;
+  TEST_ASSERT_EQUAL_STRING(
+      "/1970-02-11T16:00:00Z--1970-02-13T15:00:00Z:PT1H/" FORECAST_PARAMETERS "/48.500000,-2.250000/json?model=mix",
+      builder.path(1000, 48.5f, -2.25f));
+
+  const char* auth = builder.authorization("user", "pass");
+  TEST_ASSERT_EQUAL_STRING("Basic dXNlcjpwYXNz", auth);
+  TEST_ASSERT_EQUAL_PTR(auth, builder.authorization("user", "pass"));
+  TEST_ASSERT_EQUAL_STRING("Basic dXNlcjpwYXNzMQ==", builder.authorization("user", "pass1"));
+
+  // What actually goes on the wire
+  serveForecastFixture();
+  ForecastStore forecast;
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  TEST_ASSERT_EQUAL_STRING(builder.authorization(apiUser.c_str(), apiPass.c_str()),
+                           fake::http().lastAuthorization.c_str());
+  TEST_ASSERT_EQUAL_STRING("api.meteomatics.com", fake::headerValue(fake::http().lastRequest, "Host").c_str());
+}
+
+// The answer comes in after write() has returned, not with it: the status line
+// and headers are waited for up to the read timeout instead of being taken for
+// a dropped connection
+static void test_response_head_waits_for_late_bytes() {
+  serveForecastFixture();
+  ForecastStore forecast;
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));  // Connection open
+  int handshakes = fake::tls().handshakes;
+
+  fake::delivery() = fake::Delivery{1 << 20, 40};  // All of it, 40 ms late
+  uint64_t before = fake::clock().nowUs;
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  TEST_ASSERT_EQUAL(FORECAST_HOURS, forecast.size());
+  TEST_ASSERT_TRUE(meteomaticsApi.statistics().lastReused);
+  TEST_ASSERT_EQUAL(handshakes, fake::tls().handshakes);
+  TEST_ASSERT_TRUE(fake::clock().nowUs - before >= 40000);
+
+  // Later than the read timeout: given up on, on the reused and the new connection
+  fake::delivery().gapMs = WEATHER_READ_TIMEOUT_MS + 1000;
+  before = fake::clock().nowUs;
+  TEST_ASSERT_FALSE(getWeatherForecast(testFetchRequest(), forecast));
+  TEST_ASSERT_TRUE(fake::clock().nowUs - before >= 2 * WEATHER_READ_TIMEOUT_MS * 1000ULL);
+  TEST_ASSERT_EQUAL(handshakes + 1, fake::tls().handshakes);
+  fake::delivery() = fake::Delivery{};
+  meteomaticsApi.close();
+}
+
+// The request path (URL, Authorization, request head, response headers) must
+// not touch the heap: a whole fetch allocates no more than parsing the same
+// body from memory.
+static void bench_weather_request_allocations() {
+  WeatherRequestBuilder builder;
+  uint32_t hour = nowHour();
+  BenchResult build = runBench("weather request build (path + auth)", kRequestIters, [&] {
+    TEST_ASSERT_NOT_NULL(builder.path(hour, latitude, longitude));
+    TEST_ASSERT_NOT_NULL(builder.authorization(apiUser.c_str(), apiPass.c_str()));
+  });
+  TEST_ASSERT_EQUAL_FLOAT(0, build.allocsPerOp);
+
+  serveForecastFixture();
+  fake::http().chunked = true;
+  ForecastStore forecast;
+  std::string body = meteomaticsForecastResponse(hour);
+  FakeBodyStream stream;
+  BenchResult parse = runBench("parseForecastStream from memory", kRequestIters / 10, [&] {
+    stream.load(body);
+    TEST_ASSERT_TRUE(parseForecastStream(stream, hour, forecast));
+  });
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));  // Connection open, DNS cached
+  BenchResult fetch = runBench("getWeatherForecast, reused connection", kRequestIters / 10, [&] {
+    TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  });
+  fake::http().chunked = false;
+
+  printf("  -> allocations per fetch: %.0f, of which %.0f in the JSON parser\n", fetch.allocsPerOp,
+         parse.allocsPerOp);
+  TEST_ASSERT_EQUAL_FLOAT(parse.allocsPerOp, fetch.allocsPerOp);
+}
+
+// ============================================================================
+// Meteomatics connection
+// ============================================================================
+
+// Off a socket the body comes in pieces with gaps between them, as TLS
+// records do; a gap is waited out, not taken for the end of the body
+static void test_http_body_stream_dechunks() {
+  std::string body = meteomaticsForecastResponse(1000, 4);
+  WiFiClient wire;
+  wire.connect("api.meteomatics.com", 443);
+  fake::delivery() = fake::Delivery{64, 3};
+  wire.fakeReceive(fake::chunkEncode(body, 7) + "HTTP/1.1 200 OK");
+  HttpBodyStream stream;
+  stream.begin(wire, true, -1, WEATHER_READ_TIMEOUT_MS);
+
+  std::string out;
+  int c;
+  while ((c = stream.read()) >= 0) out += (char)c;
+  fake::delivery() = fake::Delivery{};
+  TEST_ASSERT_TRUE(out == body);
+  TEST_ASSERT_TRUE(stream.drain());
+  TEST_ASSERT_EQUAL('H', wire.read());  // next response left untouched
+}
+
+static void test_http_body_stream_ends_without_waiting() {
+  std::string body = meteomaticsForecastResponse(1000, 4);
+  FakeBodyStream wire;
+  wire.load(body);
+  HttpBodyStream stream;
+  stream.begin(wire, false, body.size());
+
+  uint64_t before = fake::clock().nowUs;
+  ForecastStore forecast;
+  TEST_ASSERT_TRUE(parseForecastStream(stream, 1000, forecast));
+  TEST_ASSERT_EQUAL(4, forecast.size());
+  TEST_ASSERT_TRUE(fake::clock().nowUs == before);  // no read timeout at the end
+}
+
+static void test_connection_reuse_and_dns_cache() {
+  serveForecastFixture();
+  fake::http().chunked = true;
+  fake::delivery() = fake::Delivery{512, 2};  // Answers arrive after write(), in pieces
+  meteomaticsApi.close();
+  int handshakes = fake::tls().handshakes;
+  int lookups = WiFi.dnsLookups;
+  ForecastStore forecast;
+
+  // Close together: one handshake, then the same connection
+  fake::clock().advanceMs(API_DNS_CACHE_MS);
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  fake::clock().advanceMs(WEATHER_REFRESH_RETRY_MS);
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  TEST_ASSERT_EQUAL(FORECAST_HOURS, forecast.size());
+  TEST_ASSERT_EQUAL(handshakes + 1, fake::tls().handshakes);
+  TEST_ASSERT_EQUAL(lookups + 1, WiFi.dnsLookups);
+  TEST_ASSERT_TRUE(meteomaticsApi.statistics().lastReused);
+  TEST_ASSERT_EQUAL_STRING("api.meteomatics.com", fake::tls().lastSni.c_str());
+
+  // Idle past the keep-alive: new handshake, cached address
+  fake::clock().advanceMs(API_KEEPALIVE_MS);
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  TEST_ASSERT_EQUAL(handshakes + 2, fake::tls().handshakes);
+  TEST_ASSERT_EQUAL(lookups + 1, WiFi.dnsLookups);
+  TEST_ASSERT_FALSE(meteomaticsApi.statistics().lastReused);
+
+  // Server closes after each response: reconnects without failing the fetch
+  fake::http().keepAlive = false;
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  TEST_ASSERT_EQUAL(handshakes + 3, fake::tls().handshakes);
+  fake::http().keepAlive = true;
+
+  // Address expired: looked up again
+  fake::clock().advanceMs(API_DNS_CACHE_MS);
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  TEST_ASSERT_EQUAL(lookups + 2, WiFi.dnsLookups);
+  fake::delivery() = fake::Delivery{};
+  fake::http().chunked = false;
+}
+
+// Wall time per fetch with a 50 ms handshake, fresh connection vs reused
+static void bench_fetch_fresh_vs_reused_connection() {
+  serveForecastFixture();
+  fake::http().chunked = true;
+  fake::tls().handshakeMs = 50;
+  fake::delivery() = fake::Delivery{512, 2};
+  ForecastStore forecast;
+  const int kFetches = 10;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kFetches; i++) {
+    meteomaticsApi.close();
+    TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  }
+  double freshUs = elapsedUs(start) / kFetches;
+  ApiConnectionStats fresh = meteomaticsApi.statistics();
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kFetches; i++) {
+    TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  }
+  double reusedUs = elapsedUs(start) / kFetches;
+  ApiConnectionStats reused = meteomaticsApi.statistics();
+  fake::tls().handshakeMs = 0;
+  fake::delivery() = fake::Delivery{};
+  fake::http().chunked = false;
+
+  printf("  -> fetch wall time: %.0f us fresh vs %.0f us reused; %u B out, %u B in per fetch\n", freshUs, reusedUs,
+         reused.lastBytesOut, reused.lastBytesIn);
+  TEST_ASSERT_EQUAL(fresh.handshakes, reused.handshakes);
+  TEST_ASSERT_LESS_THAN(freshUs, reusedUs);
+}
+
+// ============================================================================
+// Weather cache
+// ============================================================================
+
+// A tap on the pad, then the loop() pass that takes it
+static void touch() {
+  fake::drivePin(CAP_SENSOR_PIN, HIGH);
+  fake::clock().advanceMs(80);
+  fake::drivePin(CAP_SENSOR_PIN, LOW);
+  loop();
+}
+
+static void test_touch_renders_cache_before_revalidating() {
+  static uint32_t showsAtFetch;
+  fake::http().responder = [](const std::string&) {
+    showsAtFetch = fake::rmt().writes;
+    return fake::HttpResponse{200, meteomaticsForecastResponse(nowHour())};
+  };
+  weatherCache.clear();
+  animationActive = false;
+  fake::clock().advanceMs(WEATHER_CACHE_TTL_MS);  // past the retry backoff
+
+  // Cold cache: the touch has to wait for the first fetch
+  int requests = fake::http().requests;
+  touch();
+  waitForWeatherFetch();
+  TEST_ASSERT_EQUAL(requests + 1, fake::http().requests);
+  TEST_ASSERT_TRUE(animationActive);
+  TEST_ASSERT_EQUAL(7, currentTemperature);
+
+  // Fresh cache: no fetch at all, not even once the retry wait is over for
+  // the MISS the touch saw while the fetch was in flight
+  fake::clock().advanceMs(WEATHER_REFRESH_RETRY_MS);
+  loop();  // animation times out
+  touch();
+  waitForWeatherFetch();
+  TEST_ASSERT_EQUAL(requests + 1, fake::http().requests);
+  TEST_ASSERT_TRUE(animationActive);
+
+  // Stale cache: first frame goes out, then the refresh runs
+  fake::clock().advanceMs(WEATHER_CACHE_TTL_MS + 1);
+  loop();
+  uint32_t showsBeforeTouch = fake::rmt().writes;
+  touch();
+  waitForWeatherFetch();
+  TEST_ASSERT_EQUAL(requests + 2, fake::http().requests);
+  TEST_ASSERT_GREATER_THAN(showsBeforeTouch, showsAtFetch);
+}
+
+static void test_stale_forecast_survives_outage() {
+  serveForecastFixture();
+  weatherCache.clear();
+  fake::clock().advanceMs(WEATHER_CACHE_TTL_MS);
+  TEST_ASSERT_FALSE(serveCachedWeather());
+  loop();  // cold cache: loop() hands the refresh to the fetch task
+  waitForWeatherFetch();
+  TEST_ASSERT_NOT_NULL(weatherCache.forecast(latitude, longitude));
+
+  // API down past the TTL: the stored series keeps answering
+  fake::http().responder = [](const std::string&) { return fake::HttpResponse{500, ""}; };
+  fake::clock().advanceMs(WEATHER_CACHE_TTL_MS + 1);
+  TEST_ASSERT_TRUE(serveCachedWeather());
+  loop();
+  waitForWeatherFetch();
+  TEST_ASSERT_TRUE(serveCachedWeather());
+  TEST_ASSERT_EQUAL(7, lastTemperature);
+  TEST_ASSERT_EQUAL(4, weatherSymbol);
+}
+
+static void test_location_change_cancels_fetch() {
+  serveForecastFixture();
+  fake::http().latencyMs = 100;
+  weatherCache.clear();
+  fake::clock().advanceMs(WEATHER_REFRESH_RETRY_MS);
+  float oldLatitude = latitude;
+
+  serveCachedWeather();
+  loop();
+  uint32_t first = weatherFetchPending.id;
+  TEST_ASSERT_NOT_EQUAL(0, first);
+
+  latitude += 1.0f;
+  serveCachedWeather();
+  fake::clock().advanceMs(WEATHER_REFRESH_RETRY_MS);
+  loop();
+  TEST_ASSERT_NOT_EQUAL(first, weatherFetchPending.id);
+  waitForWeatherFetch();
+
+  TEST_ASSERT_NULL(weatherCache.forecast(oldLatitude, longitude));
+  TEST_ASSERT_NOT_NULL(weatherCache.forecast(latitude, longitude));
+  latitude = oldLatitude;
+  fake::http().latencyMs = 0;
+}
+
+// A fresh-weather request waits for the refresh without holding up its
+// batch, and comes back on its own once the fetch is in
+static void test_relay_parks_fresh_weather() {
+  serveForecastFixture();
+  fake::http().latencyMs = 100;
+  weatherCache.clear();
+  fake::clock().advanceMs(WEATHER_REFRESH_RETRY_MS);
+  wsClient.sent.clear();
+
+  wsClient.fakeEvent(WStype_TEXT,
+                     "{\"type\":\"batch\",\"requests\":["
+                     "{\"id\":\"slow\",\"method\":\"GET\",\"path\":\"/weather\",\"fresh\":true},"
+                     "{\"id\":\"h\",\"method\":\"GET\",\"path\":\"/health\"}]}");
+  TEST_ASSERT_EQUAL(1, wsClient.sent.size());
+  StaticJsonDocument<1024> frame;
+  deserializeJson(frame, wsClient.sent[0].payload.c_str());
+  TEST_ASSERT_EQUAL(1, frame["responses"].size());
+  TEST_ASSERT_EQUAL_STRING("h", frame["responses"][0]["id"]);
+
+  // Requests behind it are answered while it waits
+  wsClient.fakeEvent(WStype_TEXT, kRelayWeatherRequest);
+  TEST_ASSERT_EQUAL(2, wsClient.sent.size());
+
+  loop();
+  waitForWeatherFetch();
+  fake::clock().advanceMs(NETWORK_POLL_MS);
+  loop();
+  TEST_ASSERT_EQUAL(3, wsClient.sent.size());
+  deserializeJson(frame, wsClient.sent[2].payload.c_str());
+  TEST_ASSERT_EQUAL_STRING("slow", frame["id"]);
+  TEST_ASSERT_EQUAL(200, frame["status"].as<int>());
+  TEST_ASSERT_EQUAL(7, frame["data"]["temperature"].as<int>());
+  fake::clock().advanceMs(NETWORK_POLL_MS);
+  loop();
+  TEST_ASSERT_EQUAL(3, wsClient.sent.size());  // Answered once
+
+  // Fresh already: no wait
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"request\",\"id\":\"now\",\"method\":\"GET\",\"path\":\"/weather\",\"fresh\":true}");
+  TEST_ASSERT_EQUAL(4, wsClient.sent.size());
+
+  // A refresh that fails: answered from the stale cache once it has
+  fake::http().responder = [](const std::string&) { return fake::HttpResponse{500, ""}; };
+  fake::clock().advanceMs(WEATHER_CACHE_TTL_MS + 1);
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"request\",\"id\":\"late\",\"method\":\"GET\",\"path\":\"/weather\",\"fresh\":true}");
+  TEST_ASSERT_EQUAL(4, wsClient.sent.size());
+  loop();
+  waitForWeatherFetch();
+  fake::clock().advanceMs(NETWORK_POLL_MS);
+  loop();
+  TEST_ASSERT_EQUAL(5, wsClient.sent.size());
+  deserializeJson(frame, wsClient.sent[4].payload.c_str());
+  TEST_ASSERT_EQUAL_STRING("late", frame["id"]);
+  TEST_ASSERT_EQUAL(7, frame["data"]["temperature"].as<int>());
+  wsClient.sent.clear();
+  fake::http().latencyMs = 0;
+}
+
+static void test_weather_events() {
+  WeatherEvents events;
+  WeatherState state = {CONDITION_CLOUDY, 7, 0.1f, 4, 48.9075f, 2.3833f};
+  StaticJsonWriter<256> json;
+
+  // Everything first
+  TEST_ASSERT_TRUE(events.write(state, json));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"type\":\"event\",\"event\":\"weather\",\"version\":1,\"complete\":true,\"data\":{\"condition\":\"cloudy\","
+      "\"temperature\":7,\"precipitation\":0.10,\"symbol\":4,\"location\":{\"latitude\":48.9075,\"longitude\":2.3833}}}",
+      json.c_str());
+
+  // Nothing new, nothing to send
+  StaticJsonWriter<256> idle;
+  TEST_ASSERT_FALSE(events.write(state, idle));
+  TEST_ASSERT_EQUAL(0, idle.bufferedLength());
+
+  // Then only what changed
+  state.temperature = 8;
+  StaticJsonWriter<256> warmer;
+  TEST_ASSERT_TRUE(events.write(state, warmer));
+  TEST_ASSERT_EQUAL_STRING("{\"type\":\"event\",\"event\":\"weather\",\"version\":2,\"data\":{\"temperature\":8}}",
+                           warmer.c_str());
+  state.condition = CONDITION_RAIN;
+  state.symbol = 105;
+  state.longitude = 2.4f;
+  StaticJsonWriter<256> rain;
+  TEST_ASSERT_TRUE(events.write(state, rain));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"type\":\"event\",\"event\":\"weather\",\"version\":3,\"data\":{\"condition\":\"rain\",\"symbol\":105,"
+      "\"location\":{\"latitude\":48.9075,\"longitude\":2.4000}}}",
+      rain.c_str());
+
+  // An event that does not fit is not sent; the next one is complete
+  state.temperature = 9;
+  StaticJsonWriter<32> small;
+  TEST_ASSERT_FALSE(events.write(state, small));
+  TEST_ASSERT_EQUAL(3, events.version());
+  StaticJsonWriter<256> retry;
+  TEST_ASSERT_TRUE(events.write(state, retry));
+  TEST_ASSERT_NOT_NULL(strstr(retry.c_str(), "\"version\":4,\"complete\":true"));
+
+  // A new connection starts over
+  events.restart();
+  StaticJsonWriter<256> again;
+  TEST_ASSERT_TRUE(events.write(state, again));
+  TEST_ASSERT_NOT_NULL(strstr(again.c_str(), "\"version\":1,\"complete\":true"));
+}
+
+// Connected to the relay, the device pushes weather changes as they happen,
+// as long as someone subscribed
+static void test_relay_pushes_weather_events() {
+  wsClient.sent.clear();
+  wsClient.fakeEvent(WStype_CONNECTED);
+  fake::clock().advanceMs(WEATHER_CHECK_MS);
+  loop();
+  TEST_ASSERT_EQUAL(1, wsClient.sent.size());  // Registration only: nobody is watching
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"subscribers\",\"count\":1}");
+  loop();
+  TEST_ASSERT_EQUAL(2, wsClient.sent.size());  // Then the state
+  StaticJsonDocument<512> event;
+  deserializeJson(event, wsClient.sent[1].payload.c_str());
+  TEST_ASSERT_EQUAL_STRING("event", event["type"]);
+  TEST_ASSERT_EQUAL(1, event["version"].as<int>());
+  TEST_ASSERT_TRUE(event["complete"].as<bool>());
+  TEST_ASSERT_EQUAL(lastTemperature, event["data"]["temperature"].as<int>());
+
+  // Checks with nothing new send nothing
+  for (int i = 0; i < 10; i++) {
+    fake::clock().advanceMs(WEATHER_CHECK_MS);
+    loop();
+  }
+  TEST_ASSERT_EQUAL(2, wsClient.sent.size());
+
+  // A new location goes out on its own
+  float oldLatitude = latitude;
+  server.fakeRequest(HTTP_POST, "/location", "{\"latitude\":45.5,\"longitude\":2.3833}");
+  fake::clock().advanceMs(WEATHER_CHECK_MS);
+  loop();
+  TEST_ASSERT_EQUAL(3, wsClient.sent.size());
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"type\":\"event\",\"event\":\"weather\",\"version\":2,\"data\":{\"location\":{\"latitude\":45.5000,"
+      "\"longitude\":2.3833}}}",
+      wsClient.sent[2].payload.c_str());
+
+  // And back
+  server.fakeRequest(HTTP_POST, "/location", ("{\"latitude\":" + std::to_string(oldLatitude) + ",\"longitude\":2.3833}").c_str());
+  fake::clock().advanceMs(WEATHER_CHECK_MS);
+  loop();
+  TEST_ASSERT_EQUAL(4, wsClient.sent.size());
+  TEST_ASSERT_NOT_NULL(strstr(wsClient.sent[3].payload.c_str(), "\"version\":3"));
+
+  // The last subscriber gone: no events, and no refresh on nobody's behalf
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"subscribers\",\"count\":0}");
+  int requests = fake::http().requests;
+  weatherCache.setTtl(1);
+  latitude += 1.0f;
+  for (int i = 0; i < 5; i++) {
+    fake::clock().advanceMs(WEATHER_CHECK_MS);
+    loop();
+  }
+  TEST_ASSERT_EQUAL(4, wsClient.sent.size());
+  TEST_ASSERT_EQUAL(0, weatherFetchPending.id);
+  TEST_ASSERT_EQUAL(requests, fake::http().requests);
+  latitude = oldLatitude;
+  weatherCache.setTtl(WEATHER_CACHE_TTL_MS);
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"subscribers\",\"count\":1}");
+
+  // Nothing is pushed without a relay
+  wsClient.fakeEvent(WStype_DISCONNECTED);
+  latitude += 1.0f;
+  fake::clock().advanceMs(WEATHER_CHECK_MS);
+  loop();
+  TEST_ASSERT_EQUAL(4, wsClient.sent.size());
+  latitude = oldLatitude;
+  wsClient.sent.clear();
+}
+
+// A client keeping up with the weather by polling /weather through the
+// relay, against the device pushing changes. Over an hour with one change:
+// 360 polls at 10 s, or 3600 checks (one a WEATHER_CHECK_MS) and one event.
+static void bench_weather_push_vs_poll() {
+  wsClient.sent.clear();
+  wsClient.fakeEvent(WStype_CONNECTED);
+  pushWeatherEvent();
+  wsClient.sent.clear();
+
+  BenchResult poll = runBench("relay poll GET /weather", kRequestIters, relayWeatherMessage);
+  size_t pollBytes = wsClient.sent.back().payload.size() + sizeof(kRelayWeatherRequest) - 1;
+  wsClient.sent.clear();
+  BenchResult idle = runBench("weather push, nothing changed", kRequestIters, pushWeatherEvent);
+  TEST_ASSERT_EQUAL(0, wsClient.sent.size());
+  int temperature = lastTemperature;
+  BenchResult change = runBench("weather push, temperature changed", kRequestIters, [] {
+    lastTemperature++;
+    pushWeatherEvent();
+  });
+  size_t eventBytes = wsClient.sent.back().payload.size();
+  lastTemperature = temperature;
+  pushWeatherEvent();
+  wsClient.fakeEvent(WStype_DISCONNECTED);
+  wsClient.sent.clear();
+
+  printf("  -> an hour, one change: %zu B and %.0f us on the device polling every 10 s (per client), "
+         "%zu B and %.1f us pushed (all clients)\n",
+         360 * pollBytes, 360 * poll.cpuNsPerOp / 1000, eventBytes,
+         (change.cpuNsPerOp + 3600 * idle.cpuNsPerOp) / 1000);
+  TEST_ASSERT_LESS_THAN(pollBytes, eventBytes);
+  TEST_ASSERT_LESS_THAN(poll.cpuNsPerOp, change.cpuNsPerOp);
+}
+
+// A relay that takes MessagePack gets every device frame in it, binary.
+// Requests are read in either encoding.
+static void test_relay_msgpack() {
+  wsClient.sent.clear();
+  wsClient.fakeEvent(WStype_CONNECTED);
+  StaticJsonDocument<256> registration;
+  deserializeJson(registration, wsClient.sent[0].payload.c_str());
+  TEST_ASSERT_EQUAL_STRING("msgpack", registration["encodings"][0]);
+  TEST_ASSERT_EQUAL_STRING("json", registration["encodings"][1]);
+
+  // JSON until the relay says otherwise
+  wsClient.sent.clear();
+  relayWeatherMessage();
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"registered\",\"encoding\":\"msgpack\"}");
+  TEST_ASSERT_TRUE(relayMsgPack);
+  relayWeatherMessage();
+  TEST_ASSERT_EQUAL(2, wsClient.sent.size());
+  TEST_ASSERT_FALSE(wsClient.sent[0].binary);
+  TEST_ASSERT_TRUE(wsClient.sent[1].binary);
+  StaticJsonDocument<1024> json, msgpack;
+  deserializeJson(json, wsClient.sent[0].payload.c_str());
+  TEST_ASSERT_FALSE(deserializeMsgPack(msgpack, wsClient.sent[1].payload));
+  std::string a, b;
+  serializeJson(json, a);
+  serializeJson(msgpack, b);
+  TEST_ASSERT_EQUAL_STRING(a.c_str(), b.c_str());
+
+  // A MessagePack request, and the envelope byte for byte
+  std::string request;
+  deserializeJson(json, "{\"type\":\"request\",\"id\":\"x\",\"method\":\"GET\",\"path\":\"/nope\"}");
+  serializeMsgPack(json, request);
+  wsClient.fakeEvent(WStype_BIN, request);
+  TEST_ASSERT_EQUAL(3, wsClient.sent.size());
+  static const char kNotFound[] =
+      "\x84\xa2" "id" "\xa1" "x" "\xa4" "type" "\xa8" "response"
+      "\xa4" "data" "\x82\xa7" "success" "\xc2\xa5" "error" "\xa9" "Not found"
+      "\xa6" "status" "\xcd\x01\x94";
+  TEST_ASSERT_EQUAL(sizeof(kNotFound) - 1, wsClient.sent[2].payload.size());
+  TEST_ASSERT_EQUAL_MEMORY(kNotFound, wsClient.sent[2].payload.data(), sizeof(kNotFound) - 1);
+
+  // Batches, split over frames or not
+  wsClient.sent.clear();
+  wsClient.fakeEvent(WStype_TEXT, kRelayDashboardBatch);
+  TEST_ASSERT_EQUAL(1, wsClient.sent.size());
+  StaticJsonDocument<4096> frame;
+  TEST_ASSERT_FALSE(deserializeMsgPack(frame, wsClient.sent[0].payload));
+  TEST_ASSERT_EQUAL_STRING("batch", frame["type"]);
+  TEST_ASSERT_EQUAL(3, frame["responses"].size());
+  TEST_ASSERT_EQUAL(lastTemperature, frame["responses"][1]["data"]["temperature"].as<int>());
+  wsClient.sent.clear();
+  std::string big = "{\"type\":\"batch\",\"requests\":[";
+  for (int i = 0; i < 8; i++) {
+    big += std::string(i ? "," : "") + "{\"id\":\"t" + std::to_string(i) + "\",\"method\":\"GET\",\"path\":\"/tasks\"}";
+  }
+  big += "]}";
+  wsClient.fakeEvent(WStype_TEXT, big);
+  size_t answered = 0;
+  for (const FakeWsFrame& sent : wsClient.sent) {
+    TEST_ASSERT_TRUE(sent.binary);
+    TEST_ASSERT_FALSE(deserializeMsgPack(frame, sent.payload));
+    for (JsonObject response : frame["responses"].as<JsonArray>()) {
+      TEST_ASSERT_EQUAL(200, response["status"].as<int>());
+      TEST_ASSERT_EQUAL_STRING(("t" + std::to_string(answered++)).c_str(), response["id"]);
+    }
+  }
+  TEST_ASSERT_EQUAL(8, answered);
+
+  // Events
+  wsClient.sent.clear();
+  pushWeatherEvent();
+  TEST_ASSERT_EQUAL(1, wsClient.sent.size());
+  TEST_ASSERT_TRUE(wsClient.sent[0].binary);
+  TEST_ASSERT_FALSE(deserializeMsgPack(frame, wsClient.sent[0].payload));
+  TEST_ASSERT_EQUAL_STRING("event", frame["type"]);
+  TEST_ASSERT_TRUE(frame["complete"].as<bool>());
+  TEST_ASSERT_EQUAL(lastTemperature, frame["data"]["temperature"].as<int>());
+
+  // A new connection, or a relay that keeps to JSON, is JSON
+  wsClient.fakeEvent(WStype_DISCONNECTED);
+  TEST_ASSERT_FALSE(relayMsgPack);
+  wsClient.fakeEvent(WStype_CONNECTED);
+  TEST_ASSERT_FALSE(relayMsgPack);
+  wsClient.fakeEvent(WStype_TEXT, "{\"type\":\"registered\",\"encoding\":\"json\"}");
+  TEST_ASSERT_FALSE(relayMsgPack);
+  wsClient.fakeEvent(WStype_DISCONNECTED);
+  wsClient.sent.clear();
+}
+
+struct EncodingResult {
+  size_t bytes;
+  double encodeNs;
+  double decodeNs;  // The receiver's parse of the frame
+};
+
+// The last frame `send` puts out, in one encoding, and what it costs
+template <typename Fn>
+static EncodingResult benchEncoding(const char* name, bool msgpack, Fn&& send) {
+  char label[64];
+  snprintf(label, sizeof(label), "%s: %s", name, msgpack ? "MessagePack" : "JSON");
+  relayMsgPack = msgpack;
+  wsClient.sent.clear();
+  BenchResult encode = runBench(label, kRequestIters, send);
+  static std::string frame;
+  frame = wsClient.sent.back().payload;
+  wsClient.sent.clear();
+  snprintf(label, sizeof(label), "%s: %s parse", name, msgpack ? "MessagePack" : "JSON");
+  BenchResult decode = runBench(label, kRequestIters, [msgpack] {
+    static StaticJsonDocument<4096> doc;
+    TEST_ASSERT_FALSE(msgpack ? deserializeMsgPack(doc, frame) : deserializeJson(doc, frame.c_str()));
+  });
+  return {frame.size(), encode.cpuNsPerOp, decode.cpuNsPerOp};
+}
+
+static void relayRequest(const char* request) {
+  static char payload[512];
+  size_t length = strlen(request);
+  memcpy(payload, request, length + 1);
+  handleWebSocketMessage(payload, length);
+}
+
+// Every frame the device sends the relay, in JSON and in MessagePack. Parse
+// times are the host ArduinoJson stand-in's, so only their ratio means much.
+static void bench_relay_msgpack_vs_json() {
+  static const char* const kPaths[] = {"/health", "/weather", "/device-info", "/tasks"};
+  static const char* request;
+  static std::string requests[4];
+  const char* names[6] = {"response /health", "response /weather", "response /device-info", "response /tasks",
+                          "dashboard batch", "weather event"};
+  EncodingResult results[6][2];
+  wsClient.fakeEvent(WStype_CONNECTED);
+  for (int i = 0; i < 4; i++) {
+    requests[i] = std::string("{\"type\":\"request\",\"id\":\"r1\",\"method\":\"GET\",\"path\":\"") + kPaths[i] + "\"}";
+  }
+  for (int i = 0; i < 4; i++) {
+    request = requests[i].c_str();
+    for (int msgpack = 0; msgpack < 2; msgpack++) {
+      results[i][msgpack] = benchEncoding(names[i], msgpack, [] { relayRequest(request); });
+    }
+  }
+  for (int msgpack = 0; msgpack < 2; msgpack++) {
+    results[4][msgpack] = benchEncoding(names[4], msgpack, [] { relayRequest(kRelayDashboardBatch); });
+    results[5][msgpack] = benchEncoding(names[5], msgpack, [] {
+      weatherEvents.restart();  // A complete one every time
+      pushWeatherEvent();
+    });
+  }
+  relayMsgPack = false;
+  wsClient.fakeEvent(WStype_DISCONNECTED);
+  wsClient.sent.clear();
+
+  // The other way, the device parses requests
+  StaticJsonDocument<256> doc;
+  deserializeJson(doc, kRelayWeatherRequest);
+  static std::string packedRequest;
+  serializeMsgPack(doc, packedRequest);
+  BenchResult jsonRequest = runBench("relay request: JSON parse", kRequestIters, [] {
+    static StaticJsonDocument<256> parsed;
+    TEST_ASSERT_FALSE(deserializeJson(parsed, kRelayWeatherRequest));
+  });
+  BenchResult msgpackRequest = runBench("relay request: MessagePack parse", kRequestIters, [] {
+    static StaticJsonDocument<256> parsed;
+    TEST_ASSERT_FALSE(deserializeMsgPack(parsed, packedRequest));
+  });
+
+  size_t jsonTotal = 0, msgpackTotal = 0;
+  for (int i = 0; i < 6; i++) {
+    const EncodingResult& j = results[i][0];
+    const EncodingResult& m = results[i][1];
+    printf("  -> %-22s %4zu B -> %4zu B (%3.0f%% less), encode %6.0f -> %6.0f ns, parse %6.0f -> %6.0f ns\n",
+           names[i], j.bytes, m.bytes, 100.0 * (j.bytes - m.bytes) / j.bytes, j.encodeNs, m.encodeNs, j.decodeNs,
+           m.decodeNs);
+    TEST_ASSERT_LESS_THAN(j.bytes, m.bytes);
+    jsonTotal += j.bytes;
+    msgpackTotal += m.bytes;
+  }
+  printf("  -> %-22s %4zu B -> %4zu B (%3.0f%% less), parse on the device %.0f -> %.0f ns\n", "request",
+         sizeof(kRelayWeatherRequest) - 1, packedRequest.size(),
+         100.0 * (sizeof(kRelayWeatherRequest) - 1 - packedRequest.size()) / (sizeof(kRelayWeatherRequest) - 1),
+         jsonRequest.cpuNsPerOp, msgpackRequest.cpuNsPerOp);
+  printf("  -> all device frames: %zu B -> %zu B\n", jsonTotal, msgpackTotal);
+  TEST_ASSERT_LESS_THAN(sizeof(kRelayWeatherRequest) - 1, packedRequest.size());
+}
+
+static void bench_touch_cached_vs_queued_fetch() {
+  serveForecastFixture();
+
+  BenchResult miss = runBench("touch pass, cache miss (fetch queued)", 500, [] {
+    weatherCache.clear();
+    fake::clock().advanceMs(WEATHER_REFRESH_RETRY_MS + 11000);
+    loop();
+    touch();
+  });
+  waitForWeatherFetch();
+
+  weatherCache.setTtl(24UL * 3600UL * 1000UL);
+  BenchResult hit = runBench("touch pass, cache hit", 500, [] {
+    fake::clock().advanceMs(11000);
+    loop();
+    touch();
+  });
+  weatherCache.setTtl(WEATHER_CACHE_TTL_MS);
+
+  printf("  -> touch pass: %.0f ns with cache vs %.0f ns handing a miss to the fetch task\n", hit.cpuNsPerOp,
+         miss.cpuNsPerOp);
+}
+
+// Worst loop() pass (plus one HTTP request) while a slow fetch is in flight,
+// against the old inline fetch, where a single pass lasted the whole fetch.
+static void bench_loop_stall_during_fetch() {
+  serveForecastFixture();
+  fake::http().latencyMs = 200;
+
+  ForecastStore forecast;
+  auto start = std::chrono::steady_clock::now();
+  TEST_ASSERT_TRUE(getWeatherForecast(testFetchRequest(), forecast));
+  double inlineUs = elapsedUs(start);
+
+  weatherCache.clear();
+  fake::clock().advanceMs(WEATHER_REFRESH_RETRY_MS);
+  serveCachedWeather();
+  loop();
+  TEST_ASSERT_NOT_EQUAL(0, weatherFetchPending.id);
+
+  // A pass is charged what the loop thread itself spent: its CPU time, its
+  // waits on the network, and the delay()s the firmware counts in
+  // weatherFetchWorstLoopUs. Wall time would also charge it whatever the
+  // fetch thread ran while the two shared a host CPU.
+  double worstUs = 0;
+  int passes = 0;
+  start = std::chrono::steady_clock::now();
+  while (weatherFetchPending.id != 0 && elapsedUs(start) < 10e6) {
+    uint64_t cpuNs = benchThreadCpuNs();
+    uint64_t waitUs = fake::threadWaitUs();
+    loop();
+    TEST_ASSERT_EQUAL(200, server.fakeRequest(HTTP_GET, "/health").code);
+    worstUs = std::max(worstUs, (benchThreadCpuNs() - cpuNs) / 1000.0 + (fake::threadWaitUs() - waitUs));
+    passes++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  fake::http().latencyMs = 0;
+  worstUs += weatherFetchWorstLoopUs;
+
+  TEST_ASSERT_EQUAL(0, weatherFetchPending.id);
+  TEST_ASSERT_NOT_NULL(weatherCache.forecast(latitude, longitude));
+  printf("  -> worst loop() + GET /health pass during fetch: %.0f us over %d passes (inline fetch: %.0f us)\n",
+         worstUs, passes, inlineUs);
+  TEST_ASSERT_LESS_THAN(10000, (int)worstUs);
+}
+
+// The pre-table lookup: a String per symbol, then a compare chain
+static String legacyConditionName(int code) {
+  static const char* const names[] = {"", "clear_sky", "light_clouds", "partly_cloudy", "cloudy", "rain",
+                                      "rain_and_snow", "snow", "rain_shower", "snow_shower", "sleet_shower",
+                                      "light_fog", "dense_fog", "freezing_rain", "thunderstorm", "drizzle",
+                                      "sandstorm"};
+  if (code >= 100) code -= 100;
+  return code >= 1 && code <= 16 ? names[code] : "";
+}
+
+static uint32_t legacyToneFor(const String& c) {
+  if (c == "clear_sky") return 1000;
+  if (c == "light_clouds" || c == "partly_cloudy") return 800;
+  if (c == "cloudy" || c == "overcast") return 261;
+  if (c == "rain" || c == "rain_shower" || c == "drizzle") return 500;
+  if (c == "thunderstorm") return 200;
+  if (c == "snow" || c == "snow_shower") return 1200;
+  if (c == "light_fog") return 400;
+  if (c == "dense_fog") return 300;
+  if (c == "freezing_rain") return 700;
+  if (c == "sandstorm") return 300;
+  return 0;
+}
+
+static void test_weather_condition_table() {
+  for (int code = 0; code <= 120; code++) {
+    String legacy = legacyConditionName(code);
+    const ConditionInfo& info = conditionInfo(weatherCondition(code));
+    TEST_ASSERT_EQUAL_STRING(legacy.length() ? legacy.c_str() : "Unknown", info.name);
+    TEST_ASSERT_EQUAL(legacyToneFor(legacy), info.melody ? info.melody[0].frequencyHz : 0);
+  }
+  TEST_ASSERT_EQUAL(CONDITION_UNKNOWN, weatherCondition(-1));
+  TEST_ASSERT_EQUAL(CONDITION_SANDSTORM, weatherCondition(116));
+  TEST_ASSERT_EQUAL(CONDITION_UNKNOWN, weatherCondition(117));
+  TEST_ASSERT_EQUAL(CONDITION_UNKNOWN, weatherCondition(200));
+  TEST_ASSERT_EQUAL(9, CONDITIONS[CONDITION_CLOUDY].melodyLength);
+  TEST_ASSERT_EQUAL(100, CONDITIONS[CONDITION_DRIZZLE].detuneHz);
+}
+
+static void bench_weather_condition_lookup() {
+  static int code = 0;
+  BenchResult legacy = runBench("condition lookup: String + compares", kRequestIters * 10, [] {
+    code = code % 116 + 1;
+    TEST_ASSERT_TRUE(legacyToneFor(legacyConditionName(code)) < 2000);
+  });
+  BenchResult table = runBench("condition lookup: enum table", kRequestIters * 10, [] {
+    code = code % 116 + 1;
+    const ConditionInfo& info = conditionInfo(weatherCondition(code));
+    TEST_ASSERT_TRUE(!info.melody || info.melody[0].frequencyHz < 2000);
+  });
+  printf("  -> condition lookup: %.0f ns, %.2f allocs (enum) vs %.0f ns, %.2f allocs (String)\n", table.cpuNsPerOp,
+         table.allocsPerOp, legacy.cpuNsPerOp, legacy.allocsPerOp);
+  TEST_ASSERT_EQUAL(0, (int)(table.allocsPerOp * 100));
+  TEST_ASSERT_LESS_THAN(legacy.cpuNsPerOp, table.cpuNsPerOp);
+}
+
+static void bench_interpret_weather_symbol() {
+  runBench("interpretWeatherSymbol clear_sky", kRequestIters, [] {
+    interpretWeatherSymbol(1);
+    buzzer.stop();
+    fake::runTimers();
+  });
+  TEST_ASSERT_EQUAL_STRING("clear_sky", conditionName(lastWeatherCondition));
+}
+
+static void bench_led_frame(const char* name, int temperature) {
+  animationActive = false;
+  runBench(name, kRequestIters, [temperature] {
+    fake::clock().advanceMs(100);
+    setLEDRGB(temperature);
+    if (!animationActive) setLEDRGB(temperature);
+  });
+}
+
+static void bench_led_frames() {
+  bench_led_frame("setLEDRGB frame (cold)", -5);
+  bench_led_frame("setLEDRGB frame (mild)", 15);
+  bench_led_frame("setLEDRGB frame (hot)", 30);
+  animationActive = false;
+}
+
+// The pre-LedAnimation frame math, kept as the baseline: float factors and
+// map() per pixel, two random() calls per flame pixel
+static Rgb legacyPixels[12];
+static void legacyFrame(int temperature) {
+  static int animationStep = 0;
+  static int brightness = 0;
+  static bool increasing = true;
+  const int n = 12;
+  if (temperature <= 0) {
+    for (int i = 0; i < n; i++) {
+      float factor = 1.0 - (((i + animationStep) % n) / (float)n);
+      int adjustedBlue = map(temperature, -10, 0, 128, 255) * factor;
+      legacyPixels[(i + animationStep) % n] = Rgb{0, 0, (uint8_t)adjustedBlue};
+    }
+    animationStep = (animationStep + 1) % n;
+  } else if (temperature <= 25) {
+    if (increasing) {
+      brightness += 15;
+      if (brightness >= 255) increasing = false;
+    } else {
+      brightness -= 15;
+      if (brightness <= 0) increasing = true;
+    }
+    int red = map(temperature, 0, 25, 0, 128);
+    int green = map(temperature, 0, 25, 255, 128);
+    int blue = map(temperature, 0, 25, 255, 64);
+    for (int i = 0; i < n; i++) {
+      legacyPixels[i] = Rgb{(uint8_t)(red * brightness / 255), (uint8_t)(green * brightness / 255),
+                            (uint8_t)(blue * brightness / 255)};
+    }
+  } else {
+    for (int i = 0; i < n; i++) {
+      legacyPixels[i] = random(10) > 7 ? Rgb{255, (uint8_t)random(64, 128), 0} : Rgb{128, (uint8_t)random(32, 64), 0};
+    }
+  }
+}
+
+static void test_led_tables_and_effects() {
+  TEST_ASSERT_EQUAL(0, LED_GAMMA.v[0]);
+  TEST_ASSERT_EQUAL(255, LED_GAMMA.v[255]);
+  TEST_ASSERT_EQUAL(46, LED_GAMMA.v[128]);  // 255 * 0.502^2.5
+  for (int i = 1; i < 256; i++) TEST_ASSERT_TRUE(LED_GAMMA.v[i] >= LED_GAMMA.v[i - 1]);
+
+  // The table holds what map() gave per frame
+  for (int t = -10; t <= 25; t++) {
+    Rgb c = temperatureColour(t);
+    if (t <= 0) {
+      TEST_ASSERT_EQUAL(map(t, -10, 0, 128, 255), c.b);
+    } else {
+      TEST_ASSERT_EQUAL(map(t, 0, 25, 0, 128), c.r);
+      TEST_ASSERT_EQUAL(map(t, 0, 25, 255, 128), c.g);
+      TEST_ASSERT_EQUAL(map(t, 0, 25, 255, 64), c.b);
+    }
+  }
+  TEST_ASSERT_EQUAL(temperatureColour(LED_TEMP_MIN).b, temperatureColour(-60).b);  // Clamped
+
+  // Mild: the same breathing as before, within rounding
+  LedStrip<12> bench(LED_PIN);
+  LedAnimation<LedStrip<12> > animation(bench);
+  for (int frame = 0; frame < 40; frame++) {
+    animation.render(15);
+    legacyFrame(15);
+    TEST_ASSERT_INT_WITHIN(1, legacyPixels[0].g, animation.pixels()[0].g);
+  }
+
+  // Cold: the gradient turns a pixel per frame (it stood still before)
+  animation.render(-5);
+  Rgb first[12];
+  memcpy(first, animation.pixels(), sizeof(first));
+  animation.render(-5);
+  TEST_ASSERT_EQUAL(first[0].b, animation.pixels()[1].b);
+  TEST_ASSERT_EQUAL(first[11].b, animation.pixels()[0].b);
+  TEST_ASSERT_EQUAL(temperatureColour(-5).b, first[0].b);
+
+  // Hot: flares and embers in the old colour ranges
+  int flares = 0;
+  for (int frame = 0; frame < 100; frame++) {
+    animation.render(30);
+    for (int i = 0; i < 12; i++) {
+      Rgb p = animation.pixels()[i];
+      TEST_ASSERT_TRUE(p.r == 255 ? p.g >= 64 && p.g < 128 : p.r == 128 && p.g >= 32 && p.g < 64);
+      flares += p.r == 255;
+    }
+  }
+  TEST_ASSERT_INT_WITHIN(60, 240, flares);  // 1 in 5 of 1200
+}
+
+// Frame render time alone, strip output left out. The host FPU runs the
+// legacy double math in a few cycles; the ESP32 emulates doubles in
+// software, so only the fixed-point budget is checked here.
+static void bench_led_render_legacy_vs_fixed_point() {
+  static LedStrip<12> bench(LED_PIN);
+  static LedAnimation<LedStrip<12> > animation(bench);
+  const int temperatures[] = {-5, 15, 30};
+  const char* names[][2] = {
+    {"LED frame float (cold)", "LED frame fixed-point (cold)"},
+    {"LED frame float (mild)", "LED frame fixed-point (mild)"},
+    {"LED frame float (hot)", "LED frame fixed-point (hot)"},
+  };
+  for (int k = 0; k < 3; k++) {
+    static int t;
+    t = temperatures[k];
+    BenchResult legacy = runBench(names[k][0], kRequestIters * 10, [] { legacyFrame(t); });
+    BenchResult fixed = runBench(names[k][1], kRequestIters * 10, [] { animation.render(t); });
+    printf("  -> %d C: %.0f ns per frame fixed-point vs %.0f ns float\n", t, fixed.cpuNsPerOp, legacy.cpuNsPerOp);
+    TEST_ASSERT_LESS_THAN(1000, (int)fixed.cpuNsPerOp);
+  }
+}
+
+// A 300-pixel ring on its own RMT channel, so the firmware's strip is left alone
+static LedStrip<300> bigRing(LED_PIN + 1, RMT_CHANNEL_2);
+
+static void test_led_strip_rmt_output() {
+  fake::Rmt& rmt = fake::rmt(RMT_CHANNEL_2);
+  TEST_ASSERT_TRUE(bigRing.begin());
+  TEST_ASSERT_EQUAL(LED_RMT_CLK_DIV, rmt.config.clk_div);
+
+  // GRB, MSB first, WS2812 pulse widths, the latch on the last bit
+  bigRing.setPixelColor(0, 0x80, 0x01, 0xFF);
+  bigRing.setPixelColor(299, 0, 0, 1);
+  uint64_t before = fake::clock().nowUs;
+  bigRing.show();
+  TEST_ASSERT_EQUAL(before, fake::clock().nowUs);  // Returned at once
+  TEST_ASSERT_EQUAL(300 * 24, rmt.items.size());
+  TEST_ASSERT_EQUAL(LED_T0H_TICKS, rmt.items[0].duration0);  // G 0x01: bit 7
+  TEST_ASSERT_EQUAL(LED_T1H_TICKS, rmt.items[7].duration0);  // G 0x01: bit 0
+  TEST_ASSERT_EQUAL(LED_T1L_TICKS, rmt.items[8].duration1);  // R 0x80: bit 7
+  TEST_ASSERT_EQUAL(1, rmt.items[8].level0);
+  TEST_ASSERT_EQUAL(0, rmt.items[8].level1);
+  TEST_ASSERT_EQUAL(LED_T1H_TICKS, rmt.items[300 * 24 - 1].duration0);
+  TEST_ASSERT_EQUAL(LED_RESET_TICKS, rmt.items[300 * 24 - 1].duration1);
+  // 7200 bits at 1.25 us, then the 300 us latch
+  TEST_ASSERT_EQUAL(before + 9300, rmt.busyUntilUs);
+
+  // Drawing the next frame leaves the one on the wire alone, and pixels not
+  // drawn again keep their colour
+  bigRing.setPixelColor(0, 0, 0, 0);
+  TEST_ASSERT_EQUAL_MEMORY(rmt.sent.data(), rmt.src, rmt.sent.size());
+  TEST_ASSERT_EQUAL(LedStrip<300>::Color(0, 0, 1), bigRing.getPixelColor(299));
+
+  // A frame before the last is out waits for it
+  uint64_t blocked = fake::clock().blockedUs;
+  bigRing.show();
+  TEST_ASSERT_EQUAL(1, bigRing.stalls());
+  TEST_ASSERT_EQUAL(before + 9300, fake::clock().nowUs);
+  TEST_ASSERT_EQUAL(blocked + 9300, fake::clock().blockedUs);
+  TEST_ASSERT_EQUAL(0, rmt.sent[1]);
+
+  // Brightness scales as Adafruit_NeoPixel's did
+  bigRing.setBrightness(50);
+  bigRing.setPixelColor(1, 255, 255, 255);
+  TEST_ASSERT_EQUAL(LedStrip<300>::Color(50, 50, 50), bigRing.getPixelColor(1));
+  bigRing.setBrightness(255);
+  bigRing.clear();
+  bigRing.flush();
+  TEST_ASSERT_FALSE(rmt.busy());
+}
+
+// 60 fps on 300 pixels: what a frame costs the CPU. A bit-banged show() held
+// interrupts off for 30 us a pixel plus the latch. The cpu column includes the
+// fake RMT translating the frame, work the RMT interrupt does on the device.
+static void bench_led_show_rmt_vs_bitbang() {
+  static LedAnimation<LedStrip<300> > ringAnimation(bigRing);
+  static LedStrip<NUM_LEDS>* small = &strip;
+  uint32_t stalls = bigRing.stalls();
+  BenchResult ring = runBench("LED frame 300 px @60fps (RMT)", kRequestIters, [] {
+    fake::clock().advanceUs(16667);
+    ringAnimation.render(-5);
+    for (uint16_t i = 0; i < 300; i++) {
+      const Rgb& p = ringAnimation.pixels()[i];
+      bigRing.setPixelColor(i, p.r, p.g, p.b);
+    }
+    bigRing.show();
+  });
+  BenchResult ring12 = runBench("LED show 12 px (RMT)", kRequestIters, [] {
+    fake::clock().advanceMs(LED_FRAME_MS);
+    small->show();
+  });
+  printf("  -> show(): %.0f us blocked at 300 px (bit-banged: %d us, interrupts off), %.0f us at %d px (bit-banged: %d us)\n",
+         ring.blockedUsPerOp, 30 * 300 + 50, ring12.blockedUsPerOp, NUM_LEDS, 30 * NUM_LEDS + 50);
+  TEST_ASSERT_EQUAL(stalls, bigRing.stalls());  // 9.3 ms on the wire fits a 16.7 ms frame
+  TEST_ASSERT_EQUAL(0, (int)ring.blockedUsPerOp);
+  TEST_ASSERT_EQUAL(0, (int)ring12.blockedUsPerOp);
+  TEST_ASSERT_LESS_THAN(1000000, (int)ring.cpuNsPerOp);  // Under 6% of a 60 fps frame
+}
+
+static void bench_play_tone_idle() {
+  runBench("playToneIfNecessary() silent condition", kRequestIters * 10, [] { playToneIfNecessary(CONDITION_UNKNOWN); });
+}
+
+// What the buzzer sounds over `ms` of virtual time, a step at a time: the
+// frequency of each note as it starts, and when the last one ended
+static std::vector<uint32_t> listenToBuzzer(uint32_t ms, uint32_t& endedAtMs) {
+  std::vector<uint32_t> notes;
+  bool sounding = false;
+  endedAtMs = 0;
+  for (uint32_t t = 0; t <= ms; t += 10) {
+    fake::runTimers();
+    bool on = fake::ledc().duty != 0;
+    if (on && !sounding) notes.push_back(fake::ledc().freqHz);
+    sounding = on;
+    if (!buzzer.playing() && endedAtMs == 0) endedAtMs = t;
+    fake::clock().advanceMs(10);
+  }
+  return notes;
+}
+
+static void test_melody_player() {
+  buzzer.stop();
+  fake::runTimers();
+
+  // The cloudy melody no longer holds up the caller for 3 s
+  uint64_t startUs = fake::clock().nowUs;
+  uint64_t blockedUs = fake::clock().blockedUs;
+  interpretWeatherSymbol(4);
+  TEST_ASSERT_TRUE(buzzer.playing());
+  TEST_ASSERT_LESS_THAN(1000, (int)(fake::clock().nowUs - startUs));
+  TEST_ASSERT_EQUAL(blockedUs, fake::clock().blockedUs);
+
+  // Same notes, same rests (30% of each note) as the blocking version
+  uint32_t endedAtMs;
+  std::vector<uint32_t> notes = listenToBuzzer(3500, endedAtMs);
+  std::vector<uint32_t> expected = {261, 294, 330, 294, 261};
+  TEST_ASSERT_TRUE(notes == expected);
+  TEST_ASSERT_INT_WITHIN(10, 2940, endedAtMs);  // 2400 ms of notes, 540 ms of rests
+  TEST_ASSERT_EQUAL(0, fake::ledc().duty);
+
+  // A melody already playing is not restarted; a stop silences it at once
+  interpretWeatherSymbol(1);
+  fake::runTimers();
+  TEST_ASSERT_EQUAL(1000, fake::ledc().freqHz);
+  TEST_ASSERT_EQUAL(MELODY_FULL_DUTY, fake::ledc().duty);
+  interpretWeatherSymbol(14);
+  fake::runTimers();
+  TEST_ASSERT_EQUAL(1000, fake::ledc().freqHz);
+  buzzer.stop();
+  fake::runTimers();
+  TEST_ASSERT_FALSE(buzzer.playing());
+  TEST_ASSERT_EQUAL(0, fake::ledc().duty);
+
+  // Volume scales the duty
+  static const Note quiet[] = {{440, 100, 25}};
+  buzzer.play(quiet, 1);
+  fake::runTimers();
+  TEST_ASSERT_EQUAL(MELODY_FULL_DUTY / 4, fake::ledc().duty);
+  buzzer.stop();
+  fake::runTimers();
+}
+
+// Every condition's melody, started from the touch path: none may hold the
+// caller for a millisecond
+static void bench_interpret_weather_symbol_melodies() {
+  uint64_t worstUs = 0;
+  for (int code = 1; code <= 16; code++) {
+    uint64_t startUs = fake::clock().nowUs;
+    interpretWeatherSymbol(code);
+    worstUs = std::max<uint64_t>(worstUs, fake::clock().nowUs - startUs);
+    buzzer.stop();
+    fake::runTimers();
+  }
+  BenchResult cloudy = runBench("interpretWeatherSymbol cloudy", kRequestIters, [] {
+    interpretWeatherSymbol(4);
+    buzzer.stop();
+    fake::runTimers();
+  });
+  printf("  -> worst interpretWeatherSymbol(): %llu us of firmware time (blocking cloudy melody: 3120 ms)\n",
+         (unsigned long long)worstUs);
+  TEST_ASSERT_LESS_THAN(1000, (int)worstUs);
+  TEST_ASSERT_LESS_THAN(1000, (int)cloudy.blockedUsPerOp);
+}
+
+static void bench_loop_idle() {
+  runBench("loop() idle pass", kRequestIters, [] { loop(); });
+
+  // Passes per second of virtual time with nothing going on: the network
+  // poll's, as often as the old loop()'s 10 ms, with nothing else waking it
+  animationActive = false;
+  for (int i = 0; i < 10; i++) loop();
+  unsigned long start = millis();
+  int passes = 0;
+  while (millis() - start < 10000) {
+    loop();
+    passes++;
+  }
+  printf("  -> idle: %d loop() passes per second\n", passes / 10);
+  TEST_ASSERT_LESS_OR_EQUAL(1000 / NETWORK_POLL_MS + 5, passes / 10);
+}
+
+static int schedulerRuns[3];
+static Scheduler* testScheduler;
+static void periodicTask() { schedulerRuns[0]++; }
+static void onDemandTask() { schedulerRuns[1]++; }
+static void slowTask() {
+  schedulerRuns[2]++;
+  fake::clock().advanceMs(3);
+  testScheduler->runIn(2, 250);  // Picks its own next deadline
+}
+
+static void test_scheduler_deadlines() {
+  static const ScheduledTask tasks[] = {
+    { "periodic", periodicTask, 100 },
+    { "demand", onDemandTask, 0 },
+    { "slow", slowTask, 1000 },
+  };
+  Scheduler sched(tasks, 3);
+  testScheduler = &sched;
+  memset(schedulerRuns, 0, sizeof(schedulerRuns));
+  sched.begin();
+
+  // Periodic tasks run at once; the wait is up to the next deadline
+  TEST_ASSERT_EQUAL(97, sched.runDue());  // periodic, 100 ms after a pass that took 3
+  TEST_ASSERT_EQUAL(1, schedulerRuns[0]);
+  TEST_ASSERT_EQUAL(0, schedulerRuns[1]);
+  TEST_ASSERT_EQUAL(1, schedulerRuns[2]);
+
+  // Deadlines stay on the 100 ms grid however late a run starts
+  fake::clock().advanceMs(97 + 30);
+  sched.runDue();
+  TEST_ASSERT_EQUAL(2, schedulerRuns[0]);
+  TEST_ASSERT_EQUAL(30000, sched.stats(0).maxLateUs);
+  TEST_ASSERT_EQUAL(70, sched.runDue());
+
+  // Three periods behind: one run, the rest counted as missed
+  fake::clock().advanceMs(370);
+  sched.runDue();
+  TEST_ASSERT_EQUAL(3, schedulerRuns[0]);
+  TEST_ASSERT_EQUAL(3, sched.stats(0).missed);
+
+  // The slow task's runIn() replaced its period: due at 253 ms, not 1000
+  TEST_ASSERT_EQUAL(2, schedulerRuns[2]);
+  TEST_ASSERT_EQUAL(247000, sched.stats(2).maxLateUs);
+  TEST_ASSERT_EQUAL(3000, sched.stats(2).maxUs);
+
+  // Notified: runs at the next pass, once, and cuts a wait short
+  sched.notify(1);
+  TEST_ASSERT_EQUAL(97, sched.runDue());  // Back to waiting for the periodic task at 600 ms
+  TEST_ASSERT_EQUAL(1, schedulerRuns[1]);
+  sched.runDue();
+  TEST_ASSERT_EQUAL(1, schedulerRuns[1]);
+  sched.notify(1);
+  uint64_t before = fake::clock().nowUs;
+  sched.wait(50);
+  TEST_ASSERT_EQUAL(before, fake::clock().nowUs);
+  sched.runDue();
+  TEST_ASSERT_EQUAL(2, schedulerRuns[1]);
+
+  // every() starts and stops a task
+  sched.every(1, 20);
+  fake::clock().advanceMs(20);
+  sched.runDue();
+  TEST_ASSERT_EQUAL(3, schedulerRuns[1]);
+  sched.every(1, 0);
+  fake::clock().advanceMs(1000);
+  sched.runDue();
+  TEST_ASSERT_EQUAL(3, schedulerRuns[1]);
+}
+
+static void test_tasks_endpoint() {
+  const FakeHttpResponse& res = server.fakeRequest(HTTP_GET, "/tasks");
+  TEST_ASSERT_EQUAL(200, res.code);
+  TEST_ASSERT_NOT_NULL(strstr(res.body.c_str(), "{\"name\":\"network\",\"runs\":"));
+  TEST_ASSERT_NOT_NULL(strstr(res.body.c_str(), "\"name\":\"sleep\""));
+}
+
+// ============================================================================
+// Saved configuration
+// ============================================================================
+
+static ConfigRecord storedConfig() {
+  ConfigRecord record;
+  const std::string& blob = fake::nvs().entries[CONFIG_NAMESPACE "/" CONFIG_KEY];
+  if (blob.size() == sizeof(record)) memcpy(&record, blob.data(), sizeof(record));
+  return record;
+}
+
+static void test_config_record_checks() {
+  TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crc32("123456789", 9));  // Standard check value
+
+  ConfigStore store;
+  ConfigRecord saved;
+  strcpy(saved.ssid, "PotatoNet");
+  strcpy(saved.password, "hunter22");
+  saved.latitude = 48.9075f;
+  saved.longitude = 2.3833f;
+  TEST_ASSERT_TRUE(store.save(saved));
+
+  ConfigRecord loaded;
+  TEST_ASSERT_TRUE(store.load(loaded));
+  TEST_ASSERT_EQUAL_STRING("PotatoNet", loaded.ssid);
+  TEST_ASSERT_EQUAL_STRING("hunter22", loaded.password);
+  TEST_ASSERT_EQUAL_FLOAT(48.9075f, loaded.latitude);
+
+  // Saving the same record again does not touch flash
+  uint32_t writes = fake::nvs().writes;
+  TEST_ASSERT_TRUE(store.save(saved));
+  TEST_ASSERT_EQUAL(writes, fake::nvs().writes);
+
+  std::string& blob = fake::nvs().entries[CONFIG_NAMESPACE "/" CONFIG_KEY];
+  std::string good = blob;
+  blob[offsetof(ConfigRecord, latitude)] ^= 0x01;  // Flipped bit
+  TEST_ASSERT_FALSE(store.load(loaded));
+  blob = good;
+  ConfigRecord other = saved;
+  other.version = CONFIG_RECORD_VERSION + 1;  // Record from another firmware
+  other.crc = crc32(&other, offsetof(ConfigRecord, crc));
+  blob.assign((const char*)&other, sizeof(other));
+  TEST_ASSERT_FALSE(store.load(loaded));
+  blob.resize(sizeof(ConfigRecord) - 4);  // Truncated
+  TEST_ASSERT_FALSE(store.load(loaded));
+  blob = good;
+  TEST_ASSERT_TRUE(store.load(loaded));
+}
+
+// /config and /location persist what they change
+static void test_handlers_save_config() {
+  server.fakeRequest(HTTP_POST, "/config",
+                     "{\"ssid\":\"AtticNet\",\"password\":\"tuber123\",\"latitude\":45.75,\"longitude\":4.85}");
+  ConfigRecord record = storedConfig();
+  TEST_ASSERT_EQUAL_STRING("AtticNet", record.ssid);
+  TEST_ASSERT_EQUAL_STRING("tuber123", record.password);
+  TEST_ASSERT_EQUAL_FLOAT(45.75f, record.latitude);
+
+  server.fakeRequest(HTTP_POST, "/location", "{\"latitude\":48.9075,\"longitude\":2.3833}");
+  record = storedConfig();
+  TEST_ASSERT_EQUAL_STRING("AtticNet", record.ssid);
+  TEST_ASSERT_EQUAL_FLOAT(48.9075f, record.latitude);
+  TEST_ASSERT_EQUAL_FLOAT(2.3833f, record.longitude);
+
+  // A /location poll with unchanged coordinates costs no flash write
+  uint32_t writes = fake::nvs().writes;
+  server.fakeRequest(HTTP_POST, "/location", "{\"latitude\":48.9075,\"longitude\":2.3833}");
+  TEST_ASSERT_EQUAL(writes, fake::nvs().writes);
+}
+
+// Power cycle: setup() starts joining the saved network and returns; loop()
+// finishes the join. No BLE or AP onboarding.
+static void powerOn() {
+  wifiSSID = "";
+  wifiPassword = "";
+  latitude = 0;
+  longitude = 0;
+  bootToConnectedMs = 0;
+  WiFi.disconnect();
+  WiFi.fakeRunEvents();
+  server.fakePowerOff();
+  fake::clock().nowUs = 0;  // Power on
+
+  setup();
+}
+
+static void powerCycle() {
+  powerOn();
+  TEST_ASSERT_TRUE(joinWiFi());
+}
+
+// Runs last, since it boots the firmware a second time
+static void test_boot_from_saved_config() {
+  powerCycle();
+
+  TEST_ASSERT_EQUAL_STRING("AtticNet", wifiSSID.c_str());
+  TEST_ASSERT_EQUAL_FLOAT(48.9075f, latitude);
+  TEST_ASSERT_EQUAL(WL_CONNECTED, WiFi.status());
+  TEST_ASSERT_FALSE(bleEnabled);
+  TEST_ASSERT_TRUE(server.listening());
+  TEST_ASSERT_EQUAL(17, server.routeCount());
+  TEST_ASSERT_GREATER_THAN(0, bootToConnectedMs);
+  printf("  -> boot to connected from saved config: %lu ms of firmware time (setup() delays included)\n",
+         bootToConnectedMs);
+}
+
+static void printJoin(const char* what) {
+  const WiFiTimings& t = wifiLink.timings();
+  printf("  -> %-28s %5lu ms (associate %lu ms, address %lu ms, %s)\n", what, (unsigned long)t.totalMs,
+         (unsigned long)t.associateMs, (unsigned long)t.addressMs, t.fast ? "cached" : "scan + DHCP");
+}
+
+// A dropped link rejoins through the cached BSSID, channel and lease; a
+// cache that no longer fits the AP falls back to a full join and is relearned
+static void test_wifi_rejoin_through_cache() {
+  TEST_ASSERT_EQUAL(WIFI_LINK_CONNECTED, wifiLink.state());
+  printJoin("first join (no cache):");
+  TEST_ASSERT_FALSE(wifiLink.timings().fast);
+  uint32_t fullMs = wifiLink.timings().totalMs;
+
+  WiFi.fakeDropLink();
+  TEST_ASSERT_TRUE(joinWiFi());
+  printJoin("rejoin after a drop:");
+  TEST_ASSERT_TRUE(wifiLink.timings().fast);
+  TEST_ASSERT_EQUAL(0, wifiLink.timings().addressMs);  // No DHCP
+  TEST_ASSERT_LESS_THAN(500, wifiLink.timings().totalMs);
+  TEST_ASSERT_LESS_THAN(fullMs / 5, wifiLink.timings().totalMs);
+  TEST_ASSERT_TRUE(WiFi.localIP() == WiFi.fakeLocalIP);
+
+  // New router: the cached BSSID is refused, the scan finds the new one
+  WiFi.fakeBSSID[5] ^= 0x01;
+  uint32_t writes = fake::nvs().writes;
+  WiFi.fakeDropLink();
+  TEST_ASSERT_TRUE(joinWiFi());
+  printJoin("rejoin, AP replaced:");
+  TEST_ASSERT_FALSE(wifiLink.timings().fast);
+  TEST_ASSERT_EQUAL(writes + 1, fake::nvs().writes);
+
+  // Unchanged cache: no flash write
+  writes = fake::nvs().writes;
+  WiFi.fakeDropLink();
+  TEST_ASSERT_TRUE(joinWiFi());
+  TEST_ASSERT_TRUE(wifiLink.timings().fast);
+  TEST_ASSERT_EQUAL(writes, fake::nvs().writes);
+
+  // Next boot joins through the cache in NVS
+  powerCycle();
+  printJoin("boot with a cache:");
+  TEST_ASSERT_TRUE(wifiLink.timings().fast);
+  TEST_ASSERT_LESS_THAN(fullMs / 5, wifiLink.timings().totalMs);
+}
+
+// Bouncy edges on the pad pin, as the interrupt sees them
+static void pressPad(uint32_t heldMs) {
+  fake::drivePin(CAP_SENSOR_PIN, HIGH);
+  fake::clock().advanceUs(2000);
+  fake::drivePin(CAP_SENSOR_PIN, LOW);
+  fake::clock().advanceUs(1000);
+  fake::drivePin(CAP_SENSOR_PIN, HIGH);
+  fake::clock().advanceMs(heldMs);
+  fake::runTimers();
+  fake::drivePin(CAP_SENSOR_PIN, LOW);
+  fake::clock().advanceUs(3000);
+  fake::drivePin(CAP_SENSOR_PIN, HIGH);
+  fake::clock().advanceUs(1000);
+  fake::drivePin(CAP_SENSOR_PIN, LOW);
+}
+
+// Gestures are recognised off the pin interrupt and queued, so none is lost
+// or late because loop() was busy while the pad was touched
+static void test_touch_gestures() {
+  TouchEvent event;
+  while (touchInput.next(event)) {}
+  fake::clock().advanceMs(1000);
+
+  // Tap: one event, stamped at the release, despite the bounce on both edges
+  pressPad(60);
+  uint64_t releasedUs = fake::clock().nowUs - 4000;
+  fake::clock().advanceMs(100);
+  fake::runTimers();
+  TEST_ASSERT_TRUE(touchInput.next(event));
+  TEST_ASSERT_EQUAL(TOUCH_TAP, event.gesture);
+  TEST_ASSERT_EQUAL((int64_t)releasedUs, event.atUs);
+  TEST_ASSERT_FALSE(touchInput.next(event));
+
+  // A second tap soon after pairs with it; a third starts over
+  pressPad(60);
+  fake::clock().advanceMs(100);
+  pressPad(60);
+  TEST_ASSERT_TRUE(touchInput.next(event));
+  TEST_ASSERT_EQUAL(TOUCH_DOUBLE_TAP, event.gesture);
+  TEST_ASSERT_TRUE(touchInput.next(event));
+  TEST_ASSERT_EQUAL(TOUCH_TAP, event.gesture);
+
+  // Long press: reported while still held, nothing on release
+  fake::clock().advanceMs(1000);
+  uint64_t pressedUs = fake::clock().nowUs;
+  pressPad(TOUCH_LONG_PRESS_US / 1000 + 100);
+  fake::runTimers();
+  TEST_ASSERT_TRUE(touchInput.next(event));
+  TEST_ASSERT_EQUAL(TOUCH_LONG_PRESS, event.gesture);
+  TEST_ASSERT_EQUAL((int64_t)(pressedUs + TOUCH_LONG_PRESS_US), event.atUs);
+  TEST_ASSERT_FALSE(touchInput.next(event));
+
+  // A release inside the debounce window is picked up once the window ends
+  fake::clock().advanceMs(1000);
+  pressedUs = fake::clock().nowUs;
+  fake::drivePin(CAP_SENSOR_PIN, HIGH);
+  fake::clock().advanceMs(10);
+  fake::drivePin(CAP_SENSOR_PIN, LOW);
+  fake::clock().advanceMs(50);
+  fake::runTimers();
+  TEST_ASSERT_TRUE(touchInput.next(event));
+  TEST_ASSERT_EQUAL(TOUCH_TAP, event.gesture);
+  TEST_ASSERT_EQUAL((int64_t)(pressedUs + TOUCH_DEBOUNCE_US), event.atUs);
+
+  // Taps while loop() is stuck wait for it; past the queue length they drop
+  uint32_t dropped = touchInput.dropped();
+  for (int i = 0; i < TOUCH_QUEUE_LENGTH + 2; i++) {
+    fake::clock().advanceMs(1000);
+    pressPad(60);
+  }
+  fake::clock().advanceMs(100);
+  fake::runTimers();
+  TEST_ASSERT_EQUAL(dropped + 2, touchInput.dropped());
+  int queued = 0;
+  while (touchInput.next(event)) queued++;
+  TEST_ASSERT_EQUAL(TOUCH_QUEUE_LENGTH, queued);
+
+  // loop() acts on them: a tap shows the weather, a long press stops it
+  serveForecastFixture();
+  weatherCache.setTtl(24UL * 3600UL * 1000UL);
+  serveCachedWeather();
+  loop();
+  waitForWeatherFetch();
+  animationActive = false;
+  fake::clock().advanceMs(1000);
+  pressPad(60);
+  loop();
+  TEST_ASSERT_TRUE(animationActive);
+  printf("  -> tap queued at its release, long press %d ms into the press; %d taps kept through a stalled loop()\n",
+         TOUCH_LONG_PRESS_US / 1000, queued);
+  fake::clock().advanceMs(1000);
+  pressPad(TOUCH_LONG_PRESS_US / 1000 + 100);
+  loop();
+  TEST_ASSERT_FALSE(animationActive);
+  weatherCache.setTtl(WEATHER_CACHE_TTL_MS);
+}
+
+// Idle with a saved network: deep sleep until touched. The wake renders the
+// forecast kept in RTC memory before WiFi is back, then refreshes it.
+static void test_deep_sleep_touch_wake() {
+  ForecastStore forecast;
+  forecast.clear((uint32_t)(time(nullptr) / 3600));
+  forecast.set(FORECAST_TEMPERATURE, 0, 31.0f);
+  forecast.set(FORECAST_SYMBOL, 0, 1);  // Clear sky
+  weatherCache.put(latitude, longitude, millis(), forecast);
+  WiFi.softAPdisconnect(true);  // Onboarding is over
+  animationActive = false;
+  fake::pins().level[CAP_SENSOR_PIN] = LOW;
+
+  sleepAfterIdleMs = 5000;
+  uint32_t sleeps = fake::sleep().entered;
+  for (int i = 0; i < 2000 && fake::sleep().entered == sleeps; i++) loop();
+  TEST_ASSERT_EQUAL(sleeps + 1, fake::sleep().entered);
+  TEST_ASSERT_EQUAL(CAP_SENSOR_PIN, fake::sleep().ext0Pin);
+  TEST_ASSERT_EQUAL(HIGH, fake::sleep().ext0Level);
+  TEST_ASSERT_TRUE(sleepSnapshotValid(sleepSnapshot));
+  SleepSnapshot kept = sleepSnapshot;
+  sleepSnapshot.temperature ^= 1;  // Junk, as after a power cut
+  TEST_ASSERT_FALSE(sleepSnapshotValid(sleepSnapshot));
+  sleepSnapshot = kept;
+
+  // Touch wake: RAM is gone, RTC memory and the wall clock are not
+  weatherCache.clear();
+  weatherCache.setTtl(1);  // What was cached has gone stale meanwhile
+  weatherSymbol = 0;
+  lastTemperature = 0;
+  currentTemperature = 0;
+  bootToConnectedMs = 0;
+  server.close();
+  uint32_t fetches = weatherFetchGeneration;
+  fake::sleep().wakeCause = ESP_SLEEP_WAKEUP_EXT0;
+  fake::pins().level[CAP_SENSOR_PIN] = HIGH;
+  fake::rmt().firstLitUs = 0;
+  fake::rmt().busyUntilUs = 0;  // The RMT starts over with the chip
+  fake::clock().nowUs = 0;
+
+  setup();
+  uint64_t frameUs = fake::rmt().firstLitUs;
+  TEST_ASSERT_GREATER_THAN(0, frameUs);
+  TEST_ASSERT_EQUAL(31, currentTemperature);
+  TEST_ASSERT_TRUE(animationActive);
+  TEST_ASSERT_TRUE(buzzer.playing());
+  TEST_ASSERT_TRUE(WiFi.status() != WL_CONNECTED);  // Shown before WiFi is back
+
+  TEST_ASSERT_TRUE(joinWiFi());
+  for (int i = 0; i < 10 && weatherFetchGeneration == fetches; i++) loop();
+  TEST_ASSERT_GREATER_THAN(fetches, weatherFetchGeneration);  // Background refresh
+  printf("  -> touch wake to first LED frame: %llu us of firmware time, WiFi back after %lu ms\n",
+         (unsigned long long)frameUs, bootToConnectedMs);
+
+  sleepAfterIdleMs = 0;
+  weatherCache.setTtl(WEATHER_CACHE_TTL_MS);
+  fake::sleep().wakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+  fake::drivePin(CAP_SENSOR_PIN, LOW);  // The waking touch ends, not a tap
+  TouchEvent event;
+  TEST_ASSERT_FALSE(touchInput.next(event));
+}
+
+// The saved network is down at boot (router still starting after a power
+// cut): onboarding starts at the timeout, and the network is retried with
+// backoff until it is back
+static void test_wifi_retries_saved_network_after_timeout() {
+  WiFi.fakeConnectOnBegin = false;
+  powerOn();
+  TEST_ASSERT_FALSE(joinWiFi(WIFI_SAVED_TIMEOUT_MS + 1000));
+  TEST_ASSERT_TRUE(WiFi.softAPIP() == IPAddress(192, 168, 4, 1));
+  TEST_ASSERT_EQUAL(WIFI_LINK_CONNECTING, wifiLink.state());
+
+  int begins = WiFi.beginCalls;
+  TEST_ASSERT_FALSE(joinWiFi(4 * WIFI_RETRY_MAX_MS));
+  int retries = WiFi.beginCalls - begins;
+  printf("  -> %d joins in %d s after the timeout\n", retries, 4 * WIFI_RETRY_MAX_MS / 1000);
+  TEST_ASSERT_GREATER_OR_EQUAL(3, retries);
+  TEST_ASSERT_LESS_OR_EQUAL(6, retries);  // Backed off to WIFI_RETRY_MAX_MS
+
+  WiFi.fakeConnectOnBegin = true;
+  TEST_ASSERT_TRUE(joinWiFi(WIFI_RETRY_MAX_MS + 5000));
+  TEST_ASSERT_EQUAL_STRING("AtticNet", WiFi.SSID().c_str());
+  TEST_ASSERT_TRUE(WiFi.softAPIP() == IPAddress());
+  const FakeHttpResponse& res = server.fakeRequest(HTTP_GET, "/connection-status");
+  TEST_ASSERT_NOT_NULL(strstr(res.body.c_str(), "\"connected\":true"));
+}
+
+// Out of range: the network never answers, so the device goes back to
+// onboarding and the setup page is told the join failed. BLE memory was
+// released on the first connection, so only the AP comes back.
+static void test_wifi_gives_up_to_onboarding() {
+  WiFi.fakeConnectOnBegin = false;
+  server.fakeRequest(HTTP_POST, "/config", "{\"ssid\":\"FarAwayNet\",\"password\":\"tuber123\"}");
+  TEST_ASSERT_FALSE(joinWiFi(40000));
+  TEST_ASSERT_EQUAL(WIFI_LINK_FAILED, wifiLink.state());
+  TEST_ASSERT_FALSE(bleEnabled);
+  TEST_ASSERT_TRUE(WiFi.softAPIP() == IPAddress(192, 168, 4, 1));
+  const FakeHttpResponse& res = server.fakeRequest(HTTP_GET, "/connection-status");
+  TEST_ASSERT_NOT_NULL(strstr(res.body.c_str(), "\"status\":\"failed\""));
+  WiFi.fakeConnectOnBegin = true;
+}
+
+int main(int argc, char** argv) {
+  (void)argc; (void)argv;
+  fake::uart().echo = getenv("WP_ECHO_SERIAL") != nullptr;
+
+  // Unconfigured boot: BLE + soft AP onboarding, every route registered.
+  setup();
+  WiFi.fakeStatus = WL_CONNECTED;
+
+  UNITY_BEGIN();
+  benchPrintHeader();
+  RUN_TEST(test_setup_registers_routes);
+  RUN_TEST(bench_http_health);
+  RUN_TEST(bench_http_weather);
+  RUN_TEST(bench_http_device_info);
+  RUN_TEST(bench_http_connection_status);
+  RUN_TEST(bench_http_location);
+  RUN_TEST(bench_http_config);
+  RUN_TEST(test_time_sync_starts_relay);
+  RUN_TEST(test_static_pages_gzip_etag);
+  RUN_TEST(bench_http_setup_page);
+  RUN_TEST(test_page_template_renderer);
+  RUN_TEST(test_root_page_fills_fields);
+  RUN_TEST(bench_root_page_replace_vs_template);
+  RUN_TEST(test_json_writer);
+  RUN_TEST(bench_weather_json_string_vs_writer);
+  RUN_TEST(test_json_writer_msgpack);
+  RUN_TEST(test_http_msgpack);
+  RUN_TEST(test_logger_lines_and_drops);
+  RUN_TEST(test_logger_levels_compile_out);
+  RUN_TEST(bench_log_line_vs_serial);
+  RUN_TEST(bench_relay_process_local_request);
+  RUN_TEST(test_relay_shares_http_routes);
+  RUN_TEST(test_relay_response_envelope);
+  RUN_TEST(bench_relay_message_roundtrip);
+  RUN_TEST(test_relay_batch);
+  RUN_TEST(test_relay_answers_every_id);
+  RUN_TEST(bench_relay_batch_vs_singles);
+  RUN_TEST(test_parse_forecast_stream);
+  RUN_TEST(test_parse_forecast_stream_by_date);
+  RUN_TEST(test_parse_forecast_stream_unequal_series);
+  RUN_TEST(bench_weather_parse_legacy_vs_forecast);
+  RUN_TEST(bench_get_weather_forecast);
+  RUN_TEST(test_weather_request_builder);
+  RUN_TEST(test_response_head_waits_for_late_bytes);
+  RUN_TEST(bench_weather_request_allocations);
+  RUN_TEST(test_http_body_stream_dechunks);
+  RUN_TEST(test_http_body_stream_ends_without_waiting);
+  RUN_TEST(test_connection_reuse_and_dns_cache);
+  RUN_TEST(bench_fetch_fresh_vs_reused_connection);
+  RUN_TEST(test_touch_renders_cache_before_revalidating);
+  RUN_TEST(test_stale_forecast_survives_outage);
+  RUN_TEST(test_location_change_cancels_fetch);
+  RUN_TEST(test_relay_parks_fresh_weather);
+  RUN_TEST(test_weather_events);
+  RUN_TEST(test_relay_pushes_weather_events);
+  RUN_TEST(bench_weather_push_vs_poll);
+  RUN_TEST(test_relay_msgpack);
+  RUN_TEST(bench_relay_msgpack_vs_json);
+  RUN_TEST(bench_touch_cached_vs_queued_fetch);
+  RUN_TEST(test_touch_gestures);
+  RUN_TEST(bench_loop_stall_during_fetch);
+  RUN_TEST(test_weather_condition_table);
+  RUN_TEST(bench_weather_condition_lookup);
+  RUN_TEST(bench_interpret_weather_symbol);
+  RUN_TEST(bench_led_frames);
+  RUN_TEST(test_led_tables_and_effects);
+  RUN_TEST(bench_led_render_legacy_vs_fixed_point);
+  RUN_TEST(test_led_strip_rmt_output);
+  RUN_TEST(bench_led_show_rmt_vs_bitbang);
+  RUN_TEST(bench_play_tone_idle);
+  RUN_TEST(test_melody_player);
+  RUN_TEST(bench_interpret_weather_symbol_melodies);
+  RUN_TEST(bench_loop_idle);
+  RUN_TEST(test_scheduler_deadlines);
+  RUN_TEST(test_tasks_endpoint);
+  RUN_TEST(test_config_record_checks);
+  RUN_TEST(test_handlers_save_config);
+  RUN_TEST(test_boot_from_saved_config);
+  RUN_TEST(test_wifi_rejoin_through_cache);
+  RUN_TEST(test_deep_sleep_touch_wake);
+  RUN_TEST(test_wifi_retries_saved_network_after_timeout);
+  RUN_TEST(test_wifi_gives_up_to_onboarding);
+  return UNITY_END();
+}